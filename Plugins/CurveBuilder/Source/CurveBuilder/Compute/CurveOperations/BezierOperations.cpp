@@ -2,11 +2,12 @@
 // https://github.com/PacosLelouch/
 
 #include "BezierOperations.h"
-THIRD_PARTY_INCLUDES_START
-#include "Eigen/LU"
-//#include "Eigen/Dense"
-THIRD_PARTY_INCLUDES_END
+#include "Utils/NumericalCalculationUtils.h"
 
+// With uniform parameters, segment i is [K_i, K_i + D_i/3, K_{i+1} - D_{i+1}/3, K_{i+1}],
+// where D_i is the tangent at K_i. C0 and C1 hold by construction, and C2 gives
+// D_{i-1} + 4*D_i + D_{i+1} = 3*(K_{i+1} - K_{i-1}),
+// so only a tridiagonal system of tangents need to be solved.
 namespace InternalBezier3EquationSolver
 {
 	template<int32 Dim = 3>
@@ -15,136 +16,109 @@ namespace InternalBezier3EquationSolver
 	template<int32 Dim = 3>
 	void SolveEquationWith2ndDerivative(TArray<TVectorX<Dim+1>>& OutCurvePoints, const TArray<TVectorX<Dim+1>>& InPoints, TVectorX<Dim+1> Start2ndDerivative, TVectorX<Dim+1> End2ndDerivative, int32 CurveNum);
 
+	template<int32 Dim = 3>
+	void SolveEquationClosed(TArray<TVectorX<Dim+1>>& OutCurvePoints, const TArray<TVectorX<Dim+1>>& InPoints, int32 CurveNum);
+
+	template<int32 Dim = 3>
+	void MakeCurvePointsByTangents(TArray<TVectorX<Dim+1>>& OutCurvePoints, const TArray<TVectorX<Dim+1>>& InPoints, const TArray<TVectorX<Dim+1>>& InTangents, int32 CurveNum);
+
+	static constexpr double InvDegree = 1. / 3.;
 };
 
 template<int32 Dim>
-void InternalBezier3EquationSolver::SolveEquationWith1stDerivative(TArray<TVectorX<Dim+1> >& OutCurvePoints, const TArray<TVectorX<Dim+1>>& InPoints, TVectorX<Dim+1> Start1stDerivative, TVectorX<Dim+1> End1stDerivative, int32 CurveNum)
+void InternalBezier3EquationSolver::MakeCurvePointsByTangents(TArray<TVectorX<Dim+1>>& OutCurvePoints, const TArray<TVectorX<Dim+1>>& InPoints, const TArray<TVectorX<Dim+1>>& InTangents, int32 CurveNum)
 {
-	int32 MatrixDim = CurveNum * 4;
-	OutCurvePoints.SetNum(MatrixDim);
-	for (int32 c = 0; c < Dim; ++c) {
-		Eigen::MatrixXd A(MatrixDim, MatrixDim);
-		Eigen::VectorXd X(MatrixDim), B(MatrixDim);
-
-		// 0. Border conditions 1st (2 equations)
-		A(0, 0) = 1.;
-		A(0, 1) = -1.;
-		B(0) = Start1stDerivative[c];
-
-		A(1, MatrixDim - 2) = 1.;
-		A(1, MatrixDim - 1) = -1.;
-		B(1) = End1stDerivative[c];
-
-		int32 ColumnIndex = 2;
-		// 1. Point position & C0 continuity (2 * CurveDim equations)
-		for (int32 i = 0; i < CurveNum; ++i) {
-			A(ColumnIndex, i * 4) = 1.;
-			B(ColumnIndex) = InPoints[i][c];
-			++ColumnIndex;
-
-			A(ColumnIndex, i * 4 + 3) = 1.;
-			B(ColumnIndex) = InPoints[i + 1][c];
-			++ColumnIndex;
-		}
-
-		// 2. C1 continuity (CurveDim - 1 equations)
-		for (int32 i = 0; i < CurveNum - 1; ++i) {
-			A(ColumnIndex, i * 4 + 2) = 1.;
-			A(ColumnIndex, i * 4 + 3) = -1.;
-			A(ColumnIndex, i * 4 + 4) = 1.;
-			A(ColumnIndex, i * 4 + 5) = -1.;
-			B(ColumnIndex) = 0.;
-			++ColumnIndex;
-		}
-
-		// 3. C2 continuity (CurveDim - 1 equations)
-		for (int32 i = 0; i < CurveNum - 1; ++i) {
-			A(ColumnIndex, i * 4 + 1) = 1.;
-			A(ColumnIndex, i * 4 + 2) = -2.;
-			A(ColumnIndex, i * 4 + 3) = 1.;
-			A(ColumnIndex, i * 4 + 4) = 1.;
-			A(ColumnIndex, i * 4 + 5) = -2.;
-			A(ColumnIndex, i * 4 + 6) = 1.;
-			B(ColumnIndex) = 0.;
-			++ColumnIndex;
-		}
-
-		X = A.lu().solve(B);
-		for (int32 i = 0; i < MatrixDim; ++i) {
-			OutCurvePoints[i][c] = X(i);
-		}
+	OutCurvePoints.SetNum(CurveNum * 4);
+	for (int32 i = 0; i < CurveNum; ++i) {
+		OutCurvePoints[i * 4] = InPoints[i];
+		OutCurvePoints[i * 4 + 1] = InPoints[i] + InTangents[i] * InvDegree;
+		OutCurvePoints[i * 4 + 2] = InPoints[i + 1] - InTangents[i + 1] * InvDegree;
+		OutCurvePoints[i * 4 + 3] = InPoints[i + 1];
 	}
-	for (int32 i = 0; i < MatrixDim; ++i) {
+	for (int32 i = 0; i < OutCurvePoints.Num(); ++i) {
 		OutCurvePoints[i][Dim] = 1.;
 	}
 }
 
 template<int32 Dim>
-void InternalBezier3EquationSolver::SolveEquationWith2ndDerivative(TArray<TVectorX<Dim+1>>& OutCurvePoints, const TArray<TVectorX<Dim+1>>& InPoints, TVectorX<Dim+1> Start2ndDerivative, TVectorX<Dim+1> End2ndDerivative, int32 CurveNum)
+void InternalBezier3EquationSolver::SolveEquationWith1stDerivative(TArray<TVectorX<Dim+1> >& OutCurvePoints, const TArray<TVectorX<Dim+1>>& InPoints, TVectorX<Dim+1> Start1stDerivative, TVectorX<Dim+1> End1stDerivative, int32 CurveNum)
 {
-	int32 MatrixDim = CurveNum * 4;
-	OutCurvePoints.SetNum(MatrixDim);
-
-	for (int32 c = 0; c < Dim; ++c) {
-		Eigen::MatrixXd A(MatrixDim, MatrixDim);
-		Eigen::VectorXd X(MatrixDim), B(MatrixDim);
-		A.setZero();
-		B.setZero();
-		X.setZero();
-
-		// 0. Border conditions 2nd (2 equations)
-		A(0, 0) = 1.;
-		A(0, 1) = -2.;
-		A(0, 2) = 1.;
-		B(0) = Start2ndDerivative[c];
-
-		A(1, MatrixDim - 3) = 1.;
-		A(1, MatrixDim - 2) = -2.;
-		A(1, MatrixDim - 1) = 1.;
-		B(1) = End2ndDerivative[c];
-
-		int32 ColumnIndex = 2;
-		// 1. Point position & C0 continuity (2 * CurveDim equations)
-		for (int32 i = 0; i < CurveNum; ++i) {
-			A(ColumnIndex, i * 4) = 1.;
-			B(ColumnIndex) = InPoints[i][c];
-			++ColumnIndex;
-
-			A(ColumnIndex, i * 4 + 3) = 1.;
-			B(ColumnIndex) = InPoints[i + 1][c];
-			++ColumnIndex;
+	// Border conditions 1st: P1 - P0 = Start, P3 - P2 = End, so D_0 and D_N are known.
+	TArray<TVectorX<Dim+1> > Tangents;
+	Tangents.SetNum(CurveNum + 1);
+	Tangents[0] = Start1stDerivative * 3.;
+	Tangents[CurveNum] = End1stDerivative * 3.;
+
+	const int32 InteriorNum = CurveNum - 1;
+	if (InteriorNum > 0) {
+		TArray<TVectorX<Dim+1> > InteriorTangents;
+		TArray<double> Lower, Diag, Upper;
+		InteriorTangents.SetNum(InteriorNum);
+		Lower.Init(1., InteriorNum);
+		Diag.Init(4., InteriorNum);
+		Upper.Init(1., InteriorNum);
+		for (int32 i = 0; i < InteriorNum; ++i) {
+			InteriorTangents[i] = (InPoints[i + 2] - InPoints[i]) * 3.;
 		}
+		InteriorTangents[0] = InteriorTangents[0] - Tangents[0];
+		InteriorTangents[InteriorNum - 1] = InteriorTangents[InteriorNum - 1] - Tangents[CurveNum];
 
-		// 2. C1 continuity (CurveDim - 1 equations)
-		for (int32 i = 0; i < CurveNum - 1; ++i) {
-			A(ColumnIndex, i * 4 + 2) = 1.;
-			A(ColumnIndex, i * 4 + 3) = -1.;
-			A(ColumnIndex, i * 4 + 4) = -1.;
-			A(ColumnIndex, i * 4 + 5) = 1.;
-			B(ColumnIndex) = 0.;
-			++ColumnIndex;
+		TridiagonalEquationSolver::Solve(InteriorTangents, Lower, Diag, Upper);
+		for (int32 i = 0; i < InteriorNum; ++i) {
+			Tangents[i + 1] = InteriorTangents[i];
 		}
+	}
 
-		// 3. C2 continuity (CurveDim - 1 equations)
-		for (int32 i = 0; i < CurveNum - 1; ++i) {
-			A(ColumnIndex, i * 4 + 1) = 1.;
-			A(ColumnIndex, i * 4 + 2) = -2.;
-			A(ColumnIndex, i * 4 + 3) = 1.;
-			A(ColumnIndex, i * 4 + 4) = -1.;
-			A(ColumnIndex, i * 4 + 5) = 2.;
-			A(ColumnIndex, i * 4 + 6) = -1.;
-			B(ColumnIndex) = 0.;
-			++ColumnIndex;
-		}
+	MakeCurvePointsByTangents<Dim>(OutCurvePoints, InPoints, Tangents, CurveNum);
+}
 
-		X = A.lu().solve(B);
-		for (int32 i = 0; i < MatrixDim; ++i) {
-			OutCurvePoints[i][c] = X(i);
-		}
+template<int32 Dim>
+void InternalBezier3EquationSolver::SolveEquationWith2ndDerivative(TArray<TVectorX<Dim+1>>& OutCurvePoints, const TArray<TVectorX<Dim+1>>& InPoints, TVectorX<Dim+1> Start2ndDerivative, TVectorX<Dim+1> End2ndDerivative, int32 CurveNum)
+{
+	// Border conditions 2nd: P0 - 2*P1 + P2 = Start, P1 - 2*P2 + P3 = End.
+	// 2*D_0 + D_1 = 3*(K_1 - K_0 - Start)
+	// D_{N-1} + 2*D_N = 3*(K_N - K_{N-1} + End)
+	const int32 TangentNum = CurveNum + 1;
+	TArray<TVectorX<Dim+1> > Tangents;
+	TArray<double> Lower, Diag, Upper;
+	Tangents.SetNum(TangentNum);
+	Lower.Init(1., TangentNum);
+	Diag.Init(4., TangentNum);
+	Upper.Init(1., TangentNum);
+	Diag[0] = 2.;
+	Diag[CurveNum] = 2.;
+
+	Tangents[0] = (InPoints[1] - InPoints[0] - Start2ndDerivative) * 3.;
+	for (int32 i = 1; i < CurveNum; ++i) {
+		Tangents[i] = (InPoints[i + 1] - InPoints[i - 1]) * 3.;
 	}
-	for (int32 i = 0; i < MatrixDim; ++i) {
-		OutCurvePoints[i][Dim] = 1.;
+	Tangents[CurveNum] = (InPoints[CurveNum] - InPoints[CurveNum - 1] + End2ndDerivative) * 3.;
+
+	TridiagonalEquationSolver::Solve(Tangents, Lower, Diag, Upper);
+
+	MakeCurvePointsByTangents<Dim>(OutCurvePoints, InPoints, Tangents, CurveNum);
+}
+
+template<int32 Dim>
+void InternalBezier3EquationSolver::SolveEquationClosed(TArray<TVectorX<Dim+1>>& OutCurvePoints, const TArray<TVectorX<Dim+1>>& InPoints, int32 CurveNum)
+{
+	// Periodic: D_{-1} = D_{N-1}, D_N = D_0, so the system is cyclic tridiagonal.
+	TArray<TVectorX<Dim+1> > Tangents;
+	TArray<double> Lower, Diag, Upper;
+	Tangents.SetNum(CurveNum);
+	Lower.Init(1., CurveNum);
+	Diag.Init(4., CurveNum);
+	Upper.Init(1., CurveNum);
+	for (int32 i = 0; i < CurveNum; ++i) {
+		Tangents[i] = (InPoints[(i + 1) % CurveNum] - InPoints[(i + CurveNum - 1) % CurveNum]) * 3.;
 	}
+
+	TridiagonalEquationSolver::SolveCyclic(Tangents, Lower, Diag, Upper);
+
+	TArray<TVectorX<Dim+1> > LoopPoints(InPoints);
+	LoopPoints.Add(InPoints[0]);
+	Tangents.Add(Tangents[0]);
+	MakeCurvePointsByTangents<Dim>(OutCurvePoints, LoopPoints, Tangents, CurveNum);
 }
 
 void Bezier3EquationSolver::SolveEquationWith1stDerivative(TArray<TVectorX<4>>& OutCurvePoints, const TArray<TVectorX<4>>& InPoints, TVectorX<4> Start1stDerivative, TVectorX<4> End1stDerivative, int32 CurveNum)
@@ -167,3 +141,13 @@ void Bezier3EquationSolver::SolveEquationWith2ndDerivative(TArray<TVectorX<3>>&
 	InternalBezier3EquationSolver::SolveEquationWith2ndDerivative<2>(OutCurvePoints, InPoints, Start2ndDerivative, End2ndDerivative, CurveNum);
 }
 
+void Bezier3EquationSolver::SolveEquationClosed(TArray<TVectorX<4>>& OutCurvePoints, const TArray<TVectorX<4>>& InPoints, int32 CurveNum)
+{
+	InternalBezier3EquationSolver::SolveEquationClosed<3>(OutCurvePoints, InPoints, CurveNum);
+}
+
+void Bezier3EquationSolver::SolveEquationClosed(TArray<TVectorX<3>>& OutCurvePoints, const TArray<TVectorX<3>>& InPoints, int32 CurveNum)
+{
+	InternalBezier3EquationSolver::SolveEquationClosed<2>(OutCurvePoints, InPoints, CurveNum);
+}
+
@@ -30,6 +30,10 @@ public:
 		TVectorX<Dim+1> Start2ndDerivative = TVecLib<Dim>::Homogeneous(TVecLib<Dim>::Zero(), 1.),
 		TVectorX<Dim+1> End2ndDerivative = TVecLib<Dim>::Homogeneous(TVecLib<Dim>::Zero(), 1.));
 
+	// Closed loop, the last curve connects the last point to the first point.
+	static void InterpolationC2Closed(
+		TArray<TBezierCurve<Dim, 3> >& OutCurves, const TArray<TVectorX<Dim+1> >& InPoints);
+
 	//static void AdjustPointC1(...);
 };
 
@@ -14,6 +14,10 @@ namespace Bezier3EquationSolver
 	CURVEBUILDER_API void SolveEquationWith1stDerivative(TArray<TVectorX<3>>& OutCurvePoints, const TArray<TVectorX<3>>& InPoints, TVectorX<3> Start1stDerivative, TVectorX<3> End1stDerivative, int32 CurveNum);
 
 	CURVEBUILDER_API void SolveEquationWith2ndDerivative(TArray<TVectorX<3>>& OutCurvePoints, const TArray<TVectorX<3>>& InPoints, TVectorX<3> Start2ndDerivative, TVectorX<3> End2ndDerivative, int32 CurveNum);
+
+	CURVEBUILDER_API void SolveEquationClosed(TArray<TVectorX<4>>& OutCurvePoints, const TArray<TVectorX<4>>& InPoints, int32 CurveNum);
+
+	CURVEBUILDER_API void SolveEquationClosed(TArray<TVectorX<3>>& OutCurvePoints, const TArray<TVectorX<3>>& InPoints, int32 CurveNum);
 };
 
 
@@ -140,3 +144,21 @@ inline void TBezierOperationsDegree3<Dim>::InterpolationC2WithBorder2ndDerivativ
 		OutCurves.Emplace(OutCurvePoints.GetData() + (4 * i));
 	}
 }
+
+template<int32 Dim>
+inline void TBezierOperationsDegree3<Dim>::InterpolationC2Closed(TArray<TBezierCurve<Dim, 3>>& OutCurves, const TArray<TVectorX<Dim+1>>& InPoints)
+{
+	if (InPoints.Num() < 2) {
+		return;
+	}
+
+	int32 CurveNum = InPoints.Num();
+	OutCurves.Empty(CurveNum);
+	TArray<TVectorX<Dim+1> > OutCurvePoints;
+
+	Bezier3EquationSolver::SolveEquationClosed(OutCurvePoints, InPoints, CurveNum);
+
+	for (int32 i = 0; i < CurveNum; ++i) {
+		OutCurves.Emplace(OutCurvePoints.GetData() + (4 * i));
+	}
+}
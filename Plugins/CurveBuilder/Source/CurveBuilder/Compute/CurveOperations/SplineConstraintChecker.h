@@ -0,0 +1,102 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Splines/SplineGraph.h"
+#include "Utils/NumericalCalculationUtils.h"
+
+// Max curvature and max grades of splines, e.g. for validating roads.
+// On each bezier segment, the extrema and the ends of the ranges exceeding the thresholds are the roots of polynomials
+// made from the control points of the segment, found by Sturm sequences, instead of sampling GetCurvature() densely.
+// The segments with weights other than 1 use the rational derivatives, with polynomials of higher degrees.
+// The weights should be positive. Nothing is cached: the segments are made by ToBezierCurves() on each check.
+template<int32 Dim>
+class TSplineConstraintChecker
+{
+public:
+	using FSplineType = typename TSplineBase<Dim, 3>;
+	using FCurveType = typename TBezierCurve<Dim, 3>;
+	using FGraphType = typename TSplineGraph<Dim, 3>;
+	using FSplineId = typename FGraphType::FSplineId;
+
+	// Negative thresholds are not checked. The grade of an axis is its rate to the other axes, e.g. the slope for Z.
+	struct FThresholds
+	{
+		double MaxCurvature = -1.;
+		double MaxGrades[Dim];
+
+		FThresholds()
+		{
+			for (int32 i = 0; i < Dim; ++i) {
+				MaxGrades[i] = -1.;
+			}
+		}
+	};
+
+	struct FReport
+	{
+		FSplineId Id;
+		double MaxCurvature = 0.;
+		double MaxCurvatureParam = 0.;
+		// BIG_NUMBER where the spline is along the axis.
+		double MaxGrades[Dim];
+		double MaxGradeParams[Dim];
+		// Ranges of the parameter of the spline where the thresholds are exceeded, merged across the segments.
+		TArray<TTuple<double, double> > CurvatureViolations;
+		TArray<TTuple<double, double> > GradeViolations[Dim];
+
+		FReport()
+		{
+			for (int32 i = 0; i < Dim; ++i) {
+				MaxGrades[i] = 0.;
+				MaxGradeParams[i] = 0.;
+			}
+		}
+
+		bool HasViolation() const
+		{
+			bool bViolated = CurvatureViolations.Num() > 0;
+			for (int32 i = 0; i < Dim; ++i) {
+				bViolated = bViolated || GradeViolations[i].Num() > 0;
+			}
+			return bViolated;
+		}
+	};
+
+public:
+	static void CheckSpline(FReport& OutReport, const FSplineType& Spline, const FThresholds& Thresholds);
+
+	// All the splines of the graph, in parallel. Only the reports with violations are output if bOnlyViolations.
+	static void CheckGraph(TArray<FReport>& OutReports, const FGraphType& Graph, const FThresholds& Thresholds, bool bOnlyViolations = false);
+
+protected:
+	// Power basis by the local parameter of a segment.
+	// For weighted points, the derivatives are scaled by W^2, and CrossSqr by W^4 to keep CrossSqr / SpeedSqr^3.
+	struct FSegmentPolynomials
+	{
+		TArray<double> Derivatives[Dim];
+		TArray<double> SecondDerivatives[Dim];
+		// |P'|^2
+		TArray<double> SpeedSqr;
+		// |P' x P''|^2 = |P'|^2 |P''|^2 - (P' . P'')^2, in any dimension.
+		TArray<double> CrossSqr;
+	};
+
+	static void MakeSegmentPolynomials(FSegmentPolynomials& OutPolynomials, const FCurveType& Curve);
+
+	static void CheckSegment(FReport& InOutReport, const FCurveType& Curve, const TTuple<double, double>& ParamRange, const FThresholds& Thresholds);
+
+	static double GetCurvature(const FSegmentPolynomials& Polynomials, double U);
+
+	static double GetGrade(const FSegmentPolynomials& Polynomials, int32 Axis, double U);
+
+	// Ranges where Excess > 0, between its roots.
+	static void AddViolations(TArray<TTuple<double, double> >& InOutRanges, const TArray<double>& Excess, const TTuple<double, double>& ParamRange);
+
+	// Merged with the last range if they meet.
+	static void AppendRange(TArray<TTuple<double, double> >& InOutRanges, double From, double To);
+};
+
+#include "SplineConstraintChecker.inl"
@@ -0,0 +1,226 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "SplineConstraintChecker.h"
+#include "Async/ParallelFor.h"
+
+template<int32 Dim>
+inline void TSplineConstraintChecker<Dim>::CheckSpline(FReport& OutReport, const FSplineType& Spline, const FThresholds& Thresholds)
+{
+	const FSplineId Id = OutReport.Id;
+	OutReport = FReport();
+	OutReport.Id = Id;
+
+	TArray<FCurveType> Curves;
+	TArray<TTuple<double, double> > ParamRanges;
+	if (!Spline.ToBezierCurves(Curves, &ParamRanges) || Curves.Num() != ParamRanges.Num()) {
+		return;
+	}
+	for (int32 i = 0; i < Curves.Num(); ++i) {
+		CheckSegment(OutReport, Curves[i], ParamRanges[i], Thresholds);
+	}
+}
+
+template<int32 Dim>
+inline void TSplineConstraintChecker<Dim>::CheckGraph(TArray<FReport>& OutReports, const FGraphType& Graph, const FThresholds& Thresholds, bool bOnlyViolations)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_SplineConstraintChecker_CheckGraph);
+	OutReports.Reset();
+	TArray<TSharedPtr<FSplineType> > Splines;
+	for (int32 i = 0; i < Graph.GetSplineIndexCapacity(); ++i) {
+		const FSplineId Id = Graph.GetSplineIdByIndex(i);
+		TSharedPtr<FSplineType> Spline = Graph.GetSplineById(Id);
+		if (Spline.IsValid()) {
+			Splines.Add(Spline);
+			OutReports.AddDefaulted_GetRef().Id = Id;
+		}
+	}
+	ParallelFor(Splines.Num(), [&OutReports, &Splines, &Thresholds](int32 i) {
+		CheckSpline(OutReports[i], *Splines[i], Thresholds);
+	});
+	if (bOnlyViolations) {
+		OutReports.RemoveAll([](const FReport& Report) { return !Report.HasViolation(); });
+	}
+}
+
+template<int32 Dim>
+inline void TSplineConstraintChecker<Dim>::MakeSegmentPolynomials(FSegmentPolynomials& OutPolynomials, const FCurveType& Curve)
+{
+	using namespace PolynomialSolver;
+	TVectorX<Dim+1> H[4];
+	bool bRational = false;
+	for (int32 i = 0; i < 4; ++i) {
+		H[i] = Curve.GetPointHomogeneous(i);
+		bRational = bRational || !FMath::IsNearlyEqual(TVecLib<Dim+1>::Last(H[i]), 1.);
+	}
+	auto ToPowerBasis = [](TArray<double>& Out, double P0, double P1, double P2, double P3) {
+		Out = { P0, 3. * (P1 - P0), 3. * (P2 - 2. * P1 + P0), P3 - 3. * P2 + 3. * P1 - P0 };
+	};
+
+	// P = A / W for the weighted points. P' = (A' W - A W') / W^2, and the positive W^2 is dropped,
+	// so the derivatives here are N = A' W - A W' and N'. The curvature is W^4 |N x N'|^2 / |N|^6.
+	TArray<double> Weight, WeightDerivative;
+	if (bRational) {
+		ToPowerBasis(Weight, TVecLib<Dim+1>::Last(H[0]), TVecLib<Dim+1>::Last(H[1]), TVecLib<Dim+1>::Last(H[2]), TVecLib<Dim+1>::Last(H[3]));
+		Derivative(WeightDerivative, Weight);
+	}
+	OutPolynomials.SpeedSqr.Reset();
+	TArray<double> Numerator, SecondSqr, Dot, Temp, Temp2, Sum;
+	for (int32 k = 0; k < Dim; ++k) {
+		TArray<double>& AxisDerivative = OutPolynomials.Derivatives[k];
+		TArray<double>& SecondDerivative = OutPolynomials.SecondDerivatives[k];
+		if (bRational) {
+			ToPowerBasis(Numerator, H[0][k], H[1][k], H[2][k], H[3][k]);
+			Derivative(Temp, Numerator);
+			Multiply(Temp2, Temp, Weight);
+			Multiply(Temp, Numerator, WeightDerivative);
+			Add(AxisDerivative, Temp2, Temp, -1.);
+		}
+		else {
+			ToPowerBasis(Numerator, Curve.GetPoint(0)[k], Curve.GetPoint(1)[k], Curve.GetPoint(2)[k], Curve.GetPoint(3)[k]);
+			Derivative(AxisDerivative, Numerator);
+		}
+		Derivative(SecondDerivative, AxisDerivative);
+
+		Multiply(Temp, AxisDerivative, AxisDerivative);
+		Add(Sum, OutPolynomials.SpeedSqr, Temp);
+		OutPolynomials.SpeedSqr = Sum;
+		Multiply(Temp, SecondDerivative, SecondDerivative);
+		Add(Sum, SecondSqr, Temp);
+		SecondSqr = Sum;
+		Multiply(Temp, AxisDerivative, SecondDerivative);
+		Add(Sum, Dot, Temp);
+		Dot = Sum;
+	}
+	Multiply(Temp, OutPolynomials.SpeedSqr, SecondSqr);
+	Multiply(Sum, Dot, Dot);
+	Add(OutPolynomials.CrossSqr, Temp, Sum, -1.);
+	if (bRational) {
+		Multiply(Temp, Weight, Weight);
+		Multiply(Temp2, Temp, Temp);
+		Multiply(Temp, OutPolynomials.CrossSqr, Temp2);
+		OutPolynomials.CrossSqr = Temp;
+	}
+}
+
+template<int32 Dim>
+inline void TSplineConstraintChecker<Dim>::CheckSegment(FReport& InOutReport, const FCurveType& Curve, const TTuple<double, double>& ParamRange, const FThresholds& Thresholds)
+{
+	using namespace PolynomialSolver;
+	FSegmentPolynomials Polynomials;
+	MakeSegmentPolynomials(Polynomials, Curve);
+	auto ToParam = [&ParamRange](double U) -> double {
+		return FMath::Lerp(ParamRange.Get<0>(), ParamRange.Get<1>(), U);
+	};
+	TArray<double> Roots, SpeedSqrDerivative, Temp, Temp2, Target;
+	Derivative(SpeedSqrDerivative, Polynomials.SpeedSqr);
+
+	// Curvature^2 = CrossSqr / SpeedSqr^3. Its derivative is zero where CrossSqr' SpeedSqr - 3 CrossSqr SpeedSqr' = 0.
+	{
+		TArray<double> CrossSqrDerivative;
+		Derivative(CrossSqrDerivative, Polynomials.CrossSqr);
+		Multiply(Temp, CrossSqrDerivative, Polynomials.SpeedSqr);
+		Multiply(Temp2, Polynomials.CrossSqr, SpeedSqrDerivative);
+		Add(Target, Temp, Temp2, -3.);
+		FindRoots(Roots, Target, 0., 1.);
+		Roots.Add(0.);
+		Roots.Add(1.);
+		for (double U : Roots) {
+			const double Curvature = GetCurvature(Polynomials, U);
+			if (Curvature > InOutReport.MaxCurvature) {
+				InOutReport.MaxCurvature = Curvature;
+				InOutReport.MaxCurvatureParam = ToParam(U);
+			}
+		}
+		if (Thresholds.MaxCurvature >= 0.) {
+			// CrossSqr - Threshold^2 SpeedSqr^3 > 0.
+			Multiply(Temp, Polynomials.SpeedSqr, Polynomials.SpeedSqr);
+			Multiply(Temp2, Temp, Polynomials.SpeedSqr);
+			Add(Target, Polynomials.CrossSqr, Temp2, -Thresholds.MaxCurvature * Thresholds.MaxCurvature);
+			AddViolations(InOutReport.CurvatureViolations, Target, ParamRange);
+		}
+	}
+
+	// Grade^2 = D^2 / (SpeedSqr - D^2) with D = Derivatives[Axis], not changed by the scale of the derivative. Its derivative is zero where 2 D D' SpeedSqr - D^2 SpeedSqr' = 0.
+	for (int32 Axis = 0; Axis < Dim; ++Axis) {
+		const TArray<double>& AxisDerivative = Polynomials.Derivatives[Axis];
+		TArray<double> AxisSqr;
+		Multiply(AxisSqr, AxisDerivative, AxisDerivative);
+		Multiply(Temp, AxisDerivative, Polynomials.SecondDerivatives[Axis]);
+		Multiply(Temp2, Temp, Polynomials.SpeedSqr);
+		Multiply(Temp, AxisSqr, SpeedSqrDerivative);
+		Add(Target, Temp2, Temp, -0.5);
+		FindRoots(Roots, Target, 0., 1.);
+		Roots.Add(0.);
+		Roots.Add(1.);
+		for (double U : Roots) {
+			const double Grade = GetGrade(Polynomials, Axis, U);
+			if (Grade > InOutReport.MaxGrades[Axis]) {
+				InOutReport.MaxGrades[Axis] = Grade;
+				InOutReport.MaxGradeParams[Axis] = ToParam(U);
+			}
+		}
+		const double MaxGrade = Thresholds.MaxGrades[Axis];
+		if (MaxGrade >= 0.) {
+			// (1 + Threshold^2) D^2 - Threshold^2 SpeedSqr > 0.
+			const double GradeSqr = MaxGrade * MaxGrade;
+			Add(Target, AxisSqr, Polynomials.SpeedSqr, -GradeSqr / (1. + GradeSqr));
+			AddViolations(InOutReport.GradeViolations[Axis], Target, ParamRange);
+		}
+	}
+}
+
+template<int32 Dim>
+inline double TSplineConstraintChecker<Dim>::GetCurvature(const FSegmentPolynomials& Polynomials, double U)
+{
+	const double SpeedSqr = PolynomialSolver::Evaluate(Polynomials.SpeedSqr, U);
+	if (FMath::IsNearlyZero(SpeedSqr)) {
+		return 0.;
+	}
+	const double CrossSqr = FMath::Max(PolynomialSolver::Evaluate(Polynomials.CrossSqr, U), 0.);
+	return FMath::Sqrt(CrossSqr) / (SpeedSqr * FMath::Sqrt(SpeedSqr));
+}
+
+template<int32 Dim>
+inline double TSplineConstraintChecker<Dim>::GetGrade(const FSegmentPolynomials& Polynomials, int32 Axis, double U)
+{
+	const double SpeedSqr = PolynomialSolver::Evaluate(Polynomials.SpeedSqr, U);
+	if (FMath::IsNearlyZero(SpeedSqr)) {
+		return 0.;
+	}
+	const double AxisValue = PolynomialSolver::Evaluate(Polynomials.Derivatives[Axis], U);
+	const double OthersSqr = SpeedSqr - AxisValue * AxisValue;
+	if (OthersSqr <= SpeedSqr * KINDA_SMALL_NUMBER) {
+		return BIG_NUMBER;
+	}
+	return FMath::Abs(AxisValue) / FMath::Sqrt(OthersSqr);
+}
+
+template<int32 Dim>
+inline void TSplineConstraintChecker<Dim>::AddViolations(TArray<TTuple<double, double> >& InOutRanges, const TArray<double>& Excess, const TTuple<double, double>& ParamRange)
+{
+	TArray<double> Breaks;
+	PolynomialSolver::FindRoots(Breaks, Excess, 0., 1.);
+	Breaks.Insert(0., 0);
+	Breaks.Add(1.);
+	for (int32 i = 1; i < Breaks.Num(); ++i) {
+		const double From = Breaks[i - 1], To = Breaks[i];
+		if (To > From && PolynomialSolver::Evaluate(Excess, (From + To) * 0.5) > 0.) {
+			AppendRange(InOutRanges,
+				FMath::Lerp(ParamRange.Get<0>(), ParamRange.Get<1>(), From),
+				FMath::Lerp(ParamRange.Get<0>(), ParamRange.Get<1>(), To));
+		}
+	}
+}
+
+template<int32 Dim>
+inline void TSplineConstraintChecker<Dim>::AppendRange(TArray<TTuple<double, double> >& InOutRanges, double From, double To)
+{
+	if (InOutRanges.Num() > 0 && From <= InOutRanges.Last().Get<1>() + KINDA_SMALL_NUMBER) {
+		InOutRanges.Last().Get<1>() = FMath::Max(InOutRanges.Last().Get<1>(), To);
+		return;
+	}
+	InOutRanges.Add(MakeTuple(From, To));
+}
@@ -0,0 +1,105 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Splines/SplineGraph.h"
+
+PRAGMA_DEFAULT_VISIBILITY_START
+THIRD_PARTY_INCLUDES_START
+#include "Eigen/SparseCore"
+#include "Eigen/SparseCholesky"
+#include "Eigen/IterativeLinearSolvers"
+THIRD_PARTY_INCLUDES_END
+PRAGMA_DEFAULT_VISIBILITY_END
+
+// Fairing of control polygons, e.g. for smoothing hand drawn roads.
+// The energy is the squared third differences of the control polygon (the discrete variation of curvature), optionally
+// with the squared second differences, plus the squared distances of the points from where they were.
+// The system is banded, so it is solved by a sparse LDLT in natural ordering (or CG) in time linear to the points.
+// Points moving beyond the tolerance are weighted more and solved again, then clamped into the tolerance.
+// Eigen is only used for the sparse algebra.
+template<int32 Dim>
+class TSplineFairing
+{
+public:
+	using FSplineType = typename TSplineBase<Dim, 3>;
+	using FGraphType = typename TSplineGraph<Dim, 3>;
+	using FSplineId = typename FGraphType::FSplineId;
+	using FBezierStringType = typename TSplineTraitByType<ESplineType::BezierString, Dim, 3>::FSplineType;
+	using FBSplineType = typename TSplineTraitByType<ESplineType::ClampedBSpline, Dim, 3>::FSplineType;
+
+	struct FSettings
+	{
+		// Weight of the squared third differences.
+		double VariationWeight = 1.;
+		// Weight of the squared second differences.
+		double BendingWeight = 0.;
+		// Max distance of a control point from where it was.
+		double PositionTolerance = 10.;
+		// Rounds of weighting the points beyond the tolerance more.
+		int32 MaxToleranceIterations = 4;
+		// Relative distance of a joint from the line of its neighbors, to be kept smooth.
+		double CollinearTolerance = 1.e-3;
+		// Max distance of the ends joined one to one in the graph, to be faired together.
+		double JoinDistance = 1.e-2;
+		// Keep the ends without connections.
+		bool bFixFreeEnds = true;
+		// Conjugate gradient instead of LDLT, with less memory for very long chains.
+		bool bUseConjugateGradient = false;
+	};
+
+	// Control polygon of one spline or splines joined end to start.
+	struct FChain
+	{
+		TArray<TVectorX<Dim> > Points;
+		// The point is fixed if not positive.
+		TArray<double> Tolerances;
+		// Points[i] = Lambda * Points[i - 1] + (1 - Lambda) * Points[i + 1] for a smooth joint, or negative.
+		TArray<double> JointLambdas;
+	};
+
+public:
+	// Return false if the system is not solved.
+	static bool FairChain(TArray<TVectorX<Dim> >& OutPoints, const FChain& Chain, const FSettings& Settings);
+
+	// Clamped B-Spline or bezier string. The smooth joints of the bezier string are kept smooth.
+	static bool FairSpline(FSplineType& Spline, const FSettings& Settings);
+
+	// Splines joined one to one at the ends are faired together, keeping the joints smooth if they were.
+	// At the other connections, the ends and their tangents are kept. The chains are solved in parallel.
+	// It is one step of the journal of the graph if attached. Return the number of splines changed.
+	static int32 FairGraph(FGraphType& Graph, const FSettings& Settings, TArray<FSplineId>* OutAffectedIds = nullptr);
+
+protected:
+	using FSparseMatrix = typename Eigen::SparseMatrix<double>;
+	using FTriplet = typename Eigen::Triplet<double>;
+
+	struct FPiece
+	{
+		int32 SplineIndex = INDEX_NONE;
+		bool bReversed = false;
+		// Index of the first point of the piece in the chain.
+		int32 First = 0;
+		// Weights of the flat points, in the order of the spline.
+		TArray<double> Weights;
+	};
+
+	// Bezier strings are flattened to P0, Next0, Prev1, P1, Next1, ..., and the inner points are joints.
+	static bool GetFlatPoints(TArray<TVectorX<Dim> >& OutPoints, TArray<double>& OutWeights, TArray<bool>& OutJoints, const FSplineType& Spline);
+
+	static void SetFlatPoints(FSplineType& Spline, TArrayView<const TVectorX<Dim> > Points, const TArray<double>& Weights);
+
+	// Negative if the joint is not on the segment between its neighbors.
+	static double GetJointLambda(const TVectorX<Dim>& Prev, const TVectorX<Dim>& Joint, const TVectorX<Dim>& Next, double CollinearTolerance);
+
+	// The endpoint joined one to one with the endpoint, or INDEX_NONE.
+	static int32 GetJoinedEndpoint(const FGraphType& Graph, int32 Endpoint, double JoinDistance);
+
+	static bool IsFairable(const FSplineType& Spline);
+
+	static void AddEnergy(TArray<FTriplet>& OutTriplets, int32 PointNum, const FSettings& Settings);
+};
+
+#include "SplineFairing.inl"
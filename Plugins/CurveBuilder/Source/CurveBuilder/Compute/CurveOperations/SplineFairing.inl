@@ -0,0 +1,471 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "SplineFairing.h"
+#include "Async/ParallelFor.h"
+#include "Algo/Reverse.h"
+
+template<int32 Dim>
+inline bool TSplineFairing<Dim>::FairChain(TArray<TVectorX<Dim> >& OutPoints, const FChain& Chain, const FSettings& Settings)
+{
+	const TArray<TVectorX<Dim> >& Points = Chain.Points;
+	const int32 N = Points.Num();
+	OutPoints = Points;
+	if (N < 3) {
+		return true;
+	}
+	auto GetTolerance = [&Chain](int32 i) { return Chain.Tolerances.IsValidIndex(i) ? Chain.Tolerances[i] : 0.; };
+	auto GetLambda = [&Chain](int32 i) { return Chain.JointLambdas.IsValidIndex(i) ? Chain.JointLambdas[i] : -1.; };
+
+	// Free points are the variables. A joint next to another dependent joint is taken as free.
+	TArray<int32> Variables;
+	Variables.Init(INDEX_NONE, N);
+	TArray<bool> Dependent;
+	Dependent.Init(false, N);
+	int32 VarNum = 0;
+	for (int32 i = 0; i < N; ++i) {
+		if (GetTolerance(i) <= 0.) {
+			continue;
+		}
+		Dependent[i] = i > 0 && i < N - 1 && GetLambda(i) >= 0. && !Dependent[i - 1];
+		if (!Dependent[i]) {
+			Variables[i] = VarNum++;
+		}
+	}
+	if (VarNum == 0) {
+		return true;
+	}
+
+	// Points = M * X + C.
+	Eigen::MatrixXd Target(N, Dim);
+	Eigen::MatrixXd C = Eigen::MatrixXd::Zero(N, Dim);
+	for (int32 i = 0; i < N; ++i) {
+		for (int32 k = 0; k < Dim; ++k) {
+			Target(i, k) = Points[i][k];
+		}
+	}
+	TArray<FTriplet> Triplets;
+	Triplets.Reserve(N * 2);
+	for (int32 i = 0; i < N; ++i) {
+		if (Variables[i] != INDEX_NONE) {
+			Triplets.Add(FTriplet(i, Variables[i], 1.));
+		}
+		else if (Dependent[i]) {
+			const double Lambda = GetLambda(i);
+			const int32 Neighbors[2] = { i - 1, i + 1 };
+			const double Coefs[2] = { Lambda, 1. - Lambda };
+			for (int32 j = 0; j < 2; ++j) {
+				if (Variables[Neighbors[j]] != INDEX_NONE) {
+					Triplets.Add(FTriplet(i, Variables[Neighbors[j]], Coefs[j]));
+				}
+				else {
+					C.row(i) += Coefs[j] * Target.row(Neighbors[j]);
+				}
+			}
+		}
+		else {
+			C.row(i) = Target.row(i);
+		}
+	}
+	FSparseMatrix M(N, VarNum);
+	M.setFromTriplets(Triplets.GetData(), Triplets.GetData() + Triplets.Num());
+	const FSparseMatrix MT = M.transpose();
+
+	Triplets.Reset();
+	AddEnergy(Triplets, N, Settings);
+	FSparseMatrix Energy(N, N);
+	Energy.setFromTriplets(Triplets.GetData(), Triplets.GetData() + Triplets.Num());
+	const FSparseMatrix ReducedEnergy = MT * Energy * M;
+	Eigen::MatrixXd EnergyRhs = MT * (Energy * C);
+	EnergyRhs = -EnergyRhs;
+
+	Eigen::VectorXd Weights = Eigen::VectorXd::Zero(N);
+	for (int32 i = 0; i < N; ++i) {
+		const double Tolerance = GetTolerance(i);
+		if (Tolerance > 0.) {
+			Weights[i] = 1. / (Tolerance * Tolerance);
+		}
+	}
+
+	Eigen::MatrixXd Result;
+	for (int32 Iteration = 0; ; ++Iteration) {
+		const FSparseMatrix WeightedM = Weights.asDiagonal() * M;
+		const FSparseMatrix A = ReducedEnergy + FSparseMatrix(MT * WeightedM);
+		const Eigen::MatrixXd Rhs = EnergyRhs + MT * (Weights.asDiagonal() * (Target - C));
+		Eigen::MatrixXd X;
+		if (Settings.bUseConjugateGradient) {
+			Eigen::ConjugateGradient<FSparseMatrix, Eigen::Lower | Eigen::Upper> Solver;
+			Solver.compute(A);
+			if (Solver.info() != Eigen::Success) {
+				return false;
+			}
+			X = Solver.solve(Rhs);
+			if (Solver.info() != Eigen::Success) {
+				return false;
+			}
+		}
+		else {
+			// The bandwidth is kept by the natural ordering, so there is no fill-in.
+			Eigen::SimplicialLDLT<FSparseMatrix, Eigen::Lower, Eigen::NaturalOrdering<int> > Solver;
+			Solver.compute(A);
+			if (Solver.info() != Eigen::Success) {
+				return false;
+			}
+			X = Solver.solve(Rhs);
+		}
+		Result = M * X + C;
+
+		bool bExceeded = false;
+		for (int32 i = 0; i < N; ++i) {
+			const double Tolerance = GetTolerance(i);
+			if (Tolerance > 0. && (Result.row(i) - Target.row(i)).squaredNorm() > Tolerance * Tolerance) {
+				Weights[i] *= 16.;
+				bExceeded = true;
+			}
+		}
+		if (!bExceeded || Iteration + 1 >= Settings.MaxToleranceIterations) {
+			break;
+		}
+	}
+
+	// Clamp the free points into the tolerance, then place the dependent joints between them.
+	for (int32 i = 0; i < N; ++i) {
+		if (Variables[i] == INDEX_NONE) {
+			continue;
+		}
+		const double Tolerance = GetTolerance(i);
+		const Eigen::RowVectorXd Offset = Result.row(i) - Target.row(i);
+		const double Distance = Offset.norm();
+		if (Distance > Tolerance) {
+			Result.row(i) = Target.row(i) + Offset * (Tolerance / Distance);
+		}
+	}
+	for (int32 i = 1; i < N - 1; ++i) {
+		if (Dependent[i]) {
+			const double Lambda = GetLambda(i);
+			Result.row(i) = Lambda * Result.row(i - 1) + (1. - Lambda) * Result.row(i + 1);
+		}
+	}
+
+	for (int32 i = 0; i < N; ++i) {
+		for (int32 k = 0; k < Dim; ++k) {
+			OutPoints[i][k] = Result(i, k);
+		}
+	}
+	return true;
+}
+
+template<int32 Dim>
+inline bool TSplineFairing<Dim>::FairSpline(FSplineType& Spline, const FSettings& Settings)
+{
+	FChain Chain;
+	TArray<double> Weights;
+	TArray<bool> Joints;
+	if (!GetFlatPoints(Chain.Points, Weights, Joints, Spline)) {
+		return false;
+	}
+	const int32 N = Chain.Points.Num();
+	Chain.Tolerances.Init(Settings.PositionTolerance, N);
+	Chain.JointLambdas.Init(-1., N);
+	for (int32 i = 1; i < N - 1; ++i) {
+		if (Joints[i]) {
+			Chain.JointLambdas[i] = GetJointLambda(Chain.Points[i - 1], Chain.Points[i], Chain.Points[i + 1], Settings.CollinearTolerance);
+		}
+	}
+	if (Settings.bFixFreeEnds) {
+		Chain.Tolerances[0] = 0.;
+		Chain.Tolerances[N - 1] = 0.;
+	}
+	TArray<TVectorX<Dim> > Result;
+	if (!FairChain(Result, Chain, Settings)) {
+		return false;
+	}
+	SetFlatPoints(Spline, Result, Weights);
+	return true;
+}
+
+template<int32 Dim>
+inline int32 TSplineFairing<Dim>::FairGraph(FGraphType& Graph, const FSettings& Settings, TArray<FSplineId>* OutAffectedIds)
+{
+	if (OutAffectedIds) {
+		OutAffectedIds->Reset();
+	}
+	const int32 Capacity = Graph.GetSplineIndexCapacity();
+	auto GetSpline = [&Graph](int32 SplineIndex) { return Graph.GetSplineById(Graph.GetSplineIdByIndex(SplineIndex)); };
+
+	TArray<bool> Visited;
+	Visited.Init(false, Capacity);
+	TArray<TArray<FPiece> > ChainPieces;
+	TArray<FChain> Chains;
+	TArray<TVectorX<Dim> > Flat;
+	TArray<bool> FlatJoints;
+	TArray<bool> Joints;
+	for (int32 s = 0; s < Capacity; ++s) {
+		TSharedPtr<FSplineType> Spline = GetSpline(s);
+		if (Visited[s] || !Spline.IsValid() || !IsFairable(*Spline)) {
+			continue;
+		}
+		// Walk backward to the head of the chain. A loop is cut at the end of this spline: the walk stops at the spline after it.
+		int32 HeadEndpoint = FGraphType::MakeEndpoint(s, EContactType::Start);
+		for (int32 Step = 0; Step < Capacity; ++Step) {
+			const int32 Joined = GetJoinedEndpoint(Graph, HeadEndpoint, Settings.JoinDistance);
+			if (Joined == INDEX_NONE || FGraphType::GetEndpointSplineIndex(Joined) == s || Visited[FGraphType::GetEndpointSplineIndex(Joined)]) {
+				break;
+			}
+			HeadEndpoint = Joined ^ 1;
+		}
+
+		TArray<FPiece>& Pieces = ChainPieces.AddDefaulted_GetRef();
+		FChain& Chain = Chains.AddDefaulted_GetRef();
+		Joints.Reset();
+		int32 InEndpoint = HeadEndpoint;
+		int32 TailEndpoint = INDEX_NONE;
+		while (true) {
+			const int32 SplineIndex = FGraphType::GetEndpointSplineIndex(InEndpoint);
+			Visited[SplineIndex] = true;
+			FPiece& Piece = Pieces.AddDefaulted_GetRef();
+			Piece.SplineIndex = SplineIndex;
+			Piece.bReversed = FGraphType::GetEndpointContactType(InEndpoint) == EContactType::End;
+			GetFlatPoints(Flat, Piece.Weights, FlatJoints, *GetSpline(SplineIndex));
+			if (Piece.bReversed) {
+				Algo::Reverse(Flat);
+				Algo::Reverse(FlatJoints);
+			}
+			// The joined ends share one point.
+			const bool bJoined = Chain.Points.Num() > 0;
+			Piece.First = bJoined ? Chain.Points.Num() - 1 : 0;
+			if (bJoined) {
+				Chain.Points.Last() = (Chain.Points.Last() + Flat[0]) * 0.5;
+				Joints.Last() = true;
+			}
+			for (int32 i = bJoined ? 1 : 0; i < Flat.Num(); ++i) {
+				Chain.Points.Add(Flat[i]);
+				Joints.Add(FlatJoints[i]);
+			}
+			const int32 OutEndpoint = InEndpoint ^ 1;
+			const int32 Joined = GetJoinedEndpoint(Graph, OutEndpoint, Settings.JoinDistance);
+			if (Joined == INDEX_NONE || Visited[FGraphType::GetEndpointSplineIndex(Joined)]) {
+				TailEndpoint = OutEndpoint;
+				break;
+			}
+			InEndpoint = Joined;
+		}
+
+		const int32 N = Chain.Points.Num();
+		Chain.Tolerances.Init(Settings.PositionTolerance, N);
+		Chain.JointLambdas.Init(-1., N);
+		for (int32 i = 1; i < N - 1; ++i) {
+			if (Joints[i]) {
+				Chain.JointLambdas[i] = GetJointLambda(Chain.Points[i - 1], Chain.Points[i], Chain.Points[i + 1], Settings.CollinearTolerance);
+			}
+		}
+		// Keep the ends and the tangents at the other connections.
+		auto FixEnd = [&Graph, &Settings, &Chain, N](int32 Endpoint, int32 End, int32 Inner) {
+			if (Graph.GetAdjacentEndpoints(Endpoint).Num() > 0) {
+				Chain.Tolerances[End] = 0.;
+				if (N > 1) {
+					Chain.Tolerances[Inner] = 0.;
+				}
+			}
+			else if (Settings.bFixFreeEnds) {
+				Chain.Tolerances[End] = 0.;
+			}
+		};
+		FixEnd(HeadEndpoint, 0, 1);
+		FixEnd(TailEndpoint, N - 1, N - 2);
+	}
+
+	TArray<TArray<TVectorX<Dim> > > Results;
+	Results.SetNum(Chains.Num());
+	TArray<bool> Solved;
+	Solved.Init(false, Chains.Num());
+	ParallelFor(Chains.Num(), [&Results, &Solved, &Chains, &Settings](int32 c) {
+		Solved[c] = FairChain(Results[c], Chains[c], Settings);
+	});
+
+	TSplineGraphJournal<Dim>* Journal = Graph.GetJournal();
+	if (Journal) {
+		Journal->BeginEdit();
+	}
+	int32 ChangedNum = 0;
+	TArray<TVectorX<Dim> > PiecePoints;
+	for (int32 c = 0; c < Chains.Num(); ++c) {
+		if (!Solved[c]) {
+			continue;
+		}
+		for (const FPiece& Piece : ChainPieces[c]) {
+			const FSplineId Id = Graph.GetSplineIdByIndex(Piece.SplineIndex);
+			TSharedPtr<FSplineType> Spline = Graph.GetSplineById(Id);
+			PiecePoints.Reset();
+			PiecePoints.Append(Results[c].GetData() + Piece.First, Piece.Weights.Num());
+			if (Piece.bReversed) {
+				Algo::Reverse(PiecePoints);
+			}
+			if (Journal) {
+				Journal->TouchSpline(Id);
+			}
+			SetFlatPoints(*Spline, PiecePoints, Piece.Weights);
+			++ChangedNum;
+			if (OutAffectedIds) {
+				OutAffectedIds->Add(Id);
+			}
+		}
+	}
+	if (Journal) {
+		Journal->EndEdit();
+	}
+	return ChangedNum;
+}
+
+template<int32 Dim>
+inline bool TSplineFairing<Dim>::GetFlatPoints(TArray<TVectorX<Dim> >& OutPoints, TArray<double>& OutWeights, TArray<bool>& OutJoints, const FSplineType& Spline)
+{
+	OutPoints.Reset();
+	OutWeights.Reset();
+	OutJoints.Reset();
+	auto AddPoint = [&](const TVectorX<Dim+1>& Point, bool bJoint) {
+		OutPoints.Add(TVecLib<Dim+1>::Projection(Point));
+		OutWeights.Add(TVecLib<Dim+1>::Last(Point));
+		OutJoints.Add(bJoint);
+	};
+	TArray<TVectorX<Dim+1> > CtrlPoints;
+	switch (Spline.GetType()) {
+	case ESplineType::ClampedBSpline:
+	{
+		static_cast<const FBSplineType&>(Spline).GetCtrlPoints(CtrlPoints);
+		for (const TVectorX<Dim+1>& Point : CtrlPoints) {
+			AddPoint(Point, false);
+		}
+	}
+	break;
+	case ESplineType::BezierString:
+	{
+		const FBezierStringType& BezierString = static_cast<const FBezierStringType&>(Spline);
+		TArray<TVectorX<Dim+1> > PrevPoints, NextPoints;
+		BezierString.GetCtrlPoints(CtrlPoints);
+		BezierString.GetCtrlPointsPrev(PrevPoints);
+		BezierString.GetCtrlPointsNext(NextPoints);
+		const int32 M = CtrlPoints.Num();
+		for (int32 i = 0; i < M; ++i) {
+			if (i > 0) {
+				AddPoint(PrevPoints[i], false);
+			}
+			AddPoint(CtrlPoints[i], i > 0 && i < M - 1);
+			if (i < M - 1) {
+				AddPoint(NextPoints[i], false);
+			}
+		}
+	}
+	break;
+	default:
+		return false;
+	}
+	return OutPoints.Num() > 0;
+}
+
+template<int32 Dim>
+inline void TSplineFairing<Dim>::SetFlatPoints(FSplineType& Spline, TArrayView<const TVectorX<Dim> > Points, const TArray<double>& Weights)
+{
+	auto GetPoint = [&Points, &Weights](int32 i) { return TVecLib<Dim>::Homogeneous(Points[i], Weights[i]); };
+	switch (Spline.GetType()) {
+	case ESplineType::ClampedBSpline:
+	{
+		FBSplineType& BSpline = static_cast<FBSplineType&>(Spline);
+		int32 i = 0;
+		for (auto* Node = BSpline.FirstNode(); Node && i < Points.Num(); Node = Node->GetNextNode(), ++i) {
+			Node->GetValue().Get().Pos = GetPoint(i);
+		}
+	}
+	break;
+	case ESplineType::BezierString:
+	{
+		// P[i] is at 3i, Prev[i] at 3i - 1 and Next[i] at 3i + 1.
+		FBezierStringType& BezierString = static_cast<FBezierStringType&>(Spline);
+		const int32 M = BezierString.GetCtrlPointNum();
+		int32 i = 0;
+		for (auto* Node = BezierString.FirstNode(); Node && 3 * i < Points.Num(); Node = Node->GetNextNode(), ++i) {
+			const typename FBezierStringType::FControlPointType& Old = Node->GetValue().Get();
+			BezierString.SetCtrlPointAt(i, typename FBezierStringType::FControlPointType(
+				GetPoint(3 * i),
+				i > 0 ? GetPoint(3 * i - 1) : Old.PrevCtrlPointPos,
+				i < M - 1 ? GetPoint(3 * i + 1) : Old.NextCtrlPointPos,
+				Old.Param, Old.Continuity));
+		}
+	}
+	break;
+	}
+}
+
+template<int32 Dim>
+inline double TSplineFairing<Dim>::GetJointLambda(const TVectorX<Dim>& Prev, const TVectorX<Dim>& Joint, const TVectorX<Dim>& Next, double CollinearTolerance)
+{
+	const double ToPrev = TVecLib<Dim>::Size(Joint - Prev);
+	const double ToNext = TVecLib<Dim>::Size(Next - Joint);
+	const double Sum = ToPrev + ToNext;
+	if (Sum < KINDA_SMALL_NUMBER) {
+		return -1.;
+	}
+	const double Lambda = ToNext / Sum;
+	const TVectorX<Dim> OnSegment = Prev * Lambda + Next * (1. - Lambda);
+	return TVecLib<Dim>::SizeSquared(OnSegment - Joint) <= FMath::Square(CollinearTolerance * Sum) ? Lambda : -1.;
+}
+
+template<int32 Dim>
+inline int32 TSplineFairing<Dim>::GetJoinedEndpoint(const FGraphType& Graph, int32 Endpoint, double JoinDistance)
+{
+	TArrayView<const int32> Adjacent = Graph.GetAdjacentEndpoints(Endpoint);
+	if (Adjacent.Num() != 1) {
+		return INDEX_NONE;
+	}
+	const int32 Other = Adjacent[0];
+	const int32 SplineIndex = FGraphType::GetEndpointSplineIndex(Endpoint);
+	const int32 OtherSplineIndex = FGraphType::GetEndpointSplineIndex(Other);
+	if (OtherSplineIndex == SplineIndex || Graph.GetAdjacentEndpoints(Other).Num() != 1) {
+		return INDEX_NONE;
+	}
+	TSharedPtr<FSplineType> Spline = Graph.GetSplineById(Graph.GetSplineIdByIndex(SplineIndex));
+	TSharedPtr<FSplineType> OtherSpline = Graph.GetSplineById(Graph.GetSplineIdByIndex(OtherSplineIndex));
+	if (!Spline.IsValid() || !OtherSpline.IsValid() || !IsFairable(*Spline) || !IsFairable(*OtherSpline)) {
+		return INDEX_NONE;
+	}
+	auto GetEndPosition = [](const FSplineType& InSpline, EContactType ContactType) {
+		const TTuple<double, double> ParamRange = InSpline.GetParamRange();
+		return InSpline.GetPosition(ContactType == EContactType::End ? ParamRange.Get<1>() : ParamRange.Get<0>());
+	};
+	const TVectorX<Dim> Position = GetEndPosition(*Spline, FGraphType::GetEndpointContactType(Endpoint));
+	const TVectorX<Dim> OtherPosition = GetEndPosition(*OtherSpline, FGraphType::GetEndpointContactType(Other));
+	return TVecLib<Dim>::SizeSquared(Position - OtherPosition) <= JoinDistance * JoinDistance ? Other : INDEX_NONE;
+}
+
+template<int32 Dim>
+inline bool TSplineFairing<Dim>::IsFairable(const FSplineType& Spline)
+{
+	return Spline.GetType() == ESplineType::ClampedBSpline || Spline.GetType() == ESplineType::BezierString;
+}
+
+template<int32 Dim>
+inline void TSplineFairing<Dim>::AddEnergy(TArray<FTriplet>& OutTriplets, int32 PointNum, const FSettings& Settings)
+{
+	static const double Third[4] = { -1., 3., -3., 1. };
+	static const double Second[3] = { 1., -2., 1. };
+	if (Settings.VariationWeight > 0.) {
+		for (int32 i = 0; i + 3 < PointNum; ++i) {
+			for (int32 a = 0; a < 4; ++a) {
+				for (int32 b = 0; b < 4; ++b) {
+					OutTriplets.Add(FTriplet(i + a, i + b, Settings.VariationWeight * Third[a] * Third[b]));
+				}
+			}
+		}
+	}
+	if (Settings.BendingWeight > 0.) {
+		for (int32 i = 0; i + 2 < PointNum; ++i) {
+			for (int32 a = 0; a < 3; ++a) {
+				for (int32 b = 0; b < 3; ++b) {
+					OutTriplets.Add(FTriplet(i + a, i + b, Settings.BendingWeight * Second[a] * Second[b]));
+				}
+			}
+		}
+	}
+}
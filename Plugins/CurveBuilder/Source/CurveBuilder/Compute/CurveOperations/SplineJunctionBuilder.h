@@ -0,0 +1,123 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Splines/SplineGraph.h"
+#include "Splines/SplineGraphBVH.h"
+#include "Splines/SplineArcLengthTable.h"
+
+// Junctions at the crossings of splines in the middle, e.g. for road networks.
+// The candidate pairs of segments are from the segment BVH, and each pair is intersected by subdivision
+// of the control hulls with a Gauss-Newton refinement, in parallel over the segments.
+// The splines are split at the crossings, and the arms are connected to each other. With a fillet radius,
+// the arms are split again at the setbacks, and a G1 or G2 bezier fillet connects each pair of neighboring arms.
+// The fillets are solved in parallel over the junctions. The graph is only modified on the calling thread.
+// The BVH is F_Box3, so only Dim 3 is supported.
+template<int32 Dim>
+class TSplineJunctionBuilder
+{
+public:
+	static_assert(Dim == 3, "The segment BVH is F_Box3.");
+
+	using FGraphType = typename TSplineGraph<Dim, 3>;
+	using FSplineType = typename FGraphType::FSplineType;
+	using FSplineId = typename FGraphType::FSplineId;
+	using FCurveType = typename TBezierCurve<Dim, 3>;
+	using FBVHType = typename TSplineGraphBVH<Dim>;
+	using FTableType = typename TSplineArcLengthTable<Dim, 3>;
+	using FBezierStringType = typename TSplineTraitByType<ESplineType::BezierString, Dim, 3>::FSplineType;
+
+	struct FSettings
+	{
+		// Max distance between two splines to be taken as crossing.
+		double IntersectionTolerance = 1.;
+		// Radius of the fillets as circular arcs between straight arms. No fillet if not positive.
+		double FilletRadius = 0.;
+		// 1 for G1 fillets. 2 for G2 fillets, matching the curvature of the arms if possible.
+		int32 FilletContinuity = 1;
+		// Max setback on an arm, by the length of the arm.
+		double MaxSetbackRatio = 0.45;
+		// No fillet between the arms nearly overlapping or nearly opposite.
+		double MinFilletAngleDegrees = 5.;
+		int32 MaxSubdivisionDepth = 24;
+	};
+
+	struct FIntersection
+	{
+		FSplineId Ids[2];
+		double Params[2] = { 0., 0. };
+		TVectorX<Dim> Position;
+	};
+
+	struct FJunction
+	{
+		TVectorX<Dim> Position;
+		// Splines from the junction, in the order around it if there are fillets.
+		TArray<FSplineId> Arms;
+		TArray<FSplineId> Fillets;
+	};
+
+public:
+	// Crossings between different splines. The crossings at the ends of both splines are skipped.
+	static int32 FindIntersections(TArray<FIntersection>& OutIntersections, const FGraphType& Graph, const FBVHType& BVH, const FSettings& Settings);
+
+	// Parameters of the closest points of the curves in [0, 1] within the tolerance.
+	static void IntersectCurves(TArray<TTuple<double, double> >& OutParams, const FCurveType& First, const FCurveType& Second, double Tolerance, int32 MaxDepth);
+
+	// Find the crossings, split the splines, then add the fillets. The BVH is updated.
+	// It is one step of the journal of the graph if attached. Return the number of junctions.
+	static int32 BuildJunctions(TArray<FJunction>& OutJunctions, FGraphType& Graph, FBVHType& BVH, const FSettings& Settings);
+
+	// Replace the spline by the pieces split at the sorted parameters, connected one by one.
+	// The connections at the ends of the spline are moved to the first and the last pieces.
+	static void SplitSpline(TArray<TWeakPtr<FSplineType> >& OutPieces, FGraphType& Graph, const FSplineId& Id, const TArray<double>& SortedParams);
+
+protected:
+	// Spline from a junction.
+	struct FArm
+	{
+		TSharedPtr<FSplineType> Spline;
+		// The end at the junction.
+		EContactType ContactType = EContactType::Start;
+		// From the original spline, so the arms of the same spline are not connected again.
+		int32 SourceIndex = INDEX_NONE;
+		// Filled by SolveFillets().
+		TVectorX<Dim> Direction;
+		double Angle = 0.;
+		double Setback = 0.;
+		// Parameter of the arm at the setback.
+		double SetbackParam = 0.;
+		// Pieces of the arm split at the setback, near to and far from the junction.
+		TWeakPtr<FSplineType> Inner;
+		TWeakPtr<FSplineType> Outer;
+	};
+
+	struct FFillet
+	{
+		int32 Arms[2] = { INDEX_NONE, INDEX_NONE };
+		TVectorX<Dim> Points[4];
+	};
+
+	struct FJunctionBuild
+	{
+		TVectorX<Dim> Position;
+		TArray<FArm> Arms;
+		TArray<FFillet> Fillets;
+	};
+
+	static void SolveFillets(FJunctionBuild& Junction, const FSettings& Settings);
+
+	// Cubic from A toward the junction along TangentA, to B away from the junction along TangentB.
+	static void MakeFillet(FFillet& OutFillet, const TVectorX<Dim>& A, const TVectorX<Dim>& TangentA, const TVectorX<Dim>& CurvatureA,
+		const TVectorX<Dim>& B, const TVectorX<Dim>& TangentB, const TVectorX<Dim>& CurvatureB, int32 Continuity);
+
+	// Unit tangent along the spline and the curvature vector, at the length.
+	static void GetFrameAtLength(TVectorX<Dim>& OutPosition, TVectorX<Dim>& OutTangent, TVectorX<Dim>& OutCurvature, const FTableType& Table, double S);
+
+	// Within the tolerance of an end of the spline, which is output.
+	static bool IsNearEnd(EContactType& OutContactType, const FSplineType& Spline, double Param, double Tolerance);
+};
+
+#include "SplineJunctionBuilder.inl"
@@ -0,0 +1,667 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "SplineJunctionBuilder.h"
+#include "Async/ParallelFor.h"
+#include "Algo/Reverse.h"
+
+template<int32 Dim>
+inline int32 TSplineJunctionBuilder<Dim>::FindIntersections(TArray<FIntersection>& OutIntersections, const FGraphType& Graph, const FBVHType& BVH, const FSettings& Settings)
+{
+	OutIntersections.Reset();
+	const double Tolerance = Settings.IntersectionTolerance;
+	const int32 SegmentNum = BVH.GetSegmentCapacity();
+	TArray<TArray<FIntersection> > Found;
+	Found.SetNum(SegmentNum);
+	ParallelFor(SegmentNum, [&BVH, &Found, &Settings, Tolerance](int32 i) {
+		const auto& Segment = BVH.GetSegment(i);
+		if (!Segment.IsAlive()) {
+			return;
+		}
+		TArray<int32> Candidates;
+		TArray<TTuple<double, double> > Params;
+		BVH.QueryBox(Candidates, Segment.Box.ExpandBy(Tolerance));
+		for (int32 j : Candidates) {
+			// Each pair once, and only between different splines.
+			const auto& Other = BVH.GetSegment(j);
+			if (j <= i || Other.SplineId.Index == Segment.SplineId.Index) {
+				continue;
+			}
+			IntersectCurves(Params, Segment.Curve, Other.Curve, Tolerance, Settings.MaxSubdivisionDepth);
+			for (const TTuple<double, double>& Param : Params) {
+				FIntersection& Intersection = Found[i].AddDefaulted_GetRef();
+				Intersection.Ids[0] = Segment.SplineId;
+				Intersection.Ids[1] = Other.SplineId;
+				Intersection.Params[0] = Segment.GetSplineParam(Param.Get<0>());
+				Intersection.Params[1] = Other.GetSplineParam(Param.Get<1>());
+				Intersection.Position = (Segment.Curve.GetPosition(Param.Get<0>()) + Other.Curve.GetPosition(Param.Get<1>())) * 0.5;
+			}
+		}
+	});
+
+	// The crossings at the joints of segments are found twice.
+	TMap<uint64, TArray<int32, TInlineAllocator<2> > > IntersectionsByPair;
+	for (TArray<FIntersection>& FoundOfSegment : Found) {
+		for (FIntersection& Intersection : FoundOfSegment) {
+			if (Intersection.Ids[0].Index > Intersection.Ids[1].Index) {
+				Swap(Intersection.Ids[0], Intersection.Ids[1]);
+				Swap(Intersection.Params[0], Intersection.Params[1]);
+			}
+			TSharedPtr<FSplineType> Splines[2] = { Graph.GetSplineById(Intersection.Ids[0]), Graph.GetSplineById(Intersection.Ids[1]) };
+			EContactType ContactType;
+			if (!Splines[0].IsValid() || !Splines[1].IsValid()
+				|| (IsNearEnd(ContactType, *Splines[0], Intersection.Params[0], Tolerance) && IsNearEnd(ContactType, *Splines[1], Intersection.Params[1], Tolerance))) {
+				continue;
+			}
+			const uint64 Key = (static_cast<uint64>(Intersection.Ids[0].Index) << 32) | static_cast<uint32>(Intersection.Ids[1].Index);
+			auto& Indices = IntersectionsByPair.FindOrAdd(Key);
+			const bool bDuplicated = Indices.ContainsByPredicate([&](int32 Index) {
+				return TVecLib<Dim>::SizeSquared(OutIntersections[Index].Position - Intersection.Position) <= Tolerance * Tolerance;
+			});
+			if (!bDuplicated) {
+				Indices.Add(OutIntersections.Add(Intersection));
+			}
+		}
+	}
+	return OutIntersections.Num();
+}
+
+template<int32 Dim>
+inline void TSplineJunctionBuilder<Dim>::IntersectCurves(TArray<TTuple<double, double> >& OutParams, const FCurveType& First, const FCurveType& Second, double Tolerance, int32 MaxDepth)
+{
+	OutParams.Reset();
+	struct FPiece
+	{
+		FCurveType Curve;
+		double Begin = 0.;
+		double End = 1.;
+	};
+	struct FPair
+	{
+		FPiece Pieces[2];
+		int32 Depth = 0;
+	};
+	// Enough for curves overlapping along a length.
+	constexpr int32 MaxCandidates = 64;
+	const double HalfTolerance = Tolerance * 0.5;
+
+	// Subdivide the pairs of which the control hulls overlap, until both are within the tolerance.
+	TArray<TTuple<double, double>, TInlineAllocator<8> > Candidates;
+	TArray<FPair, TInlineAllocator<32> > Stack;
+	Stack.Add(FPair{ { FPiece{ First, 0., 1. }, FPiece{ Second, 0., 1. } }, 0 });
+	while (Stack.Num() > 0 && Candidates.Num() < MaxCandidates) {
+		const FPair Pair = Stack.Pop(false);
+		const F_Box3 Boxes[2] = { Pair.Pieces[0].Curve.GetBox(), Pair.Pieces[1].Curve.GetBox() };
+		if (!Boxes[0].ExpandBy(HalfTolerance).Intersect(Boxes[1].ExpandBy(HalfTolerance))) {
+			continue;
+		}
+		const bool bSmall[2] = { Boxes[0].GetSize().GetMax() <= Tolerance, Boxes[1].GetSize().GetMax() <= Tolerance };
+		if ((bSmall[0] && bSmall[1]) || Pair.Depth >= MaxDepth) {
+			Candidates.Add(MakeTuple((Pair.Pieces[0].Begin + Pair.Pieces[0].End) * 0.5, (Pair.Pieces[1].Begin + Pair.Pieces[1].End) * 0.5));
+			continue;
+		}
+		TArray<FPiece, TInlineAllocator<2> > Halves[2];
+		for (int32 k = 0; k < 2; ++k) {
+			const FPiece& Piece = Pair.Pieces[k];
+			if (bSmall[k]) {
+				Halves[k].Add(Piece);
+				continue;
+			}
+			const double Mid = (Piece.Begin + Piece.End) * 0.5;
+			FPiece& Left = Halves[k].AddDefaulted_GetRef();
+			FPiece& Right = Halves[k].AddDefaulted_GetRef();
+			Piece.Curve.Split(Left.Curve, Right.Curve, 0.5);
+			Left.Begin = Piece.Begin;
+			Left.End = Mid;
+			Right.Begin = Mid;
+			Right.End = Piece.End;
+		}
+		for (const FPiece& A : Halves[0]) {
+			for (const FPiece& B : Halves[1]) {
+				Stack.Add(FPair{ { A, B }, Pair.Depth + 1 });
+			}
+		}
+	}
+
+	// Gauss-Newton on the squared distance, then merge the candidates converging to the same point.
+	const double ToleranceSqr = Tolerance * Tolerance;
+	for (const TTuple<double, double>& Candidate : Candidates) {
+		double S = Candidate.Get<0>(), T = Candidate.Get<1>();
+		for (int32 Iteration = 0; Iteration < 8; ++Iteration) {
+			const TVectorX<Dim> F = First.GetPosition(S) - Second.GetPosition(T);
+			const TVectorX<Dim> DA = First.GetTangent(S);
+			const TVectorX<Dim> DB = Second.GetTangent(T);
+			const double AA = TVecLib<Dim>::Dot(DA, DA), AB = -TVecLib<Dim>::Dot(DA, DB), BB = TVecLib<Dim>::Dot(DB, DB);
+			const double RA = -TVecLib<Dim>::Dot(DA, F), RB = TVecLib<Dim>::Dot(DB, F);
+			const double Det = AA * BB - AB * AB;
+			if (FMath::Abs(Det) < SMALL_NUMBER) {
+				break;
+			}
+			const double DS = (RA * BB - AB * RB) / Det;
+			const double DT = (AA * RB - AB * RA) / Det;
+			S = FMath::Clamp(S + DS, 0., 1.);
+			T = FMath::Clamp(T + DT, 0., 1.);
+			if (FMath::Abs(DS) + FMath::Abs(DT) < 1.e-9) {
+				break;
+			}
+		}
+		const TVectorX<Dim> Position = First.GetPosition(S);
+		if (TVecLib<Dim>::SizeSquared(Position - Second.GetPosition(T)) > ToleranceSqr) {
+			continue;
+		}
+		const bool bDuplicated = OutParams.ContainsByPredicate([&](const TTuple<double, double>& Param) {
+			return TVecLib<Dim>::SizeSquared(First.GetPosition(Param.Get<0>()) - Position) <= ToleranceSqr;
+		});
+		if (!bDuplicated) {
+			OutParams.Add(MakeTuple(S, T));
+		}
+	}
+}
+
+template<int32 Dim>
+inline int32 TSplineJunctionBuilder<Dim>::BuildJunctions(TArray<FJunction>& OutJunctions, FGraphType& Graph, FBVHType& BVH, const FSettings& Settings)
+{
+	OutJunctions.Reset();
+	const double Tolerance = Settings.IntersectionTolerance;
+	BVH.Update(Graph);
+	TArray<FIntersection> Intersections;
+	if (FindIntersections(Intersections, Graph, BVH, Settings) == 0) {
+		return 0;
+	}
+
+	TSplineGraphJournal<Dim>* Journal = Graph.GetJournal();
+	if (Journal) {
+		Journal->BeginEdit();
+	}
+
+	// Crossings at the same point are one junction.
+	TArray<int32> Parents;
+	for (int32 k = 0; k < Intersections.Num(); ++k) {
+		Parents.Add(k);
+	}
+	auto FindRoot = [&Parents](int32 k) {
+		while (Parents[k] != k) {
+			k = Parents[k] = Parents[Parents[k]];
+		}
+		return k;
+	};
+
+	// Arm by the original spline, the index of the piece, and the end at the junction.
+	using FArmRef = TTuple<int32, int32, EContactType>;
+	TArray<TArray<FArmRef, TInlineAllocator<4> > > ArmRefs;
+	ArmRefs.SetNum(Intersections.Num());
+	TMap<int32, TArray<TTuple<double, int32> > > CrossingsBySpline;
+	TArray<TTuple<int32, int32, EContactType> > EndArms;
+	for (int32 k = 0; k < Intersections.Num(); ++k) {
+		const FIntersection& Intersection = Intersections[k];
+		for (int32 Side = 0; Side < 2; ++Side) {
+			const FSplineId& Id = Intersection.Ids[Side];
+			EContactType ContactType;
+			if (IsNearEnd(ContactType, *Graph.GetSplineById(Id), Intersection.Params[Side], Tolerance)) {
+				EndArms.Add(MakeTuple(k, Id.Index, ContactType));
+				CrossingsBySpline.FindOrAdd(Id.Index);
+			}
+			else {
+				CrossingsBySpline.FindOrAdd(Id.Index).Add(MakeTuple(Intersection.Params[Side], k));
+			}
+		}
+	}
+
+	// Split each spline once at all of its crossings.
+	TMap<int32, TArray<TWeakPtr<FSplineType> > > PiecesBySpline;
+	TArray<double> SplitParams;
+	for (TPair<int32, TArray<TTuple<double, int32> > >& Pair : CrossingsBySpline) {
+		const FSplineId Id = Graph.GetSplineIdByIndex(Pair.Key);
+		TSharedPtr<FSplineType> Spline = Graph.GetSplineById(Id);
+		TArray<TTuple<double, int32> >& Crossings = Pair.Value;
+		Crossings.Sort([](const TTuple<double, int32>& A, const TTuple<double, int32>& B) { return A.Get<0>() < B.Get<0>(); });
+		SplitParams.Reset();
+		TArray<int32> Groups;
+		TVectorX<Dim> LastPosition = TVecLib<Dim>::Zero();
+		for (const TTuple<double, int32>& Crossing : Crossings) {
+			const TVectorX<Dim> Position = Spline->GetPosition(Crossing.Get<0>());
+			if (SplitParams.Num() > 0 && TVecLib<Dim>::SizeSquared(Position - LastPosition) <= Tolerance * Tolerance) {
+				Parents[FindRoot(Crossing.Get<1>())] = FindRoot(Crossings[Groups.IndexOfByKey(SplitParams.Num() - 1)].Get<1>());
+			}
+			else {
+				SplitParams.Add(Crossing.Get<0>());
+				LastPosition = Position;
+			}
+			Groups.Add(SplitParams.Num() - 1);
+		}
+		TArray<TWeakPtr<FSplineType> >& Pieces = PiecesBySpline.Add(Pair.Key);
+		if (SplitParams.Num() == 0) {
+			Pieces.Add(Spline);
+			continue;
+		}
+		SplitSpline(Pieces, Graph, Id, SplitParams);
+		if (Pieces.Num() != SplitParams.Num() + 1) {
+			// Not split, so only the ends of the spline can be arms.
+			Pieces.Reset();
+			Pieces.Add(Spline);
+			continue;
+		}
+		for (int32 c = 0; c < Crossings.Num(); ++c) {
+			ArmRefs[Crossings[c].Get<1>()].AddUnique(FArmRef(Pair.Key, Groups[c], EContactType::End));
+			ArmRefs[Crossings[c].Get<1>()].AddUnique(FArmRef(Pair.Key, Groups[c] + 1, EContactType::Start));
+		}
+	}
+	for (const TTuple<int32, int32, EContactType>& EndArm : EndArms) {
+		const TArray<TWeakPtr<FSplineType> >& Pieces = PiecesBySpline[EndArm.Get<1>()];
+		ArmRefs[EndArm.Get<0>()].AddUnique(FArmRef(EndArm.Get<1>(), EndArm.Get<2>() == EContactType::Start ? 0 : Pieces.Num() - 1, EndArm.Get<2>()));
+	}
+
+	// Gather the arms of each junction, and connect the arms from different splines at the junction.
+	TArray<FJunctionBuild> Builds;
+	TArray<int32> BuildIndices;
+	BuildIndices.Init(INDEX_NONE, Intersections.Num());
+	TArray<TArray<FArmRef, TInlineAllocator<4> > > BuildArmRefs;
+	for (int32 k = 0; k < Intersections.Num(); ++k) {
+		const int32 Root = FindRoot(k);
+		if (BuildIndices[Root] == INDEX_NONE) {
+			BuildIndices[Root] = Builds.Num();
+			Builds.AddDefaulted_GetRef().Position = Intersections[Root].Position;
+			BuildArmRefs.AddDefaulted();
+		}
+		for (const FArmRef& ArmRef : ArmRefs[k]) {
+			BuildArmRefs[BuildIndices[Root]].AddUnique(ArmRef);
+		}
+	}
+	for (int32 b = 0; b < Builds.Num(); ++b) {
+		FJunctionBuild& Build = Builds[b];
+		for (const FArmRef& ArmRef : BuildArmRefs[b]) {
+			const TArray<TWeakPtr<FSplineType> >& Pieces = PiecesBySpline[ArmRef.Get<0>()];
+			if (!Pieces.IsValidIndex(ArmRef.Get<1>()) || !Pieces[ArmRef.Get<1>()].IsValid()) {
+				continue;
+			}
+			FArm& Arm = Build.Arms.AddDefaulted_GetRef();
+			Arm.Spline = Pieces[ArmRef.Get<1>()].Pin();
+			Arm.ContactType = ArmRef.Get<2>();
+			Arm.SourceIndex = ArmRef.Get<0>();
+			Arm.Inner = Arm.Spline;
+		}
+		for (int32 i = 0; i < Build.Arms.Num(); ++i) {
+			for (int32 j = i + 1; j < Build.Arms.Num(); ++j) {
+				if (Build.Arms[i].SourceIndex != Build.Arms[j].SourceIndex) {
+					Graph.VirtualConnect(Build.Arms[i].Spline, Build.Arms[j].Spline, Build.Arms[i].ContactType, Build.Arms[j].ContactType);
+				}
+			}
+		}
+	}
+
+	if (Settings.FilletRadius > 0.) {
+		ParallelFor(Builds.Num(), [&Builds, &Settings](int32 b) {
+			SolveFillets(Builds[b], Settings);
+		});
+
+		// Split the arms at the setbacks. An arm may be from two junctions, so it is split at both ends at once.
+		TMap<const FSplineType*, TArray<TTuple<int32, int32> > > ArmsBySpline;
+		for (int32 b = 0; b < Builds.Num(); ++b) {
+			for (int32 a = 0; a < Builds[b].Arms.Num(); ++a) {
+				ArmsBySpline.FindOrAdd(Builds[b].Arms[a].Spline.Get()).Add(MakeTuple(b, a));
+			}
+		}
+		TArray<TWeakPtr<FSplineType> > Pieces;
+		for (const TPair<const FSplineType*, TArray<TTuple<int32, int32> > >& Pair : ArmsBySpline) {
+			FArm* StartArm = nullptr;
+			FArm* EndArm = nullptr;
+			for (const TTuple<int32, int32>& Ref : Pair.Value) {
+				FArm& Arm = Builds[Ref.Get<0>()].Arms[Ref.Get<1>()];
+				(Arm.ContactType == EContactType::Start ? StartArm : EndArm) = &Arm;
+			}
+			SplitParams.Reset();
+			if (StartArm && StartArm->Setback > 0.) {
+				SplitParams.Add(StartArm->SetbackParam);
+			}
+			if (EndArm && EndArm->Setback > 0.) {
+				SplitParams.Add(EndArm->SetbackParam);
+			}
+			if (SplitParams.Num() == 0) {
+				continue;
+			}
+			SplitParams.Sort();
+			SplitSpline(Pieces, Graph, Graph.GetSplineId(Pair.Key), SplitParams);
+			if (Pieces.Num() != SplitParams.Num() + 1) {
+				// Not split, so no fillet at the arms.
+				for (FArm* Arm : { StartArm, EndArm }) {
+					if (Arm) {
+						Arm->Setback = 0.;
+					}
+				}
+				continue;
+			}
+			if (StartArm) {
+				StartArm->Inner = Pieces[0];
+				StartArm->Outer = StartArm->Setback > 0. ? Pieces[1] : nullptr;
+			}
+			if (EndArm) {
+				EndArm->Inner = Pieces.Last();
+				EndArm->Outer = EndArm->Setback > 0. ? Pieces.Last(1) : nullptr;
+			}
+		}
+	}
+
+	for (FJunctionBuild& Build : Builds) {
+		FJunction& Junction = OutJunctions.AddDefaulted_GetRef();
+		Junction.Position = Build.Position;
+		for (const FArm& Arm : Build.Arms) {
+			Junction.Arms.Add(Graph.GetSplineId(Arm.Inner));
+		}
+		for (const FFillet& Fillet : Build.Fillets) {
+			const FArm& ArmA = Build.Arms[Fillet.Arms[0]];
+			const FArm& ArmB = Build.Arms[Fillet.Arms[1]];
+			if (ArmA.Setback <= 0. || ArmB.Setback <= 0.) {
+				continue;
+			}
+			FCurveType Curve;
+			for (int32 i = 0; i < 4; ++i) {
+				Curve.SetPoint(i, Fillet.Points[i], 1.);
+			}
+			TWeakPtr<FSplineType> FilletSpline = Graph.AddSplineToGraph(MakeShareable(new FBezierStringType(TArray<FCurveType>{ Curve })));
+			// The inner piece ends at the setback on the far side from the junction, and the outer piece starts there.
+			auto ConnectToArm = [&Graph, &FilletSpline](const FArm& Arm, EContactType FilletContactType) {
+				const bool bStartAtJunction = Arm.ContactType == EContactType::Start;
+				Graph.VirtualConnect(FilletSpline, Arm.Inner, FilletContactType, bStartAtJunction ? EContactType::End : EContactType::Start);
+				Graph.VirtualConnect(FilletSpline, Arm.Outer, FilletContactType, bStartAtJunction ? EContactType::Start : EContactType::End);
+			};
+			ConnectToArm(ArmA, EContactType::Start);
+			ConnectToArm(ArmB, EContactType::End);
+			Junction.Fillets.Add(Graph.GetSplineId(FilletSpline));
+		}
+	}
+
+	if (Journal) {
+		Journal->EndEdit();
+	}
+	BVH.Update(Graph);
+	return OutJunctions.Num();
+}
+
+template<int32 Dim>
+inline void TSplineJunctionBuilder<Dim>::SplitSpline(TArray<TWeakPtr<FSplineType> >& OutPieces, FGraphType& Graph, const FSplineId& Id, const TArray<double>& SortedParams)
+{
+	OutPieces.Reset();
+	TSharedPtr<FSplineType> Spline = Graph.GetSplineById(Id);
+	if (!Spline.IsValid()) {
+		return;
+	}
+
+	auto SplitOnce = [](TSharedPtr<FSplineType>& OutFirst, TSharedPtr<FSplineType>& OutSecond, const FSplineType& InSpline, double T) {
+		switch (InSpline.GetType()) {
+		case ESplineType::ClampedBSpline:
+		{
+			using FBSplineType = typename TSplineTraitByType<ESplineType::ClampedBSpline, Dim, 3>::FSplineType;
+			TSharedPtr<FBSplineType> First = MakeShareable(new FBSplineType());
+			TSharedPtr<FBSplineType> Second = MakeShareable(new FBSplineType());
+			static_cast<const FBSplineType&>(InSpline).Split(*First, *Second, T);
+			OutFirst = First;
+			OutSecond = Second;
+		}
+		break;
+		case ESplineType::BezierString:
+		{
+			TSharedPtr<FBezierStringType> First = MakeShareable(new FBezierStringType());
+			TSharedPtr<FBezierStringType> Second = MakeShareable(new FBezierStringType());
+			static_cast<const FBezierStringType&>(InSpline).Split(*First, *Second, T);
+			OutFirst = First;
+			OutSecond = Second;
+		}
+		break;
+		default:
+			return false;
+		}
+		return OutFirst->GetCtrlPointNum() >= 2 && OutSecond->GetCtrlPointNum() >= 2;
+	};
+
+	// From the last parameter, so the rest is always the first piece. The parameters of the first piece
+	// may be changed by the split, so they are found again by the positions.
+	TArray<TVectorX<Dim> > Positions;
+	for (double Param : SortedParams) {
+		Positions.Add(Spline->GetPosition(Param));
+	}
+	TArray<TSharedPtr<FSplineType> > Pieces;
+	TSharedPtr<FSplineType> Rest = Spline;
+	for (int32 i = SortedParams.Num() - 1; i >= 0; --i) {
+		double T = SortedParams[i];
+		if (Rest != Spline && !Rest->FindParamByPosition(T, Positions[i])) {
+			return;
+		}
+		TSharedPtr<FSplineType> First, Second;
+		if (!SplitOnce(First, Second, *Rest, T)) {
+			return;
+		}
+		Pieces.Add(Second);
+		Rest = First;
+	}
+	Pieces.Add(Rest);
+	Algo::Reverse(Pieces);
+
+	// The connections at the ends, before the spline is removed. A connection to the spline itself is to the other piece.
+	TArray<TTuple<TWeakPtr<FSplineType>, EContactType> > EndLinks[2];
+	for (int32 End = 0; End < 2; ++End) {
+		for (int32 Endpoint : Graph.GetAdjacentEndpoints(FGraphType::MakeEndpoint(Id.Index, End == 0 ? EContactType::Start : EContactType::End))) {
+			const int32 SplineIndex = FGraphType::GetEndpointSplineIndex(Endpoint);
+			const EContactType ContactType = FGraphType::GetEndpointContactType(Endpoint);
+			TWeakPtr<FSplineType> Target = SplineIndex == Id.Index
+				? TWeakPtr<FSplineType>(ContactType == EContactType::Start ? Pieces[0] : Pieces.Last())
+				: TWeakPtr<FSplineType>(Graph.GetSplineById(Graph.GetSplineIdByIndex(SplineIndex)));
+			EndLinks[End].Add(MakeTuple(Target, ContactType));
+		}
+	}
+
+	Graph.DeleteSpline(Spline);
+	for (const TSharedPtr<FSplineType>& Piece : Pieces) {
+		OutPieces.Add(Graph.AddSplineToGraph(Piece));
+	}
+	for (int32 i = 0; i + 1 < OutPieces.Num(); ++i) {
+		Graph.VirtualConnect(OutPieces[i], OutPieces[i + 1], EContactType::End, EContactType::Start);
+	}
+	for (const TTuple<TWeakPtr<FSplineType>, EContactType>& Link : EndLinks[0]) {
+		Graph.VirtualConnect(OutPieces[0], Link.Get<0>(), EContactType::Start, Link.Get<1>());
+	}
+	for (const TTuple<TWeakPtr<FSplineType>, EContactType>& Link : EndLinks[1]) {
+		// A link from the end to the start of the spline itself is added from the start already.
+		if (Link.Get<0>() != OutPieces[0] || Link.Get<1>() != EContactType::Start) {
+			Graph.VirtualConnect(OutPieces.Last(), Link.Get<0>(), EContactType::End, Link.Get<1>());
+		}
+	}
+}
+
+template<int32 Dim>
+inline void TSplineJunctionBuilder<Dim>::SolveFillets(FJunctionBuild& Junction, const FSettings& Settings)
+{
+	TArray<FArm>& Arms = Junction.Arms;
+	const int32 ArmNum = Arms.Num();
+	if (ArmNum < 2) {
+		return;
+	}
+
+	// Directions of the arms from the junction.
+	TArray<FTableType> Tables;
+	Tables.SetNum(ArmNum);
+	TVectorX<Dim> Position, Tangent, Curvature;
+	for (int32 a = 0; a < ArmNum; ++a) {
+		FArm& Arm = Arms[a];
+		Tables[a].Build(*Arm.Spline);
+		const bool bStartAtJunction = Arm.ContactType == EContactType::Start;
+		GetFrameAtLength(Position, Tangent, Curvature, Tables[a], bStartAtJunction ? 0. : Tables[a].GetTotalLength());
+		Arm.Direction = bStartAtJunction ? Tangent : -Tangent;
+	}
+
+	// Plane of the junction by the two arms most apart, and the angles of the arms in it.
+	TVectorX<Dim> Normal = TVecLib<Dim>::Zero();
+	for (int32 i = 0; i < ArmNum; ++i) {
+		for (int32 j = i + 1; j < ArmNum; ++j) {
+			const TVectorX<Dim> Cross = Arms[i].Direction ^ Arms[j].Direction;
+			if (TVecLib<Dim>::SizeSquared(Cross) > TVecLib<Dim>::SizeSquared(Normal)) {
+				Normal = Cross;
+			}
+		}
+	}
+	if (TVecLib<Dim>::SizeSquared(Normal) < KINDA_SMALL_NUMBER) {
+		return;
+	}
+	Normal = Normal / TVecLib<Dim>::Size(Normal);
+	TVectorX<Dim> AxisU = Arms[0].Direction - Normal * TVecLib<Dim>::Dot(Arms[0].Direction, Normal);
+	AxisU = AxisU / TVecLib<Dim>::Size(AxisU);
+	const TVectorX<Dim> AxisV = Normal ^ AxisU;
+	for (FArm& Arm : Arms) {
+		Arm.Angle = FMath::Atan2(TVecLib<Dim>::Dot(Arm.Direction, AxisV), TVecLib<Dim>::Dot(Arm.Direction, AxisU));
+		if (Arm.Angle < 0.) {
+			Arm.Angle += 2. * PI;
+		}
+	}
+	TArray<int32> Order;
+	for (int32 a = 0; a < ArmNum; ++a) {
+		Order.Add(a);
+	}
+	Order.Sort([&Arms](int32 A, int32 B) { return Arms[A].Angle < Arms[B].Angle; });
+	{
+		TArray<FArm> SortedArms;
+		TArray<FTableType> SortedTables;
+		for (int32 a : Order) {
+			SortedArms.Add(MoveTemp(Arms[a]));
+			SortedTables.Add(MoveTemp(Tables[a]));
+		}
+		Arms = MoveTemp(SortedArms);
+		Tables = MoveTemp(SortedTables);
+	}
+
+	// Setback of a circular arc of the radius between straight arms, r / tan(theta / 2). Each arm takes
+	// the larger one of its two sides, limited by its length.
+	const double MinAngle = FMath::DegreesToRadians(Settings.MinFilletAngleDegrees);
+	TArray<int32> FilletArms;
+	for (int32 i = 0; i < ArmNum; ++i) {
+		const int32 j = (i + 1) % ArmNum;
+		double Theta = Arms[j].Angle - Arms[i].Angle;
+		if (Theta < 0.) {
+			Theta += 2. * PI;
+		}
+		if (Theta <= MinAngle || Theta >= PI - MinAngle) {
+			continue;
+		}
+		const double Setback = Settings.FilletRadius / FMath::Tan(Theta * 0.5);
+		Arms[i].Setback = FMath::Max(Arms[i].Setback, Setback);
+		Arms[j].Setback = FMath::Max(Arms[j].Setback, Setback);
+		FilletArms.Add(i);
+	}
+	for (int32 a = 0; a < ArmNum; ++a) {
+		FArm& Arm = Arms[a];
+		const double Length = Tables[a].GetTotalLength();
+		Arm.Setback = FMath::Min(Arm.Setback, Length * Settings.MaxSetbackRatio);
+		if (Arm.Setback <= KINDA_SMALL_NUMBER) {
+			Arm.Setback = 0.;
+			continue;
+		}
+		const double S = Arm.ContactType == EContactType::Start ? Arm.Setback : Length - Arm.Setback;
+		Arm.SetbackParam = Tables[a].GetParameterAtLength(S);
+	}
+
+	// From the arm toward the junction, to the next arm away from the junction.
+	TVectorX<Dim> Positions[2], Tangents[2], Curvatures[2];
+	for (int32 i : FilletArms) {
+		const int32 Pair[2] = { i, (i + 1) % ArmNum };
+		if (Arms[Pair[0]].Setback <= 0. || Arms[Pair[1]].Setback <= 0.) {
+			continue;
+		}
+		for (int32 k = 0; k < 2; ++k) {
+			const FArm& Arm = Arms[Pair[k]];
+			const bool bStartAtJunction = Arm.ContactType == EContactType::Start;
+			const double Length = Tables[Pair[k]].GetTotalLength();
+			GetFrameAtLength(Positions[k], Tangents[k], Curvatures[k], Tables[Pair[k]], bStartAtJunction ? Arm.Setback : Length - Arm.Setback);
+			if (bStartAtJunction == (k == 0)) {
+				Tangents[k] = -Tangents[k];
+			}
+		}
+		FFillet& Fillet = Junction.Fillets.AddDefaulted_GetRef();
+		Fillet.Arms[0] = Pair[0];
+		Fillet.Arms[1] = Pair[1];
+		MakeFillet(Fillet, Positions[0], Tangents[0], Curvatures[0], Positions[1], Tangents[1], Curvatures[1], Settings.FilletContinuity);
+	}
+}
+
+template<int32 Dim>
+inline void TSplineJunctionBuilder<Dim>::MakeFillet(FFillet& OutFillet, const TVectorX<Dim>& A, const TVectorX<Dim>& TangentA, const TVectorX<Dim>& CurvatureA,
+	const TVectorX<Dim>& B, const TVectorX<Dim>& TangentB, const TVectorX<Dim>& CurvatureB, int32 Continuity)
+{
+	const TVectorX<Dim> D = B - A;
+	double HandleA = TVecLib<Dim>::Size(D) / 3., HandleB = HandleA;
+
+	// Corner of the tangent lines, A + TangentA * U = B - TangentB * V.
+	const double Cos = FMath::Clamp(TVecLib<Dim>::Dot(TangentA, TangentB), -1., 1.);
+	const double Det = 1. - Cos * Cos;
+	if (Det > KINDA_SMALL_NUMBER) {
+		const double DotA = TVecLib<Dim>::Dot(TangentA, D), DotB = TVecLib<Dim>::Dot(TangentB, D);
+		const double U = (DotA - Cos * DotB) / Det;
+		const double V = (DotB - Cos * DotA) / Det;
+		if (U > 0. && V > 0.) {
+			// Handles of a circular arc turning by Turn, 4/3 * tan(Turn / 4) * r, where U = V = tan(Turn / 2) * r.
+			const double Turn = FMath::Acos(Cos);
+			const double Scale = 4. / 3. * FMath::Tan(Turn * 0.25) / FMath::Tan(Turn * 0.5);
+			HandleA = Scale * U;
+			HandleB = Scale * V;
+
+			if (Continuity >= 2) {
+				// Signed curvatures at the ends, with Sin = |TangentA x TangentB|:
+				// KA = 2/3 * (Sin * V - Sin * HandleB) / HandleA^2, KB = 2/3 * (Sin * U - Sin * HandleA) / HandleB^2.
+				// Solved by fixed point iteration from the corner, which is the solution for straight arms.
+				const TVectorX<Dim> Cross = TangentA ^ TangentB;
+				const double Sin = TVecLib<Dim>::Size(Cross);
+				const TVectorX<Dim> Normal = Cross / Sin;
+				const double KA = TVecLib<Dim>::Dot(TangentA ^ CurvatureA, Normal);
+				const double KB = TVecLib<Dim>::Dot(TangentB ^ CurvatureB, Normal);
+				double H1 = U, H2 = V;
+				for (int32 Iteration = 0; Iteration < 16; ++Iteration) {
+					H2 = V - 1.5 * KA * H1 * H1 / Sin;
+					H1 = U - 1.5 * KB * H2 * H2 / Sin;
+				}
+				const double Residual = FMath::Abs(H2 - (V - 1.5 * KA * H1 * H1 / Sin));
+				if (H1 > 0. && H2 > 0. && Residual <= 1.e-3 * (H1 + H2)) {
+					HandleA = H1;
+					HandleB = H2;
+				}
+			}
+		}
+	}
+	OutFillet.Points[0] = A;
+	OutFillet.Points[1] = A + TangentA * HandleA;
+	OutFillet.Points[2] = B - TangentB * HandleB;
+	OutFillet.Points[3] = B;
+}
+
+template<int32 Dim>
+inline void TSplineJunctionBuilder<Dim>::GetFrameAtLength(TVectorX<Dim>& OutPosition, TVectorX<Dim>& OutTangent, TVectorX<Dim>& OutCurvature, const FTableType& Table, double S)
+{
+	const double Length = Table.GetTotalLength();
+	S = FMath::Clamp(S, 0., Length);
+	auto GetUnitTangent = [&Table](double InS) {
+		const TVectorX<Dim> Tangent = Table.GetTangent(Table.GetParameterAtLength(InS));
+		const double Size = TVecLib<Dim>::Size(Tangent);
+		return Size > SMALL_NUMBER ? Tangent / Size : Tangent;
+	};
+	OutPosition = Table.GetPosition(Table.GetParameterAtLength(S));
+	OutTangent = GetUnitTangent(S);
+	// Central difference of the unit tangent by length.
+	const double H = FMath::Max(Length * 1.e-3, KINDA_SMALL_NUMBER);
+	const double S0 = FMath::Max(S - H, 0.), S1 = FMath::Min(S + H, Length);
+	OutCurvature = S1 > S0 ? (GetUnitTangent(S1) - GetUnitTangent(S0)) / (S1 - S0) : TVecLib<Dim>::Zero();
+}
+
+template<int32 Dim>
+inline bool TSplineJunctionBuilder<Dim>::IsNearEnd(EContactType& OutContactType, const FSplineType& Spline, double Param, double Tolerance)
+{
+	const TTuple<double, double> ParamRange = Spline.GetParamRange();
+	const TVectorX<Dim> Position = Spline.GetPosition(Param);
+	const double ToleranceSqr = Tolerance * Tolerance;
+	if (TVecLib<Dim>::SizeSquared(Position - Spline.GetPosition(ParamRange.Get<0>())) <= ToleranceSqr) {
+		OutContactType = EContactType::Start;
+		return true;
+	}
+	if (TVecLib<Dim>::SizeSquared(Position - Spline.GetPosition(ParamRange.Get<1>())) <= ToleranceSqr) {
+		OutContactType = EContactType::End;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,99 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Splines/SplineFrameTable.h"
+
+// Cross section in the frame of the spline. X is along the binormal (the right side if the normal is up) and Y is along the normal.
+// The faces of a counter-clockwise section are outwards. U goes from 0 to 1 along the section.
+struct FSweepCrossSection
+{
+	TArray<FVector2D> Points;
+	bool bClosed = false;
+};
+
+struct FSweepSettings
+{
+	// Max chord error of each LOD, from the finest to the coarsest. The finest is sampled on the spline,
+	// and the coarser ones are simplified from it.
+	TArray<double> LODChordErrors{ 1., 4., 16. };
+	// Max depth of bisection of each segment of the spline.
+	int32 MaxDepth = 8;
+	// Max arc length between two rings of the finest LOD, not limited if non-positive.
+	double MaxRingSpacing = 0.;
+	// Arc length of one repeat of V.
+	double VLength = 100.;
+};
+
+// Raw buffers of one LOD, with the winding of UE meshes (the front face of (A, B, C) is along (C - A) ^ (B - A)).
+struct FSweepMeshBuffers
+{
+	TArray<FVector> Positions;
+	TArray<FVector> Normals;
+	// Along U.
+	TArray<FVector> Tangents;
+	TArray<FVector2D> UVs;
+	TArray<int32> Indices;
+
+	FORCEINLINE void Empty()
+	{
+		Positions.Empty();
+		Normals.Empty();
+		Tangents.Empty();
+		UVs.Empty();
+		Indices.Empty();
+	}
+};
+
+// Sweep a cross section along a spline by its rotation minimizing frames, as one mesh section for each LOD.
+// Each segment of the spline is sampled, simplified and written to the buffers in parallel.
+template<int32 Degree = 3>
+class TSplineSweep
+{
+public:
+	using FFrameTableType = typename TSplineFrameTable<Degree>;
+	using FFrame = typename FFrameTableType::FFrame;
+
+	static bool Build(TArray<FSweepMeshBuffers>& OutLODs, const FFrameTableType& Frames, const FSweepCrossSection& Section, const FSweepSettings& Settings = FSweepSettings());
+
+protected:
+	struct FRing
+	{
+		double Param = 0.;
+		double Length = 0.;
+		FFrame Frame;
+	};
+
+	struct FSectionVertex
+	{
+		FVector2D Point;
+		FVector2D Normal;
+		FVector2D Tangent;
+		float U = 0.f;
+	};
+
+	struct FSegmentRings
+	{
+		TArray<FRing> Rings;
+		// Indices of Rings kept by each LOD, including both ends.
+		TArray<TArray<int32> > LODRings;
+	};
+
+	static void MakeSectionVertices(TArray<FSectionVertex>& OutVertices, const FSweepCrossSection& Section);
+
+	static FORCEINLINE FVector GetSectionPosition(const FFrame& Frame, const FVector2D& Point)
+	{
+		return Frame.Position + Frame.Binormal * Point.X + Frame.Normal * Point.Y;
+	}
+
+	// Largest distance of the points of the section at Ring from the lerp of them between From and To.
+	static double GetChordError(const FRing& Ring, const FRing& From, const FRing& To, const TArray<FSectionVertex>& SectionVertices);
+
+	static void SampleSegment(FSegmentRings& OutSegment, int32 Segment, const FFrameTableType& Frames, const TArray<FSectionVertex>& SectionVertices, const FSweepSettings& Settings, double ChordError);
+
+	static void SimplifySegment(TArray<int32>& OutKept, const TArray<FRing>& Rings, const TArray<FSectionVertex>& SectionVertices, double ChordError);
+};
+
+#include "SplineSweep.inl"
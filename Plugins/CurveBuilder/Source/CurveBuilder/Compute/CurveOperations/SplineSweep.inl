@@ -0,0 +1,229 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "SplineSweep.h"
+#include "Async/ParallelFor.h"
+
+template<int32 Degree>
+inline bool TSplineSweep<Degree>::Build(TArray<FSweepMeshBuffers>& OutLODs, const FFrameTableType& Frames, const FSweepCrossSection& Section, const FSweepSettings& Settings)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_SplineSweep_Build);
+	OutLODs.Reset();
+	const int32 SegmentNum = Frames.GetArcLengthTable().GetSegmentNum();
+	if (Frames.IsEmpty() || SegmentNum == 0 || Section.Points.Num() < 2) {
+		return false;
+	}
+	TArray<double> ChordErrors = Settings.LODChordErrors;
+	if (ChordErrors.Num() == 0) {
+		ChordErrors.Add(1.);
+	}
+	for (double& ChordError : ChordErrors) {
+		ChordError = FMath::Max(ChordError, static_cast<double>(KINDA_SMALL_NUMBER));
+	}
+	const int32 LODNum = ChordErrors.Num();
+
+	TArray<FSectionVertex> SectionVertices;
+	MakeSectionVertices(SectionVertices, Section);
+	const int32 RingVertexNum = SectionVertices.Num();
+	const int32 RingQuadNum = RingVertexNum - 1;
+
+	// Rings of each segment. The finest LOD is sampled, and the others are simplified from it.
+	TArray<FSegmentRings> Segments;
+	Segments.SetNum(SegmentNum);
+	ParallelFor(SegmentNum, [&Segments, &Frames, &SectionVertices, &Settings, &ChordErrors, LODNum](int32 i) {
+		FSegmentRings& Segment = Segments[i];
+		SampleSegment(Segment, i, Frames, SectionVertices, Settings, ChordErrors[0]);
+		Segment.LODRings.SetNum(LODNum);
+		Segment.LODRings[0].Reserve(Segment.Rings.Num());
+		for (int32 r = 0; r < Segment.Rings.Num(); ++r) {
+			Segment.LODRings[0].Add(r);
+		}
+		for (int32 l = 1; l < LODNum; ++l) {
+			SimplifySegment(Segment.LODRings[l], Segment.Rings, SectionVertices, ChordErrors[l]);
+		}
+	});
+
+	// The last ring of a segment is the first ring of the next segment, so it is written once.
+	TArray<TArray<int32> > RingOffsets;
+	RingOffsets.SetNum(LODNum);
+	OutLODs.SetNum(LODNum);
+	for (int32 l = 0; l < LODNum; ++l) {
+		TArray<int32>& Offsets = RingOffsets[l];
+		Offsets.SetNumUninitialized(SegmentNum);
+		int32 RingNum = 0;
+		for (int32 i = 0; i < SegmentNum; ++i) {
+			Offsets[i] = RingNum;
+			RingNum += Segments[i].LODRings[l].Num() - 1;
+		}
+		++RingNum;
+		FSweepMeshBuffers& Buffers = OutLODs[l];
+		Buffers.Positions.SetNumUninitialized(RingNum * RingVertexNum);
+		Buffers.Normals.SetNumUninitialized(RingNum * RingVertexNum);
+		Buffers.Tangents.SetNumUninitialized(RingNum * RingVertexNum);
+		Buffers.UVs.SetNumUninitialized(RingNum * RingVertexNum);
+		Buffers.Indices.SetNumUninitialized((RingNum - 1) * RingQuadNum * 6);
+	}
+
+	const double InvVLength = Settings.VLength > 0. ? 1. / Settings.VLength : 1.;
+	ParallelFor(SegmentNum, [&OutLODs, &Segments, &RingOffsets, &SectionVertices, SegmentNum, LODNum, RingVertexNum, RingQuadNum, InvVLength](int32 i) {
+		const FSegmentRings& Segment = Segments[i];
+		for (int32 l = 0; l < LODNum; ++l) {
+			FSweepMeshBuffers& Buffers = OutLODs[l];
+			const TArray<int32>& Kept = Segment.LODRings[l];
+			const int32 Offset = RingOffsets[l][i];
+			const int32 WriteNum = i == SegmentNum - 1 ? Kept.Num() : Kept.Num() - 1;
+			for (int32 r = 0; r < WriteNum; ++r) {
+				const FRing& Ring = Segment.Rings[Kept[r]];
+				const FFrame& Frame = Ring.Frame;
+				const float V = static_cast<float>(Ring.Length * InvVLength);
+				const int32 Base = (Offset + r) * RingVertexNum;
+				for (int32 v = 0; v < RingVertexNum; ++v) {
+					const FSectionVertex& SectionVertex = SectionVertices[v];
+					Buffers.Positions[Base + v] = GetSectionPosition(Frame, SectionVertex.Point);
+					Buffers.Normals[Base + v] = Frame.Binormal * SectionVertex.Normal.X + Frame.Normal * SectionVertex.Normal.Y;
+					Buffers.Tangents[Base + v] = Frame.Binormal * SectionVertex.Tangent.X + Frame.Normal * SectionVertex.Tangent.Y;
+					Buffers.UVs[Base + v] = FVector2D(SectionVertex.U, V);
+				}
+			}
+			for (int32 r = 0; r + 1 < Kept.Num(); ++r) {
+				const int32 A0 = (Offset + r) * RingVertexNum;
+				const int32 A1 = A0 + RingVertexNum;
+				int32* Indices = Buffers.Indices.GetData() + (Offset + r) * RingQuadNum * 6;
+				for (int32 q = 0; q < RingQuadNum; ++q) {
+					Indices[0] = A0 + q;
+					Indices[1] = A1 + q;
+					Indices[2] = A0 + q + 1;
+					Indices[3] = A0 + q + 1;
+					Indices[4] = A1 + q;
+					Indices[5] = A1 + q + 1;
+					Indices += 6;
+				}
+			}
+		}
+	});
+	return true;
+}
+
+template<int32 Degree>
+inline void TSplineSweep<Degree>::MakeSectionVertices(TArray<FSectionVertex>& OutVertices, const FSweepCrossSection& Section)
+{
+	const TArray<FVector2D>& Points = Section.Points;
+	const int32 PointNum = Points.Num();
+	const int32 VertexNum = Section.bClosed ? PointNum + 1 : PointNum;
+
+	// U by the length along the section, with a seam vertex at U = 1 if closed.
+	TArray<float> Distances;
+	Distances.SetNumUninitialized(VertexNum);
+	Distances[0] = 0.f;
+	for (int32 v = 1; v < VertexNum; ++v) {
+		Distances[v] = Distances[v - 1] + FVector2D::Distance(Points[v % PointNum], Points[v - 1]);
+	}
+	const float Perimeter = Distances.Last();
+
+	// The normals are averaged at the points.
+	OutVertices.Reset(VertexNum);
+	for (int32 v = 0; v < VertexNum; ++v) {
+		const int32 j = v % PointNum;
+		FVector2D Tangent = FVector2D::ZeroVector;
+		if (j > 0 || Section.bClosed) {
+			Tangent += (Points[j] - Points[(j + PointNum - 1) % PointNum]).GetSafeNormal();
+		}
+		if (j + 1 < PointNum || Section.bClosed) {
+			Tangent += (Points[(j + 1) % PointNum] - Points[j]).GetSafeNormal();
+		}
+		Tangent = Tangent.GetSafeNormal();
+
+		FSectionVertex& Vertex = OutVertices.AddDefaulted_GetRef();
+		Vertex.Point = Points[j];
+		Vertex.Tangent = Tangent;
+		Vertex.Normal = FVector2D(Tangent.Y, -Tangent.X);
+		Vertex.U = Perimeter > 0.f ? Distances[v] / Perimeter : 0.f;
+	}
+}
+
+template<int32 Degree>
+inline double TSplineSweep<Degree>::GetChordError(const FRing& Ring, const FRing& From, const FRing& To, const TArray<FSectionVertex>& SectionVertices)
+{
+	const double Diff = To.Param - From.Param;
+	const float Alpha = FMath::IsNearlyZero(Diff) ? 0.f : static_cast<float>((Ring.Param - From.Param) / Diff);
+	double MaxError = 0.;
+	for (const FSectionVertex& SectionVertex : SectionVertices) {
+		const FVector Chord = FMath::Lerp(GetSectionPosition(From.Frame, SectionVertex.Point), GetSectionPosition(To.Frame, SectionVertex.Point), Alpha);
+		MaxError = FMath::Max(MaxError, static_cast<double>(FVector::Distance(GetSectionPosition(Ring.Frame, SectionVertex.Point), Chord)));
+	}
+	return MaxError;
+}
+
+template<int32 Degree>
+inline void TSplineSweep<Degree>::SampleSegment(FSegmentRings& OutSegment, int32 Segment, const FFrameTableType& Frames, const TArray<FSectionVertex>& SectionVertices, const FSweepSettings& Settings, double ChordError)
+{
+	const typename FFrameTableType::FTableType& Table = Frames.GetArcLengthTable();
+	const TTuple<double, double>& ParamRange = Table.GetSegmentParamRange(Segment);
+	auto MakeRing = [&Frames, &Table](double Param) -> FRing {
+		FRing Ring;
+		Ring.Param = Param;
+		Ring.Length = Table.GetLengthAtParameter(Param);
+		Ring.Frame = Frames.GetFrame(Param);
+		return Ring;
+	};
+
+	TArray<FRing>& Rings = OutSegment.Rings;
+	Rings.Reset();
+	Rings.Add(MakeRing(ParamRange.Get<0>()));
+	const FRing LastRing = MakeRing(ParamRange.Get<1>());
+	int32 InitialNum = 1;
+	if (Settings.MaxRingSpacing > 0.) {
+		InitialNum = FMath::Max(FMath::CeilToInt((LastRing.Length - Rings[0].Length) / Settings.MaxRingSpacing), 1);
+	}
+
+	// Bisect while the middle ring is too far from the chord.
+	struct FPending
+	{
+		FRing To;
+		int32 Depth;
+	};
+	TArray<FPending, TInlineAllocator<16> > Stack;
+	for (int32 k = 1; k <= InitialNum; ++k) {
+		Stack.Add(FPending{ k == InitialNum ? LastRing : MakeRing(FMath::Lerp(ParamRange.Get<0>(), ParamRange.Get<1>(), k / static_cast<double>(InitialNum))), 0 });
+		while (Stack.Num() > 0) {
+			FPending& Top = Stack.Last();
+			if (Top.Depth < Settings.MaxDepth) {
+				const FRing& From = Rings.Last();
+				FRing Mid = MakeRing((From.Param + Top.To.Param) * 0.5);
+				if (GetChordError(Mid, From, Top.To, SectionVertices) > ChordError) {
+					const int32 Depth = ++Top.Depth;
+					Stack.Add(FPending{ MoveTemp(Mid), Depth });
+					continue;
+				}
+			}
+			Rings.Add(Top.To);
+			Stack.Pop(false);
+		}
+	}
+}
+
+template<int32 Degree>
+inline void TSplineSweep<Degree>::SimplifySegment(TArray<int32>& OutKept, const TArray<FRing>& Rings, const TArray<FSectionVertex>& SectionVertices, double ChordError)
+{
+	// Greedy. Extend each span while all the rings skipped by it are close to its chord.
+	OutKept.Reset();
+	OutKept.Add(0);
+	int32 From = 0;
+	while (From + 1 < Rings.Num()) {
+		int32 To = From + 1;
+		while (To + 1 < Rings.Num()) {
+			bool bKeepAll = true;
+			for (int32 r = From + 1; r <= To && bKeepAll; ++r) {
+				bKeepAll = GetChordError(Rings[r], Rings[From], Rings[To + 1], SectionVertices) <= ChordError;
+			}
+			if (!bKeepAll) {
+				break;
+			}
+			++To;
+		}
+		OutKept.Add(To);
+		From = To;
+	}
+}
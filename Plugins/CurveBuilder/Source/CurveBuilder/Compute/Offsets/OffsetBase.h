@@ -4,6 +4,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Utils/LinearAlgebraUtils.h"
 
 template<int32 Dim, int32 Degree>
 class TOffsetBase
@@ -28,8 +29,7 @@ public:
 
 	virtual TTuple<double, double> GetParamRange() const { return MakeTuple(-1., -1.); }
 
-	template<int32 DimOri>
-	virtual void MakeCurves(TArray<TBezierCurve<DimOri, Degree> >& OutCurves, const TSplineBase<DimOri, Degree>& InOriginalSpline) const = 0;
+	// MakeCurves() of the original spline is a template in each kind of offset, which can't be virtual.
 
 protected:
 	virtual TVectorX<Dim> GetPosition(double T) const { return TVecLib<Dim>::Zero(); }
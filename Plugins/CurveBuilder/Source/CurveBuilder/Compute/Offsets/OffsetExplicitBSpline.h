@@ -7,17 +7,30 @@
 #include "../Splines/BSpline.h"
 #include "OffsetExplicitBase.h"
 
-
+// Offset profile as a clamped B-Spline in 2D. Add the points as (arc length, offset distance).
 template<int32 Degree>
 class TOffsetExplicit2ClampedBSpline : public TOffsetExplicit2Base<Degree>, public TClampedBSpline<2, Degree>
 {
 public:
-	using TOffsetExplicit2Base<Degree>::TOffsetExplicit2Base;
+	TOffsetExplicit2ClampedBSpline(double InFromP = 0., double InToP = 1.)
+		: TOffsetExplicit2Base<Degree>(InFromP, InToP)
+	{
+		this->SplineType = ESplineType::ClampedBSpline;
+	}
+
+	using TOffsetExplicit2Base<Degree>::GetType;
+
+	using TOffsetExplicit2Base<Degree>::MakeCurves;
 
 	virtual void GetKnotsS(TArray<double>& OutKnotsS) const override;
 
-	template<int32 DimOri>
-	virtual void MakeCurves(TArray<TBezierCurve<DimOri, Degree> >& OutCurves, const TSplineBase<DimOri, Degree>& InOriginalSpline) const override;
+	virtual int32 GetCtrlPointNum() const override { return TClampedBSpline<2, Degree>::GetCtrlPointNum(); }
+
+	virtual TTuple<double, double> GetParamRange() const override { return TClampedBSpline<2, Degree>::GetParamRange(); }
+
+	virtual TVectorX<2> GetPosition(double T) const override { return TClampedBSpline<2, Degree>::GetPosition(T); }
+
+	virtual TVectorX<2> GetTangent(double T) const override { return TClampedBSpline<2, Degree>::GetTangent(T); }
 
 protected:
 
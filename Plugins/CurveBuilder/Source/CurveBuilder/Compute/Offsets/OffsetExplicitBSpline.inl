@@ -8,12 +8,11 @@
 template<int32 Degree>
 inline void TOffsetExplicit2ClampedBSpline<Degree>::GetKnotsS(TArray<double>& OutKnotsS) const
 {
-	OutKnotsS = KnotIntervals;
-}
-
-template<int32 Degree>
-template<int32 DimOri>
-inline void TOffsetExplicit2ClampedBSpline<Degree>::MakeCurves(TArray<TBezierCurve<DimOri, Degree> >& OutCurves, const TSplineBase<DimOri, Degree>& InOriginalSpline) const
-{
-	TOffsetExplicit2Base<Degree>::MakeCurves(OutCurves, InOriginalSpline);
+	// Repeated knots make no segment.
+	this->GetKnotIntervals(OutKnotsS);
+	for (int32 i = OutKnotsS.Num() - 1; i > 0; --i) {
+		if (OutKnotsS[i] <= OutKnotsS[i - 1]) {
+			OutKnotsS.RemoveAt(i, 1, false);
+		}
+	}
 }
@@ -6,6 +6,9 @@
 #include "CoreMinimal.h"
 #include "OffsetBase.h"
 #include "../Splines/SplineBase.h"
+#include "../Splines/SplineArcLengthTable.h"
+#include "../Splines/BezierString.h"
+#include "../Splines/BSpline.h"
 
 enum class EOffsetDirectionType : uint8
 {
@@ -20,13 +23,18 @@ struct FOffsetType
 };
 
 
+// Offset of a spline by a profile in 2D, whose X is the arc length along the original spline, and Y is the offset distance.
 template<int32 Degree>
 class TOffsetExplicit2Base : public TOffsetBase<2, Degree>
 {
 public:
 	using TOffsetBase<2, Degree>::TOffsetBase;
 
-	FORCEINLINE ESplineType GetType() const { return Type; }
+	FORCEINLINE ESplineType GetType() const { return SplineType; }
+
+	FORCEINLINE const FOffsetType& GetOffsetType() const { return OffsetType; }
+
+	FORCEINLINE void SetOffsetType(const FOffsetType& InOffsetType) { OffsetType = InOffsetType; }
 
 	double GetLength(double T) const
 	{
@@ -48,7 +56,7 @@ public:
 		return GaussLegendre.SolveFromIntegration(S);
 	}
 
-	virtual TVectorX<2> GetValue(double T) const 
+	virtual double GetValue(double T) const 
 	{ 
 		return GetPosition(T)[1]; 
 	}
@@ -58,8 +66,6 @@ public:
 		return false;
 	}
 
-	virtual void ToPolynomialForm(TArray<TArray<TVectorX<3> > >& OutPolyForms) const override {}
-
 	virtual int32 GetCtrlPointNum() const
 	{
 		return -1;
@@ -111,12 +117,57 @@ protected:
 
 public:
 
+	// Offset distance and its derivative by the arc length at arc length S. InOutParam is the parameter of the profile
+	// to start from, e.g. the one of the previous query when sweeping forward, and the solved one is written back.
+	virtual bool GetOffsetAtLength(double& OutOffset, double& OutOffsetDerivative, double S, double& InOutParam) const;
+
+	// Parameters of the profile at the knots, in ascending order.
 	virtual void GetKnotsS(TArray<double>& OutKnotsS) const {}
 
+	// Arc lengths of the original spline at the knots.
+	void GetKnotLengths(TArray<double>& OutLengths) const
+	{
+		GetKnotsS(OutLengths);
+		for (double& Length : OutLengths) {
+			Length = GetPosition(Length)[0];
+		}
+	}
+
+	// One segment between each two knots of the profile, as a hermite curve of the offset positions and derivatives.
+	// The original spline is sampled once for each knot.
 	template<int32 DimOri>
-	virtual void MakeCurves(TArray<TBezierCurve<DimOri, Degree> >& OutCurves, const TSplineBase<DimOri, Degree>& InOriginalSpline) const override;
+	void MakeCurves(TArray<TBezierCurve<DimOri, Degree> >& OutCurves, const TSplineBase<DimOri, Degree>& InOriginalSpline) const;
+
+	// The arc length table of the original spline can be shared by many offsets of it.
+	template<int32 DimOri>
+	void MakeCurves(TArray<TBezierCurve<DimOri, Degree> >& OutCurves, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable) const;
+
+	// Fit cubic curves to the exact offset, and subdivide a curve only where the deviation sampled on it exceeds the tolerance.
+	// For offsets along DirT, the loops made where the offset is larger than the radius of curvature are trimmed
+	// at their self-intersections in the XY plane, and the cusps become corners.
+	template<int32 DimOri>
+	void MakeCurvesAdaptive(TArray<TBezierCurve<DimOri, Degree> >& OutCurves, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable, double Tolerance = 1., int32 MaxDepth = 16) const;
+
+	template<int32 DimOri>
+	bool MakeBezierStringAdaptive(TBezierString3<DimOri>& OutSpline, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable, double Tolerance = 1.) const;
+
+	// Return false if the curves can't be joined as a B-Spline, such as with corners.
+	template<int32 DimOri>
+	bool MakeClampedBSplineAdaptive(TClampedBSpline<DimOri, Degree>& OutSpline, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable, double Tolerance = 1.) const;
 
 public:
+	static TVectorX<3> GetOffsetDirection(const TVectorX<3>& OriginalTangent, const FOffsetType& InOffsetType)
+	{
+		switch (InOffsetType.DirectionType)
+		{
+		case EOffsetDirectionType::DirT:
+			return (FVector::UpVector ^ OriginalTangent).GetSafeNormal() * InOffsetType.Sgn;
+		case EOffsetDirectionType::DirZ:
+		default:
+			return FVector::UpVector * InOffsetType.Sgn;
+		}
+	}
+
 	static double ConvertRange(double T, const TTuple<double, double>& RangeFrom, const TTuple<double, double>& RangeTo)
 	{
 		double DiffFrom = RangeFrom.Get<1>() - RangeFrom.Get<0>();
@@ -127,6 +178,44 @@ public:
 		return RangeTo.Get<0>() * (1 - TN) + RangeTo.Get<1>() * TN;
 	}
 
+protected:
+	// Exact offset at a parameter of the profile. The derivative is by the parameter of the profile.
+	template<int32 DimOri>
+	struct TOffsetSample
+	{
+		double OffP = 0.;
+		double OriP = 0.;
+		TVectorX<DimOri> Position;
+		TVectorX<DimOri> Derivative;
+		TVectorX<DimOri> OriginalTangent;
+	};
+
+	// Part of the profile kept after trimming. The ends are moved to the joint points if they are set.
+	template<int32 DimOri>
+	struct TOffsetRange
+	{
+		double From = 0.;
+		double To = 0.;
+		TOptional<TVectorX<DimOri> > FromPoint;
+		TOptional<TVectorX<DimOri> > ToPoint;
+	};
+
+	template<int32 DimOri>
+	static void GetOriginalParameters(TArray<double>& OutOriP, const TArray<double>& OriS, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable);
+
+	// With the profile and the parameter of the original spline already evaluated.
+	template<int32 DimOri>
+	void EvaluateOffsetAt(TOffsetSample<DimOri>& OutSample, double OffP, const TVectorX<2>& OffV, const TVectorX<2>& OffT, double OriP, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable) const;
+
+	template<int32 DimOri>
+	void EvaluateOffset(TOffsetSample<DimOri>& OutSample, double OffP, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable) const;
+
+	template<int32 DimOri>
+	void FindTrimmedRanges(TArray<TOffsetRange<DimOri> >& OutRanges, const TArray<double>& KnotsS, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable) const;
+
+	template<int32 DimOri>
+	void FitRangeAdaptive(TArray<TBezierCurve<DimOri, Degree> >& OutCurves, const TOffsetRange<DimOri>& Range, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable, double Tolerance, int32 MaxDepth) const;
+
 protected:
 	ESplineType SplineType = ESplineType::Unknown;
 	FOffsetType OffsetType;
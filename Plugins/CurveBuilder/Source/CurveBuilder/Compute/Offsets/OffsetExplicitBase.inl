@@ -4,77 +4,391 @@
 #pragma once
 
 #include "OffsetExplicitBase.h"
+#include "Algo/IsSorted.h"
+
+template<int32 Degree>
+inline bool TOffsetExplicit2Base<Degree>::GetOffsetAtLength(double& OutOffset, double& OutOffsetDerivative, double S, double& InOutParam) const
+{
+	static constexpr int32 Iteration = 4;
+	const TTuple<double, double> ParamRange = GetParamRange();
+	if (ParamRange.Get<1>() <= ParamRange.Get<0>()) {
+		return false;
+	}
+	double P = FMath::Clamp(InOutParam, ParamRange.Get<0>(), ParamRange.Get<1>());
+	TVectorX<2> V = GetPosition(P);
+	TVectorX<2> T = GetTangent(P);
+	for (int32 i = 0; i < Iteration && !FMath::IsNearlyZero(V[0] - S, KINDA_SMALL_NUMBER) && !FMath::IsNearlyZero(T[0]); ++i) {
+		P = FMath::Clamp(P - (V[0] - S) / T[0], ParamRange.Get<0>(), ParamRange.Get<1>());
+		V = GetPosition(P);
+		T = GetTangent(P);
+	}
+	InOutParam = P;
+	OutOffset = V[1];
+	OutOffsetDerivative = FMath::IsNearlyZero(T[0]) ? 0. : T[1] / T[0];
+	return true;
+}
 
 template<int32 Degree>
 template<int32 DimOri>
 inline void TOffsetExplicit2Base<Degree>::MakeCurves(TArray<TBezierCurve<DimOri, Degree>>& OutCurves, const TSplineBase<DimOri, Degree>& InOriginalSpline) const
 {
-	TTuple<double, double> OriginalParamRange = InOriginalSpline.GetParamRange();
+	TSplineArcLengthTable<DimOri, Degree> OriginalTable(InOriginalSpline);
+	MakeCurves(OutCurves, OriginalTable);
+}
+
+template<int32 Degree>
+template<int32 DimOri>
+inline void TOffsetExplicit2Base<Degree>::MakeCurves(TArray<TBezierCurve<DimOri, Degree>>& OutCurves, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable) const
+{
+	static_assert(DimOri == 3, "Offset directions are defined in 3D.");
+	static_assert(Degree == 3, "Offset curves are made as cubic hermite curves.");
 	static constexpr double InvDegDbl = 1. / static_cast<double>(Degree);
-	TArray<TVectorX<DimOri> > OffDirs;
-	TArray<TVectorX<DimOri> > OriV;
-	TArray<TVectorX<DimOri> > OriT;
-	TArray<double> OriP;
-	TArray<TVectorX<2> > OffV;
-	TArray<TVectorX<2> > OffT;
 
+	OutCurves.Reset();
 	TArray<double> KnotsS;
 	GetKnotsS(KnotsS);
+	if (KnotsS.Num() < 2 || OriginalTable.IsEmpty()) {
+		return;
+	}
 
-	OffsetDirs.Reserve(KnotsS.Num());
-	OriV.Reserve(KnotsS.Num());
-	OriT.Reserve(KnotsS.Num());
-	OriP.Reserve(KnotsS.Num());
+	// Profile at the knots.
+	TArray<TVectorX<2> > OffV;
+	TArray<TVectorX<2> > OffT;
+	TArray<double> OriS;
 	OffV.Reserve(KnotsS.Num());
 	OffT.Reserve(KnotsS.Num());
-	OutCurves.Empty(KnotsS.Num() - 1);
-	for (int32 i = 0; i < KnotsS.Num(); ++i)
-	{
-		TVectorX<DimOri>& CurOffDir = OffDirs.Add_GetRef(TVecLib<DimOri>::Zero());
+	OriS.Reserve(KnotsS.Num());
+	for (double KnotS : KnotsS) {
+		OffV.Add(GetPosition(KnotS));
+		OffT.Add(GetTangent(KnotS));
+		OriS.Add(OffV.Last()[0]);
+	}
+
+	TArray<double> OriP;
+	GetOriginalParameters(OriP, OriS, OriginalTable);
+
+	TArray<TOffsetSample<DimOri> > Targets;
+	Targets.SetNum(KnotsS.Num());
+	for (int32 i = 0; i < KnotsS.Num(); ++i) {
+		EvaluateOffsetAt(Targets[i], KnotsS[i], OffV[i], OffT[i], OriP[i], OriginalTable);
+	}
+
+	OutCurves.Reserve(KnotsS.Num() - 1);
+	for (int32 i = 1; i < KnotsS.Num(); ++i) {
+		const double Span = (KnotsS[i] - KnotsS[i - 1]) * InvDegDbl;
+		const TVectorX<DimOri> Points[4] = {
+			Targets[i - 1].Position,
+			Targets[i - 1].Position + Targets[i - 1].Derivative * Span,
+			Targets[i].Position - Targets[i].Derivative * Span,
+			Targets[i].Position, };
+		OutCurves.Add(TBezierCurve<DimOri, Degree>(Points));
+	}
+}
+
+template<int32 Degree>
+template<int32 DimOri>
+inline void TOffsetExplicit2Base<Degree>::MakeCurvesAdaptive(TArray<TBezierCurve<DimOri, Degree>>& OutCurves, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable, double Tolerance, int32 MaxDepth) const
+{
+	static_assert(DimOri == 3, "Offset directions are defined in 3D.");
+	static_assert(Degree == 3, "Offset curves are made as cubic hermite curves.");
+
+	OutCurves.Reset();
+	TArray<double> KnotsS;
+	GetKnotsS(KnotsS);
+	if (KnotsS.Num() < 2 || OriginalTable.IsEmpty()) {
+		return;
+	}
+
+	TArray<TOffsetRange<DimOri> > Ranges;
+	FindTrimmedRanges(Ranges, KnotsS, OriginalTable);
+	for (const TOffsetRange<DimOri>& Range : Ranges) {
+		FitRangeAdaptive(OutCurves, Range, OriginalTable, FMath::Max(Tolerance, KINDA_SMALL_NUMBER), MaxDepth);
+	}
+}
+
+template<int32 Degree>
+template<int32 DimOri>
+inline bool TOffsetExplicit2Base<Degree>::MakeBezierStringAdaptive(TBezierString3<DimOri>& OutSpline, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable, double Tolerance) const
+{
+	TArray<TBezierCurve<DimOri, Degree> > Curves;
+	MakeCurvesAdaptive(Curves, OriginalTable, Tolerance);
+	OutSpline.FromCurveArray(Curves);
+	return Curves.Num() > 0 && OutSpline.GetCtrlPointNum() == Curves.Num() + 1;
+}
+
+template<int32 Degree>
+template<int32 DimOri>
+inline bool TOffsetExplicit2Base<Degree>::MakeClampedBSplineAdaptive(TClampedBSpline<DimOri, Degree>& OutSpline, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable, double Tolerance) const
+{
+	TArray<TBezierCurve<DimOri, Degree> > Curves;
+	MakeCurvesAdaptive(Curves, OriginalTable, Tolerance);
+	return Curves.Num() > 0 && OutSpline.CreateFromBezierCurves(Curves) == Curves.Num();
+}
+
+template<int32 Degree>
+template<int32 DimOri>
+inline void TOffsetExplicit2Base<Degree>::GetOriginalParameters(TArray<double>& OutOriP, const TArray<double>& OriS, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable)
+{
+	// In one sweep if the profile goes forward.
+	if (Algo::IsSorted(OriS)) {
+		OriginalTable.GetParametersAtLengths(OutOriP, OriS);
+		return;
+	}
+	OutOriP.Reset(OriS.Num());
+	for (double S : OriS) {
+		OutOriP.Add(OriginalTable.GetParameterAtLength(S));
+	}
+}
 
-		double CurKnotS = KnotsS[i];
+template<int32 Degree>
+template<int32 DimOri>
+inline void TOffsetExplicit2Base<Degree>::EvaluateOffsetAt(TOffsetSample<DimOri>& OutSample, double OffP, const TVectorX<2>& OffV, const TVectorX<2>& OffT, double OriP, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable) const
+{
+	const TTuple<double, double>& OriginalParamRange = OriginalTable.GetParamRange();
+	const double DirectionStep = (OriginalParamRange.Get<1>() - OriginalParamRange.Get<0>()) * 1e-5;
+
+	const TVectorX<DimOri> CurV = OriginalTable.GetPosition(OriP);
+	const TVectorX<DimOri> CurT = OriginalTable.GetTangent(OriP);
+	const TVectorX<DimOri> CurOffDir = GetOffsetDirection(CurT, OffsetType);
+
+	// The direction turns with the original spline.
+	TVectorX<DimOri> CurOffDirT = TVecLib<DimOri>::Zero();
+	const double PrevP = FMath::Max(OriP - DirectionStep, OriginalParamRange.Get<0>());
+	const double NextP = FMath::Min(OriP + DirectionStep, OriginalParamRange.Get<1>());
+	if (NextP > PrevP) {
+		CurOffDirT = (GetOffsetDirection(OriginalTable.GetTangent(NextP), OffsetType)
+			- GetOffsetDirection(OriginalTable.GetTangent(PrevP), OffsetType)) / (NextP - PrevP);
+	}
+
+	// dS = |T| dP along the original spline.
+	const double CurTSize = TVecLib<DimOri>::Size(CurT);
+	const double OriPByOffP = FMath::IsNearlyZero(CurTSize) ? 0. : OffT[0] / CurTSize;
+	const double Offset = TVecLib<2>::Last(OffV);
 
-		double& InCurP = OriP.Add_GetRef(InOriginalSpline.GetParameterAtLength(CurKnotS));
-		if (InCurP > OriginalParamRange.Value)
-		{
-			InCurP = OriginalParamRange.Value;
+	OutSample.OffP = OffP;
+	OutSample.OriP = OriP;
+	OutSample.Position = CurV + CurOffDir * Offset;
+	OutSample.Derivative = (CurT + CurOffDirT * Offset) * OriPByOffP + CurOffDir * TVecLib<2>::Last(OffT);
+	OutSample.OriginalTangent = CurT;
+}
+
+template<int32 Degree>
+template<int32 DimOri>
+inline void TOffsetExplicit2Base<Degree>::EvaluateOffset(TOffsetSample<DimOri>& OutSample, double OffP, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable) const
+{
+	const TVectorX<2> OffV = GetPosition(OffP);
+	EvaluateOffsetAt(OutSample, OffP, OffV, GetTangent(OffP), OriginalTable.GetParameterAtLength(OffV[0]), OriginalTable);
+}
+
+template<int32 Degree>
+template<int32 DimOri>
+inline void TOffsetExplicit2Base<Degree>::FindTrimmedRanges(TArray<TOffsetRange<DimOri> >& OutRanges, const TArray<double>& KnotsS, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable) const
+{
+	static constexpr int32 SamplesPerKnot = 16;
+	OutRanges.Reset();
+	TOffsetRange<DimOri>& WholeRange = OutRanges.AddDefaulted_GetRef();
+	WholeRange.From = KnotsS[0];
+	WholeRange.To = KnotsS.Last();
+	if (OffsetType.DirectionType != EOffsetDirectionType::DirT) {
+		return;
+	}
+
+	// Dense samples to find where the offset goes backward.
+	const int32 SampleNum = (KnotsS.Num() - 1) * SamplesPerKnot + 1;
+	TArray<double> OffPs;
+	TArray<TVectorX<2> > OffV;
+	TArray<TVectorX<2> > OffT;
+	TArray<double> OriS;
+	OffPs.Reserve(SampleNum);
+	OffV.Reserve(SampleNum);
+	OffT.Reserve(SampleNum);
+	OriS.Reserve(SampleNum);
+	for (int32 k = 0; k + 1 < KnotsS.Num(); ++k) {
+		for (int32 j = 0; j < SamplesPerKnot; ++j) {
+			OffPs.Add(FMath::Lerp(KnotsS[k], KnotsS[k + 1], static_cast<double>(j) / SamplesPerKnot));
+		}
+	}
+	OffPs.Add(KnotsS.Last());
+	for (double OffP : OffPs) {
+		OffV.Add(GetPosition(OffP));
+		OffT.Add(GetTangent(OffP));
+		OriS.Add(OffV.Last()[0]);
+	}
+	TArray<double> OriP;
+	GetOriginalParameters(OriP, OriS, OriginalTable);
+	TArray<TOffsetSample<DimOri> > Samples;
+	TArray<bool> Reversed;
+	Samples.SetNum(SampleNum);
+	Reversed.SetNumZeroed(SampleNum);
+	bool bAnyReversed = false;
+	for (int32 i = 0; i < SampleNum; ++i) {
+		EvaluateOffsetAt(Samples[i], OffPs[i], OffV[i], OffT[i], OriP[i], OriginalTable);
+		Reversed[i] = TVecLib<DimOri>::Dot(Samples[i].Derivative, Samples[i].OriginalTangent) * OffT[i][0] <= 0.;
+		bAnyReversed |= Reversed[i];
+	}
+	if (!bAnyReversed) {
+		return;
+	}
+
+	auto IntersectXY = [](double& OutT1, double& OutT2, const TVectorX<DimOri>& A0, const TVectorX<DimOri>& A1, const TVectorX<DimOri>& B0, const TVectorX<DimOri>& B1) -> bool {
+		const double D1X = A1[0] - A0[0], D1Y = A1[1] - A0[1];
+		const double D2X = B1[0] - B0[0], D2Y = B1[1] - B0[1];
+		const double RX = B0[0] - A0[0], RY = B0[1] - A0[1];
+		const double Den = D1X * D2Y - D1Y * D2X;
+		if (FMath::IsNearlyZero(Den)) {
+			return false;
 		}
+		OutT1 = (RX * D2Y - RY * D2X) / Den;
+		OutT2 = (RX * D1Y - RY * D1X) / Den;
+		return OutT1 >= 0. && OutT1 <= 1. && OutT2 >= 0. && OutT2 <= 1.;
+	};
 
-		TVectorX<DimOri>& CurV = OriV.Add_GetRef(OffsetInOriginalSpline.GetPosition(InCurP));
-		TVectorX<DimOri>& CurT = OriT.Add_GetRef(InOriginalSpline.GetTangent(InCurP));
+	// A backward run is a cusp, or the inner part of a loop. Cut from the self-intersection before it to the one after it.
+	OutRanges.Reset();
+	double From = KnotsS[0];
+	TOptional<TVectorX<DimOri> > FromPoint;
+	int32 i = 0;
+	while (i < SampleNum) {
+		if (!Reversed[i]) {
+			++i;
+			continue;
+		}
+		const int32 RunStart = i;
+		while (i < SampleNum && Reversed[i]) {
+			++i;
+		}
+		const int32 RunEnd = i - 1;
+		const int32 Window = FMath::Max(8, (RunEnd - RunStart + 1) * 4);
 
-		TVectorX<2>& CurOffV = OffV.Add_GetRef(GetPosition(CurKnotS));
-		TVectorX<2>& CurOffT = OffT.Add_GetRef(GetTangent(CurKnotS));
+		bool bFound = false;
+		double CutFrom = 0., CutTo = 0.;
+		TOptional<TVectorX<DimOri> > JointPoint;
+		int32 ResumeIndex = i;
+		for (int32 j = RunStart - 1; j >= FMath::Max(0, RunStart - Window) && !bFound; --j) {
+			for (int32 k = FMath::Max(RunEnd, j + 2); k < FMath::Min(SampleNum - 1, RunEnd + Window) && !bFound; ++k) {
+				double T1 = 0., T2 = 0.;
+				if (IntersectXY(T1, T2, Samples[j].Position, Samples[j + 1].Position, Samples[k].Position, Samples[k + 1].Position)) {
+					bFound = true;
+					CutFrom = FMath::Lerp(OffPs[j], OffPs[j + 1], T1);
+					CutTo = FMath::Lerp(OffPs[k], OffPs[k + 1], T2);
+					const TVectorX<DimOri> PointA = Samples[j].Position + (Samples[j + 1].Position - Samples[j].Position) * T1;
+					const TVectorX<DimOri> PointB = Samples[k].Position + (Samples[k + 1].Position - Samples[k].Position) * T2;
+					JointPoint = (PointA + PointB) * 0.5;
+					ResumeIndex = k + 1;
+				}
+			}
+		}
+		if (!bFound) {
+			if (RunStart == 0) {
+				// The loop is cut by the start. The range starts on the offset curve, without a joint.
+				From = OffPs[FMath::Min(RunEnd + 1, SampleNum - 1)];
+				FromPoint.Reset();
+				continue;
+			}
+			if (RunEnd == SampleNum - 1) {
+				// The loop is cut by the end.
+				CutFrom = OffPs[RunStart - 1];
+				CutTo = KnotsS.Last();
+			}
+			else {
+				// A cusp without a loop becomes a corner.
+				CutFrom = OffPs[RunStart];
+				CutTo = OffPs[RunEnd];
+				JointPoint = (Samples[RunStart].Position + Samples[RunEnd].Position) * 0.5;
+			}
+		}
+		if (CutFrom < From) {
+			// Inside the previous cut.
+			i = FMath::Max(i, ResumeIndex);
+			continue;
+		}
+		TOffsetRange<DimOri>& Range = OutRanges.AddDefaulted_GetRef();
+		Range.From = From;
+		Range.To = CutFrom;
+		Range.FromPoint = FromPoint;
+		Range.ToPoint = JointPoint;
+		From = CutTo;
+		FromPoint = JointPoint;
+		i = FMath::Max(i, ResumeIndex);
+	}
+	if (From < KnotsS.Last()) {
+		TOffsetRange<DimOri>& Range = OutRanges.AddDefaulted_GetRef();
+		Range.From = From;
+		Range.To = KnotsS.Last();
+		Range.FromPoint = FromPoint;
+	}
+	OutRanges.RemoveAll([](const TOffsetRange<DimOri>& Range) { return Range.To <= Range.From; });
+}
 
-		//double CurTSize = TVecLib<DimOri>::Size(CurT);
-		//CurOffT *= (CurTSize / CurOffT[0]);
+template<int32 Degree>
+template<int32 DimOri>
+inline void TOffsetExplicit2Base<Degree>::FitRangeAdaptive(TArray<TBezierCurve<DimOri, Degree> >& OutCurves, const TOffsetRange<DimOri>& Range, const TSplineArcLengthTable<DimOri, Degree>& OriginalTable, double Tolerance, int32 MaxDepth) const
+{
+	static constexpr int32 CheckNumPerSegment = 8;
+	static constexpr int32 MaxCheckNum = 64;
+	static constexpr double InvDegDbl = 1. / static_cast<double>(Degree);
+	struct FInterval
+	{
+		TOffsetSample<DimOri> Start;
+		TOffsetSample<DimOri> End;
+		int32 Depth = 0;
+	};
+	auto MakeHermite = [](const TOffsetSample<DimOri>& Start, const TOffsetSample<DimOri>& End) {
+		const double Span = (End.OffP - Start.OffP) * InvDegDbl;
+		const TVectorX<DimOri> Points[4] = {
+			Start.Position,
+			Start.Position + Start.Derivative * Span,
+			End.Position - End.Derivative * Span,
+			End.Position, };
+		return TBezierCurve<DimOri, Degree>(Points);
+	};
 
-		double CurTBiProjSize = CurT | CurOffDir;
-		double CurTProjSize = sqrt(TVecLib<DimOri>::SizeSquared(CurT) - CurTBiProjSize * CurTBiProjSize);
-		CurOffT *= CurTProjSize / CurOffT[0];
+	const int32 FirstCurve = OutCurves.Num();
+	TArray<FInterval, TInlineAllocator<32> > Stack;
+	FInterval& Whole = Stack.AddDefaulted_GetRef();
+	EvaluateOffset(Whole.Start, Range.From, OriginalTable);
+	EvaluateOffset(Whole.End, Range.To, OriginalTable);
 
-		switch (OffsetType.DirectionType)
-		{
-		case EOffsetDirectionType::DirZ:
-			CurOffDir = FVector::UpVector * OffsetType.Sgn;
-			break;
-		case EOffsetDirectionType::DirT:
-			CurOffDir = (FVector::UpVector ^ CurT).GetSafeNormal() * OffsetType.Sgn;
-			break;
+	// Depth first with the first half on top, so the curves are in order.
+	const double ToleranceSqr = Tolerance * Tolerance;
+	TOffsetSample<DimOri> Check;
+	while (Stack.Num() > 0) {
+		FInterval Interval = Stack.Pop(false);
+		TBezierCurve<DimOri, Degree> Curve = MakeHermite(Interval.Start, Interval.End);
+		bool bSplit = false;
+		if (Interval.Depth < MaxDepth) {
+			// More checks if the interval covers more segments of the original spline, not to miss the turns.
+			const int32 SegmentNum = FMath::Abs(OriginalTable.FindSegment(Interval.End.OriP) - OriginalTable.FindSegment(Interval.Start.OriP)) + 1;
+			const int32 CheckNum = FMath::Min(CheckNumPerSegment * SegmentNum, MaxCheckNum);
+			for (int32 i = 1; i <= CheckNum && !bSplit; ++i) {
+				const double U = static_cast<double>(i) / (CheckNum + 1);
+				EvaluateOffset(Check, FMath::Lerp(Interval.Start.OffP, Interval.End.OffP, U), OriginalTable);
+				bSplit = TVecLib<DimOri>::SizeSquared(Curve.GetPosition(U) - Check.Position) > ToleranceSqr;
+			}
 		}
+		if (!bSplit) {
+			OutCurves.Add(Curve);
+			continue;
+		}
+		TOffsetSample<DimOri> Mid;
+		EvaluateOffset(Mid, (Interval.Start.OffP + Interval.End.OffP) * 0.5, OriginalTable);
+		Stack.Add(FInterval{ Mid, Interval.End, Interval.Depth + 1 });
+		Stack.Add(FInterval{ Interval.Start, Mid, Interval.Depth + 1 });
+	}
 
-		if (i > 0)
-		{
-			TVectorX<DimOri> PrevTargetV = OriV.Last(1) + OffDirs.Last(1) * TVecLib<2>::Last(OffV.Last(1));
-			TVectorX<DimOri> CurTargetV = CurV + CurOffDir * TVecLib<2>::Last(CurOffV);
-			TVectorX<DimOri> PrevTargetT = OriT.Last(1) + OffDirs.Last(1) * TVecLib<2>::Last(OffT.Last(1));
-			TVectorX<DimOri> CurTargetT = CurT + CurOffDir * TVecLib<2>::Last(CurOffT);
-
-			OutCurves.Add(TBezierCurve<DimOri, Degree>({
-				PrevTargetV,
-				PrevTargetV + PrevTargetT * InvDegDbl,
-				CurTargetV - CurTargetT * InvDegDbl,
-				CurTargetV, }));
+	// Join the trimmed ends at the self-intersections.
+	if (OutCurves.Num() > FirstCurve) {
+		if (Range.FromPoint) {
+			TBezierCurve<DimOri, Degree>& First = OutCurves[FirstCurve];
+			const TVectorX<DimOri> Delta = Range.FromPoint.GetValue() - First.GetPoint(0);
+			First.SetPoint(0, Range.FromPoint.GetValue());
+			First.SetPoint(1, First.GetPoint(1) + Delta);
+		}
+		if (Range.ToPoint) {
+			TBezierCurve<DimOri, Degree>& Last = OutCurves.Last();
+			const TVectorX<DimOri> Delta = Range.ToPoint.GetValue() - Last.GetPoint(Degree);
+			Last.SetPoint(Degree, Range.ToPoint.GetValue());
+			Last.SetPoint(Degree - 1, Last.GetPoint(Degree - 1) + Delta);
 		}
 	}
 }
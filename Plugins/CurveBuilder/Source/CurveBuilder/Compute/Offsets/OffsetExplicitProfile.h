@@ -0,0 +1,98 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Algo/BinarySearch.h"
+#include "../Splines/BSpline.h"
+#include "OffsetExplicitBase.h"
+
+// Offset profile as piecewise polynomials over the arc length. The parameter of the profile is the arc length itself,
+// so GetOffsetAtLength() needs no iteration, and the segment of an arc length is found by binary search of the knots.
+// Use it for variable widths, e.g. of roads.
+template<int32 Degree = 3>
+class TOffsetExplicit2Profile : public TOffsetExplicit2Base<Degree>
+{
+public:
+	using FCurveType = typename TBezierCurve<2, Degree>;
+
+	TOffsetExplicit2Profile() {}
+
+	using TOffsetExplicit2Base<Degree>::MakeCurves;
+
+	// Cubic hermite segments between the knots, with the offsets and their derivatives by the arc length at the knots.
+	bool FromHermite(const TArray<double>& InKnotsS, const TArray<double>& InOffsets, const TArray<double>& InSlopes);
+
+	// Monotone cubic interpolation (Fritsch-Carlson), which doesn't overshoot between the knots.
+	bool FromMonotoneCubic(const TArray<double>& InKnotsS, const TArray<double>& InOffsets);
+
+	// From a 2D profile such as TOffsetExplicit2ClampedBSpline. Return false if the X of the control points of a segment
+	// is not increasing, where the profile may not be a function of the arc length.
+	bool FromBSpline(const TClampedBSpline<2, Degree>& InSpline);
+
+	void Empty();
+
+	FORCEINLINE bool IsEmpty() const { return Curves.Num() == 0; }
+
+	FORCEINLINE int32 GetSegmentNum() const { return Curves.Num(); }
+
+	FORCEINLINE const FCurveType& GetCurve(int32 Segment) const { return Curves[Segment]; }
+
+	// The offsets before the first knot and after the last knot are the ones at the ends.
+	double GetOffset(double S) const;
+
+	// The derivative is by the arc length.
+	void GetOffsetAndDerivative(double& OutOffset, double& OutOffsetDerivative, double S) const;
+
+	// Directly at S, without the solve from InOutParam.
+	virtual bool GetOffsetAtLength(double& OutOffset, double& OutOffsetDerivative, double S, double& InOutParam) const override
+	{
+		GetOffsetAndDerivative(OutOffset, OutOffsetDerivative, S);
+		InOutParam = S;
+		return Curves.Num() > 0;
+	}
+
+	virtual double GetValue(double T) const override { return GetOffset(T); }
+
+	virtual void GetKnotsS(TArray<double>& OutKnotsS) const override { OutKnotsS = KnotsS; }
+
+	virtual int32 GetCtrlPointNum() const override { return KnotsS.Num(); }
+
+	virtual TTuple<double, double> GetParamRange() const override
+	{
+		return KnotsS.Num() > 0 ? MakeTuple(KnotsS[0], KnotsS.Last()) : MakeTuple(-1., -1.);
+	}
+
+	virtual TSharedRef<TOffsetExplicit2Base<Degree> > CreateSameType(int32 EndContinuity = -1) const override
+	{
+		return MakeShared<TOffsetExplicit2Profile<Degree> >();
+	}
+
+	virtual TSharedRef<TOffsetExplicit2Base<Degree> > Copy() const override
+	{
+		return MakeShared<TOffsetExplicit2Profile<Degree> >(*this);
+	}
+
+	// (S, offset at S).
+	virtual TVectorX<2> GetPosition(double T) const override;
+
+	// (1, derivative of the offset at S).
+	virtual TVectorX<2> GetTangent(double T) const override;
+
+protected:
+	int32 FindSegment(double S) const;
+
+	// Local parameter of the segment where its X is S. Exact for the segments linear in X,
+	// otherwise by Newton steps kept in a bracket, since X is increasing in the segment.
+	double SolveLocalParameter(int32 Segment, double S) const;
+
+protected:
+	// KnotsS[i] and KnotsS[i + 1] are the ends of Curves[i].
+	TArray<double> KnotsS;
+	TArray<FCurveType> Curves;
+	// Whether the X of Curves[i] is linear in its local parameter.
+	TArray<bool> LinearX;
+};
+
+#include "OffsetExplicitProfile.inl"
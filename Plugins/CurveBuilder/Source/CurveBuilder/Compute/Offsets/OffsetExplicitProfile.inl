@@ -0,0 +1,210 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "OffsetExplicitProfile.h"
+
+template<int32 Degree>
+inline bool TOffsetExplicit2Profile<Degree>::FromHermite(const TArray<double>& InKnotsS, const TArray<double>& InOffsets, const TArray<double>& InSlopes)
+{
+	static_assert(Degree == 3, "Hermite segments are cubic.");
+	Empty();
+	const int32 KnotNum = InKnotsS.Num();
+	if (KnotNum < 2 || InOffsets.Num() != KnotNum || InSlopes.Num() != KnotNum) {
+		return false;
+	}
+	for (int32 i = 1; i < KnotNum; ++i) {
+		if (InKnotsS[i] <= InKnotsS[i - 1]) {
+			return false;
+		}
+	}
+	KnotsS = InKnotsS;
+	Curves.Reserve(KnotNum - 1);
+	LinearX.Init(true, KnotNum - 1);
+	for (int32 i = 1; i < KnotNum; ++i) {
+		const double Span = (InKnotsS[i] - InKnotsS[i - 1]) / 3.;
+		const TVectorX<2> Points[4] = {
+			TVectorX<2>(InKnotsS[i - 1], InOffsets[i - 1]),
+			TVectorX<2>(InKnotsS[i - 1] + Span, InOffsets[i - 1] + InSlopes[i - 1] * Span),
+			TVectorX<2>(InKnotsS[i] - Span, InOffsets[i] - InSlopes[i] * Span),
+			TVectorX<2>(InKnotsS[i], InOffsets[i]), };
+		Curves.Add(FCurveType(Points));
+	}
+	return true;
+}
+
+template<int32 Degree>
+inline bool TOffsetExplicit2Profile<Degree>::FromMonotoneCubic(const TArray<double>& InKnotsS, const TArray<double>& InOffsets)
+{
+	const int32 KnotNum = InKnotsS.Num();
+	if (KnotNum < 2 || InOffsets.Num() != KnotNum) {
+		Empty();
+		return false;
+	}
+	TArray<double> Secants;
+	Secants.SetNumUninitialized(KnotNum - 1);
+	for (int32 i = 1; i < KnotNum; ++i) {
+		const double Diff = InKnotsS[i] - InKnotsS[i - 1];
+		if (Diff <= 0.) {
+			Empty();
+			return false;
+		}
+		Secants[i - 1] = (InOffsets[i] - InOffsets[i - 1]) / Diff;
+	}
+	TArray<double> Slopes;
+	Slopes.SetNumUninitialized(KnotNum);
+	Slopes[0] = Secants[0];
+	Slopes[KnotNum - 1] = Secants.Last();
+	for (int32 i = 1; i + 1 < KnotNum; ++i) {
+		Slopes[i] = Secants[i - 1] * Secants[i] <= 0. ? 0. : (Secants[i - 1] + Secants[i]) * 0.5;
+	}
+	// Limit the slopes to the monotone region.
+	for (int32 i = 0; i + 1 < KnotNum; ++i) {
+		if (FMath::IsNearlyZero(Secants[i])) {
+			Slopes[i] = 0.;
+			Slopes[i + 1] = 0.;
+			continue;
+		}
+		const double A = Slopes[i] / Secants[i];
+		const double B = Slopes[i + 1] / Secants[i];
+		const double SizeSqr = A * A + B * B;
+		if (SizeSqr > 9.) {
+			const double Tau = 3. / FMath::Sqrt(SizeSqr);
+			Slopes[i] = Tau * A * Secants[i];
+			Slopes[i + 1] = Tau * B * Secants[i];
+		}
+	}
+	return FromHermite(InKnotsS, InOffsets, Slopes);
+}
+
+template<int32 Degree>
+inline bool TOffsetExplicit2Profile<Degree>::FromBSpline(const TClampedBSpline<2, Degree>& InSpline)
+{
+	Empty();
+	TArray<FCurveType> BezierCurves;
+	if (!InSpline.ToBezierCurves(BezierCurves) || BezierCurves.Num() == 0) {
+		return false;
+	}
+	Curves.Reserve(BezierCurves.Num());
+	LinearX.Reserve(BezierCurves.Num());
+	KnotsS.Reserve(BezierCurves.Num() + 1);
+	for (const FCurveType& Curve : BezierCurves) {
+		const double S0 = Curve.GetPoint(0)[0];
+		const double S1 = Curve.GetPoint(Degree)[0];
+		// Equal weights make a polynomial curve, so only then X may be linear.
+		const double W0 = TVecLib<3>::Last(Curve.GetPointHomogeneous(0));
+		bool bLinearX = true;
+		for (int32 j = 1; j <= Degree; ++j) {
+			if (Curve.GetPoint(j)[0] < Curve.GetPoint(j - 1)[0]) {
+				Empty();
+				return false;
+			}
+			const double LinearS = S0 + (S1 - S0) * j / static_cast<double>(Degree);
+			bLinearX = bLinearX && FMath::IsNearlyEqual(Curve.GetPoint(j)[0], LinearS, KINDA_SMALL_NUMBER * FMath::Max(1., S1 - S0))
+				&& FMath::IsNearlyEqual(TVecLib<3>::Last(Curve.GetPointHomogeneous(j)), W0);
+		}
+		if (S1 <= S0) {
+			// Degenerate segments make no length, but a jump of the offset is not a function of the arc length.
+			if (!FMath::IsNearlyEqual(Curve.GetPoint(0)[1], Curve.GetPoint(Degree)[1])) {
+				Empty();
+				return false;
+			}
+			continue;
+		}
+		if (KnotsS.Num() == 0) {
+			KnotsS.Add(S0);
+		}
+		KnotsS.Add(S1);
+		Curves.Add(Curve);
+		LinearX.Add(bLinearX);
+	}
+	return Curves.Num() > 0;
+}
+
+template<int32 Degree>
+inline void TOffsetExplicit2Profile<Degree>::Empty()
+{
+	KnotsS.Reset();
+	Curves.Reset();
+	LinearX.Reset();
+}
+
+template<int32 Degree>
+inline double TOffsetExplicit2Profile<Degree>::GetOffset(double S) const
+{
+	double Offset = 0., OffsetDerivative = 0.;
+	GetOffsetAndDerivative(Offset, OffsetDerivative, S);
+	return Offset;
+}
+
+template<int32 Degree>
+inline void TOffsetExplicit2Profile<Degree>::GetOffsetAndDerivative(double& OutOffset, double& OutOffsetDerivative, double S) const
+{
+	OutOffset = 0.;
+	OutOffsetDerivative = 0.;
+	if (Curves.Num() == 0) {
+		return;
+	}
+	if (S <= KnotsS[0] || S >= KnotsS.Last()) {
+		OutOffset = S <= KnotsS[0] ? Curves[0].GetPoint(0)[1] : Curves.Last().GetPoint(Degree)[1];
+		return;
+	}
+	const int32 Segment = FindSegment(S);
+	const double U = SolveLocalParameter(Segment, S);
+	const FCurveType& Curve = Curves[Segment];
+	const TVectorX<2> Tangent = Curve.GetTangent(U);
+	OutOffset = Curve.GetPosition(U)[1];
+	OutOffsetDerivative = Tangent[0] > 0. ? Tangent[1] / Tangent[0] : 0.;
+}
+
+template<int32 Degree>
+inline TVectorX<2> TOffsetExplicit2Profile<Degree>::GetPosition(double T) const
+{
+	return TVectorX<2>(T, GetOffset(T));
+}
+
+template<int32 Degree>
+inline TVectorX<2> TOffsetExplicit2Profile<Degree>::GetTangent(double T) const
+{
+	double Offset = 0., OffsetDerivative = 0.;
+	GetOffsetAndDerivative(Offset, OffsetDerivative, T);
+	return TVectorX<2>(1., OffsetDerivative);
+}
+
+template<int32 Degree>
+inline int32 TOffsetExplicit2Profile<Degree>::FindSegment(double S) const
+{
+	return FMath::Clamp(Algo::UpperBound(KnotsS, S) - 1, 0, Curves.Num() - 1);
+}
+
+template<int32 Degree>
+inline double TOffsetExplicit2Profile<Degree>::SolveLocalParameter(int32 Segment, double S) const
+{
+	static constexpr int32 Iteration = 16;
+	const double S0 = KnotsS[Segment];
+	const double Diff = KnotsS[Segment + 1] - S0;
+	double U = FMath::Clamp((S - S0) / Diff, 0., 1.);
+	if (LinearX[Segment]) {
+		return U;
+	}
+	const FCurveType& Curve = Curves[Segment];
+	const double Tolerance = Diff * 1e-6;
+	double Low = 0., High = 1.;
+	for (int32 i = 0; i < Iteration; ++i) {
+		const double Error = Curve.GetPosition(U)[0] - S;
+		if (FMath::Abs(Error) <= Tolerance) {
+			break;
+		}
+		if (Error < 0.) {
+			Low = U;
+		}
+		else {
+			High = U;
+		}
+		const double DX = Curve.GetTangent(U)[0];
+		const double Next = DX > 0. ? U - Error / DX : -1.;
+		U = Next > Low && Next < High ? Next : (Low + High) * 0.5;
+	}
+	return U;
+}
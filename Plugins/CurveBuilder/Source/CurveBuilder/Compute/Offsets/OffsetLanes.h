@@ -0,0 +1,67 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OffsetExplicitBase.h"
+#include "../Splines/SplineArcLengthTable.h"
+#include "../Splines/SplineFrameTable.h"
+
+// Many offsets of the same spline at once, such as the lane lines, shoulders and kerbs of a road.
+// All the lanes share a grid of arc lengths, so the original spline is evaluated once for each sample,
+// then each lane only adds its offset. The profiles are referenced, not copied.
+template<int32 Degree = 3>
+class TOffsetLanes
+{
+public:
+	static_assert(Degree == 3, "Offset curves are made as cubic hermite curves.");
+
+	using FProfileType = typename TOffsetExplicit2Base<Degree>;
+	using FCurveType = typename TBezierCurve<3, Degree>;
+	using FTableType = typename TSplineArcLengthTable<3, Degree>;
+	using FFrameTableType = typename TSplineFrameTable<Degree>;
+
+	// The offset is Distance, or from the profile if it is set.
+	struct FLane
+	{
+		double Distance = 0.;
+		const FProfileType* Profile = nullptr;
+		FOffsetType OffsetType;
+	};
+
+public:
+	FORCEINLINE int32 AddLane(double Distance, const FOffsetType& OffsetType = FOffsetType())
+	{
+		return Lanes.Add(FLane{ Distance, nullptr, OffsetType });
+	}
+
+	FORCEINLINE int32 AddLane(const FProfileType& Profile)
+	{
+		return Lanes.Add(FLane{ 0., &Profile, Profile.GetOffsetType() });
+	}
+
+	FORCEINLINE void Empty() { Lanes.Empty(); }
+
+	FORCEINLINE int32 GetLaneNum() const { return Lanes.Num(); }
+
+	FORCEINLINE const FLane& GetLane(int32 Index) const { return Lanes[Index]; }
+
+	// Curves of each lane, in the order of the lanes. The grid has the joints of the original spline and the knots
+	// of the profiles, and each interval of them is divided into SubdivisionNum curves.
+	void MakeCurves(TArray<TArray<FCurveType> >& OutLaneCurves, const FTableType& OriginalTable, int32 SubdivisionNum = 2) const;
+
+	// The lateral and up directions are the binormals and normals of the rotation minimizing frames,
+	// instead of UpVector ^ Tangent and UpVector, so the lanes do not flip on vertical tangents.
+	void MakeCurves(TArray<TArray<FCurveType> >& OutLaneCurves, const FFrameTableType& OriginalFrames, int32 SubdivisionNum = 2) const;
+
+	void MakeSampleLengths(TArray<double>& OutLengths, const FTableType& OriginalTable, int32 SubdivisionNum = 2) const;
+
+protected:
+	void MakeCurvesInternal(TArray<TArray<FCurveType> >& OutLaneCurves, const FTableType& OriginalTable, const FFrameTableType* OriginalFrames, int32 SubdivisionNum) const;
+
+protected:
+	TArray<FLane> Lanes;
+};
+
+#include "OffsetLanes.inl"
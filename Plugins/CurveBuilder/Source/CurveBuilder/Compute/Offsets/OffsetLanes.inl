@@ -0,0 +1,198 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "OffsetLanes.h"
+
+template<int32 Degree>
+inline void TOffsetLanes<Degree>::MakeSampleLengths(TArray<double>& OutLengths, const FTableType& OriginalTable, int32 SubdivisionNum) const
+{
+	OutLengths.Reset();
+	if (OriginalTable.IsEmpty()) {
+		return;
+	}
+	const double TotalLength = OriginalTable.GetTotalLength();
+
+	TArray<double> Breaks;
+	Breaks.Reserve(OriginalTable.GetSegmentNum() + 1);
+	for (int32 i = 0; i < OriginalTable.GetSegmentNum(); ++i) {
+		Breaks.Add(OriginalTable.GetLengthAtParameter(OriginalTable.GetSegmentParamRange(i).Get<0>()));
+	}
+	Breaks.Add(TotalLength);
+	TArray<double> KnotLengths;
+	for (const FLane& Lane : Lanes) {
+		if (Lane.Profile) {
+			Lane.Profile->GetKnotLengths(KnotLengths);
+			Breaks.Append(KnotLengths);
+		}
+	}
+	for (double& Break : Breaks) {
+		Break = FMath::Clamp(Break, 0., TotalLength);
+	}
+	Breaks.Sort();
+
+	SubdivisionNum = FMath::Max(SubdivisionNum, 1);
+	const double InvSubdivisionNum = 1. / static_cast<double>(SubdivisionNum);
+	OutLengths.Reserve(Breaks.Num() * SubdivisionNum);
+	OutLengths.Add(Breaks[0]);
+	for (int32 i = 1; i < Breaks.Num(); ++i) {
+		const double From = OutLengths.Last();
+		if (FMath::IsNearlyEqual(Breaks[i], From, KINDA_SMALL_NUMBER)) {
+			continue;
+		}
+		for (int32 k = 1; k <= SubdivisionNum; ++k) {
+			OutLengths.Add(FMath::Lerp(From, Breaks[i], k * InvSubdivisionNum));
+		}
+	}
+}
+
+template<int32 Degree>
+inline void TOffsetLanes<Degree>::MakeCurves(TArray<TArray<FCurveType> >& OutLaneCurves, const FTableType& OriginalTable, int32 SubdivisionNum) const
+{
+	MakeCurvesInternal(OutLaneCurves, OriginalTable, nullptr, SubdivisionNum);
+}
+
+template<int32 Degree>
+inline void TOffsetLanes<Degree>::MakeCurves(TArray<TArray<FCurveType> >& OutLaneCurves, const FFrameTableType& OriginalFrames, int32 SubdivisionNum) const
+{
+	MakeCurvesInternal(OutLaneCurves, OriginalFrames.GetArcLengthTable(), &OriginalFrames, SubdivisionNum);
+}
+
+template<int32 Degree>
+inline void TOffsetLanes<Degree>::MakeCurvesInternal(TArray<TArray<FCurveType> >& OutLaneCurves, const FTableType& OriginalTable, const FFrameTableType* OriginalFrames, int32 SubdivisionNum) const
+{
+	static constexpr double InvDegDbl = 1. / static_cast<double>(Degree);
+	const int32 LaneNum = Lanes.Num();
+	OutLaneCurves.Reset();
+	OutLaneCurves.SetNum(LaneNum);
+
+	TArray<double> Lengths;
+	MakeSampleLengths(Lengths, OriginalTable, SubdivisionNum);
+	const int32 SampleNum = Lengths.Num();
+	if (SampleNum < 2 || LaneNum == 0) {
+		return;
+	}
+	TArray<double> OriP;
+	OriginalTable.GetParametersAtLengths(OriP, Lengths);
+
+	// Offsets and their derivatives by the arc length, sample by sample. Each profile is swept forward once.
+	TArray<double> Offsets;
+	TArray<double> OffsetDerivatives;
+	Offsets.SetNumUninitialized(SampleNum * LaneNum);
+	OffsetDerivatives.SetNumUninitialized(SampleNum * LaneNum);
+	for (int32 l = 0; l < LaneNum; ++l) {
+		const FLane& Lane = Lanes[l];
+		double ProfileParam = Lane.Profile ? Lane.Profile->GetParamRange().Get<0>() : 0.;
+		for (int32 k = 0; k < SampleNum; ++k) {
+			double& Offset = Offsets[k * LaneNum + l];
+			double& OffsetDerivative = OffsetDerivatives[k * LaneNum + l];
+			Offset = Lane.Distance;
+			OffsetDerivative = 0.;
+			if (Lane.Profile && !Lane.Profile->GetOffsetAtLength(Offset, OffsetDerivative, Lengths[k], ProfileParam)) {
+				Offset = 0.;
+			}
+		}
+	}
+
+	// Signs of the offset along the lateral direction and the up direction, so that the lanes are done without branches.
+	TArray<double> LateralSgns;
+	TArray<double> UpSgns;
+	LateralSgns.Reserve(LaneNum);
+	UpSgns.Reserve(LaneNum);
+	for (const FLane& Lane : Lanes) {
+		const bool bLateral = Lane.OffsetType.DirectionType == EOffsetDirectionType::DirT;
+		LateralSgns.Add(bLateral ? Lane.OffsetType.Sgn : 0.);
+		UpSgns.Add(bLateral ? 0. : Lane.OffsetType.Sgn);
+	}
+
+	// The frame of the original spline once for each sample, then all the lanes.
+	const TTuple<double, double>& OriginalParamRange = OriginalTable.GetParamRange();
+	const double DirectionStep = (OriginalParamRange.Get<1>() - OriginalParamRange.Get<0>()) * 1e-5;
+	const FOffsetType LateralType{ EOffsetDirectionType::DirT, 1. };
+	auto GetDirections = [&OriginalTable, OriginalFrames, &LateralType](FVector& OutLateral, FVector& OutUp, double P) {
+		if (OriginalFrames) {
+			const typename FFrameTableType::FFrame Frame = OriginalFrames->GetFrame(P);
+			OutLateral = Frame.Binormal;
+			OutUp = Frame.Normal;
+		}
+		else {
+			OutLateral = FProfileType::GetOffsetDirection(OriginalTable.GetTangent(P), LateralType);
+			OutUp = FVector::UpVector;
+		}
+	};
+	// Positions and derivatives by components, each in [sample][lane] order, so the loops over the lanes are vectorized.
+	TArray<double> Positions[3];
+	TArray<double> Derivatives[3];
+	for (int32 c = 0; c < 3; ++c) {
+		Positions[c].SetNumUninitialized(SampleNum * LaneNum);
+		Derivatives[c].SetNumUninitialized(SampleNum * LaneNum);
+	}
+	TArray<double> LateralOffsets, UpOffsets, LateralRates, UpRates;
+	LateralOffsets.SetNumUninitialized(LaneNum);
+	UpOffsets.SetNumUninitialized(LaneNum);
+	LateralRates.SetNumUninitialized(LaneNum);
+	UpRates.SetNumUninitialized(LaneNum);
+	for (int32 k = 0; k < SampleNum; ++k) {
+		const double P = OriP[k];
+		const FVector V = OriginalTable.GetPosition(P);
+		const FVector T = OriginalTable.GetTangent(P);
+		const double TSize = TVecLib<3>::Size(T);
+		const FVector UnitT = FMath::IsNearlyZero(TSize) ? FVector::ZeroVector : T / TSize;
+		FVector Lateral, Up;
+		GetDirections(Lateral, Up, P);
+
+		// The directions turn with the original spline.
+		FVector LateralByS = FVector::ZeroVector;
+		FVector UpByS = FVector::ZeroVector;
+		const double PrevP = FMath::Max(P - DirectionStep, OriginalParamRange.Get<0>());
+		const double NextP = FMath::Min(P + DirectionStep, OriginalParamRange.Get<1>());
+		if (NextP > PrevP && !FMath::IsNearlyZero(TSize)) {
+			FVector PrevLateral, PrevUp, NextLateral, NextUp;
+			GetDirections(PrevLateral, PrevUp, PrevP);
+			GetDirections(NextLateral, NextUp, NextP);
+			const double InvDiff = 1. / ((NextP - PrevP) * TSize);
+			LateralByS = (NextLateral - PrevLateral) * InvDiff;
+			UpByS = (NextUp - PrevUp) * InvDiff;
+		}
+
+		const double* SampleOffsets = Offsets.GetData() + k * LaneNum;
+		const double* SampleOffsetDerivatives = OffsetDerivatives.GetData() + k * LaneNum;
+		for (int32 l = 0; l < LaneNum; ++l) {
+			LateralOffsets[l] = LateralSgns[l] * SampleOffsets[l];
+			UpOffsets[l] = UpSgns[l] * SampleOffsets[l];
+			LateralRates[l] = LateralSgns[l] * SampleOffsetDerivatives[l];
+			UpRates[l] = UpSgns[l] * SampleOffsetDerivatives[l];
+		}
+		for (int32 c = 0; c < 3; ++c) {
+			const double VC = V[c], TC = UnitT[c], LateralC = Lateral[c], UpC = Up[c], LateralBySC = LateralByS[c], UpBySC = UpByS[c];
+			double* SamplePositions = Positions[c].GetData() + k * LaneNum;
+			double* SampleDerivatives = Derivatives[c].GetData() + k * LaneNum;
+			for (int32 l = 0; l < LaneNum; ++l) {
+				SamplePositions[l] = VC + LateralC * LateralOffsets[l] + UpC * UpOffsets[l];
+				SampleDerivatives[l] = TC + LateralBySC * LateralOffsets[l] + UpBySC * UpOffsets[l]
+					+ LateralC * LateralRates[l] + UpC * UpRates[l];
+			}
+		}
+	}
+
+	auto GetSample = [LaneNum](const TArray<double> (&Components)[3], int32 k, int32 l) -> TVectorX<3> {
+		const int32 Index = k * LaneNum + l;
+		return TVectorX<3>(Components[0][Index], Components[1][Index], Components[2][Index]);
+	};
+	for (int32 l = 0; l < LaneNum; ++l) {
+		TArray<FCurveType>& Curves = OutLaneCurves[l];
+		Curves.Reserve(SampleNum - 1);
+		for (int32 k = 1; k < SampleNum; ++k) {
+			const double Span = (Lengths[k] - Lengths[k - 1]) * InvDegDbl;
+			const TVectorX<3> PrevV = GetSample(Positions, k - 1, l);
+			const TVectorX<3> CurV = GetSample(Positions, k, l);
+			const TVectorX<3> Points[4] = {
+				PrevV,
+				PrevV + GetSample(Derivatives, k - 1, l) * Span,
+				CurV - GetSample(Derivatives, k, l) * Span,
+				CurV, };
+			Curves.Add(FCurveType(Points));
+		}
+	}
+}
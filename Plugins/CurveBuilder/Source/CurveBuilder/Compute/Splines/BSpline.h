@@ -5,6 +5,7 @@
 
 #include "SplineBase.h"
 #include "Containers/List.h"
+#include "Algo/BinarySearch.h"
 #include "Utils/LinearAlgebraUtils.h"
 #include "Utils/NumericalCalculationUtils.h"
 #include "Curves/BezierCurve.h"
@@ -125,6 +126,10 @@ public:
 	// Insert a knot.
 	virtual FPointNode* AddPointWithParamWithoutChangingShape(double T);
 
+	// Insert many knots at once (knot refinement). Params out of range or equal to existing knots are skipped.
+	// Returns the number of new nodes.
+	virtual int32 InsertParamsWithoutChangingShape(TArray<FPointNode*>& OutNewNodes, TArrayView<const double> InParams);
+
 	virtual bool AdjustCtrlPointPos(FPointNode* Node, const TVectorX<Dim>& To, int32 NthPointOfFrom = 0);
 
 	//virtual void AdjustCtrlPointParam(double From, double To, int32 NthPointOfFrom = 0);
@@ -666,6 +666,124 @@ inline typename TClampedBSpline<Dim, Degree>::FPointNode* TClampedBSpline<Dim, D
 	//}
 }
 
+template<int32 Dim, int32 Degree>
+inline int32 TClampedBSpline<Dim, Degree>::InsertParamsWithoutChangingShape(TArray<FPointNode*>& OutNewNodes, TArrayView<const double> InParams)
+{
+	OutNewNodes.Reset();
+	if (CtrlPointsList.Num() <= 1 || InParams.Num() == 0) {
+		return 0;
+	}
+
+	TArray<TVectorX<Dim+1> > CtrlPoints;
+	TArray<double> Params;
+	GetCtrlPoints(CtrlPoints);
+	GetClampedKnotIntervals(Params);
+	const int32 n = CtrlPoints.Num() - 1;
+	const int32 m = Params.Num() - 1;
+	if (m != n + Degree + 1) {
+		return 0;
+	}
+
+	TArray<double> NewKnots;
+	NewKnots.Reserve(InParams.Num());
+	for (double T : InParams) {
+		if (Params[Degree] < T && T < Params[n + 1]) {
+			NewKnots.Add(T);
+		}
+	}
+	NewKnots.Sort();
+	int32 NewKnotNum = 0;
+	for (int32 i = 0; i < NewKnots.Num(); ++i) {
+		int32 Span = Algo::UpperBound(Params, NewKnots[i]) - 1;
+		if ((NewKnotNum > 0 && FMath::IsNearlyEqual(NewKnots[i], NewKnots[NewKnotNum - 1]))
+			|| FMath::IsNearlyEqual(NewKnots[i], Params[Span]) || FMath::IsNearlyEqual(NewKnots[i], Params[Span + 1])) {
+			continue;
+		}
+		NewKnots[NewKnotNum++] = NewKnots[i];
+	}
+	NewKnots.SetNum(NewKnotNum, false);
+	if (NewKnotNum == 0) {
+		return 0;
+	}
+
+	// Reference: The NURBS Book, Algorithm A5.4 (RefineKnotVectCurve).
+	const int32 r = NewKnotNum - 1;
+	const int32 a = Algo::UpperBound(Params, NewKnots[0]) - 1;
+	const int32 b = Algo::UpperBound(Params, NewKnots[r]);
+	TArray<TVectorX<Dim+1> > NewCtrlPoints;
+	TArray<double> NewParams;
+	NewCtrlPoints.SetNum(n + r + 2);
+	NewParams.SetNum(m + r + 2);
+	for (int32 j = 0; j <= a - Degree; ++j) {
+		NewCtrlPoints[j] = CtrlPoints[j];
+	}
+	for (int32 j = b - 1; j <= n; ++j) {
+		NewCtrlPoints[j + r + 1] = CtrlPoints[j];
+	}
+	for (int32 j = 0; j <= a; ++j) {
+		NewParams[j] = Params[j];
+	}
+	for (int32 j = b + Degree; j <= m; ++j) {
+		NewParams[j + r + 1] = Params[j];
+	}
+	int32 i = b + Degree - 1;
+	int32 k = b + Degree + r;
+	for (int32 j = r; j >= 0; --j) {
+		while (NewKnots[j] <= Params[i] && i > a) {
+			NewCtrlPoints[k - Degree - 1] = CtrlPoints[i - Degree - 1];
+			NewParams[k] = Params[i];
+			--k;
+			--i;
+		}
+		NewCtrlPoints[k - Degree - 1] = NewCtrlPoints[k - Degree];
+		for (int32 l = 1; l <= Degree; ++l) {
+			int32 Index = k - Degree + l;
+			double Alpha = NewParams[k + l] - NewKnots[j];
+			if (FMath::IsNearlyZero(Alpha)) {
+				NewCtrlPoints[Index - 1] = NewCtrlPoints[Index];
+			}
+			else {
+				Alpha /= NewParams[k + l] - Params[i - Degree + l];
+				NewCtrlPoints[Index - 1] = NewCtrlPoints[Index - 1] * Alpha + NewCtrlPoints[Index] * (1. - Alpha);
+			}
+		}
+		NewParams[k] = NewKnots[j];
+		--k;
+	}
+
+	// Same node order as inserting the knots one by one in ascending order,
+	// where the j-th knot in span s adds the node at (s + j - Degree + 1).
+	OutNewNodes.Reserve(NewKnotNum);
+	FPointNode* Node = CtrlPointsList.GetHead();
+	int32 NextNewKnot = 0;
+	int32 NextNewNodeIndex = Algo::UpperBound(Params, NewKnots[0]) - Degree;
+	for (int32 Index = 0; Index < NewCtrlPoints.Num(); ++Index) {
+		if (Index == NextNewNodeIndex) {
+			if (Node) {
+				CtrlPointsList.InsertNode(MakeShared<FControlPointType>(NewCtrlPoints[Index]), Node);
+				OutNewNodes.Add(Node->GetPrevNode());
+			}
+			else {
+				CtrlPointsList.AddTail(MakeShared<FControlPointType>(NewCtrlPoints[Index]));
+				OutNewNodes.Add(CtrlPointsList.GetTail());
+			}
+			if (++NextNewKnot < NewKnotNum) {
+				NextNewNodeIndex = Algo::UpperBound(Params, NewKnots[NextNewKnot]) + NextNewKnot - Degree;
+			}
+		}
+		else {
+			Node->GetValueRef().Pos = NewCtrlPoints[Index];
+			Node = Node->GetNextNode();
+		}
+	}
+
+	KnotIntervals.Reset(NewParams.Num() - (Degree << 1));
+	for (int32 j = Degree; j < NewParams.Num() - Degree; ++j) {
+		KnotIntervals.Add(NewParams[j]);
+	}
+	return NewKnotNum;
+}
+
 template<int32 Dim, int32 Degree>
 inline bool TClampedBSpline<Dim, Degree>::AdjustCtrlPointPos(FPointNode* Node, const TVectorX<Dim>& To, int32 NthPointOfFrom)
 {
@@ -5,6 +5,7 @@
 
 #include "SplineBase.h"
 #include "Containers/List.h"
+#include "Algo/BinarySearch.h"
 #include "Utils/LinearAlgebraUtils.h"
 #include "Utils/NumericalCalculationUtils.h"
 #include "Curves/BezierCurve.h"
@@ -56,7 +57,7 @@ public:
 
 	FORCEINLINE void FromCurveArray(const TArray<TBezierCurve<Dim, 3> >& InCurves);
 
-	FORCEINLINE void Reset() { Type = ESplineType::BezierString; CtrlPointsList.Empty(); }
+	FORCEINLINE void Reset() { Type = ESplineType::BezierString; CtrlPointsList.Empty(); NodeCache.Empty(); ParamCache.Empty(); SegmentCache.Empty(); }
 
 	FORCEINLINE void Reset(
 		const TArray<TVectorX<Dim+1>>& InPos, 
@@ -65,7 +66,8 @@ public:
 		const TArray<double>& InParams, 
 		const TArray<EEndPointContinuity>& InContinuities);
 
-	FORCEINLINE void RemakeC2() { UpdateBezierString(nullptr); }
+	// If closed, the first point is repeated as the last point, and the string is C2 at the seam.
+	void RemakeC2(bool bClosed = false);
 
 	virtual ~TBezierString3() { CtrlPointsList.Empty(); }
 
@@ -98,6 +100,24 @@ public:
 
 	virtual bool ToBezierCurves(TArray<TBezierCurve<Dim, 3> >& BezierCurves, TArray<TTuple<double, double> >* ParamRangesPtr = nullptr) const override;
 
+	// Segments are cached contiguously and kept up to date by the mutators.
+	// Call this after modifying the control point structs directly.
+	void RebuildSegmentCache();
+
+	FORCEINLINE const TArray<TBezierCurve<Dim, 3> >& GetSegments() const { return SegmentCache; }
+
+	// Overwrite the control point at the index in place, so the struct referenced by others is kept.
+	// Only the two segments around it are refreshed.
+	void SetCtrlPointAt(int32 Index, const FControlPointType& Point);
+
+	// Binary search, or O(1) if SegmentHint is the segment of the last query (or the one after it).
+	int32 FindSegmentIndex(double T, int32 SegmentHint = INDEX_NONE) const;
+
+	// For sequential queries. InOutSegmentHint receives the segment found.
+	TVectorX<Dim> GetPosition(double T, int32& InOutSegmentHint) const;
+
+	TVectorX<Dim> GetTangent(double T, int32& InOutSegmentHint) const;
+
 public:
 	virtual int32 GetCtrlPointNum() const override
 	{
@@ -128,6 +148,10 @@ public:
 
 	virtual FPointNode* AddPointWithParamWithoutChangingShape(double T);
 
+	// Sort the params and split each segment at all of its params in one sweep.
+	// Params out of range or equal to existing ones are skipped. Returns the number of new nodes.
+	virtual int32 InsertParamsWithoutChangingShape(TArray<FPointNode*>& OutNewNodes, TArrayView<const double> InParams);
+
 	virtual void AdjustCtrlPointParam(double From, double To, int32 NthPointOfFrom = 0);
 
 	virtual void ChangeCtrlPointContinuous(double From, EEndPointContinuity Continuity, int32 NthPointOfFrom = 0);
@@ -140,6 +164,10 @@ public:
 
 	virtual bool AdjustCtrlPointPos(FPointNode* Node, const TVectorX<Dim>& To, int32 NthPointOfFrom = 0);
 
+	// Keep C2 by re-solving tangents only in a window around the node. The window is sized by the
+	// relative Tolerance, and covers the whole string (full solve in place) if the string is short.
+	virtual bool AdjustCtrlPointPosC2Locally(FPointNode* Node, const TVectorX<Dim>& To, double Tolerance = 1e-4);
+
 public:
 	virtual void AddPointAtLast(const TVectorX<Dim>& Point, TOptional<double> Param = TOptional<double>(), double Weight = 1.) override;
 
@@ -178,13 +206,32 @@ public:
 protected:
 	TDoubleLinkedList<FControlPointTypeRef> CtrlPointsList;
 
+	// Same order as CtrlPointsList. SegmentCache[i] is the curve from NodeCache[i] to NodeCache[i + 1].
+	TArray<FPointNode*> NodeCache;
+	TArray<double> ParamCache;
+	TArray<TBezierCurve<Dim, 3> > SegmentCache;
+
+	int32 FindNodeIndex(const FPointNode* Node) const;
+
+	void RefreshSegmentCache(int32 FirstSegment, int32 LastSegment);
+
+	void RefreshSegmentCacheByNode(const FPointNode* Node);
+
+	void InsertToSegmentCache(FPointNode* NewNode, int32 Index);
+
+	void RemoveNodeWithSegmentCache(FPointNode* Node);
+
 	double GetNormalizedParam(const FPointNode* StartNode, const FPointNode* EndNode, double T) const;
 
+	double GetNormalizedParam(int32 SegmentIndex, double T) const;
+
 	TBezierCurve<Dim, 3> MakeBezierCurve(const FPointNode* StartNode, const FPointNode* EndNode) const;
 
 	void UpdateBezierString(FPointNode* NodeToUpdateFirst = nullptr);
 
 	bool AdjustPointByStaticPointReturnShouldSpread(FPointNode* Node, bool bFromNext = true);
+
+	void UpdateBezierStringC2Locally(FPointNode* Node, const TVectorX<Dim>& PosDiff, double Tolerance);
 };
 
 template<int32 Dim>
@@ -14,6 +14,7 @@ inline TBezierString3<Dim>::TBezierString3(const TBezierString3<Dim>& InSpline)
 	for (const FControlPointTypeRef& Pos : InSpline.CtrlPointsList) {
 		CtrlPointsList.AddTail(MakeShared<FControlPointType>(Pos.Get()));
 	}
+	RebuildSegmentCache();
 }
 
 template<int32 Dim>
@@ -31,6 +32,7 @@ inline TBezierString3<Dim>& TBezierString3<Dim>::operator=(const TBezierString3<
 	for (const FControlPointTypeRef& Pos : InSpline.CtrlPointsList) {
 		CtrlPointsList.AddTail(MakeShared<FControlPointType>(Pos.Get()));
 	}
+	RebuildSegmentCache();
 	return *this;
 }
 
@@ -62,6 +64,7 @@ inline void TBezierString3<Dim>::FromCurveArray(const TArray<TBezierCurve<Dim, 3
 			NextCtrlPointPos,
 			static_cast<double>(InCurves.Num())));
 	}
+	RebuildSegmentCache();
 }
 
 template<int32 Dim>
@@ -78,6 +81,7 @@ inline void TBezierString3<Dim>::Reset(
 	{
 		CtrlPointsList.AddTail(MakeShared<FControlPointType>(InPos[i], InPrev[i], InNext[i], InParams[i], InContinuities[i]));
 	}
+	RebuildSegmentCache();
 }
 
 template<int32 Dim>
@@ -196,31 +200,146 @@ inline void TBezierString3<Dim>::GetCtrlParams(TArray<double>& CtrlParams) const
 template<int32 Dim>
 inline bool TBezierString3<Dim>::ToBezierCurves(TArray<TBezierCurve<Dim, 3> >& BezierCurves, TArray<TTuple<double, double> >* ParamRangesPtr) const
 {
-	FPointNode* Node = CtrlPointsList.GetHead();
-	if (!Node) {
+	if (CtrlPointsList.Num() == 0) {
 		return false;
 	}
-	BezierCurves.Empty(CtrlPointsList.Num() - 1);
+	BezierCurves = SegmentCache;
 	if (ParamRangesPtr)
 	{
-		ParamRangesPtr->Empty(CtrlPointsList.Num() - 1);
-	}
-	FPointNode* NextNode = Node->GetNextNode();
-	while (Node && NextNode) {
-		const auto& NodeVal = Node->GetValueRef();
-		const auto& NextNodeVal = NextNode->GetValueRef();
-		TArray<TVectorX<Dim+1> > CtrlPoints{ NodeVal.Pos, NodeVal.NextCtrlPointPos, NextNodeVal.PrevCtrlPointPos, NextNodeVal.Pos };
-		BezierCurves.Emplace(CtrlPoints);
-		if (ParamRangesPtr)
-		{
-			ParamRangesPtr->Emplace(MakeTuple(NodeVal.Param, NextNodeVal.Param));
+		ParamRangesPtr->Empty(SegmentCache.Num());
+		for (int32 i = 0; i < SegmentCache.Num(); ++i) {
+			ParamRangesPtr->Emplace(MakeTuple(ParamCache[i], ParamCache[i + 1]));
 		}
-		Node = Node->GetNextNode();
-		NextNode = Node->GetNextNode();
 	}
 	return true;
 }
 
+template<int32 Dim>
+inline void TBezierString3<Dim>::RebuildSegmentCache()
+{
+	const int32 Num = CtrlPointsList.Num();
+	NodeCache.Reset(Num);
+	ParamCache.Reset(Num);
+	SegmentCache.Reset(FMath::Max(Num - 1, 0));
+	for (FPointNode* Node = CtrlPointsList.GetHead(); Node; Node = Node->GetNextNode()) {
+		NodeCache.Add(Node);
+		ParamCache.Add(Node->GetValueRef().Param);
+		if (Node->GetNextNode()) {
+			SegmentCache.Add(MakeBezierCurve(Node, Node->GetNextNode()));
+		}
+	}
+}
+
+template<int32 Dim>
+inline void TBezierString3<Dim>::SetCtrlPointAt(int32 Index, const FControlPointType& Point)
+{
+	if (NodeCache.Num() != CtrlPointsList.Num()) {
+		RebuildSegmentCache();
+	}
+	if (!NodeCache.IsValidIndex(Index)) {
+		return;
+	}
+	FControlPointType& PointToSet = NodeCache[Index]->GetValue().Get();
+	PointToSet = Point;
+	// Continuity is not assigned by operator=.
+	PointToSet.Continuity = Point.Continuity;
+	ParamCache[Index] = PointToSet.Param;
+	RefreshSegmentCache(Index - 1, Index);
+}
+
+template<int32 Dim>
+inline int32 TBezierString3<Dim>::FindSegmentIndex(double T, int32 SegmentHint) const
+{
+	const int32 SegNum = SegmentCache.Num();
+	if (SegNum == 0) {
+		return INDEX_NONE;
+	}
+	if (SegmentHint >= 0 && SegmentHint < SegNum) {
+		if (ParamCache[SegmentHint] <= T && T < ParamCache[SegmentHint + 1]) {
+			return SegmentHint;
+		}
+		if (SegmentHint + 1 < SegNum && ParamCache[SegmentHint + 1] <= T && T < ParamCache[SegmentHint + 2]) {
+			return SegmentHint + 1;
+		}
+	}
+	return FMath::Clamp(Algo::UpperBound(ParamCache, T) - 1, 0, SegNum - 1);
+}
+
+template<int32 Dim>
+inline int32 TBezierString3<Dim>::FindNodeIndex(const FPointNode* Node) const
+{
+	if (!Node) {
+		return INDEX_NONE;
+	}
+	const double Param = Node->GetValueRef().Param;
+	for (int32 i = Algo::LowerBound(ParamCache, Param); i < NodeCache.Num() && ParamCache[i] <= Param; ++i) {
+		if (NodeCache[i] == Node) {
+			return i;
+		}
+	}
+	// The param of the node may be changed.
+	return NodeCache.Find(const_cast<FPointNode*>(Node));
+}
+
+template<int32 Dim>
+inline void TBezierString3<Dim>::RefreshSegmentCache(int32 FirstSegment, int32 LastSegment)
+{
+	FirstSegment = FMath::Max(FirstSegment, 0);
+	LastSegment = FMath::Min(LastSegment, SegmentCache.Num() - 1);
+	for (int32 i = FirstSegment; i <= LastSegment; ++i) {
+		SegmentCache[i] = MakeBezierCurve(NodeCache[i], NodeCache[i + 1]);
+		ParamCache[i] = NodeCache[i]->GetValueRef().Param;
+		ParamCache[i + 1] = NodeCache[i + 1]->GetValueRef().Param;
+	}
+}
+
+template<int32 Dim>
+inline void TBezierString3<Dim>::RefreshSegmentCacheByNode(const FPointNode* Node)
+{
+	int32 Index = FindNodeIndex(Node);
+	if (Index == INDEX_NONE || NodeCache.Num() != CtrlPointsList.Num()) {
+		RebuildSegmentCache();
+		return;
+	}
+	ParamCache[Index] = Node->GetValueRef().Param;
+	RefreshSegmentCache(Index - 1, Index);
+}
+
+template<int32 Dim>
+inline void TBezierString3<Dim>::InsertToSegmentCache(FPointNode* NewNode, int32 Index)
+{
+	if (Index == INDEX_NONE || NodeCache.Num() + 1 != CtrlPointsList.Num()) {
+		RebuildSegmentCache();
+		return;
+	}
+	NodeCache.Insert(NewNode, Index);
+	ParamCache.Insert(NewNode->GetValueRef().Param, Index);
+	if (NodeCache.Num() > 1) {
+		SegmentCache.Insert(TBezierCurve<Dim, 3>(), FMath::Min(Index, SegmentCache.Num()));
+		RefreshSegmentCache(Index - 1, Index);
+	}
+}
+
+template<int32 Dim>
+inline void TBezierString3<Dim>::RemoveNodeWithSegmentCache(FPointNode* Node)
+{
+	if (!Node) {
+		return;
+	}
+	int32 Index = FindNodeIndex(Node);
+	CtrlPointsList.RemoveNode(Node);
+	if (Index == INDEX_NONE || NodeCache.Num() - 1 != CtrlPointsList.Num()) {
+		RebuildSegmentCache();
+		return;
+	}
+	NodeCache.RemoveAt(Index, 1, false);
+	ParamCache.RemoveAt(Index, 1, false);
+	if (SegmentCache.Num() > 0) {
+		SegmentCache.RemoveAt(FMath::Min(Index, SegmentCache.Num() - 1), 1, false);
+		RefreshSegmentCache(Index - 1, Index - 1);
+	}
+}
+
 template<int32 Dim>
 inline void TBezierString3<Dim>::GetCtrlPointStructs(TArray<TWeakPtr<TSplineBaseControlPoint<Dim, 3>>>& OutControlPointStructs) const
 {
@@ -286,6 +405,7 @@ inline TSharedRef<TSplineBase<Dim, 3>> TBezierString3<Dim>::CreateSameType(int32
 			}
 			Beziers.FirstNode()->GetValueRef().PrevCtrlPointPos = CtrlPointsList.GetTail()->GetValueRef().PrevCtrlPointPos;
 			Beziers.FirstNode()->GetValueRef().NextCtrlPointPos = CtrlPointsList.GetTail()->GetValueRef().NextCtrlPointPos;
+			Beziers.RebuildSegmentCache();
 		}
 	}
 	return NewSpline;
@@ -366,19 +486,22 @@ template<int32 Dim>
 inline void TBezierString3<Dim>::AddPointAtLast(const TBezierString3ControlPoint<Dim>& PointStruct)
 {
 	CtrlPointsList.AddTail(MakeShared<FControlPointType>(PointStruct));
+	InsertToSegmentCache(CtrlPointsList.GetTail(), CtrlPointsList.Num() - 1);
 }
 
 template<int32 Dim>
 inline void TBezierString3<Dim>::AddPointAtFirst(const TBezierString3ControlPoint<Dim>& PointStruct)
 {
 	CtrlPointsList.AddHead(MakeShared<FControlPointType>(PointStruct));
+	InsertToSegmentCache(CtrlPointsList.GetHead(), 0);
 }
 
 template<int32 Dim>
 inline void TBezierString3<Dim>::AddPointAt(const TBezierString3ControlPoint<Dim>& PointStruct, int32 Index)
 {
 	FPointNode* NodeToInsertBefore = CtrlPointsList.GetHead();
-	for (int32 i = 0; i < Index; ++i) {
+	int32 InsertIndex = 0;
+	for (; InsertIndex < Index; ++InsertIndex) {
 		if (NodeToInsertBefore) {
 			NodeToInsertBefore = NodeToInsertBefore->GetNextNode();
 		}
@@ -388,9 +511,11 @@ inline void TBezierString3<Dim>::AddPointAt(const TBezierString3ControlPoint<Dim
 	}
 	if (NodeToInsertBefore) {
 		CtrlPointsList.InsertNode(MakeShared<FControlPointType>(PointStruct), NodeToInsertBefore);
+		InsertToSegmentCache(NodeToInsertBefore->GetPrevNode(), InsertIndex);
 	}
 	else {
 		CtrlPointsList.AddTail(MakeShared<FControlPointType>(PointStruct));
+		InsertToSegmentCache(CtrlPointsList.GetTail(), CtrlPointsList.Num() - 1);
 	}
 }
 
@@ -402,42 +527,16 @@ inline typename TBezierString3<Dim>::FPointNode* TBezierString3<Dim>::AddPointWi
 		return nullptr;
 	}
 
-	FPointNode* Node = CtrlPointsList.GetHead();
-	FPointNode* NodeToInsertBefore = nullptr;
-	TArray<TVectorX<Dim+1> > SplitCurveCtrlPoints;
-	SplitCurveCtrlPoints.Reserve(4);
-	while (Node) {
-		if (Node->GetValueRef().Param <= T) {
-			const auto& Val = Node->GetValueRef();
-			//Val.Param = static_cast<double>(OutFirst.GetCtrlPointNum());
-			//OutFirst.AddEndPoint(Val);
-			FPointNode* NextNode = Node->GetNextNode();
-			if (NextNode && T < NextNode->GetValueRef().Param) {
-				NodeToInsertBefore = NextNode;
-				SplitCurveCtrlPoints.Add(Val.Pos);
-				SplitCurveCtrlPoints.Add(Val.NextCtrlPointPos);
-				SplitCurveCtrlPoints.Add(NextNode->GetValueRef().PrevCtrlPointPos);
-				SplitCurveCtrlPoints.Add(NextNode->GetValueRef().Pos);
-				//SplitT = (T - Node->GetValueRef().Param) / (NextNode->GetValueRef().Param - Node->GetValueRef().Param);
-				break;
-			}
-		}
-		//else {
-		//	auto Val = Node->GetValueRef();
-		//	Val.Param = static_cast<double>(OutSecond.GetCtrlPointNum() + 1);
-		//	OutSecond.AddEndPoint(Node->GetValueRef());
-		//}
-		Node = Node->GetNextNode();
-	}
-	if (SplitCurveCtrlPoints.Num() != 4 || !NodeToInsertBefore) {
+	int32 SegmentIndex = FindSegmentIndex(T);
+	if (SegmentIndex == INDEX_NONE) {
 		return nullptr;
 	}
-	FPointNode* NodeToInsertAfter = NodeToInsertBefore->GetPrevNode();
+	FPointNode* NodeToInsertAfter = NodeCache[SegmentIndex];
+	FPointNode* NodeToInsertBefore = NodeCache[SegmentIndex + 1];
 
 	TBezierCurve<Dim, 3> NewLeft, NewRight;
-	TBezierCurve<Dim, 3> SplitCurve(SplitCurveCtrlPoints);
-	double TN = GetNormalizedParam(NodeToInsertAfter, NodeToInsertBefore, T);
-	TVectorX<Dim+1> SplitPos = SplitCurve.Split(NewLeft, NewRight, TN);
+	double TN = GetNormalizedParam(SegmentIndex, T);
+	TVectorX<Dim+1> SplitPos = SegmentCache[SegmentIndex].Split(NewLeft, NewRight, TN);
 
 	NodeToInsertAfter->GetValueRef().NextCtrlPointPos = NewLeft.GetPointHomogeneous(1);
 	NodeToInsertBefore->GetValueRef().PrevCtrlPointPos = NewRight.GetPointHomogeneous(2);
@@ -448,9 +547,66 @@ inline typename TBezierString3<Dim>::FPointNode* TBezierString3<Dim>::AddPointWi
 		NewRight.GetPointHomogeneous(1),
 		T);
 	CtrlPointsList.InsertNode(MakeShared<FControlPointType>(Val), NodeToInsertBefore);
+	InsertToSegmentCache(NodeToInsertBefore->GetPrevNode(), SegmentIndex + 1);
 	return NodeToInsertBefore->GetPrevNode();
 }
 
+template<int32 Dim>
+inline int32 TBezierString3<Dim>::InsertParamsWithoutChangingShape(TArray<FPointNode*>& OutNewNodes, TArrayView<const double> InParams)
+{
+	OutNewNodes.Reset();
+	if (SegmentCache.Num() == 0 || InParams.Num() == 0) {
+		return 0;
+	}
+	TArray<double> SortedParams(InParams.GetData(), InParams.Num());
+	SortedParams.Sort();
+	OutNewNodes.Reserve(SortedParams.Num());
+
+	int32 ParamIndex = Algo::UpperBound(SortedParams, ParamCache[0]);
+	for (int32 SegmentIndex = 0; SegmentIndex < SegmentCache.Num() && ParamIndex < SortedParams.Num(); ++SegmentIndex) {
+		const double EndParam = ParamCache[SegmentIndex + 1];
+		if (SortedParams[ParamIndex] >= EndParam) {
+			continue;
+		}
+		FPointNode* NodeToInsertAfter = NodeCache[SegmentIndex];
+		FPointNode* NodeToInsertBefore = NodeCache[SegmentIndex + 1];
+		TBezierCurve<Dim, 3> RestCurve = SegmentCache[SegmentIndex];
+		double LastParam = ParamCache[SegmentIndex];
+
+		// Split the rest of the segment each time, so the left part is final.
+		for (; ParamIndex < SortedParams.Num() && SortedParams[ParamIndex] < EndParam; ++ParamIndex) {
+			double T = SortedParams[ParamIndex];
+			if (FMath::IsNearlyEqual(T, LastParam) || FMath::IsNearlyEqual(T, EndParam)) {
+				continue;
+			}
+			TBezierCurve<Dim, 3> NewLeft, NewRight;
+			double TN = (T - LastParam) / (EndParam - LastParam);
+			TVectorX<Dim+1> SplitPos = RestCurve.Split(NewLeft, NewRight, TN);
+
+			NodeToInsertAfter->GetValueRef().NextCtrlPointPos = NewLeft.GetPointHomogeneous(1);
+			TBezierString3ControlPoint<Dim> Val(
+				SplitPos,
+				NewLeft.GetPointHomogeneous(2),
+				NewRight.GetPointHomogeneous(1),
+				T);
+			CtrlPointsList.InsertNode(MakeShared<FControlPointType>(Val), NodeToInsertBefore);
+			NodeToInsertAfter = NodeToInsertBefore->GetPrevNode();
+			OutNewNodes.Add(NodeToInsertAfter);
+
+			RestCurve = NewRight;
+			LastParam = T;
+		}
+		if (NodeToInsertAfter != NodeCache[SegmentIndex]) {
+			NodeToInsertBefore->GetValueRef().PrevCtrlPointPos = RestCurve.GetPointHomogeneous(2);
+		}
+	}
+
+	if (OutNewNodes.Num() > 0) {
+		RebuildSegmentCache();
+	}
+	return OutNewNodes.Num();
+}
+
 template<int32 Dim>
 inline void TBezierString3<Dim>::AdjustCtrlPointParam(double From, double To, int32 NthPointOfFrom)
 {
@@ -550,7 +706,7 @@ template<int32 Dim>
 inline void TBezierString3<Dim>::RemovePoint(double Param, int32 NthPointOfFrom)
 {
 	FPointNode* Node = FindNodeByParam(Param, NthPointOfFrom);
-	CtrlPointsList.RemoveNode(Node);
+	RemoveNodeWithSegmentCache(Node);
 }
 
 template<int32 Dim>
@@ -565,9 +721,35 @@ inline bool TBezierString3<Dim>::AdjustCtrlPointPos(FPointNode* Node, const TVec
 		Node->GetValueRef().NextCtrlPointPos += TVecLib<Dim>::Homogeneous(AdjustDiff, 0.);
 
 		if (CtrlPointsList.Num() > 1) {
-			UpdateBezierString(Node);
+			if (Con == EEndPointContinuity::C2) {
+				UpdateBezierStringC2Locally(Node, AdjustDiff, 1e-4);
+			}
+			else {
+				UpdateBezierString(Node);
+			}
+			return true;
 		}
 	}
+	RefreshSegmentCacheByNode(Node);
+	return true;
+}
+
+template<int32 Dim>
+inline bool TBezierString3<Dim>::AdjustCtrlPointPosC2Locally(FPointNode* Node, const TVectorX<Dim>& To, double Tolerance)
+{
+	if (!Node) {
+		return false;
+	}
+	TVectorX<Dim> AdjustDiff = To - TVecLib<Dim+1>::Projection(Node->GetValueRef().Pos);
+	Node->GetValueRef().Pos = TVecLib<Dim>::Homogeneous(To, 1.);
+	Node->GetValueRef().PrevCtrlPointPos += TVecLib<Dim>::Homogeneous(AdjustDiff, 0.);
+	Node->GetValueRef().NextCtrlPointPos += TVecLib<Dim>::Homogeneous(AdjustDiff, 0.);
+	if (CtrlPointsList.Num() > 1) {
+		UpdateBezierStringC2Locally(Node, AdjustDiff, Tolerance);
+	}
+	else {
+		RefreshSegmentCacheByNode(Node);
+	}
 	return true;
 }
 
@@ -702,14 +884,14 @@ inline void TBezierString3<Dim>::RemovePointAt(int32 Index)
 			Node = Node->GetNextNode();
 		}
 	}
-	CtrlPointsList.RemoveNode(Node);
+	RemoveNodeWithSegmentCache(Node);
 }
 
 template<int32 Dim>
 inline void TBezierString3<Dim>::RemovePoint(const TVectorX<Dim>& Point, int32 NthPointOfFrom)
 {
 	FPointNode* Node = FindNodeByPosition(Point, NthPointOfFrom);
-	CtrlPointsList.RemoveNode(Node);
+	RemoveNodeWithSegmentCache(Node);
 }
 
 template<int32 Dim>
@@ -719,7 +901,7 @@ inline void TBezierString3<Dim>::RemovePoint(const TSplineBaseControlPoint<Dim,
 	{
 		if (&Node->GetValueRef() == &TargetPointStruct)
 		{
-			CtrlPointsList.RemoveNode(Node);
+			RemoveNodeWithSegmentCache(Node);
 			return;
 		}
 	}
@@ -794,10 +976,18 @@ inline void TBezierString3<Dim>::Reverse()
 	for (const FControlPointTypeRef& Point : NewList) {
 		CtrlPointsList.AddTail(MakeShared<FControlPointType>(Point.Get()));
 	}
+	RebuildSegmentCache();
 }
 
 template<int32 Dim>
 inline TVectorX<Dim> TBezierString3<Dim>::GetPosition(double T) const
+{
+	int32 SegmentHint = INDEX_NONE;
+	return GetPosition(T, SegmentHint);
+}
+
+template<int32 Dim>
+inline TVectorX<Dim> TBezierString3<Dim>::GetPosition(double T, int32& InOutSegmentHint) const
 {
 	int32 ListNum = CtrlPointsList.Num();
 	if (ListNum == 0) {
@@ -808,40 +998,36 @@ inline TVectorX<Dim> TBezierString3<Dim>::GetPosition(double T) const
 	}
 	const auto& ParamRange = GetParamRange();
 	if (ParamRange.Get<0>() >= T) {
-		TVecLib<Dim+1>::Projection(CtrlPointsList.GetHead()->GetValueRef().Pos);
+		return TVecLib<Dim+1>::Projection(CtrlPointsList.GetHead()->GetValueRef().Pos);
 	}
 	else if(T >= ParamRange.Get<1>()) {
 		return TVecLib<Dim+1>::Projection(CtrlPointsList.GetTail()->GetValueRef().Pos);
 	}
 
-	FPointNode* EndNode = FindNodeGreaterThanParam(T);
-	FPointNode* StartNode = EndNode->GetPrevNode() ? EndNode->GetPrevNode() : EndNode;
-	double TN = GetNormalizedParam(StartNode, EndNode, T);
-	TBezierCurve<Dim, 3> TargetCurve = MakeBezierCurve(StartNode, EndNode);
-	return TargetCurve.GetPosition(TN);
+	InOutSegmentHint = FindSegmentIndex(T, InOutSegmentHint);
+	return SegmentCache[InOutSegmentHint].GetPosition(GetNormalizedParam(InOutSegmentHint, T));
 }
 
 template<int32 Dim>
 inline TVectorX<Dim> TBezierString3<Dim>::GetTangent(double T) const
+{
+	int32 SegmentHint = INDEX_NONE;
+	return GetTangent(T, SegmentHint);
+}
+
+template<int32 Dim>
+inline TVectorX<Dim> TBezierString3<Dim>::GetTangent(double T, int32& InOutSegmentHint) const
 {
 	//if (constexpr(Degree <= 0)) {
 	//	return TVecLib<Dim>::Zero();
 	//}
-	FPointNode* EndNode = FindNodeGreaterThanParam(T);
-	if (!EndNode) {
-		EndNode = CtrlPointsList.GetTail();
-	}
-	if (!EndNode) {
-		return TVecLib<Dim>::Zero();
-	}
-	FPointNode* StartNode = EndNode->GetPrevNode();
-	if (!StartNode) {
+	if (SegmentCache.Num() == 0 || T < ParamCache[0]) {
 		return TVecLib<Dim>::Zero();
 	}
-	double TN = GetNormalizedParam(StartNode, EndNode, T);
-	TBezierCurve<Dim, 3> Curve = MakeBezierCurve(StartNode, EndNode);
+	InOutSegmentHint = FindSegmentIndex(T, InOutSegmentHint);
+	double TN = GetNormalizedParam(InOutSegmentHint, T);
 	TBezierCurve<Dim, 2> Hodograph;
-	Curve.CreateHodograph(Hodograph);
+	SegmentCache[InOutSegmentHint].CreateHodograph(Hodograph);
 	
 	TVectorX<Dim> Tangent = Hodograph.GetPosition(TN);
 	return TVecLib<Dim>::IsNearlyZero(Tangent) ? Hodograph.GetTangent(TN) : Tangent;
@@ -850,21 +1036,13 @@ inline TVectorX<Dim> TBezierString3<Dim>::GetTangent(double T) const
 template<int32 Dim>
 inline double TBezierString3<Dim>::GetPlanCurvature(double T, int32 PlanIndex) const
 {
-	FPointNode* EndNode = FindNodeGreaterThanParam(T);
-	if (!EndNode) {
-		EndNode = CtrlPointsList.GetTail();
-	}
-	if (!EndNode) {
-		return 0.;
-	}
-	FPointNode* StartNode = EndNode->GetPrevNode();
-	if (!StartNode) {
+	if (SegmentCache.Num() == 0 || T < ParamCache[0]) {
 		return 0.;
 	}
-	double TN = GetNormalizedParam(StartNode, EndNode, T);
-	TBezierCurve<Dim, 3> Curve = MakeBezierCurve(StartNode, EndNode);
+	int32 SegmentIndex = FindSegmentIndex(T);
+	double TN = GetNormalizedParam(SegmentIndex, T);
 	TBezierCurve<Dim, 2> Hodograph;
-	Curve.CreateHodograph(Hodograph);
+	SegmentCache[SegmentIndex].CreateHodograph(Hodograph);
 	TBezierCurve<Dim, 1> Hodograph2;
 	Hodograph.CreateHodograph(Hodograph2);
 
@@ -874,21 +1052,13 @@ inline double TBezierString3<Dim>::GetPlanCurvature(double T, int32 PlanIndex) c
 template<int32 Dim>
 inline double TBezierString3<Dim>::GetCurvature(double T) const
 {
-	FPointNode* EndNode = FindNodeGreaterThanParam(T);
-	if (!EndNode) {
-		EndNode = CtrlPointsList.GetTail();
-	}
-	if (!EndNode) {
-		return 0.;
-	}
-	FPointNode* StartNode = EndNode->GetPrevNode();
-	if (!StartNode) {
+	if (SegmentCache.Num() == 0 || T < ParamCache[0]) {
 		return 0.;
 	}
-	double TN = GetNormalizedParam(StartNode, EndNode, T);
-	TBezierCurve<Dim, 3> Curve = MakeBezierCurve(StartNode, EndNode);
+	int32 SegmentIndex = FindSegmentIndex(T);
+	double TN = GetNormalizedParam(SegmentIndex, T);
 	TBezierCurve<Dim, 2> Hodograph;
-	Curve.CreateHodograph(Hodograph);
+	SegmentCache[SegmentIndex].CreateHodograph(Hodograph);
 	TBezierCurve<Dim, 1> Hodograph2;
 	Hodograph.CreateHodograph(Hodograph2);
 
@@ -898,20 +1068,14 @@ inline double TBezierString3<Dim>::GetCurvature(double T) const
 template<int32 Dim>
 inline void TBezierString3<Dim>::ToPolynomialForm(TArray<TArray<TVectorX<Dim+1>>>& OutPolyForms) const
 {
-	FPointNode* Node = CtrlPointsList.GetHead();
-	if (!Node) {
+	if (!CtrlPointsList.GetHead()) {
 		return;
 	}
-	OutPolyForms.Empty(CtrlPointsList.Num() - 1);
-	while (Node && Node->GetNextNode()) {
-		FPointNode* Next = Node->GetNextNode();
-
+	OutPolyForms.Empty(SegmentCache.Num());
+	for (const TBezierCurve<Dim, 3>& Segment : SegmentCache) {
 		TArray<TVectorX<Dim+1> >& NewArray = OutPolyForms.AddDefaulted_GetRef();
 		NewArray.SetNum(4);
-		TBezierCurve<Dim, 3> NewBezier = MakeBezierCurve(Node, Next);
-		NewBezier.ToPolynomialForm(NewArray.GetData());
-
-		Node = Next;
+		Segment.ToPolynomialForm(NewArray.GetData());
 	}
 }
 
@@ -928,26 +1092,22 @@ inline TTuple<double, double> TBezierString3<Dim>::GetParamRange() const
 template<int32 Dim>
 inline bool TBezierString3<Dim>::FindParamByPosition(double& OutParam, const TVectorX<Dim>& InPos, double ToleranceSqr) const
 {
-	FPointNode* Node = CtrlPointsList.GetHead();
-	if (!Node) {
+	if (!CtrlPointsList.GetHead()) {
 		return false;
 	}
 	TOptional<double> CurParam;
 	TOptional<double> CurDistSqr;
 
 	F_Box3 InPosBox = F_Box3({ F_Vec3(InPos) }).ExpandBy(sqrt(ToleranceSqr));
-	while (Node && Node->GetNextNode()) {
-		FPointNode* Next = Node->GetNextNode();
-
-		TBezierCurve<Dim, 3> NewBezier = MakeBezierCurve(Node, Next);
+	for (int32 i = 0; i < SegmentCache.Num(); ++i) {
+		const TBezierCurve<Dim, 3>& NewBezier = SegmentCache[i];
 		if (!NewBezier.GetBox().Intersect(InPosBox))
 		{
-			Node = Next;
 			continue;
 		}
 		double NewParamNormal = -1.;
 		if (NewBezier.FindParamByPosition(NewParamNormal, InPos, ToleranceSqr)) {
-			double NewParam = Node->GetValueRef().Param * (1. - NewParamNormal) + Next->GetValueRef().Param * NewParamNormal;
+			double NewParam = ParamCache[i] * (1. - NewParamNormal) + ParamCache[i + 1] * NewParamNormal;
 			if (CurParam) {
 				TVectorX<Dim> NewPos = NewBezier.GetPosition(NewParamNormal);
 				double NewDistSqr = TVecLib<Dim>::SizeSquared(NewPos - InPos);
@@ -963,8 +1123,6 @@ inline bool TBezierString3<Dim>::FindParamByPosition(double& OutParam, const TVe
 				CurParam = NewParam;
 			}
 		}
-
-		Node = Next;
 	}
 
 	if (CurParam) {
@@ -977,29 +1135,25 @@ inline bool TBezierString3<Dim>::FindParamByPosition(double& OutParam, const TVe
 template<int32 Dim>
 inline bool TBezierString3<Dim>::FindParamsByComponentValue(TArray<double>& OutParams, double InValue, int32 InComponentIndex, double ToleranceSqr) const
 {
-	FPointNode* Node = CtrlPointsList.GetHead();
-	if (!Node) {
+	if (!CtrlPointsList.GetHead()) {
 		return false;
 	}
 	TOptional<double> CurParam;
 	TOptional<double> CurDistSqr;
 
 	//F_Box3 InPosBox = F_Box3({ F_Vec3(InPos) }).ExpandBy(sqrt(ToleranceSqr));
-	while (Node && Node->GetNextNode()) {
-		FPointNode* Next = Node->GetNextNode();
-
-		TBezierCurve<Dim, 3> NewBezier = MakeBezierCurve(Node, Next);
+	for (int32 i = 0; i < SegmentCache.Num(); ++i) {
+		const TBezierCurve<Dim, 3>& NewBezier = SegmentCache[i];
 		F_Box3 BezierBox = NewBezier.GetBox();
 		if (BezierBox.Min[InComponentIndex] > InValue || BezierBox.Max[InComponentIndex] < InValue)
 		{
-			Node = Next;
 			continue;
 		}
 		TArray<double> LocalParams;
 		if (NewBezier.FindParamsByComponentValue(LocalParams, InValue, InComponentIndex, ToleranceSqr)) {
 			for (double NewParamNormal : LocalParams)
 			{
-				double NewParam = Node->GetValueRef().Param * (1. - NewParamNormal) + Next->GetValueRef().Param * NewParamNormal;
+				double NewParam = ParamCache[i] * (1. - NewParamNormal) + ParamCache[i + 1] * NewParamNormal;
 				//if (CurParam) {
 				//	TVectorX<Dim> NewPos = NewBezier.GetPosition(NewParamNormal);
 				//	double NewDistSqr = TVecLib<Dim>::SizeSquared(NewPos - InPos);
@@ -1017,8 +1171,6 @@ inline bool TBezierString3<Dim>::FindParamsByComponentValue(TArray<double>& OutP
 				//}
 			}
 		}
-
-		Node = Next;
 	}
 
 	if (CurParam) {
@@ -1038,6 +1190,35 @@ inline double TBezierString3<Dim>::GetNormalizedParam(
 	return FMath::IsNearlyZero(De) ? 0.5 : (T - StartNode->GetValueRef().Param) / De;
 }
 
+template<int32 Dim>
+inline double TBezierString3<Dim>::GetNormalizedParam(int32 SegmentIndex, double T) const
+{
+	double De = ParamCache[SegmentIndex + 1] - ParamCache[SegmentIndex];
+	return FMath::IsNearlyZero(De) ? 0.5 : (T - ParamCache[SegmentIndex]) / De;
+}
+
+template<int32 Dim>
+inline void TBezierString3<Dim>::RemakeC2(bool bClosed)
+{
+	if (!bClosed) {
+		UpdateBezierString(nullptr);
+		return;
+	}
+
+	TArray<TVectorX<Dim+1> > EndPoints;
+	GetCtrlPoints(EndPoints);
+	if (EndPoints.Num() > 1 && TVecLib<Dim+1>::IsNearlyZero(EndPoints.Last() - EndPoints[0])) {
+		EndPoints.Pop(false);
+	}
+	if (EndPoints.Num() < 3) {
+		UpdateBezierString(nullptr);
+		return;
+	}
+	TArray<TBezierCurve<Dim, 3> > Beziers;
+	TBezierOperationsDegree3<Dim>::InterpolationC2Closed(Beziers, EndPoints);
+	FromCurveArray(Beziers);
+}
+
 template<int32 Dim>
 inline TBezierCurve<Dim, 3> TBezierString3<Dim>::MakeBezierCurve(
 	const typename TBezierString3<Dim>::FPointNode* StartNode, 
@@ -1065,6 +1246,7 @@ inline void TBezierString3<Dim>::UpdateBezierString(typename TBezierString3<Dim>
 		TArray<TVectorX<Dim+1> > EndPoints;
 		GetCtrlPoints(EndPoints);
 		if (EndPoints.Num() < 2) {
+			RebuildSegmentCache();
 			return;
 		}
 		TArray<TBezierCurve<Dim, 3> > Beziers;
@@ -1073,18 +1255,30 @@ inline void TBezierString3<Dim>::UpdateBezierString(typename TBezierString3<Dim>
 		return;
 	}
 
+	int32 PrevStepNum = 0, NextStepNum = 0;
 	for (FPointNode* PrevNode = NodeToUpdateFirst->GetPrevNode(); PrevNode; PrevNode = PrevNode->GetPrevNode()) {
+		++PrevStepNum;
 		if (!AdjustPointByStaticPointReturnShouldSpread(PrevNode, true)) {
 			break;
 		}
 	}
 
 	for (FPointNode* NextNode = NodeToUpdateFirst->GetNextNode(); NextNode; NextNode = NextNode->GetNextNode()) {
+		++NextStepNum;
 		if (!AdjustPointByStaticPointReturnShouldSpread(NextNode, false)) {
 			break;
 		}
 	}
 
+	// Only the segments touched by the spreading need to be refreshed.
+	int32 Index = FindNodeIndex(NodeToUpdateFirst);
+	if (Index == INDEX_NONE || NodeCache.Num() != CtrlPointsList.Num()) {
+		RebuildSegmentCache();
+	}
+	else {
+		RefreshSegmentCache(Index - PrevStepNum - 1, Index + NextStepNum);
+	}
+
 	//static const TMap<EEndPointContinuity, int32> TypeMap{
 	//	{EEndPointContinuity::C0, 0},
 	//	{EEndPointContinuity::C1, 1},
@@ -1095,6 +1289,96 @@ inline void TBezierString3<Dim>::UpdateBezierString(typename TBezierString3<Dim>
 	//int32 PointToAdjustEachSide = 2;//TypeMap[NodeToUpdateFirst->GetValueRef().Continuity];
 }
 
+template<int32 Dim>
+inline void TBezierString3<Dim>::UpdateBezierStringC2Locally(typename TBezierString3<Dim>::FPointNode* Node, const TVectorX<Dim>& PosDiff, double Tolerance)
+{
+	// Tangents D satisfy M * D = 3 * (K_{i+1} - K_{i-1}) with M = (1, 4, 1), see BezierOperations.cpp.
+	// Moving K_j only changes rows j-1, j, j+1, and the entries of M^-1 decay by
+	// Rho = 2 - sqrt(3) per node, so the change beyond the window is below Tolerance.
+	// Only the tangents of C2 nodes are solved. The window stops before the first node of other continuity
+	// on each side, whose handles are kept as fixed tangent end conditions, like UpdateBezierString() stops at C0.
+	static const double LogRho = FMath::Loge(2. - FMath::Sqrt(3.));
+	static constexpr double InvDegreeDbl = 1. / 3.;
+	const int32 HalfWindow = FMath::CeilToInt(FMath::Loge(FMath::Max(Tolerance, SMALL_NUMBER)) / LogRho) + 1;
+
+	auto IsC2 = [](const FPointNode* CurNode) -> bool {
+		return CurNode->GetValueRef().Continuity == EEndPointContinuity::C2;
+	};
+
+	FPointNode* FirstNode = Node;
+	int32 CenterIndex = 0;
+	while (CenterIndex < HalfWindow && FirstNode->GetPrevNode() && IsC2(FirstNode->GetPrevNode())) {
+		FirstNode = FirstNode->GetPrevNode();
+		++CenterIndex;
+	}
+	TArray<FPointNode*, TInlineAllocator<32> > WindowNodes;
+	for (FPointNode* CurNode = FirstNode; CurNode && WindowNodes.Num() <= CenterIndex + HalfWindow; CurNode = CurNode->GetNextNode()) {
+		if (WindowNodes.Num() > CenterIndex && !IsC2(CurNode)) {
+			break;
+		}
+		WindowNodes.Add(CurNode);
+	}
+	const int32 Num = WindowNodes.Num();
+
+	// The tangent changes outside the window are regarded as zero.
+	// Natural end conditions only apply if the window reaches the ends of the string.
+	// If the moved node is not C2, its handles are only translated, so its row is fixed to zero.
+	const bool bCenterFixed = !IsC2(Node);
+	TArray<TVectorX<Dim> > DeltaTangents;
+	TArray<double> Lower, Diag, Upper;
+	DeltaTangents.Init(TVecLib<Dim>::Zero(), Num);
+	Lower.Init(1., Num);
+	Diag.Init(4., Num);
+	Upper.Init(1., Num);
+	if (!WindowNodes[0]->GetPrevNode()) {
+		Diag[0] = 2.;
+	}
+	if (!WindowNodes[Num - 1]->GetNextNode()) {
+		Diag[Num - 1] = 2.;
+	}
+
+	const TVectorX<Dim> PosDiff3 = PosDiff * 3.;
+	if (CenterIndex > 0) {
+		DeltaTangents[CenterIndex - 1] += PosDiff3;
+	}
+	if (CenterIndex < Num - 1) {
+		DeltaTangents[CenterIndex + 1] -= PosDiff3;
+	}
+	if (bCenterFixed) {
+		Lower[CenterIndex] = 0.;
+		Diag[CenterIndex] = 1.;
+		Upper[CenterIndex] = 0.;
+	}
+	else {
+		if (!Node->GetPrevNode()) {
+			DeltaTangents[CenterIndex] -= PosDiff3;
+		}
+		if (!Node->GetNextNode()) {
+			DeltaTangents[CenterIndex] += PosDiff3;
+		}
+	}
+
+	TridiagonalEquationSolver::Solve(DeltaTangents, Lower, Diag, Upper);
+
+	for (int32 i = 0; i < Num; ++i) {
+		if (i == CenterIndex && bCenterFixed) {
+			continue;
+		}
+		FControlPointType& Point = WindowNodes[i]->GetValueRef();
+		TVectorX<Dim> PosProj = TVecLib<Dim+1>::Projection(Point.Pos);
+		TVectorX<Dim> Tangent = (TVecLib<Dim+1>::Projection(Point.NextCtrlPointPos) - PosProj) * 3. + DeltaTangents[i];
+		Point.NextCtrlPointPos = TVecLib<Dim>::Homogeneous(PosProj + Tangent * InvDegreeDbl, 1.);
+		Point.PrevCtrlPointPos = TVecLib<Dim>::Homogeneous(PosProj - Tangent * InvDegreeDbl, 1.);
+	}
+
+	int32 FirstIndex = FindNodeIndex(FirstNode);
+	if (FirstIndex == INDEX_NONE || NodeCache.Num() != CtrlPointsList.Num()) {
+		RebuildSegmentCache();
+		return;
+	}
+	RefreshSegmentCache(FirstIndex - 1, FirstIndex + Num - 1);
+}
+
 template<int32 Dim>
 inline bool TBezierString3<Dim>::AdjustPointByStaticPointReturnShouldSpread(TBezierString3<Dim>::FPointNode* Node, bool bFromNext)
 {
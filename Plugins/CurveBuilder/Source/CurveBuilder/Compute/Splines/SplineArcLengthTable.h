@@ -0,0 +1,89 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SplineBase.h"
+#include "Algo/BinarySearch.h"
+#include "Utils/NumericalCalculationUtils.h"
+
+// Arc length of a spline, sampled once in bezier form.
+// Lengths and parameters are mapped by binary search in the table and a short Newton solve in one sample interval,
+// instead of integrating from the start of the spline each time. Rebuild it after the spline is changed.
+template<int32 Dim, int32 Degree = 3>
+class TSplineArcLengthTable
+{
+public:
+	using FSplineType = typename TSplineBase<Dim, Degree>;
+	using FCurveType = typename TBezierCurve<Dim, Degree>;
+
+	TSplineArcLengthTable() {}
+
+	TSplineArcLengthTable(const FSplineType& Spline, int32 SamplesPerSegment = 8)
+	{
+		Build(Spline, SamplesPerSegment);
+	}
+
+	void Build(const FSplineType& Spline, int32 SamplesPerSegment = 8);
+
+	void Empty();
+
+	FORCEINLINE bool IsEmpty() const { return Params.Num() == 0; }
+
+	FORCEINLINE double GetTotalLength() const { return Lengths.Num() > 0 ? Lengths.Last() : 0.; }
+
+	FORCEINLINE const TTuple<double, double>& GetParamRange() const { return ParamRange; }
+
+	FORCEINLINE int32 GetSegmentNum() const { return Curves.Num(); }
+
+	FORCEINLINE const FCurveType& GetCurve(int32 Segment) const { return Curves[Segment]; }
+
+	FORCEINLINE const TTuple<double, double>& GetSegmentParamRange(int32 Segment) const { return ParamRanges[Segment]; }
+
+	// Sample i is at parameter GetSampleParam(i) and length GetSampleLength(i), from 0 to the total length.
+	FORCEINLINE int32 GetSampleNum() const { return Params.Num(); }
+
+	FORCEINLINE double GetSampleParam(int32 Index) const { return Params[Index]; }
+
+	FORCEINLINE double GetSampleLength(int32 Index) const { return Lengths[Index]; }
+
+	FORCEINLINE int32 GetSampleSegment(int32 Index) const { return SampleSegments[Index]; }
+
+	// Without the virtual call and the walk of the control points of the spline.
+	TVectorX<Dim> GetPosition(double T) const;
+
+	// Derivative by the parameter of the spline.
+	TVectorX<Dim> GetTangent(double T) const;
+
+	// Segment containing the parameter, by binary search.
+	int32 FindSegment(double T) const;
+
+	double GetLengthAtParameter(double T) const;
+
+	double GetParameterAtLength(double S) const;
+
+	// Lengths in ascending order. Each solve starts from the interval of the previous one.
+	void GetParametersAtLengths(TArray<double>& OutParams, TArrayView<const double> SortedLengths) const;
+
+protected:
+	// Interval of samples [Index, Index + 1] containing the length.
+	int32 FindSampleIntervalByLength(double S) const;
+
+	int32 FindSampleIntervalByParameter(double T) const;
+
+	double GetLocalParameter(int32 Segment, double T) const;
+
+	double SolveParameterInInterval(int32 Index, double S) const;
+
+protected:
+	TArray<FCurveType> Curves;
+	TArray<TTuple<double, double> > ParamRanges;
+	TTuple<double, double> ParamRange = MakeTuple(0., 0.);
+
+	TArray<double> Params;
+	TArray<double> Lengths;
+	TArray<int32> SampleSegments;
+};
+
+#include "SplineArcLengthTable.inl"
@@ -0,0 +1,194 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "SplineArcLengthTable.h"
+
+template<int32 Dim, int32 Degree>
+inline void TSplineArcLengthTable<Dim, Degree>::Build(const FSplineType& Spline, int32 SamplesPerSegment)
+{
+	Empty();
+	if (!Spline.ToBezierCurves(Curves, &ParamRanges) || Curves.Num() == 0 || Curves.Num() != ParamRanges.Num()) {
+		Empty();
+		return;
+	}
+	ParamRange = MakeTuple(ParamRanges[0].Get<0>(), ParamRanges.Last().Get<1>());
+
+	SamplesPerSegment = FMath::Max(SamplesPerSegment, 1);
+	const double InvSampleNum = 1. / static_cast<double>(SamplesPerSegment);
+	const int32 SampleNum = Curves.Num() * SamplesPerSegment + 1;
+	Params.Reserve(SampleNum);
+	Lengths.Reserve(SampleNum);
+	SampleSegments.Reserve(SampleNum);
+	Params.Add(ParamRange.Get<0>());
+	Lengths.Add(0.);
+	SampleSegments.Add(0);
+
+	double Length = 0.;
+	for (int32 i = 0; i < Curves.Num(); ++i) {
+		const FCurveType& Curve = Curves[i];
+		const TTuple<double, double>& Range = ParamRanges[i];
+		for (int32 k = 1; k <= SamplesPerSegment; ++k) {
+			const double U0 = (k - 1) * InvSampleNum, U1 = k * InvSampleNum;
+			TGaussLegendre<NumericalCalculationConst::GaussLegendreN> GaussLegendre([&Curve](double InU) -> double {
+				return TVecLib<Dim>::Size(Curve.GetTangent(InU));
+			}, U0, U1);
+			Length += GaussLegendre.Integrate(U1);
+			Params.Add(Range.Get<0>() * (1. - U1) + Range.Get<1>() * U1);
+			Lengths.Add(Length);
+			SampleSegments.Add(i);
+		}
+	}
+}
+
+template<int32 Dim, int32 Degree>
+inline void TSplineArcLengthTable<Dim, Degree>::Empty()
+{
+	Curves.Reset();
+	ParamRanges.Reset();
+	ParamRange = MakeTuple(0., 0.);
+	Params.Reset();
+	Lengths.Reset();
+	SampleSegments.Reset();
+}
+
+template<int32 Dim, int32 Degree>
+inline TVectorX<Dim> TSplineArcLengthTable<Dim, Degree>::GetPosition(double T) const
+{
+	int32 Segment = FindSegment(T);
+	if (Segment == INDEX_NONE) {
+		return TVecLib<Dim>::Zero();
+	}
+	return Curves[Segment].GetPosition(GetLocalParameter(Segment, T));
+}
+
+template<int32 Dim, int32 Degree>
+inline TVectorX<Dim> TSplineArcLengthTable<Dim, Degree>::GetTangent(double T) const
+{
+	int32 Segment = FindSegment(T);
+	if (Segment == INDEX_NONE) {
+		return TVecLib<Dim>::Zero();
+	}
+	const TTuple<double, double>& Range = ParamRanges[Segment];
+	double Diff = Range.Get<1>() - Range.Get<0>();
+	if (FMath::IsNearlyZero(Diff)) {
+		return Curves[Segment].GetTangent(0.);
+	}
+	return Curves[Segment].GetTangent(GetLocalParameter(Segment, T)) / Diff;
+}
+
+template<int32 Dim, int32 Degree>
+inline int32 TSplineArcLengthTable<Dim, Degree>::FindSegment(double T) const
+{
+	if (ParamRanges.Num() == 0) {
+		return INDEX_NONE;
+	}
+	int32 Low = 0, High = ParamRanges.Num() - 1;
+	while (Low < High) {
+		int32 Mid = (Low + High + 1) >> 1;
+		if (ParamRanges[Mid].Get<0>() <= T) {
+			Low = Mid;
+		}
+		else {
+			High = Mid - 1;
+		}
+	}
+	return Low;
+}
+
+template<int32 Dim, int32 Degree>
+inline double TSplineArcLengthTable<Dim, Degree>::GetLengthAtParameter(double T) const
+{
+	if (Params.Num() < 2) {
+		return 0.;
+	}
+	T = FMath::Clamp(T, ParamRange.Get<0>(), ParamRange.Get<1>());
+	const int32 Index = FindSampleIntervalByParameter(T);
+	const int32 Segment = SampleSegments[Index + 1];
+	const FCurveType& Curve = Curves[Segment];
+	TGaussLegendre<NumericalCalculationConst::GaussLegendreN> GaussLegendre([&Curve](double InU) -> double {
+		return TVecLib<Dim>::Size(Curve.GetTangent(InU));
+	}, GetLocalParameter(Segment, Params[Index]), 1.);
+	return Lengths[Index] + GaussLegendre.Integrate(GetLocalParameter(Segment, T));
+}
+
+template<int32 Dim, int32 Degree>
+inline double TSplineArcLengthTable<Dim, Degree>::GetParameterAtLength(double S) const
+{
+	if (Params.Num() < 2) {
+		return ParamRange.Get<0>();
+	}
+	S = FMath::Clamp(S, 0., GetTotalLength());
+	return SolveParameterInInterval(FindSampleIntervalByLength(S), S);
+}
+
+template<int32 Dim, int32 Degree>
+inline void TSplineArcLengthTable<Dim, Degree>::GetParametersAtLengths(TArray<double>& OutParams, TArrayView<const double> SortedLengths) const
+{
+	OutParams.Reset(SortedLengths.Num());
+	if (Params.Num() < 2) {
+		OutParams.Init(ParamRange.Get<0>(), SortedLengths.Num());
+		return;
+	}
+	const double TotalLength = GetTotalLength();
+	const int32 LastInterval = Lengths.Num() - 2;
+	int32 Index = 0;
+	for (double S : SortedLengths) {
+		S = FMath::Clamp(S, 0., TotalLength);
+		while (Index < LastInterval && Lengths[Index + 1] < S) {
+			++Index;
+		}
+		OutParams.Add(SolveParameterInInterval(Index, S));
+	}
+}
+
+template<int32 Dim, int32 Degree>
+inline int32 TSplineArcLengthTable<Dim, Degree>::FindSampleIntervalByLength(double S) const
+{
+	return FMath::Clamp(Algo::UpperBound(Lengths, S) - 1, 0, Lengths.Num() - 2);
+}
+
+template<int32 Dim, int32 Degree>
+inline int32 TSplineArcLengthTable<Dim, Degree>::FindSampleIntervalByParameter(double T) const
+{
+	return FMath::Clamp(Algo::UpperBound(Params, T) - 1, 0, Params.Num() - 2);
+}
+
+template<int32 Dim, int32 Degree>
+inline double TSplineArcLengthTable<Dim, Degree>::GetLocalParameter(int32 Segment, double T) const
+{
+	const TTuple<double, double>& Range = ParamRanges[Segment];
+	double Diff = Range.Get<1>() - Range.Get<0>();
+	return FMath::IsNearlyZero(Diff) ? 0. : FMath::Clamp((T - Range.Get<0>()) / Diff, 0., 1.);
+}
+
+template<int32 Dim, int32 Degree>
+inline double TSplineArcLengthTable<Dim, Degree>::SolveParameterInInterval(int32 Index, double S) const
+{
+	static constexpr int32 Iteration = 3;
+	const double IntervalLength = Lengths[Index + 1] - Lengths[Index];
+	if (FMath::IsNearlyZero(IntervalLength)) {
+		return Params[Index];
+	}
+	const int32 Segment = SampleSegments[Index + 1];
+	const FCurveType& Curve = Curves[Segment];
+	const double U0 = GetLocalParameter(Segment, Params[Index]);
+	const double U1 = GetLocalParameter(Segment, Params[Index + 1]);
+	const double Target = S - Lengths[Index];
+
+	// The interval is short, so the linear guess is close and a few Newton steps are enough.
+	TGaussLegendre<NumericalCalculationConst::GaussLegendreN> GaussLegendre([&Curve](double InU) -> double {
+		return TVecLib<Dim>::Size(Curve.GetTangent(InU));
+	}, U0, U1);
+	double U = U0 + (U1 - U0) * (Target / IntervalLength);
+	for (int32 i = 0; i < Iteration; ++i) {
+		double Speed = TVecLib<Dim>::Size(Curve.GetTangent(U));
+		if (FMath::IsNearlyZero(Speed)) {
+			break;
+		}
+		U = FMath::Clamp(U - (GaussLegendre.Integrate(U) - Target) / Speed, U0, U1);
+	}
+	const TTuple<double, double>& Range = ParamRanges[Segment];
+	return Range.Get<0>() * (1. - U) + Range.Get<1>() * U;
+}
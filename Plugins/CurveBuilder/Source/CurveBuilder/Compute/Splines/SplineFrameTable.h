@@ -0,0 +1,94 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SplineArcLengthTable.h"
+
+// Rotation minimizing frames of a spatial spline, by the double reflection method (Wang et al. 2008).
+// The frames are propagated along the samples of the arc length table, and an interval is bisected while the tangent
+// turns more than the max angle in it, so the table is dense only where it is curved. Unlike UpVector ^ Tangent,
+// the frames do not flip on vertical tangents. The arc length table is kept in it, so both are built and cached together.
+template<int32 Degree = 3>
+class TSplineFrameTable
+{
+public:
+	using FSplineType = typename TSplineBase<3, Degree>;
+	using FTableType = typename TSplineArcLengthTable<3, Degree>;
+
+	// Binormal is Normal ^ Tangent, which is the same as the DirT offset direction if Normal is UpVector.
+	struct FFrame
+	{
+		FVector Position = FVector::ZeroVector;
+		FVector Tangent = FVector::ForwardVector;
+		FVector Normal = FVector::UpVector;
+		FVector Binormal = FVector::RightVector;
+
+		FORCEINLINE FQuat GetRotation() const { return FRotationMatrix::MakeFromXZ(Tangent, Normal).ToQuat(); }
+	};
+
+	TSplineFrameTable() {}
+
+	TSplineFrameTable(const FSplineType& Spline, int32 SamplesPerSegment = 8)
+	{
+		Build(Spline, SamplesPerSegment);
+	}
+
+	// The first normal is InitialNormal made perpendicular to the first tangent.
+	void Build(const FSplineType& Spline, int32 SamplesPerSegment = 8, const FVector& InitialNormal = FVector::UpVector, double MaxAngleDegrees = 5., int32 MaxDepth = 8);
+
+	// Keep the arc length table and only rebuild the frames, e.g. with another initial normal.
+	void BuildFrames(const FVector& InitialNormal = FVector::UpVector, double MaxAngleDegrees = 5., int32 MaxDepth = 8);
+
+	void Empty();
+
+	FORCEINLINE bool IsEmpty() const { return Params.Num() == 0; }
+
+	FORCEINLINE const FTableType& GetArcLengthTable() const { return ArcLengthTable; }
+
+	FORCEINLINE int32 GetSampleNum() const { return Params.Num(); }
+
+	FORCEINLINE double GetSampleParam(int32 Index) const { return Params[Index]; }
+
+	FORCEINLINE double GetSampleLength(int32 Index) const { return Lengths[Index]; }
+
+	FORCEINLINE const FVector& GetSampleNormal(int32 Index) const { return Normals[Index]; }
+
+	// Binary search of the samples, then the normal is interpolated and made perpendicular to the exact tangent.
+	FFrame GetFrame(double T) const;
+
+	FFrame GetFrameAtLength(double S) const;
+
+	FVector GetNormal(double T) const;
+
+	FVector GetBinormal(double T) const;
+
+	// Roll for USplineMeshComponent, whose up direction is ReferenceUp.
+	double GetRoll(double T, const FVector& ReferenceUp = FVector::UpVector) const;
+
+	// The angle rotating the base frame of USplineMeshComponent around Tangent, such that the mesh is up to Normal.
+	// It is in (-PI, PI], so unwrap the rolls along the spline with UnwrapRoll().
+	static double GetRollAroundTangent(const FVector& Tangent, const FVector& Normal, const FVector& ReferenceUp = FVector::UpVector);
+
+	// The roll equivalent to Roll nearest to PrevRoll, since USplineMeshComponent blends the rolls linearly.
+	static double UnwrapRoll(double Roll, double PrevRoll);
+
+protected:
+	// Interval of samples [Index, Index + 1] containing the parameter.
+	int32 FindSampleInterval(double T) const;
+
+	FVector GetUnitTangent(double T, const FVector& Fallback) const;
+
+	static FVector MakeNormal(const FVector& Tangent, const FVector& PreferredNormal);
+
+protected:
+	FTableType ArcLengthTable;
+
+	TArray<double> Params;
+	TArray<double> Lengths;
+	TArray<FVector> Tangents;
+	TArray<FVector> Normals;
+};
+
+#include "SplineFrameTable.inl"
@@ -0,0 +1,194 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "SplineFrameTable.h"
+
+template<int32 Degree>
+inline void TSplineFrameTable<Degree>::Build(const FSplineType& Spline, int32 SamplesPerSegment, const FVector& InitialNormal, double MaxAngleDegrees, int32 MaxDepth)
+{
+	ArcLengthTable.Build(Spline, SamplesPerSegment);
+	BuildFrames(InitialNormal, MaxAngleDegrees, MaxDepth);
+}
+
+template<int32 Degree>
+inline void TSplineFrameTable<Degree>::BuildFrames(const FVector& InitialNormal, double MaxAngleDegrees, int32 MaxDepth)
+{
+	Params.Reset();
+	Lengths.Reset();
+	Tangents.Reset();
+	Normals.Reset();
+	const int32 TableSampleNum = ArcLengthTable.GetSampleNum();
+	if (TableSampleNum == 0) {
+		return;
+	}
+	const double MaxCos = FMath::Cos(FMath::DegreesToRadians(FMath::Clamp(MaxAngleDegrees, KINDA_SMALL_NUMBER, 180.)));
+
+	// Samples. Bisect the intervals of the arc length table where the tangent turns too much.
+	const double FirstParam = ArcLengthTable.GetSampleParam(0);
+	const FVector FirstFallback = TableSampleNum > 1
+		? (ArcLengthTable.GetPosition(ArcLengthTable.GetSampleParam(1)) - ArcLengthTable.GetPosition(FirstParam)).GetSafeNormal()
+		: FVector::ForwardVector;
+	Params.Reserve(TableSampleNum);
+	Lengths.Reserve(TableSampleNum);
+	Tangents.Reserve(TableSampleNum);
+	Params.Add(FirstParam);
+	Lengths.Add(0.);
+	Tangents.Add(GetUnitTangent(FirstParam, FirstFallback.IsNearlyZero() ? FVector::ForwardVector : FirstFallback));
+
+	struct FPending
+	{
+		double To;
+		FVector ToTangent;
+		int32 Depth;
+	};
+	TArray<FPending, TInlineAllocator<16> > Stack;
+	for (int32 i = 1; i < TableSampleNum; ++i) {
+		const double To = ArcLengthTable.GetSampleParam(i);
+		Stack.Add(FPending{ To, GetUnitTangent(To, Tangents.Last()), 0 });
+		while (Stack.Num() > 0) {
+			FPending& Top = Stack.Last();
+			const double From = Params.Last();
+			if (Top.Depth < MaxDepth && (Tangents.Last() | Top.ToTangent) < MaxCos) {
+				const double Mid = (From + Top.To) * 0.5;
+				const int32 Depth = ++Top.Depth;
+				Stack.Add(FPending{ Mid, GetUnitTangent(Mid, Tangents.Last()), Depth });
+				continue;
+			}
+			Params.Add(Top.To);
+			Lengths.Add(Stack.Num() == 1 ? ArcLengthTable.GetSampleLength(i) : ArcLengthTable.GetLengthAtParameter(Top.To));
+			Tangents.Add(Top.ToTangent);
+			Stack.Pop(false);
+		}
+	}
+
+	// Double reflection. The first reflection is by the bisecting plane of the two positions,
+	// and the second one takes the reflected tangent to the next tangent.
+	Normals.Reserve(Params.Num());
+	Normals.Add(MakeNormal(Tangents[0], InitialNormal));
+	FVector PrevPosition = ArcLengthTable.GetPosition(Params[0]);
+	for (int32 i = 1; i < Params.Num(); ++i) {
+		const FVector Position = ArcLengthTable.GetPosition(Params[i]);
+		const FVector& PrevTangent = Tangents[i - 1];
+		const FVector& PrevNormal = Normals[i - 1];
+		FVector Normal = PrevNormal;
+		const FVector V1 = Position - PrevPosition;
+		const double C1 = V1 | V1;
+		if (!FMath::IsNearlyZero(C1)) {
+			const FVector NormalL = PrevNormal - V1 * (2. / C1 * (V1 | PrevNormal));
+			const FVector TangentL = PrevTangent - V1 * (2. / C1 * (V1 | PrevTangent));
+			const FVector V2 = Tangents[i] - TangentL;
+			const double C2 = V2 | V2;
+			Normal = FMath::IsNearlyZero(C2) ? NormalL : NormalL - V2 * (2. / C2 * (V2 | NormalL));
+		}
+		// Remove the drift of the float vectors.
+		Normals.Add(MakeNormal(Tangents[i], Normal));
+		PrevPosition = Position;
+	}
+}
+
+template<int32 Degree>
+inline void TSplineFrameTable<Degree>::Empty()
+{
+	ArcLengthTable.Empty();
+	Params.Reset();
+	Lengths.Reset();
+	Tangents.Reset();
+	Normals.Reset();
+}
+
+template<int32 Degree>
+inline typename TSplineFrameTable<Degree>::FFrame TSplineFrameTable<Degree>::GetFrame(double T) const
+{
+	FFrame Frame;
+	if (Params.Num() == 0) {
+		return Frame;
+	}
+	const TTuple<double, double>& ParamRange = ArcLengthTable.GetParamRange();
+	T = FMath::Clamp(T, ParamRange.Get<0>(), ParamRange.Get<1>());
+	Frame.Position = ArcLengthTable.GetPosition(T);
+	if (Params.Num() == 1) {
+		Frame.Tangent = Tangents[0];
+		Frame.Normal = Normals[0];
+	}
+	else {
+		const int32 Index = FindSampleInterval(T);
+		const double Diff = Params[Index + 1] - Params[Index];
+		const double Alpha = FMath::IsNearlyZero(Diff) ? 0. : FMath::Clamp((T - Params[Index]) / Diff, 0., 1.);
+		Frame.Tangent = GetUnitTangent(T, Tangents[Index]);
+		Frame.Normal = MakeNormal(Frame.Tangent, FMath::Lerp(Normals[Index], Normals[Index + 1], static_cast<float>(Alpha)));
+	}
+	Frame.Binormal = Frame.Normal ^ Frame.Tangent;
+	return Frame;
+}
+
+template<int32 Degree>
+inline typename TSplineFrameTable<Degree>::FFrame TSplineFrameTable<Degree>::GetFrameAtLength(double S) const
+{
+	return GetFrame(ArcLengthTable.GetParameterAtLength(S));
+}
+
+template<int32 Degree>
+inline FVector TSplineFrameTable<Degree>::GetNormal(double T) const
+{
+	return GetFrame(T).Normal;
+}
+
+template<int32 Degree>
+inline FVector TSplineFrameTable<Degree>::GetBinormal(double T) const
+{
+	return GetFrame(T).Binormal;
+}
+
+template<int32 Degree>
+inline double TSplineFrameTable<Degree>::GetRoll(double T, const FVector& ReferenceUp) const
+{
+	const FFrame Frame = GetFrame(T);
+	return GetRollAroundTangent(Frame.Tangent, Frame.Normal, ReferenceUp);
+}
+
+template<int32 Degree>
+inline double TSplineFrameTable<Degree>::GetRollAroundTangent(const FVector& Tangent, const FVector& Normal, const FVector& ReferenceUp)
+{
+	// Same base frame as USplineMeshComponent::CalcSliceTransform.
+	const FVector Dir = Tangent.GetSafeNormal();
+	const FVector BaseX = (ReferenceUp ^ Dir).GetSafeNormal();
+	if (BaseX.IsNearlyZero()) {
+		return 0.;
+	}
+	const FVector BaseY = Dir ^ BaseX;
+	return FMath::Atan2(Normal | BaseX, Normal | BaseY);
+}
+
+template<int32 Degree>
+inline double TSplineFrameTable<Degree>::UnwrapRoll(double Roll, double PrevRoll)
+{
+	return PrevRoll + FMath::UnwindRadians(Roll - PrevRoll);
+}
+
+template<int32 Degree>
+inline int32 TSplineFrameTable<Degree>::FindSampleInterval(double T) const
+{
+	return FMath::Clamp(Algo::UpperBound(Params, T) - 1, 0, Params.Num() - 2);
+}
+
+template<int32 Degree>
+inline FVector TSplineFrameTable<Degree>::GetUnitTangent(double T, const FVector& Fallback) const
+{
+	const FVector Tangent = ArcLengthTable.GetTangent(T);
+	return Tangent.IsNearlyZero() ? Fallback : Tangent.GetSafeNormal();
+}
+
+template<int32 Degree>
+inline FVector TSplineFrameTable<Degree>::MakeNormal(const FVector& Tangent, const FVector& PreferredNormal)
+{
+	const FVector Candidates[] = { PreferredNormal, FVector::UpVector, FVector::ForwardVector, FVector::RightVector };
+	for (const FVector& Candidate : Candidates) {
+		const FVector Normal = Candidate - Tangent * (Tangent | Candidate);
+		if (!Normal.IsNearlyZero()) {
+			return Normal.GetSafeNormal();
+		}
+	}
+	return FVector::UpVector;
+}
@@ -4,7 +4,6 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Containers/Queue.h"
 #include "BezierString.h"
 #include "BSpline.h"
 
@@ -12,6 +11,9 @@
 template<int32 Dim, int32 Degree = 3>
 class TSplineGraph;
 
+template<int32 Dim>
+class TSplineGraphJournal;
+
 template<int32 Dim>
 class TSplineGraph<Dim, 3>
 {
@@ -31,21 +33,48 @@ public:
 		TSharedPtr<FSplineType> Spline;
 	};
 
+	// Stable handle of a spline in the graph. The index may be reused after the spline is deleted,
+	// but the generation is increased, so old handles become invalid.
+	struct FSplineId
+	{
+		int32 Index = INDEX_NONE;
+		uint32 Generation = 0;
+
+		FORCEINLINE bool IsValid() const { return Index != INDEX_NONE; }
+
+		FORCEINLINE bool operator==(const FSplineId& Other) const { return Index == Other.Index && Generation == Other.Generation; }
+
+		FORCEINLINE bool operator!=(const FSplineId& Other) const { return !(*this == Other); }
+
+		friend uint32 GetTypeHash(const FSplineId& Id)
+		{
+			return HashCombine(::GetTypeHash(Id.Index), ::GetTypeHash(Id.Generation));
+		}
+	};
+
 	struct FGraphNode
 	{
 		TWeakPtr<FSplineWrapper> SplineWrapper;
 		EContactType ContactType = Start;
+		FSplineId SplineId;
 
 		friend uint32 GetTypeHash(const FGraphNode& Node)
 		{
+			if (Node.SplineId.IsValid()) {
+				return GetTypeHash(Node.SplineId);
+			}
 			if (Node.SplineWrapper.IsValid()) {
 				return ::PointerHash(Node.SplineWrapper.Pin()->Spline.Get());
 			}
 			return ::PointerHash(nullptr);
 		}
 
+		// Same fields as GetTypeHash(), so a node with the id never equals a node without it.
 		bool operator==(const FGraphNode& Other) const
 		{
+			if (SplineId.IsValid() || Other.SplineId.IsValid()) {
+				return SplineId == Other.SplineId;
+			}
 			if (!SplineWrapper.IsValid() && !Other.SplineWrapper.IsValid()) {
 				return true;
 			}
@@ -53,29 +82,21 @@ public:
 		}
 	};
 
+	// An endpoint is (SplineIndex * 2 + (End ? 1 : 0)).
+	FORCEINLINE static constexpr int32 MakeEndpoint(int32 SplineIndex, EContactType ContactType) { return (SplineIndex << 1) | (ContactType == EContactType::End ? 1 : 0); }
+	FORCEINLINE static constexpr int32 GetEndpointSplineIndex(int32 Endpoint) { return Endpoint >> 1; }
+	FORCEINLINE static constexpr EContactType GetEndpointContactType(int32 Endpoint) { return (Endpoint & 1) ? EContactType::End : EContactType::Start; }
+
 public:
 	FORCEINLINE TSplineGraph() {}
 	FORCEINLINE virtual ~TSplineGraph() 
 	{
-		for (auto& Pair : InternalGraphForward)
-		{
-			Pair.Get<0>().Reset();
-		}
-		InternalGraphForward.Empty();
-
-		for (auto& Pair : InternalGraphBackward)
-		{
-			Pair.Get<0>().Reset();
-		}
-		InternalGraphBackward.Empty();
-
-		for (auto& Pair : SplineToWrapper)
-		{
-			Pair.Get<0>().Reset();
-		}
-		SplineToWrapper.Empty();
+		SetJournal(nullptr);
+		Empty();
 	}
 
+	// Connect the splines as a chain, and the last one to the first one if closed. The splines are not modified,
+	// so call RemakeC2() after the construction to make a closed chain of bezier strings C2 at the seam.
 	FORCEINLINE TSplineGraph(const TArray<TSharedPtr<FSplineType> >& Splines, bool bClosed = false);
 
 	virtual void Empty();
@@ -115,8 +136,36 @@ public:
 		const TVectorX<Dim>& From, const TVectorX<Dim>& To, TWeakPtr<FSplineType> SplinePtrToAdjust = nullptr, 
 		int32 MoveLevel = 0, int32 TangentFlag = 0, int32 NthPointOfFrom = 0, double ToleranceSqr = 1.);
 
+	// Moves between BeginBatch() and the outermost EndBatch() are applied immediately, but the connected splines
+	// are adjusted only once at the end, from the shape of each moved spline before its first move in the batch.
+	// Batches can be nested.
+	void BeginBatch();
+
+	// Return the number of splines moved or adjusted in the batch, which are output if OutAffectedIds is not null.
+	int32 EndBatch(TArray<FSplineId>* OutAffectedIds = nullptr);
+
+	FORCEINLINE bool IsInBatch() const { return BatchDepth > 0; }
+
+	// Scoped batch.
+	struct FGraphEditTransaction
+	{
+		FORCEINLINE FGraphEditTransaction(TSplineGraph& InGraph, TArray<FSplineId>* InOutAffectedIds = nullptr)
+			: Graph(InGraph), OutAffectedIds(InOutAffectedIds)
+		{
+			Graph.BeginBatch();
+		}
+
+		FORCEINLINE ~FGraphEditTransaction()
+		{
+			Graph.EndBatch(OutAffectedIds);
+		}
+
+		TSplineGraph& Graph;
+		TArray<FSplineId>* OutAffectedIds;
+	};
+
 	// EContactType::End means forward, EContactType::Start means backward.
-	virtual void GetClusterWithoutSelf(TSet<TTuple<FGraphNode, int32> >& Cluster, const TSharedPtr<FSplineType>& SplinePtr, EContactType Direction = EContactType::End);
+	virtual void GetClusterWithoutSelf(TSet<TTuple<FGraphNode, int32> >& Cluster, const TSharedPtr<FSplineType>& SplinePtr, EContactType Direction = EContactType::End, int32 MaxDistance = -1);
 
 	virtual void GetSplines(TArray<TWeakPtr<FSplineType> >& Splines) const;
 
@@ -128,25 +177,207 @@ public:
 
 	virtual void ChangeSplineType(TWeakPtr<FSplineType>& SplinePtr, ESplineType NewType);
 
+	// Result of ChangeSplineTypes() for one spline. The old spline is kept alive here, so that the old control point
+	// structs can still be compared with. NewToOldPoints[i] is the index of the old control point at the same position
+	// as the new control point i, or INDEX_NONE.
+	struct FSplineTypeRemap
+	{
+		FSplineId Id;
+		TSharedPtr<FSplineType> OldSpline;
+		TSharedPtr<FSplineType> NewSpline;
+		TArray<int32> NewToOldPoints;
+	};
+
+	// Convert the splines in parallel. The wrappers, ids and connections are kept.
+	// Splines already of the type, or failing to convert, are skipped. Return the number of splines converted.
+	int32 ChangeSplineTypes(TArray<FSplineTypeRemap>& OutRemaps, TArrayView<const FSplineId> Ids, ESplineType NewType);
+
+	// Edits are recorded by the journal between its BeginEdit() and EndEdit(). Only one journal at a time.
+	void SetJournal(TSplineGraphJournal<Dim>* InJournal);
+
+	FORCEINLINE TSplineGraphJournal<Dim>* GetJournal() const { return Journal; }
+
+	// Interpolate the points of a chain of bezier strings as a whole, C2 at the joints.
+	// If closed, the chain is also C2 at the seam from the last spline to the first spline.
+	// Return false if any spline in the chain is not a bezier string.
+	virtual bool RemakeC2(const TArray<TSharedPtr<FSplineType> >& SplineChain, bool bClosed = false);
+
+	// Flat description of splines for bulk construction. Spline s has the points [PointOffsets[s], PointOffsets[s + 1]).
+	// Bezier strings use PrevPoints and NextPoints as the tangent handles if they are not empty,
+	// otherwise they are interpolated C2. B-Splines have uniform knot intervals.
+	// A connection links two endpoints (MakeEndpoint() with the spline indices in the description) both ways.
+	struct FBuildArrays
+	{
+		TArrayView<const TVectorX<Dim> > Points;
+		TArrayView<const TVectorX<Dim> > PrevPoints;
+		TArrayView<const TVectorX<Dim> > NextPoints;
+		TArrayView<const int32> PointOffsets;
+		TArrayView<const ESplineType> Types;
+		TArrayView<const TTuple<int32, int32> > Connections;
+	};
+
+	// The splines are constructed in parallel, then added and connected in one pass.
+	// Return false without adding anything if the arrays are inconsistent. OutIds are in the order of the description.
+	bool BuildFromArrays(TArray<FSplineId>& OutIds, const FBuildArrays& Arrays);
+
+public:
+	// Integer handle API. The pointer API above is a thin layer on it.
+
+	FSplineId GetSplineId(const FSplineType* Spline) const;
+
+	FSplineId GetSplineId(TWeakPtr<FSplineType> SplineWeakPtr) const { return SplineWeakPtr.IsValid() ? GetSplineId(SplineWeakPtr.Pin().Get()) : FSplineId(); }
+
+	FORCEINLINE bool IsValidId(const FSplineId& Id) const
+	{
+		return SplineSlots.IsValidIndex(Id.Index) && SplineSlots[Id.Index].Generation == Id.Generation && SplineSlots[Id.Index].Wrapper.IsValid();
+	}
+
+	FORCEINLINE TSharedPtr<FSplineType> GetSplineById(const FSplineId& Id) const { return IsValidId(Id) ? SplineSlots[Id.Index].Wrapper->Spline : nullptr; }
+
+	FORCEINLINE TSharedPtr<FSplineWrapper> GetSplineWrapperById(const FSplineId& Id) const { return IsValidId(Id) ? SplineSlots[Id.Index].Wrapper : nullptr; }
+
+	FORCEINLINE FSplineId GetSplineIdByIndex(int32 SplineIndex) const
+	{
+		return (SplineSlots.IsValidIndex(SplineIndex) && SplineSlots[SplineIndex].Wrapper.IsValid()) ? FSplineId{ SplineIndex, SplineSlots[SplineIndex].Generation } : FSplineId();
+	}
+
+	// Upper bound of spline indices, for arrays indexed by spline index.
+	FORCEINLINE int32 GetSplineIndexCapacity() const { return SplineSlots.Num(); }
+
+	// Increased whenever a connection or a spline is added or removed.
+	FORCEINLINE uint32 GetTopologyGeneration() const { return TopologyGeneration; }
+
+	bool HasConnection(const FSplineId& Id, EContactType Direction) const;
+
+	// Endpoints connected to the endpoint, in the compact adjacency.
+	TArrayView<const int32> GetAdjacentEndpoints(int32 Endpoint) const;
+
+	// Breadth first from the endpoint, without hashing or allocation if OutEndpointsWithDistance is reused.
+	// The output is sorted by distance (level), and MaxDistance < 0 means no cutoff.
+	// Not thread safe, since the visit marks are shared by the graph.
+	void GetClusterWithoutSelf(TArray<TTuple<int32, int32> >& OutEndpointsWithDistance, const FSplineId& Id, EContactType Direction = EContactType::End, int32 MaxDistance = -1) const;
+
 protected:
-	TMap<TSharedPtr<FSplineWrapper>, TSet<FGraphNode> > InternalGraphForward;
-	TMap<TSharedPtr<FSplineWrapper>, TSet<FGraphNode> > InternalGraphBackward;
+	template<int32> friend class TSplineGraphJournal;
+
+	struct FSplineSlot
+	{
+		TSharedPtr<FSplineWrapper> Wrapper;
+		uint32 Generation = 0;
+	};
+
+	struct FEndpointLink
+	{
+		int32 Endpoint = INDEX_NONE;
+		uint32 Generation = 0;
+	};
+
+	TArray<FSplineSlot> SplineSlots;
+	TArray<int32> FreeSplineIndices;
+	TMap<const FSplineType*, int32> SplineToIndex;
+
+	// Editable directed links of each endpoint. Links to deleted splines are detected by generation.
+	TArray<TArray<FEndpointLink, TInlineAllocator<4> > > EndpointLinks;
+
+	// Compact (CSR) copy of the live links for traversal, rebuilt lazily after the topology changes.
+	mutable TArray<int32> AdjacencyOffsets;
+	mutable TArray<int32> AdjacencyEndpoints;
+	mutable bool bAdjacencyDirty = true;
+
+	uint32 TopologyGeneration = 0;
+
+	// Scratch for traversal. An endpoint is visited if its epoch equals VisitEpoch.
+	mutable TArray<uint32> EndpointVisitEpochs;
+	mutable uint32 VisitEpoch = 0;
+	mutable TArray<TTuple<int32, int32> > ClusterScratch;
+
+	// A spline moved in the current batch, with the end states before its first move.
+	struct FBatchedEdit
+	{
+		FSplineId Id;
+		TMap<EContactType, TVectorX<Dim> > InitialPos;
+		TMap<EContactType, TVectorX<Dim> > InitialTangent;
+		int32 MoveLevel = 0;
+		int32 NthPointOfFrom = 0;
+	};
 
-	TMap<TSharedPtr<FSplineType>, TWeakPtr<FSplineWrapper> > SplineToWrapper;
+	int32 BatchDepth = 0;
+	TArray<FBatchedEdit> BatchedEdits;
+	// Index in BatchedEdits by spline index, or INDEX_NONE.
+	TArray<int32> BatchedEditIndices;
+	// Whether the spline is in the affected ids of EndBatch(), by spline index.
+	TArray<bool> BatchAffectedFlags;
 
-	const FGraphNode* FindGraphNodeBySplinePtrInSet(const TSet<FGraphNode>& AdjSet, TWeakPtr<FSplineType> Spline) const;
+	TSplineGraphJournal<Dim>* Journal = nullptr;
+
+	bool IsJournalRecording() const;
+
+	// Capture the spline before it is modified in the current edit of the journal.
+	// Return true if it is captured now, so DiscardTouch() can drop it if nothing is modified.
+	bool RecordTouch(int32 SplineIndex);
+
+	void DiscardTouch(int32 SplineIndex);
+
+	uint32 BeginVisit() const;
+
+	int32 AddSplineSlot(TSharedPtr<FSplineWrapper> Wrapper);
+
+	FORCEINLINE bool IsLinkAlive(const FEndpointLink& Link) const
+	{
+		int32 SplineIndex = GetEndpointSplineIndex(Link.Endpoint);
+		return SplineSlots.IsValidIndex(SplineIndex) && SplineSlots[SplineIndex].Generation == Link.Generation && SplineSlots[SplineIndex].Wrapper.IsValid();
+	}
+
+	FORCEINLINE FGraphNode MakeGraphNode(int32 Endpoint) const
+	{
+		int32 SplineIndex = GetEndpointSplineIndex(Endpoint);
+		return FGraphNode{ SplineSlots[SplineIndex].Wrapper, GetEndpointContactType(Endpoint), FSplineId{ SplineIndex, SplineSlots[SplineIndex].Generation } };
+	}
+
+	// A link from an endpoint to a spline is unique, so the contact type is replaced if linked again.
+	void AddDirectedLink(int32 FromEndpoint, int32 ToEndpoint);
+
+	void RemoveDirectedLinksToSpline(int32 FromEndpoint, int32 ToSplineIndex, TOptional<EContactType> ToContactType = TOptional<EContactType>());
+
+	// Swap the links of both ends of the spline, and flip the links to it.
+	void ReverseLinks(int32 SplineIndex, uint32 Generation);
+
+	void MarkTopologyChanged();
+
+	void RebuildAdjacency() const;
 
 	void ChangeSplineTypeFromBezierString(TSharedPtr<FSplineWrapper> WrapperSharedPtr, ESplineType NewType);
 
 	void ChangeSplineTypeFromBSpline(TSharedPtr<FSplineWrapper> WrapperSharedPtr, ESplineType NewType);
 
-	void UpdateDeleted(TWeakPtr<FSplineWrapper> SplineWrapperToDelete);
+	// Only read the spline. Return nullptr if the spline can't be converted.
+	static TSharedPtr<FSplineType> MakeSplineOfType(const FSplineType& Spline, ESplineType NewType);
+
+	static void GetCtrlPointPositions(TArray<TVectorX<Dim+1> >& OutPositions, const FSplineType& Spline);
+
+	// Both splines have the control points ordered from start to end.
+	static void MatchCtrlPointsByPosition(TArray<int32>& OutNewToOld, const FSplineType& OldSpline, const FSplineType& NewSpline);
+
+	void ReplaceSpline(FSplineWrapper& Wrapper, const TSharedPtr<FSplineType>& NewSpline);
+
+	void UpdateDeleted(int32 SplineIndex);
 
 	void AdjustAuxiliaryFunc(
 		const TSharedPtr<FSplineType>& SplinePtr, const TTuple<double, double>& ParamRange,
 		const TMap<EContactType, TVectorX<Dim> >& InitialPos,
 		const TMap<EContactType, TVectorX<Dim> >& InitialTangent,
-		int32 MoveLevel = 1, int32 NthPointOfFrom = 0);
+		int32 MoveLevel = 1, int32 NthPointOfFrom = 0, TArray<FSplineId>* OutAdjustedIds = nullptr);
+
+	// Add the id if not added yet in EndBatch(), by BatchAffectedFlags.
+	void AddBatchAffectedId(TArray<FSplineId>& OutAffectedIds, const FSplineId& Id);
+
+	// Adjust the connected splines now, or record the edit if in a batch.
+	void AdjustOrRecordAuxiliary(
+		const TSharedPtr<FSplineType>& SplinePtr, const TTuple<double, double>& ParamRange,
+		const TMap<EContactType, TVectorX<Dim> >& InitialPos,
+		const TMap<EContactType, TVectorX<Dim> >& InitialTangent,
+		int32 MoveLevel, int32 NthPointOfFrom);
 };
 
 #include "SplineGraph.inl"
+#include "SplineGraphJournal.h"
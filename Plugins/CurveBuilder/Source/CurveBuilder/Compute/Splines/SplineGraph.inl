@@ -4,57 +4,57 @@
 #pragma once
 
 #include "SplineGraph.h"
+#include "Async/ParallelFor.h"
 
 template<int32 Dim>
 inline TSplineGraph<Dim, 3>::TSplineGraph(const TArray<TSharedPtr<FSplineType> >& Splines, bool bClosed)
 {
-	TArray<TSharedPtr<FSplineWrapper> > SplineWrappers;
-	SplineWrappers.Reserve(Splines.Num());
+	SplineSlots.Reserve(Splines.Num());
+	EndpointLinks.Reserve(Splines.Num() << 1);
+	SplineToIndex.Reserve(Splines.Num());
+	TArray<int32> SplineIndices;
+	SplineIndices.Reserve(Splines.Num());
 	for (int32 i = 0; i < Splines.Num(); ++i) {
-		TSharedPtr<FSplineWrapper>& SplineWrapper = SplineWrappers.Add_GetRef(MakeShareable(new FSplineWrapper{ Splines[i] }));
-		InternalGraphForward.Add(SplineWrapper, {});
-		InternalGraphBackward.Add(SplineWrapper, {});
-		SplineToWrapper.Add(Splines[i], TWeakPtr<FSplineWrapper>(SplineWrapper));
+		SplineIndices.Add(AddSplineSlot(MakeShareable(new FSplineWrapper{ Splines[i] })));
 	}
 	for (int32 i = 0; i < Splines.Num() - 1; ++i) {
-		InternalGraphForward[SplineToWrapper[Splines[i]].Pin()].Add({ TWeakPtr<FSplineWrapper>(SplineWrappers[i + 1]), EContactType::Start });
+		AddDirectedLink(MakeEndpoint(SplineIndices[i], EContactType::End), MakeEndpoint(SplineIndices[i + 1], EContactType::Start));
 	}
 	for (int32 i = 1; i < Splines.Num(); ++i) {
-		InternalGraphBackward[SplineToWrapper[Splines[i]].Pin()].Add({ TWeakPtr<FSplineWrapper>(SplineWrappers[i - 1]), EContactType::End });
+		AddDirectedLink(MakeEndpoint(SplineIndices[i], EContactType::Start), MakeEndpoint(SplineIndices[i - 1], EContactType::End));
 	}
-	if (bClosed) {
-		InternalGraphForward[SplineWrappers.Last()].Add({ TWeakPtr<FSplineWrapper>(SplineWrappers[0]), EContactType::Start });
-		InternalGraphBackward[SplineWrappers[0]].Add({ TWeakPtr<FSplineWrapper>(SplineWrappers.Last()), EContactType::End });
+	if (bClosed && Splines.Num() > 0) {
+		AddDirectedLink(MakeEndpoint(SplineIndices.Last(), EContactType::End), MakeEndpoint(SplineIndices[0], EContactType::Start));
+		AddDirectedLink(MakeEndpoint(SplineIndices[0], EContactType::Start), MakeEndpoint(SplineIndices.Last(), EContactType::End));
 	}
 }
 
 template<int32 Dim>
 inline void TSplineGraph<Dim, 3>::Empty()
 {
-	SplineToWrapper.Empty();
-	InternalGraphForward.Empty();
-	InternalGraphBackward.Empty();
+	SplineToIndex.Empty();
+	SplineSlots.Empty();
+	FreeSplineIndices.Empty();
+	EndpointLinks.Empty();
+	BatchedEdits.Empty();
+	BatchedEditIndices.Empty();
+	MarkTopologyChanged();
+	if (Journal)
+	{
+		Journal->Empty();
+	}
 }
 
 template<int32 Dim>
 inline int32 TSplineGraph<Dim, 3>::Num() const
 {
-	return FMath::Max(InternalGraphForward.Num(), InternalGraphBackward.Num());
+	return SplineToIndex.Num();
 }
 
 template<int32 Dim>
 inline TWeakPtr<typename TSplineGraph<Dim, 3>::FSplineWrapper> TSplineGraph<Dim, 3>::GetSplineWrapper(TWeakPtr<FSplineType> SplineWeakPtr)
 {
-	if (!SplineWeakPtr.IsValid())
-	{
-		return TWeakPtr<FSplineWrapper>();
-	}
-	TWeakPtr<FSplineWrapper>* WrapperWeakPtrPtr = SplineToWrapper.Find(SplineWeakPtr.Pin());
-	if (!WrapperWeakPtrPtr)
-	{
-		return TWeakPtr<FSplineWrapper>();
-	}
-	return *WrapperWeakPtrPtr;
+	return TWeakPtr<FSplineWrapper>(GetSplineWrapperById(GetSplineId(SplineWeakPtr)));
 }
 
 template<int32 Dim>
@@ -76,33 +76,15 @@ inline TWeakPtr<typename TSplineGraph<Dim, 3>::FSplineType> TSplineGraph<Dim, 3>
 
 template<int32 Dim>
 inline TWeakPtr<typename TSplineGraph<Dim, 3>::FSplineType> TSplineGraph<Dim, 3>::AddSplineToGraph(TSharedPtr<FSplineType> Spline, TWeakPtr<FSplineType> Prev, TWeakPtr<FSplineType> Next)
-
 {
-	TSharedPtr<FSplineWrapper> SplineWrapper = MakeShareable(new FSplineWrapper{ Spline });
-	InternalGraphForward.FindOrAdd(SplineWrapper, {});
-	InternalGraphBackward.FindOrAdd(SplineWrapper, {});
-	SplineToWrapper.FindOrAdd(Spline, TWeakPtr<FSplineWrapper>(SplineWrapper));
+	if (!SplineToIndex.Contains(Spline.Get())) {
+		AddSplineSlot(MakeShareable(new FSplineWrapper{ Spline }));
+	}
 
 	TWeakPtr<FSplineType> SplineWeakPtr(Spline);
 
 	VirtualConnectFromPrevEnd(SplineWeakPtr, Next);
 	VirtualConnectFromPrevEnd(Prev, SplineWeakPtr);
-	//if (Prev.IsValid()) {
-	//	auto* PrevValuePtr = InternalGraphForward.Find(Prev.Pin());
-	//	if (PrevValuePtr) {
-	//		(*PrevValuePtr).Add(SplineWeakPtr);
-	//		auto& CurValueRef = InternalGraphBackward[SplineWeakPtr.Pin()];
-	//		CurValueRef.Add(Prev);
-	//	}
-	//}
-	//if (Next.IsValid()) {
-	//	auto* NextValuePtr = InternalGraphBackward.Find(Next.Pin());
-	//	if (NextValuePtr) {
-	//		(*NextValuePtr).Add(SplineWeakPtr);
-	//		auto& CurValueRef = InternalGraphForward[SplineWeakPtr.Pin()];
-	//		CurValueRef.Add(Next);
-	//	}
-	//}
 
 	return SplineWeakPtr;
 }
@@ -110,53 +92,39 @@ inline TWeakPtr<typename TSplineGraph<Dim, 3>::FSplineType> TSplineGraph<Dim, 3>
 template<int32 Dim>
 inline TWeakPtr<typename TSplineGraph<Dim, 3>::FSplineType> TSplineGraph<Dim, 3>::CreateSplineBesidesExisted(TWeakPtr<FSplineType> Prev, EContactType Direction, int32 EndContinuity, TArray<TWeakPtr<FControlPointType>>* NewControlPointStructsPtr)
 {
-	EContactType InvDirection = (Direction == EContactType::Start) ? EContactType::End : EContactType::Start;
 	if (Prev.IsValid()) {
 		TSharedPtr<FSplineType> PrevSharedPtr = Prev.Pin();
+		FSplineId PrevId = GetSplineId(PrevSharedPtr.Get());
+		if (PrevId.IsValid()) {
+			RecordTouch(PrevId.Index);
+		}
 		PrevSharedPtr->ProcessBeforeCreateSameType(NewControlPointStructsPtr);
-		TWeakPtr<FSplineWrapper>* PrevWrapperPtr = SplineToWrapper.Find(PrevSharedPtr);
-		if (PrevWrapperPtr) {
+		if (PrevId.IsValid()) {
 			TSharedRef<FSplineType> TempSpline = PrevSharedPtr.Get()->Copy();
 			auto& TempSplineGet = TempSpline.Get();
 			//TempSplineGet.ProcessBeforeCreateSameType(nullptr);
-			auto* GraphPtr1 = &InternalGraphForward;
-			auto* GraphPtr2 = &InternalGraphBackward;
-
 			if (Direction == EContactType::Start)
 			{
-				GraphPtr1 = &InternalGraphBackward;
-				GraphPtr2 = &InternalGraphForward;
 				TempSplineGet.Reverse();
 			}
 
-			TSet<TTuple<FGraphNode, int32> > Cluster;
-			GetClusterWithoutSelf(Cluster, PrevSharedPtr, Direction);
-
-			TSharedPtr<FSplineWrapper> PrevWrapperSharedPtr = PrevWrapperPtr->Pin();
+			TArray<TTuple<int32, int32> > Cluster;
+			GetClusterWithoutSelf(Cluster, PrevId, Direction);
 
 			TSharedRef<FSplineType> NewSpline = TempSplineGet.CreateSameType(EndContinuity);
 			TSharedPtr<FSplineType> NewSplinePtr(NewSpline);
-			TSharedPtr<FSplineWrapper> NewSplineWrapper = MakeShareable(new FSplineWrapper{ NewSplinePtr });
+			int32 NewIndex = AddSplineSlot(MakeShareable(new FSplineWrapper{ NewSplinePtr }));
 
-			InternalGraphForward.Add(NewSplineWrapper, {});
-			InternalGraphBackward.Add(NewSplineWrapper, { { *PrevWrapperPtr, Direction } });
-			//GraphPtr1->Add(NewSplineWrapper, {});
-			//GraphPtr2->Add(NewSplineWrapper, { { *PrevWrapperPtr, Direction } });
-			for (TTuple<FGraphNode, int32>& Tuple : Cluster)
+			const int32 NewStartEndpoint = MakeEndpoint(NewIndex, EContactType::Start);
+			AddDirectedLink(NewStartEndpoint, MakeEndpoint(PrevId.Index, Direction));
+			for (const TTuple<int32, int32>& Tuple : Cluster)
 			{
 				if ((Tuple.Value & 1) == 0)
 				{
-					InternalGraphBackward[NewSplineWrapper].Add(Tuple.Key);
-					//(*GraphPtr2)[NewSplineWrapper].Add(Tuple.Key);
+					AddDirectedLink(NewStartEndpoint, Tuple.Key);
 				}
 			}
-
-			TWeakPtr<FSplineWrapper> NewSplineWrapperWeakPtr(NewSplineWrapper);
-			auto* PrevValuePtr = GraphPtr1->Find(PrevWrapperSharedPtr);
-			(*PrevValuePtr).Add({ NewSplineWrapperWeakPtr, EContactType::Start });
-			//(*PrevValuePtr).Add({ NewSplineWrapperWeakPtr, InvDirection }); // Fixed
-
-			SplineToWrapper.Add(NewSplinePtr, NewSplineWrapperWeakPtr);
+			AddDirectedLink(MakeEndpoint(PrevId.Index, Direction), NewStartEndpoint);
 
 			return TWeakPtr<FSplineType>(NewSplinePtr);
 		}
@@ -168,27 +136,6 @@ template<int32 Dim>
 inline void TSplineGraph<Dim, 3>::VirtualConnectFromPrevEnd(TWeakPtr<FSplineType> Prev, TWeakPtr<FSplineType> Next, EContactType NextContactType)
 {
 	VirtualConnect(Prev, Next, EContactType::End, NextContactType);
-	//if (Prev.IsValid() && Next.IsValid()) 
-	//{
-	//	TWeakPtr<FSplineWrapper>* PrevWrapperPtr = SplineToWrapper.Find(Prev.Pin());
-	//	TWeakPtr<FSplineWrapper>* NextWrapperPtr = SplineToWrapper.Find(Next.Pin());
-
-	//	if (PrevWrapperPtr && NextWrapperPtr) 
-	//	{
-	//		auto* PrevValuePtr = InternalGraphForward.Find(PrevWrapperPtr->Pin());
-	//		auto* NextValuePtr = PrevValuePtr;
-	//		if (NextContactType == EContactType::Start) {
-	//			NextValuePtr = InternalGraphBackward.Find(NextWrapperPtr->Pin());
-	//		}
-	//		else {
-	//			NextValuePtr = InternalGraphForward.Find(NextWrapperPtr->Pin());
-	//		}
-	//		if (PrevValuePtr && NextValuePtr) {
-	//			(*PrevValuePtr).Add({ *NextWrapperPtr, NextContactType });
-	//			(*NextValuePtr).Add({ *PrevWrapperPtr, EContactType::End });
-	//		}
-	//	}
-	//}
 }
 
 template<int32 Dim>
@@ -196,34 +143,12 @@ inline void TSplineGraph<Dim, 3>::VirtualConnect(
 	TWeakPtr<FSplineType> Prev, TWeakPtr<FSplineType> Next, 
 	EContactType PrevContactType, EContactType NextContactType)
 {
-	if (Prev.IsValid() && Next.IsValid())
+	FSplineId PrevId = GetSplineId(Prev);
+	FSplineId NextId = GetSplineId(Next);
+	if (PrevId.IsValid() && NextId.IsValid())
 	{
-		TWeakPtr<FSplineWrapper>* PrevWrapperPtr = SplineToWrapper.Find(Prev.Pin());
-		TWeakPtr<FSplineWrapper>* NextWrapperPtr = SplineToWrapper.Find(Next.Pin());
-
-		if (PrevWrapperPtr && NextWrapperPtr)
-		{
-			TSet<FGraphNode>* PrevValuePtr = nullptr;
-			if (PrevContactType == EContactType::Start) {
-				PrevValuePtr = InternalGraphBackward.Find(PrevWrapperPtr->Pin());
-			}
-			else {
-				PrevValuePtr = InternalGraphForward.Find(PrevWrapperPtr->Pin());
-			}
-				
-			TSet<FGraphNode>* NextValuePtr = nullptr;
-			if (NextContactType == EContactType::Start) {
-				NextValuePtr = InternalGraphBackward.Find(NextWrapperPtr->Pin());
-			}
-			else {
-				NextValuePtr = InternalGraphForward.Find(NextWrapperPtr->Pin());
-			}
-
-			if (PrevValuePtr && NextValuePtr) {
-				(*PrevValuePtr).Add({ *NextWrapperPtr, NextContactType });
-				(*NextValuePtr).Add({ *PrevWrapperPtr, PrevContactType });
-			}
-		}
+		AddDirectedLink(MakeEndpoint(PrevId.Index, PrevContactType), MakeEndpoint(NextId.Index, NextContactType));
+		AddDirectedLink(MakeEndpoint(NextId.Index, NextContactType), MakeEndpoint(PrevId.Index, PrevContactType));
 	}
 }
 
@@ -257,6 +182,14 @@ inline TWeakPtr<typename TSplineGraph<Dim, 3>::FSplineType> TSplineGraph<Dim, 3>
 		return nullptr;
 	}
 
+	for (const FSplineId& Id : { GetSplineId(SourceSpline), GetSplineId(TargetSpline) })
+	{
+		if (Id.IsValid())
+		{
+			RecordTouch(Id.Index);
+		}
+	}
+
 	TVectorX<Dim> FirstPos, SecondPos;
 	TargetSpline->ProcessBeforeCreateSameType(NewTarControlPointStructsPtr);
 	switch (TargetSpline->GetType())
@@ -359,57 +292,23 @@ inline TWeakPtr<typename TSplineGraph<Dim, 3>::FSplineType> TSplineGraph<Dim, 3>
 template<int32 Dim>
 inline void TSplineGraph<Dim, 3>::SplitConnection(TWeakPtr<FSplineType> Prev, TWeakPtr<FSplineType> Next, EContactType NextContactType)
 {
-	if (Prev.IsValid() && Next.IsValid()) 
+	FSplineId PrevId = GetSplineId(Prev);
+	FSplineId NextId = GetSplineId(Next);
+	if (PrevId.IsValid() && NextId.IsValid())
 	{
-		TWeakPtr<FSplineWrapper>* PrevWrapperPtr = SplineToWrapper.Find(Prev.Pin());
-		TWeakPtr<FSplineWrapper>* NextWrapperPtr = SplineToWrapper.Find(Next.Pin());
-
-		if (PrevWrapperPtr && NextWrapperPtr)
-		{
-			auto PrevWrapperSP = PrevWrapperPtr->Pin();
-			auto* PrevFwdValuePtr = InternalGraphForward.Find(PrevWrapperSP);
-			auto* PrevBwdValuePtr = InternalGraphBackward.Find(PrevWrapperSP);
-			//auto* NextFwdValuePtr = InternalGraphForward.Find(NextWrapperPtr->Pin());
-			//auto* NextBwdValuePtr = InternalGraphBackward.Find(NextWrapperPtr->Pin());
-			auto* NextValuePtr = PrevFwdValuePtr;
-			if (NextContactType == EContactType::Start) {
-				NextValuePtr = InternalGraphBackward.Find(NextWrapperPtr->Pin());
-			}
-			else {
-				NextValuePtr = InternalGraphForward.Find(NextWrapperPtr->Pin());
-			}
-			if (PrevFwdValuePtr && PrevBwdValuePtr
-				//&& NextFwdValuePtr && NextBwdValuePtr
-				&& NextValuePtr) {
-				const FGraphNode* Node = FindGraphNodeBySplinePtrInSet(*PrevFwdValuePtr, Next);
-				if (Node && Node->ContactType == NextContactType) {
-					(*PrevFwdValuePtr).Remove(*Node);
-				}
-				Node = FindGraphNodeBySplinePtrInSet(*PrevBwdValuePtr, Next);
-				if (Node && Node->ContactType == NextContactType) {
-					(*PrevBwdValuePtr).Remove(*Node);
-				}
-				Node = FindGraphNodeBySplinePtrInSet(*NextValuePtr, Prev);
-				if (Node) {
-					(*NextValuePtr).Remove(*Node);
-				}
-			}
-		}
+		RemoveDirectedLinksToSpline(MakeEndpoint(PrevId.Index, EContactType::End), NextId.Index, NextContactType);
+		RemoveDirectedLinksToSpline(MakeEndpoint(PrevId.Index, EContactType::Start), NextId.Index, NextContactType);
+		RemoveDirectedLinksToSpline(MakeEndpoint(NextId.Index, NextContactType), PrevId.Index);
 	}
 }
 
 template<int32 Dim>
 inline bool TSplineGraph<Dim, 3>::DeleteSpline(TWeakPtr<FSplineType> Spline)
 {
-	if (Spline.IsValid())
+	FSplineId Id = GetSplineId(Spline);
+	if (Id.IsValid())
 	{
-		TSharedPtr<FSplineType> SplineSharedPtr = Spline.Pin();
-		TWeakPtr<FSplineWrapper>* SplineWrapper = SplineToWrapper.Find(SplineSharedPtr);
-
-		if (SplineWrapper)
-		{
-			UpdateDeleted(*SplineWrapper);
-		}
+		UpdateDeleted(Id.Index);
 	}
 	return false;
 }
@@ -444,11 +343,17 @@ inline void TSplineGraph<Dim, 3>::AdjustCtrlPointPos(FControlPointType& PointStr
 			{ EContactType::Start, Spline.GetTangent(GetEndParam(ParamRange, EContactType::Start)) },
 			{ EContactType::End, Spline.GetTangent(GetEndParam(ParamRange, EContactType::End)) },
 		};
+		const FSplineId Id = GetSplineId(SplinePtr.Get());
+		const bool bTouched = Id.IsValid() && RecordTouch(Id.Index);
 		if (Spline.AdjustCtrlPointPos(PointStructToAdjust, To, TangentFlag, NthPointOfFrom))
 		{
-			AdjustAuxiliaryFunc(SplinePtr, ParamRange, InitialPos, InitialTangent, MoveLevel, NthPointOfFrom);
+			AdjustOrRecordAuxiliary(SplinePtr, ParamRange, InitialPos, InitialTangent, MoveLevel, NthPointOfFrom);
 			return true;
 		}
+		if (bTouched)
+		{
+			DiscardTouch(Id.Index);
+		}
 		return false;
 	};
 
@@ -498,11 +403,17 @@ inline void TSplineGraph<Dim, 3>::AdjustCtrlPointPos(
 			{ EContactType::Start, Spline.GetTangent(GetEndParam(ParamRange, EContactType::Start)) },
 			{ EContactType::End, Spline.GetTangent(GetEndParam(ParamRange, EContactType::End)) },
 		};
+		const FSplineId Id = GetSplineId(SplinePtr.Get());
+		const bool bTouched = Id.IsValid() && RecordTouch(Id.Index);
 		if (Spline.AdjustCtrlPointPos(From, To, TangentFlag, NthPointOfFrom, ToleranceSqr))
 		{
-			AdjustAuxiliaryFunc(SplinePtr, ParamRange, InitialPos, InitialTangent, MoveLevel, NthPointOfFrom);
+			AdjustOrRecordAuxiliary(SplinePtr, ParamRange, InitialPos, InitialTangent, MoveLevel, NthPointOfFrom);
 			return true;
 		}
+		if (bTouched)
+		{
+			DiscardTouch(Id.Index);
+		}
 		return false;
 	};
 
@@ -534,65 +445,73 @@ inline void TSplineGraph<Dim, 3>::AdjustCtrlPointPos(
 
 
 template<int32 Dim>
-inline void TSplineGraph<Dim, 3>::GetClusterWithoutSelf(TSet<TTuple<FGraphNode, int32> >& Cluster, const TSharedPtr<FSplineType>& SplinePtr, EContactType Direction)
+inline void TSplineGraph<Dim, 3>::GetClusterWithoutSelf(TSet<TTuple<FGraphNode, int32> >& Cluster, const TSharedPtr<FSplineType>& SplinePtr, EContactType Direction, int32 MaxDistance)
 {
-	TWeakPtr<FSplineWrapper>* SplineWrapperPtr = SplineToWrapper.Find(SplinePtr);
-	if (!SplineWrapperPtr) {
-		return;
+	GetClusterWithoutSelf(ClusterScratch, GetSplineId(SplinePtr.Get()), Direction, MaxDistance);
+	Cluster.Empty(ClusterScratch.Num());
+	for (const TTuple<int32, int32>& Tuple : ClusterScratch) {
+		Cluster.Add(MakeTuple(MakeGraphNode(Tuple.Key), Tuple.Value));
 	}
-	TSharedPtr<FSplineWrapper> SplineWrapperSharedPtr = SplineWrapperPtr->Pin();
-	TSet<FGraphNode>* JunctionToVisitNow = (Direction == EContactType::Start) ? InternalGraphBackward.Find(SplineWrapperSharedPtr) : InternalGraphForward.Find(SplineWrapperSharedPtr);
-	if (!JunctionToVisitNow) {
+}
+
+template<int32 Dim>
+inline void TSplineGraph<Dim, 3>::GetClusterWithoutSelf(TArray<TTuple<int32, int32> >& OutEndpointsWithDistance, const FSplineId& Id, EContactType Direction, int32 MaxDistance) const
+{
+	OutEndpointsWithDistance.Reset();
+	if (!IsValidId(Id) || MaxDistance == 0) {
 		return;
 	}
+	if (bAdjacencyDirty) {
+		RebuildAdjacency();
+	}
 
-	TSet<TSet<FGraphNode>*> VisitedJunctions;
-	TSet<FGraphNode*> VisitedNodes;
-	TQueue<TTuple<TSet<FGraphNode>*, int32> > JunctionQueue;
-	VisitedJunctions.Add(JunctionToVisitNow);
-	JunctionQueue.Enqueue(MakeTuple(JunctionToVisitNow, 1));
-
-	Cluster.Empty(InternalGraphForward.Num());
-	//int32 CurNum = Cluster.Num();
-	//int32 PrevNum = -1;
-	
-	TTuple<TSet<FGraphNode>*, int32> VisitTuple;
+	// Visit the endpoints (junctions) breadth first. An endpoint is reported when it is reached first,
+	// and the output itself is the queue.
+	const uint32 Epoch = BeginVisit();
+	const int32 SourceEndpoint = MakeEndpoint(Id.Index, Direction);
+	EndpointVisitEpochs[SourceEndpoint] = Epoch;
 
-	while (JunctionQueue.Dequeue(VisitTuple)) {
-		JunctionToVisitNow = VisitTuple.Key;
-		int32 Distance = VisitTuple.Value;
-		if (!JunctionToVisitNow) {
-			continue;
+	auto VisitAdjacentEndpoints = [this, &OutEndpointsWithDistance, &Id, Epoch](int32 Endpoint, int32 Distance) {
+		for (int32 NextEndpoint : GetAdjacentEndpoints(Endpoint)) {
+			if (GetEndpointSplineIndex(NextEndpoint) == Id.Index || EndpointVisitEpochs[NextEndpoint] == Epoch) {
+				continue;
+			}
+			EndpointVisitEpochs[NextEndpoint] = Epoch;
+			OutEndpointsWithDistance.Add(MakeTuple(NextEndpoint, Distance));
 		}
-		for (FGraphNode& Node : (*JunctionToVisitNow)) {
-			if (Node.SplineWrapper.IsValid()) {
-				TSharedPtr<FSplineWrapper> CurSplnieWrapperPtr = Node.SplineWrapper.Pin();
-				if (CurSplnieWrapperPtr->Spline != SplinePtr) {
-					TSet<FGraphNode>* JunctionToVisitSoon = Node.ContactType == EContactType::Start ? InternalGraphBackward.Find(CurSplnieWrapperPtr) : InternalGraphForward.Find(CurSplnieWrapperPtr);
-					if (VisitedJunctions.Contains(JunctionToVisitSoon)) {
-						continue;
-					}
-					VisitedJunctions.Add(JunctionToVisitSoon);
-					JunctionQueue.Enqueue(MakeTuple(JunctionToVisitSoon, Distance + 1));
-
-					if (VisitedNodes.Contains(&Node)) {
-						continue;
-					}
+	};
 
-					Cluster.Add(MakeTuple(Node, Distance));
-					VisitedNodes.Add(&Node);
-				}
-			}
+	VisitAdjacentEndpoints(SourceEndpoint, 1);
+	for (int32 Head = 0; Head < OutEndpointsWithDistance.Num(); ++Head) {
+		const int32 Distance = OutEndpointsWithDistance[Head].Value + 1;
+		if (MaxDistance >= 0 && Distance > MaxDistance) {
+			break;
 		}
+		VisitAdjacentEndpoints(OutEndpointsWithDistance[Head].Key, Distance);
 	}
 }
 
+template<int32 Dim>
+inline uint32 TSplineGraph<Dim, 3>::BeginVisit() const
+{
+	if (EndpointVisitEpochs.Num() < EndpointLinks.Num()) {
+		EndpointVisitEpochs.SetNumZeroed(EndpointLinks.Num());
+	}
+	if (++VisitEpoch == 0) {
+		FMemory::Memzero(EndpointVisitEpochs.GetData(), EndpointVisitEpochs.Num() * sizeof(uint32));
+		VisitEpoch = 1;
+	}
+	return VisitEpoch;
+}
+
 template<int32 Dim>
 inline void TSplineGraph<Dim, 3>::GetSplines(TArray<TWeakPtr<FSplineType> >& Splines) const
 {
-	Splines.Empty(InternalGraphForward.Num());
-	for (const auto& Pair : InternalGraphForward) {
-		Splines.Add(TWeakPtr<FSplineType>(Pair.Key->Spline));
+	Splines.Empty(SplineToIndex.Num());
+	for (const FSplineSlot& Slot : SplineSlots) {
+		if (Slot.Wrapper.IsValid()) {
+			Splines.Add(TWeakPtr<FSplineType>(Slot.Wrapper->Spline));
+		}
 	}
 }
 
@@ -602,45 +521,50 @@ inline void TSplineGraph<Dim, 3>::ReverseSpline(TWeakPtr<FSplineType> SplinePtrT
 	if (SplinePtrToReverse.IsValid()) 
 	{
 		TSharedPtr<FSplineType> SplineSharedPtr = SplinePtrToReverse.Pin();
+		FSplineId Id = GetSplineId(SplineSharedPtr.Get());
+		if (Id.IsValid())
+		{
+			RecordTouch(Id.Index);
+		}
 		SplineSharedPtr->Reverse();
 
-		TWeakPtr<FSplineWrapper>* SplineWrapperWeakPtrPtr = SplineToWrapper.Find(SplineSharedPtr);
-		if (SplineWrapperWeakPtrPtr)
+		if (Id.IsValid())
 		{
-			TSharedPtr<FSplineWrapper> SplineWrapperSharedPtr = SplineWrapperWeakPtrPtr->Pin();
-			auto* NextValuePtr = InternalGraphForward.Find(SplineWrapperSharedPtr);
-			auto* PrevValuePtr = InternalGraphBackward.Find(SplineWrapperSharedPtr);
-			if (NextValuePtr && PrevValuePtr)
-			{
-				//TSet<FGraphNode> TempNode = *NextValuePtr;
-				//*NextValuePtr = *PrevValuePtr;
-				//*PrevValuePtr = TempNode;
-				Swap(*NextValuePtr, *PrevValuePtr);
-			}
+			ReverseLinks(Id.Index, Id.Generation);
+		}
+	}
+}
 
-			for (auto& Pair : InternalGraphForward)
-			{
-				for (auto& Node : Pair.Value)
-				{
-					if (Node.SplineWrapper == SplineWrapperSharedPtr) 
-					{
-						Node.ContactType = (Node.ContactType == EContactType::Start) ? EContactType::End : EContactType::Start;
-					}
-				}
-			}
+template<int32 Dim>
+inline void TSplineGraph<Dim, 3>::ReverseLinks(int32 SplineIndex, uint32 Generation)
+{
+	Swap(EndpointLinks[MakeEndpoint(SplineIndex, EContactType::Start)], EndpointLinks[MakeEndpoint(SplineIndex, EContactType::End)]);
 
-			for (auto& Pair : InternalGraphBackward)
+	// Links to the spline may be one-way, so check all of them.
+	// The flipped links are recorded, so the journal replays only them.
+	const bool bRecording = IsJournalRecording();
+	TArray<TTuple<int32, int32> > FlippedLinks;
+	for (int32 FromEndpoint = 0; FromEndpoint < EndpointLinks.Num(); ++FromEndpoint)
+	{
+		auto& Links = EndpointLinks[FromEndpoint];
+		for (int32 i = 0; i < Links.Num(); ++i)
+		{
+			FEndpointLink& Link = Links[i];
+			if (GetEndpointSplineIndex(Link.Endpoint) == SplineIndex && Link.Generation == Generation)
 			{
-				for (auto& Node : Pair.Value)
+				Link.Endpoint ^= 1;
+				if (bRecording)
 				{
-					if (Node.SplineWrapper == SplineWrapperSharedPtr)
-					{
-						Node.ContactType = (Node.ContactType == EContactType::Start) ? EContactType::End : EContactType::Start;
-					}
+					FlippedLinks.Add(MakeTuple(FromEndpoint, i));
 				}
 			}
 		}
 	}
+	if (bRecording)
+	{
+		Journal->RecordReverseLinks(SplineIndex, Generation, MoveTemp(FlippedLinks));
+	}
+	MarkTopologyChanged();
 }
 
 template<int32 Dim>
@@ -648,58 +572,163 @@ inline bool TSplineGraph<Dim, 3>::HasConnection(
 	TWeakPtr<FSplineType> SplinePtr, EContactType Direction,
 	TArray<FGraphNode>* ConnectedSplineNodes) const
 {
-	if (SplinePtr.IsValid()) 
+	FSplineId Id = GetSplineId(SplinePtr);
+	if (ConnectedSplineNodes)
 	{
-		const TWeakPtr<FSplineWrapper>* WrapperWeakPtrPtr = SplineToWrapper.Find(SplinePtr.Pin());
-		if (WrapperWeakPtrPtr)
+		ConnectedSplineNodes->Reset();
+		if (Id.IsValid())
 		{
-			TSharedPtr<FSplineWrapper> WrapperSharedPtr = WrapperWeakPtrPtr->Pin();
-			switch (Direction)
-			{
-			case EContactType::Start:
+			for (const FEndpointLink& Link : EndpointLinks[MakeEndpoint(Id.Index, Direction)])
 			{
-				auto* ConnectionSetPtr = InternalGraphBackward.Find(WrapperSharedPtr);
-				if (ConnectionSetPtr)
+				if (IsLinkAlive(Link))
 				{
-					if (ConnectedSplineNodes)
-					{
-						ConnectedSplineNodes->Empty(ConnectionSetPtr->Num());
-						for (const FGraphNode& Node : *ConnectionSetPtr)
-						{
-							ConnectedSplineNodes->Add(Node);
-						}
-					}
-					return ConnectionSetPtr->Num() > 0;
-				}
-			}
-			break;
-			case EContactType::End:
-			{
-				auto* ConnectionSetPtr = InternalGraphForward.Find(WrapperSharedPtr);
-				if (ConnectionSetPtr)
-				{
-					if (ConnectedSplineNodes)
-					{
-						ConnectedSplineNodes->Empty(ConnectionSetPtr->Num());
-						for (const FGraphNode& Node : *ConnectionSetPtr)
-						{
-							ConnectedSplineNodes->Add(Node);
-						}
-					}
-					return ConnectionSetPtr->Num() > 0;
+					ConnectedSplineNodes->Add(MakeGraphNode(Link.Endpoint));
 				}
 			}
-			break;
-			}
 		}
+		return ConnectedSplineNodes->Num() > 0;
 	}
-	if (ConnectedSplineNodes)
+	return HasConnection(Id, Direction);
+}
+
+template<int32 Dim>
+inline bool TSplineGraph<Dim, 3>::HasConnection(const FSplineId& Id, EContactType Direction) const
+{
+	if (!IsValidId(Id))
 	{
-		ConnectedSplineNodes->Empty();
+		return false;
+	}
+	for (const FEndpointLink& Link : EndpointLinks[MakeEndpoint(Id.Index, Direction)])
+	{
+		if (IsLinkAlive(Link))
+		{
+			return true;
+		}
 	}
 	return false;
 }
 
+template<int32 Dim>
+inline typename TSplineGraph<Dim, 3>::FSplineId TSplineGraph<Dim, 3>::GetSplineId(const FSplineType* Spline) const
+{
+	const int32* IndexPtr = SplineToIndex.Find(Spline);
+	if (!IndexPtr) {
+		return FSplineId();
+	}
+	return FSplineId{ *IndexPtr, SplineSlots[*IndexPtr].Generation };
+}
+
+template<int32 Dim>
+inline TArrayView<const int32> TSplineGraph<Dim, 3>::GetAdjacentEndpoints(int32 Endpoint) const
+{
+	if (bAdjacencyDirty) {
+		RebuildAdjacency();
+	}
+	if (Endpoint < 0 || Endpoint + 1 >= AdjacencyOffsets.Num()) {
+		return TArrayView<const int32>();
+	}
+	return TArrayView<const int32>(AdjacencyEndpoints.GetData() + AdjacencyOffsets[Endpoint], AdjacencyOffsets[Endpoint + 1] - AdjacencyOffsets[Endpoint]);
+}
+
+template<int32 Dim>
+inline int32 TSplineGraph<Dim, 3>::AddSplineSlot(TSharedPtr<FSplineWrapper> Wrapper)
+{
+	int32 SplineIndex = INDEX_NONE;
+	if (FreeSplineIndices.Num() > 0) {
+		SplineIndex = FreeSplineIndices.Pop(false);
+	}
+	else {
+		SplineIndex = SplineSlots.AddDefaulted();
+		EndpointLinks.AddDefaulted(2);
+	}
+	SplineSlots[SplineIndex].Wrapper = Wrapper;
+	SplineToIndex.Add(Wrapper->Spline.Get(), SplineIndex);
+	MarkTopologyChanged();
+	if (IsJournalRecording())
+	{
+		Journal->RecordSlot(true, SplineIndex);
+		Journal->TouchSplineIndex(SplineIndex);
+	}
+	return SplineIndex;
+}
+
+template<int32 Dim>
+inline void TSplineGraph<Dim, 3>::AddDirectedLink(int32 FromEndpoint, int32 ToEndpoint)
+{
+	const int32 ToSplineIndex = GetEndpointSplineIndex(ToEndpoint);
+	const uint32 ToGeneration = SplineSlots[ToSplineIndex].Generation;
+	auto& Links = EndpointLinks[FromEndpoint];
+	for (int32 i = 0; i < Links.Num(); ++i) {
+		FEndpointLink& Link = Links[i];
+		if (GetEndpointSplineIndex(Link.Endpoint) == ToSplineIndex && Link.Generation == ToGeneration) {
+			const int32 OldEndpoint = Link.Endpoint;
+			Link.Endpoint = ToEndpoint;
+			if (IsJournalRecording()) {
+				Journal->RecordLinkReplace(FromEndpoint, i, OldEndpoint);
+			}
+			MarkTopologyChanged();
+			return;
+		}
+	}
+	Links.Add(FEndpointLink{ ToEndpoint, ToGeneration });
+	if (IsJournalRecording()) {
+		Journal->RecordLinkInsert(FromEndpoint, Links.Num() - 1);
+	}
+	MarkTopologyChanged();
+}
+
+template<int32 Dim>
+inline void TSplineGraph<Dim, 3>::RemoveDirectedLinksToSpline(int32 FromEndpoint, int32 ToSplineIndex, TOptional<EContactType> ToContactType)
+{
+	auto& Links = EndpointLinks[FromEndpoint];
+	const bool bRecording = IsJournalRecording();
+	int32 RemovedNum = 0;
+	// Backward, so the journal can insert them back in the reversed order.
+	for (int32 i = Links.Num() - 1; i >= 0; --i) {
+		const FEndpointLink& Link = Links[i];
+		if (GetEndpointSplineIndex(Link.Endpoint) == ToSplineIndex
+			&& Link.Generation == SplineSlots[ToSplineIndex].Generation
+			&& (!ToContactType || GetEndpointContactType(Link.Endpoint) == ToContactType.GetValue())) {
+			if (bRecording) {
+				Journal->RecordLinkRemove(FromEndpoint, i);
+			}
+			Links.RemoveAt(i, 1, false);
+			++RemovedNum;
+		}
+	}
+	if (RemovedNum > 0) {
+		MarkTopologyChanged();
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraph<Dim, 3>::MarkTopologyChanged()
+{
+	bAdjacencyDirty = true;
+	++TopologyGeneration;
+}
+
+template<int32 Dim>
+inline void TSplineGraph<Dim, 3>::RebuildAdjacency() const
+{
+	const int32 EndpointNum = EndpointLinks.Num();
+	AdjacencyOffsets.SetNumUninitialized(EndpointNum + 1);
+	AdjacencyEndpoints.Reset();
+	for (int32 Endpoint = 0; Endpoint < EndpointNum; ++Endpoint) {
+		AdjacencyOffsets[Endpoint] = AdjacencyEndpoints.Num();
+		if (!SplineSlots[GetEndpointSplineIndex(Endpoint)].Wrapper.IsValid()) {
+			continue;
+		}
+		for (const FEndpointLink& Link : EndpointLinks[Endpoint]) {
+			if (IsLinkAlive(Link)) {
+				AdjacencyEndpoints.Add(Link.Endpoint);
+			}
+		}
+	}
+	AdjacencyOffsets[EndpointNum] = AdjacencyEndpoints.Num();
+	bAdjacencyDirty = false;
+}
+
 template<int32 Dim>
 inline void TSplineGraph<Dim, 3>::ChangeSplineType(TWeakPtr<FSplineType>& SplinePtr, ESplineType NewType)
 {
@@ -708,10 +737,11 @@ inline void TSplineGraph<Dim, 3>::ChangeSplineType(TWeakPtr<FSplineType>& Spline
 		TSharedPtr<FSplineType> SplineSharedPtr = SplinePtr.Pin();
 		if (NewType != SplineSharedPtr->GetType()) 
 		{
-			TWeakPtr<FSplineWrapper>* WrapperWeakPtrPtr = SplineToWrapper.Find(SplineSharedPtr);
-			if (WrapperWeakPtrPtr)
+			FSplineId Id = GetSplineId(SplineSharedPtr.Get());
+			TSharedPtr<FSplineWrapper> WrapperSharedPtr = GetSplineWrapperById(Id);
+			if (WrapperSharedPtr)
 			{
-				TSharedPtr<FSplineWrapper> WrapperSharedPtr = WrapperWeakPtrPtr->Pin();
+				RecordTouch(Id.Index);
 				switch (SplineSharedPtr->GetType())
 				{
 				case ESplineType::BezierString:
@@ -728,86 +758,388 @@ inline void TSplineGraph<Dim, 3>::ChangeSplineType(TWeakPtr<FSplineType>& Spline
 }
 
 template<int32 Dim>
-inline const typename TSplineGraph<Dim, 3>::FGraphNode* TSplineGraph<Dim, 3>::FindGraphNodeBySplinePtrInSet(const TSet<FGraphNode>& AdjSet, TWeakPtr<FSplineType> Spline) const
+inline bool TSplineGraph<Dim, 3>::RemakeC2(const TArray<TSharedPtr<FSplineType> >& SplineChain, bool bClosed)
 {
-	if (Spline.IsValid()) {
-		TSharedPtr<FSplineType> SplineShared = Spline.Pin();
-		for (const FGraphNode& Node : AdjSet) {
-			if (Node.SplineWrapper.Pin()->Spline == SplineShared) {
-				return &Node;
+	using FBezierStringType = typename TSplineTraitByType<ESplineType::BezierString, Dim, 3>::FSplineType;
+	if (SplineChain.Num() == 0) {
+		return false;
+	}
+	for (const TSharedPtr<FSplineType>& Spline : SplineChain) {
+		if (!Spline.IsValid() || Spline->GetType() != ESplineType::BezierString) {
+			return false;
+		}
+	}
+	for (const TSharedPtr<FSplineType>& Spline : SplineChain) {
+		FSplineId Id = GetSplineId(Spline.Get());
+		if (Id.IsValid()) {
+			RecordTouch(Id.Index);
+		}
+	}
+	if (SplineChain.Num() == 1) {
+		static_cast<FBezierStringType*>(SplineChain[0].Get())->RemakeC2(bClosed);
+		return true;
+	}
+
+	// Joint points shared by adjacent splines are interpolated only once.
+	TArray<TVectorX<Dim+1> > ChainPoints;
+	TArray<TTuple<int32, int32> > FirstIndexAndNum;
+	FirstIndexAndNum.Reserve(SplineChain.Num());
+	for (const TSharedPtr<FSplineType>& Spline : SplineChain) {
+		TArray<TVectorX<Dim+1> > Points;
+		static_cast<FBezierStringType*>(Spline.Get())->GetCtrlPoints(Points);
+		int32 StartIndex = 0;
+		if (ChainPoints.Num() > 0 && Points.Num() > 0 && TVecLib<Dim+1>::IsNearlyZero(ChainPoints.Last() - Points[0])) {
+			StartIndex = 1;
+		}
+		FirstIndexAndNum.Add(MakeTuple(ChainPoints.Num() - StartIndex, Points.Num()));
+		for (int32 i = StartIndex; i < Points.Num(); ++i) {
+			ChainPoints.Add(Points[i]);
+		}
+	}
+
+	TArray<TBezierCurve<Dim, 3> > Beziers;
+	if (bClosed) {
+		if (ChainPoints.Num() > 1 && TVecLib<Dim+1>::IsNearlyZero(ChainPoints.Last() - ChainPoints[0])) {
+			ChainPoints.Pop(false);
+		}
+		TBezierOperationsDegree3<Dim>::InterpolationC2Closed(Beziers, ChainPoints);
+	}
+	else {
+		TBezierOperationsDegree3<Dim>::InterpolationC2WithBorder2ndDerivative(Beziers, ChainPoints);
+	}
+	if (Beziers.Num() == 0) {
+		return false;
+	}
+
+	// The curve between two unshared end points is skipped.
+	for (int32 s = 0; s < SplineChain.Num(); ++s) {
+		int32 FirstIndex = FirstIndexAndNum[s].Get<0>();
+		int32 PointNum = FirstIndexAndNum[s].Get<1>();
+		if (PointNum < 2) {
+			continue;
+		}
+		TArray<TBezierCurve<Dim, 3> > SubBeziers;
+		SubBeziers.Reserve(PointNum - 1);
+		for (int32 i = 0; i < PointNum - 1; ++i) {
+			SubBeziers.Add(Beziers[(FirstIndex + i) % Beziers.Num()]);
+		}
+		static_cast<FBezierStringType*>(SplineChain[s].Get())->FromCurveArray(SubBeziers);
+	}
+	return true;
+}
+
+template<int32 Dim>
+inline bool TSplineGraph<Dim, 3>::BuildFromArrays(TArray<FSplineId>& OutIds, const FBuildArrays& Arrays)
+{
+	using FBezierStringType = typename TSplineTraitByType<ESplineType::BezierString, Dim, 3>::FSplineType;
+	using FBSplineType = typename TSplineTraitByType<ESplineType::ClampedBSpline, Dim, 3>::FSplineType;
+	OutIds.Reset();
+	const int32 SplineNum = Arrays.Types.Num();
+	if (Arrays.PointOffsets.Num() != SplineNum + 1 || (SplineNum > 0 && Arrays.PointOffsets[0] < 0)) {
+		return false;
+	}
+	for (int32 s = 0; s < SplineNum; ++s) {
+		if (Arrays.PointOffsets[s] > Arrays.PointOffsets[s + 1]
+			|| (Arrays.Types[s] != ESplineType::BezierString && Arrays.Types[s] != ESplineType::ClampedBSpline)) {
+			return false;
+		}
+	}
+	if (Arrays.PointOffsets.Last() > Arrays.Points.Num()) {
+		return false;
+	}
+	const bool bHasHandles = Arrays.PrevPoints.Num() > 0 || Arrays.NextPoints.Num() > 0;
+	if (bHasHandles && (Arrays.PrevPoints.Num() != Arrays.Points.Num() || Arrays.NextPoints.Num() != Arrays.Points.Num())) {
+		return false;
+	}
+	for (const TTuple<int32, int32>& Connection : Arrays.Connections) {
+		if (Connection.Key < 0 || Connection.Value < 0 || Connection.Key >= SplineNum * 2 || Connection.Value >= SplineNum * 2) {
+			return false;
+		}
+	}
+
+	// Each task only touches its own spline.
+	TArray<TSharedPtr<FSplineType> > NewSplines;
+	NewSplines.SetNum(SplineNum);
+	ParallelFor(SplineNum, [&Arrays, &NewSplines, bHasHandles](int32 s) {
+		const int32 First = Arrays.PointOffsets[s];
+		const int32 PointNum = Arrays.PointOffsets[s + 1] - First;
+		TArray<TVectorX<Dim+1> > Pos;
+		Pos.Reserve(PointNum);
+		for (int32 i = 0; i < PointNum; ++i) {
+			Pos.Add(TVecLib<Dim>::Homogeneous(Arrays.Points[First + i], 1.));
+		}
+		switch (Arrays.Types[s]) {
+		case ESplineType::ClampedBSpline:
+		{
+			// Same as adding the points one by one.
+			const int32 KnotNum = PointNum == 0 ? 0 : (PointNum == 1 ? 1 : FMath::Max(PointNum - 3, 1) + 1);
+			TArray<double> KnotIntervals;
+			KnotIntervals.Reserve(KnotNum);
+			for (int32 k = 0; k < KnotNum; ++k) {
+				KnotIntervals.Add(static_cast<double>(k));
+			}
+			FBSplineType* BSpline = new FBSplineType();
+			BSpline->Reset(Pos, KnotIntervals);
+			NewSplines[s] = MakeShareable(BSpline);
+		}
+		break;
+		case ESplineType::BezierString:
+		{
+			FBezierStringType* BezierString = new FBezierStringType();
+			if (bHasHandles) {
+				TArray<TVectorX<Dim+1> > Prev, Next;
+				TArray<double> Params;
+				TArray<EEndPointContinuity> Continuities;
+				Prev.Reserve(PointNum);
+				Next.Reserve(PointNum);
+				Params.Reserve(PointNum);
+				Continuities.Init(EEndPointContinuity::G1, PointNum);
+				for (int32 i = 0; i < PointNum; ++i) {
+					Prev.Add(TVecLib<Dim>::Homogeneous(Arrays.PrevPoints[First + i], 1.));
+					Next.Add(TVecLib<Dim>::Homogeneous(Arrays.NextPoints[First + i], 1.));
+					Params.Add(static_cast<double>(i));
+				}
+				BezierString->Reset(Pos, Prev, Next, Params, Continuities);
 			}
+			else if (PointNum > 1) {
+				TArray<TBezierCurve<Dim, 3> > Beziers;
+				TBezierOperationsDegree3<Dim>::InterpolationC2WithBorder2ndDerivative(Beziers, Pos);
+				BezierString->FromCurveArray(Beziers);
+			}
+			else if (PointNum == 1) {
+				BezierString->AddPointAtLast(Arrays.Points[First]);
+			}
+			NewSplines[s] = MakeShareable(BezierString);
+		}
+		break;
 		}
+	}, SplineNum < 2);
+
+	SplineSlots.Reserve(SplineSlots.Num() + SplineNum);
+	EndpointLinks.Reserve(EndpointLinks.Num() + SplineNum * 2);
+	SplineToIndex.Reserve(SplineToIndex.Num() + SplineNum);
+	OutIds.Reserve(SplineNum);
+	for (int32 s = 0; s < SplineNum; ++s) {
+		const int32 SplineIndex = AddSplineSlot(MakeShareable(new FSplineWrapper{ NewSplines[s] }));
+		OutIds.Add(FSplineId{ SplineIndex, SplineSlots[SplineIndex].Generation });
 	}
-	return nullptr;
+	for (const TTuple<int32, int32>& Connection : Arrays.Connections) {
+		const int32 Endpoint0 = MakeEndpoint(OutIds[GetEndpointSplineIndex(Connection.Key)].Index, GetEndpointContactType(Connection.Key));
+		const int32 Endpoint1 = MakeEndpoint(OutIds[GetEndpointSplineIndex(Connection.Value)].Index, GetEndpointContactType(Connection.Value));
+		AddDirectedLink(Endpoint0, Endpoint1);
+		AddDirectedLink(Endpoint1, Endpoint0);
+	}
+	return true;
 }
 
 template<int32 Dim>
 inline void TSplineGraph<Dim, 3>::ChangeSplineTypeFromBezierString(TSharedPtr<FSplineWrapper> WrapperSharedPtr, ESplineType NewType)
 {
-	//TODO
+	TSharedPtr<FSplineType> NewSpline = MakeSplineOfType(*WrapperSharedPtr->Spline, NewType);
+	if (NewSpline.IsValid())
+	{
+		ReplaceSpline(*WrapperSharedPtr, NewSpline);
+	}
 }
 
 template<int32 Dim>
 inline void TSplineGraph<Dim, 3>::ChangeSplineTypeFromBSpline(TSharedPtr<FSplineWrapper> WrapperSharedPtr, ESplineType NewType)
 {
-	TSharedPtr<FSplineType> SplinePtr = WrapperSharedPtr->Spline;
+	TSharedPtr<FSplineType> NewSpline = MakeSplineOfType(*WrapperSharedPtr->Spline, NewType);
+	if (NewSpline.IsValid())
+	{
+		ReplaceSpline(*WrapperSharedPtr, NewSpline);
+	}
+}
+
+template<int32 Dim>
+inline int32 TSplineGraph<Dim, 3>::ChangeSplineTypes(TArray<FSplineTypeRemap>& OutRemaps, TArrayView<const FSplineId> Ids, ESplineType NewType)
+{
+	OutRemaps.Reset();
+	if (NewType != ESplineType::BezierString && NewType != ESplineType::ClampedBSpline) {
+		return 0;
+	}
+	TSet<int32> AddedIndices;
+	AddedIndices.Reserve(Ids.Num());
+	OutRemaps.Reserve(Ids.Num());
+	for (const FSplineId& Id : Ids) {
+		if (!IsValidId(Id) || SplineSlots[Id.Index].Wrapper->Spline->GetType() == NewType) {
+			continue;
+		}
+		bool bAlreadyAdded = false;
+		AddedIndices.Add(Id.Index, &bAlreadyAdded);
+		if (!bAlreadyAdded) {
+			FSplineTypeRemap& Remap = OutRemaps.AddDefaulted_GetRef();
+			Remap.Id = Id;
+			Remap.OldSpline = SplineSlots[Id.Index].Wrapper->Spline;
+		}
+	}
+
+	// Each task only reads its old spline and writes its own remap.
+	ParallelFor(OutRemaps.Num(), [&OutRemaps, NewType](int32 i) {
+		FSplineTypeRemap& Remap = OutRemaps[i];
+		Remap.NewSpline = MakeSplineOfType(*Remap.OldSpline, NewType);
+		if (Remap.NewSpline.IsValid()) {
+			MatchCtrlPointsByPosition(Remap.NewToOldPoints, *Remap.OldSpline, *Remap.NewSpline);
+		}
+	}, OutRemaps.Num() < 2);
+
+	for (int32 i = OutRemaps.Num() - 1; i >= 0; --i) {
+		if (!OutRemaps[i].NewSpline.IsValid()) {
+			OutRemaps.RemoveAt(i, 1, false);
+		}
+	}
+	for (const FSplineTypeRemap& Remap : OutRemaps) {
+		RecordTouch(Remap.Id.Index);
+		ReplaceSpline(*SplineSlots[Remap.Id.Index].Wrapper, Remap.NewSpline);
+	}
+	return OutRemaps.Num();
+}
+
+template<int32 Dim>
+inline TSharedPtr<typename TSplineGraph<Dim, 3>::FSplineType> TSplineGraph<Dim, 3>::MakeSplineOfType(const FSplineType& Spline, ESplineType NewType)
+{
+	using FBezierStringType = typename TSplineTraitByType<ESplineType::BezierString, Dim, 3>::FSplineType;
+	using FBSplineType = typename TSplineTraitByType<ESplineType::ClampedBSpline, Dim, 3>::FSplineType;
+	if (Spline.GetType() == NewType) {
+		return Spline.Copy();
+	}
+	TArray<TBezierCurve<Dim, 3> > Beziers;
+	Spline.ToBezierCurves(Beziers);
+	// A spline with a single point has no segment.
+	TArray<TVectorX<Dim+1> > Positions;
+	if (Beziers.Num() == 0) {
+		GetCtrlPointPositions(Positions, Spline);
+	}
 	switch (NewType)
 	{
 	case ESplineType::BezierString:
 	{
-		auto* BSpline = static_cast<TClampedBSpline<Dim, 3>*>(SplinePtr.Get());
-		TArray<TBezierCurve<Dim, 3> > Beziers;
-		BSpline->ToBezierCurves(Beziers);
-		SplineToWrapper.Remove(WrapperSharedPtr->Spline);
-		WrapperSharedPtr->Spline = MakeShareable(new TBezierString3<Dim>(Beziers));
-		SplineToWrapper.Add(WrapperSharedPtr->Spline, WrapperSharedPtr);
+		FBezierStringType* BezierString = new FBezierStringType();
+		if (Beziers.Num() > 0) {
+			BezierString->FromCurveArray(Beziers);
+		}
+		else if (Positions.Num() > 0) {
+			BezierString->AddPointAtLast(TVecLib<Dim+1>::Projection(Positions[0]));
+		}
+		return MakeShareable(BezierString);
 	}
+	case ESplineType::ClampedBSpline:
+	{
+		FBSplineType* BSpline = new FBSplineType();
+		if (Beziers.Num() > 0) {
+			if (BSpline->CreateFromBezierCurves(Beziers) != Beziers.Num()) {
+				delete BSpline;
+				return nullptr;
+			}
+		}
+		else if (Positions.Num() > 0) {
+			BSpline->AddPointAtLast(TVecLib<Dim+1>::Projection(Positions[0]));
+		}
+		return MakeShareable(BSpline);
+	}
+	}
+	return nullptr;
+}
+
+template<int32 Dim>
+inline void TSplineGraph<Dim, 3>::GetCtrlPointPositions(TArray<TVectorX<Dim+1> >& OutPositions, const FSplineType& Spline)
+{
+	OutPositions.Reset();
+	switch (Spline.GetType())
+	{
+	case ESplineType::BezierString:
+		static_cast<const typename TSplineTraitByType<ESplineType::BezierString, Dim, 3>::FSplineType&>(Spline).GetCtrlPoints(OutPositions);
+		break;
+	case ESplineType::ClampedBSpline:
+		static_cast<const typename TSplineTraitByType<ESplineType::ClampedBSpline, Dim, 3>::FSplineType&>(Spline).GetCtrlPoints(OutPositions);
 		break;
 	}
 }
 
 template<int32 Dim>
-inline void TSplineGraph<Dim, 3>::UpdateDeleted(TWeakPtr<FSplineWrapper> SplineWrapperToDelete)
+inline void TSplineGraph<Dim, 3>::MatchCtrlPointsByPosition(TArray<int32>& OutNewToOld, const FSplineType& OldSpline, const FSplineType& NewSpline)
+{
+	TArray<TVectorX<Dim+1> > OldPositions, NewPositions;
+	GetCtrlPointPositions(OldPositions, OldSpline);
+	GetCtrlPointPositions(NewPositions, NewSpline);
+	OutNewToOld.Init(INDEX_NONE, NewPositions.Num());
+
+	auto IsSamePosition = [&OldPositions, &NewPositions](int32 NewIndex, int32 OldIndex) {
+		return TVecLib<Dim>::IsNearlyZero(TVecLib<Dim+1>::Projection(OldPositions[OldIndex]) - TVecLib<Dim+1>::Projection(NewPositions[NewIndex]), KINDA_SMALL_NUMBER);
+	};
+
+	// The matched points are in the same order and not far from each other (at most a segment),
+	// so search a few points forward from the last match.
+	int32 OldIndex = 0;
+	for (int32 i = 0; i < NewPositions.Num() && OldIndex < OldPositions.Num(); ++i) {
+		const int32 SearchEnd = FMath::Min(OldIndex + 4, OldPositions.Num());
+		for (int32 j = OldIndex; j < SearchEnd; ++j) {
+			if (IsSamePosition(i, j)) {
+				OutNewToOld[i] = j;
+				OldIndex = j + 1;
+				break;
+			}
+		}
+	}
+	// Both ends are clamped.
+	if (NewPositions.Num() > 0 && OutNewToOld.Last() == INDEX_NONE && OldIndex < OldPositions.Num()
+		&& IsSamePosition(NewPositions.Num() - 1, OldPositions.Num() - 1)) {
+		OutNewToOld.Last() = OldPositions.Num() - 1;
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraph<Dim, 3>::ReplaceSpline(FSplineWrapper& Wrapper, const TSharedPtr<FSplineType>& NewSpline)
 {
-	if (!SplineWrapperToDelete.IsValid())
+	int32 SplineIndex = INDEX_NONE;
+	SplineToIndex.RemoveAndCopyValue(Wrapper.Spline.Get(), SplineIndex);
+	Wrapper.Spline = NewSpline;
+	SplineToIndex.Add(Wrapper.Spline.Get(), SplineIndex);
+}
+
+template<int32 Dim>
+inline void TSplineGraph<Dim, 3>::UpdateDeleted(int32 SplineIndex)
+{
+	if (!SplineSlots.IsValidIndex(SplineIndex) || !SplineSlots[SplineIndex].Wrapper.IsValid())
 	{
 		return;
 	}
-	TSharedPtr<FSplineWrapper> WrapperSharedPtr = SplineWrapperToDelete.Pin();
-	SplineToWrapper.Remove(WrapperSharedPtr->Spline);
-
-	auto* FwdValuePtr = InternalGraphForward.Find(WrapperSharedPtr);
-	auto* BwdValuePtr = InternalGraphBackward.Find(WrapperSharedPtr);
+	FSplineSlot& Slot = SplineSlots[SplineIndex];
+	SplineToIndex.Remove(Slot.Wrapper->Spline.Get());
 
-	for (auto* ValuePtr :{ InternalGraphForward.Find(WrapperSharedPtr), InternalGraphBackward.Find(WrapperSharedPtr) })
+	for (EContactType ContactType : { EContactType::Start, EContactType::End })
 	{
-		if (!ValuePtr)
+		auto& Links = EndpointLinks[MakeEndpoint(SplineIndex, ContactType)];
+		for (const FEndpointLink& Link : Links)
 		{
-			continue;
-		}
-		for (const FGraphNode& Node : *ValuePtr)
-		{
-			if (!Node.SplineWrapper.IsValid())
+			if (!IsLinkAlive(Link))
 			{
 				continue;
 			}
-			TSharedPtr<FSplineWrapper> WrapperSharedPtr1 = Node.SplineWrapper.Pin();
-			for (auto* ValuePtr1 :{ InternalGraphForward.Find(WrapperSharedPtr1), InternalGraphBackward.Find(WrapperSharedPtr1) })
+			int32 AdjSplineIndex = GetEndpointSplineIndex(Link.Endpoint);
+			RemoveDirectedLinksToSpline(MakeEndpoint(AdjSplineIndex, EContactType::Start), SplineIndex);
+			RemoveDirectedLinksToSpline(MakeEndpoint(AdjSplineIndex, EContactType::End), SplineIndex);
+		}
+		if (IsJournalRecording())
+		{
+			for (int32 i = Links.Num() - 1; i >= 0; --i)
 			{
-				if (ValuePtr1)
-				{
-					const FGraphNode* NodeToRemove = FindGraphNodeBySplinePtrInSet(*ValuePtr1, WrapperSharedPtr->Spline);
-					if (NodeToRemove)
-					{
-						ValuePtr1->Remove(*NodeToRemove);
-					}
-				}
+				Journal->RecordLinkRemove(MakeEndpoint(SplineIndex, ContactType), i);
 			}
 		}
+		Links.Empty();
 	}
 
-	InternalGraphForward.Remove(WrapperSharedPtr);
-	InternalGraphBackward.Remove(WrapperSharedPtr);
+	// Other one-way links to the spline are dropped by generation.
+	if (IsJournalRecording())
+	{
+		Journal->RecordSlot(false, SplineIndex);
+	}
+	Slot.Wrapper.Reset();
+	++Slot.Generation;
+	FreeSplineIndices.Add(SplineIndex);
+	MarkTopologyChanged();
 }
 
 template<int32 Dim>
@@ -815,7 +1147,7 @@ inline void TSplineGraph<Dim, 3>::AdjustAuxiliaryFunc(
 	const TSharedPtr<FSplineType>& SplinePtr, const TTuple<double, double>& ParamRange,
 	const TMap<EContactType, TVectorX<Dim> >& InitialPos,
 	const TMap<EContactType, TVectorX<Dim> >& InitialTangent,
-	int32 MoveLevel, int32 NthPointOfFrom)
+	int32 MoveLevel, int32 NthPointOfFrom, TArray<FSplineId>* OutAdjustedIds)
 {
 	FSplineType& Spline = *SplinePtr.Get();
 	static const auto GetEndNodeBezierString = [](TBezierString3<Dim>& Spline, EContactType Type) {
@@ -835,15 +1167,19 @@ inline void TSplineGraph<Dim, 3>::AdjustAuxiliaryFunc(
 		if ((!TVecLib<Dim>::IsNearlyZero(InitialPos[ContactTypeToAdjust] - NewEndPos)) ||
 			(!TVecLib<Dim>::IsNearlyZero(InitialTangent[ContactTypeToAdjust] - NewEndTangent)))
 		{
-			TSet<TTuple<FGraphNode, int32> > EndCluster;
-			GetClusterWithoutSelf(EndCluster, SplinePtr, ContactTypeToAdjust);
+			GetClusterWithoutSelf(ClusterScratch, GetSplineId(SplinePtr.Get()), ContactTypeToAdjust);
 
-			for (TTuple<FGraphNode, int32>& NodePair : EndCluster)
+			for (const TTuple<int32, int32>& EndpointPair : ClusterScratch)
 			{
-				FGraphNode& Node = NodePair.Key;
-				int32 Distance = NodePair.Value;
+				FGraphNode Node = MakeGraphNode(EndpointPair.Key);
+				int32 Distance = EndpointPair.Value;
 				if (Node.SplineWrapper.IsValid() && Node.SplineWrapper.Pin()->Spline != SplinePtr)
 				{
+					if (OutAdjustedIds)
+					{
+						AddBatchAffectedId(*OutAdjustedIds, Node.SplineId);
+					}
+					RecordTouch(Node.SplineId.Index);
 					FSplineType& SplineToAdjust = *Node.SplineWrapper.Pin()->Spline.Get();
 					const auto& ParamRangeToAdjust = SplineToAdjust.GetParamRange();
 					TVectorX<Dim> TangentToAdjust = SplineToAdjust.GetTangent(GetEndParam(ParamRangeToAdjust, Node.ContactType));
@@ -890,3 +1226,142 @@ inline void TSplineGraph<Dim, 3>::AdjustAuxiliaryFunc(
 		}
 	}
 }
+
+template<int32 Dim>
+inline void TSplineGraph<Dim, 3>::BeginBatch()
+{
+	++BatchDepth;
+}
+
+template<int32 Dim>
+inline int32 TSplineGraph<Dim, 3>::EndBatch(TArray<FSplineId>* OutAffectedIds)
+{
+	if (OutAffectedIds)
+	{
+		OutAffectedIds->Reset();
+	}
+	if (BatchDepth <= 0 || --BatchDepth > 0)
+	{
+		return 0;
+	}
+
+	TArray<FSplineId> AffectedIds;
+	TArray<FSplineId>& AffectedIdsRef = OutAffectedIds ? *OutAffectedIds : AffectedIds;
+	for (const FBatchedEdit& Edit : BatchedEdits)
+	{
+		if (IsValidId(Edit.Id))
+		{
+			AddBatchAffectedId(AffectedIdsRef, Edit.Id);
+		}
+	}
+	for (const FBatchedEdit& Edit : BatchedEdits)
+	{
+		TSharedPtr<FSplineType> SplinePtr = GetSplineById(Edit.Id);
+		if (SplinePtr)
+		{
+			AdjustAuxiliaryFunc(SplinePtr, SplinePtr->GetParamRange(), Edit.InitialPos, Edit.InitialTangent, Edit.MoveLevel, Edit.NthPointOfFrom, &AffectedIdsRef);
+		}
+		BatchedEditIndices[Edit.Id.Index] = INDEX_NONE;
+	}
+	BatchedEdits.Reset();
+	for (const FSplineId& Id : AffectedIdsRef)
+	{
+		BatchAffectedFlags[Id.Index] = false;
+	}
+	return AffectedIdsRef.Num();
+}
+
+template<int32 Dim>
+inline void TSplineGraph<Dim, 3>::AddBatchAffectedId(TArray<FSplineId>& OutAffectedIds, const FSplineId& Id)
+{
+	if (!Id.IsValid())
+	{
+		return;
+	}
+	if (BatchAffectedFlags.Num() <= Id.Index)
+	{
+		BatchAffectedFlags.SetNumZeroed(SplineSlots.Num());
+	}
+	if (!BatchAffectedFlags[Id.Index])
+	{
+		BatchAffectedFlags[Id.Index] = true;
+		OutAffectedIds.Add(Id);
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraph<Dim, 3>::AdjustOrRecordAuxiliary(
+	const TSharedPtr<FSplineType>& SplinePtr, const TTuple<double, double>& ParamRange,
+	const TMap<EContactType, TVectorX<Dim> >& InitialPos,
+	const TMap<EContactType, TVectorX<Dim> >& InitialTangent,
+	int32 MoveLevel, int32 NthPointOfFrom)
+{
+	FSplineId Id = GetSplineId(SplinePtr.Get());
+	if (BatchDepth <= 0 || !Id.IsValid())
+	{
+		AdjustAuxiliaryFunc(SplinePtr, ParamRange, InitialPos, InitialTangent, MoveLevel, NthPointOfFrom);
+		return;
+	}
+
+	if (BatchedEditIndices.Num() <= Id.Index)
+	{
+		int32 OldNum = BatchedEditIndices.Num();
+		BatchedEditIndices.SetNumUninitialized(SplineSlots.Num());
+		for (int32 i = OldNum; i < BatchedEditIndices.Num(); ++i)
+		{
+			BatchedEditIndices[i] = INDEX_NONE;
+		}
+	}
+	int32 EditIndex = BatchedEditIndices[Id.Index];
+	if (EditIndex != INDEX_NONE && BatchedEdits[EditIndex].Id == Id)
+	{
+		// Keep the initial states of the first move.
+		FBatchedEdit& Edit = BatchedEdits[EditIndex];
+		Edit.MoveLevel = FMath::Max(Edit.MoveLevel, MoveLevel);
+		Edit.NthPointOfFrom = NthPointOfFrom;
+		return;
+	}
+	BatchedEditIndices[Id.Index] = BatchedEdits.Num();
+	FBatchedEdit& Edit = BatchedEdits.AddDefaulted_GetRef();
+	Edit.Id = Id;
+	Edit.InitialPos = InitialPos;
+	Edit.InitialTangent = InitialTangent;
+	Edit.MoveLevel = MoveLevel;
+	Edit.NthPointOfFrom = NthPointOfFrom;
+}
+
+template<int32 Dim>
+inline void TSplineGraph<Dim, 3>::SetJournal(TSplineGraphJournal<Dim>* InJournal)
+{
+	if (Journal == InJournal)
+	{
+		return;
+	}
+	TSplineGraphJournal<Dim>* OldJournal = Journal;
+	Journal = InJournal;
+	if (OldJournal)
+	{
+		OldJournal->OnDetached();
+	}
+}
+
+template<int32 Dim>
+inline bool TSplineGraph<Dim, 3>::IsJournalRecording() const
+{
+	return Journal && Journal->IsRecording();
+}
+
+template<int32 Dim>
+inline bool TSplineGraph<Dim, 3>::RecordTouch(int32 SplineIndex)
+{
+	return IsJournalRecording() && Journal->TouchSplineIndex(SplineIndex);
+}
+
+template<int32 Dim>
+inline void TSplineGraph<Dim, 3>::DiscardTouch(int32 SplineIndex)
+{
+	if (IsJournalRecording())
+	{
+		Journal->DiscardTouch(SplineIndex);
+	}
+}
@@ -0,0 +1,148 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SplineGraph.h"
+
+// Bounding volume hierarchy over the bezier segments of all splines in a graph.
+// Splines are marked dirty when changed, and Update() refits the changed segments in place.
+// Segments of new or resized splines are kept in a pending list until too many accumulate, then the tree is rebuilt.
+// The boxes are F_Box3, so only Dim 3 is supported.
+template<int32 Dim>
+class TSplineGraphBVH
+{
+public:
+	using FGraphType = typename TSplineGraph<Dim, 3>;
+	using FSplineType = typename FGraphType::FSplineType;
+	using FSplineId = typename FGraphType::FSplineId;
+	using FCurveType = typename TBezierCurve<Dim, 3>;
+
+	struct FSegment
+	{
+		FSplineId SplineId;
+		int32 SegmentIndex = INDEX_NONE;
+		TTuple<double, double> ParamRange;
+		FCurveType Curve;
+		F_Box3 Box = F_Box3(EForceInit::ForceInit);
+		// Leaf containing this segment, or INDEX_NONE if pending.
+		int32 LeafNode = INDEX_NONE;
+
+		FORCEINLINE bool IsAlive() const { return SplineId.IsValid(); }
+
+		FORCEINLINE double GetSplineParam(double SegmentParam) const { return FMath::Lerp(ParamRange.Get<0>(), ParamRange.Get<1>(), SegmentParam); }
+	};
+
+	struct FSegmentHit
+	{
+		int32 Segment = INDEX_NONE;
+		FSplineId SplineId;
+		// Parameter of the spline, and of the bezier segment in [0, 1].
+		double Param = 0.;
+		double SegmentParam = 0.;
+		TVectorX<Dim> Position;
+		double DistanceSquared = 0.;
+		// Distance along the ray, only for Raycast.
+		double RayDistance = 0.;
+	};
+
+public:
+	void Empty();
+
+	void MarkSplineDirty(const FSplineId& Id);
+
+	void MarkAllDirty();
+
+	void Update(const FGraphType& Graph);
+
+	void Rebuild(const FGraphType& Graph);
+
+	FORCEINLINE int32 GetSegmentCapacity() const { return Segments.Num(); }
+
+	FORCEINLINE const FSegment& GetSegment(int32 Segment) const { return Segments[Segment]; }
+
+	FORCEINLINE TArrayView<const int32> GetSegmentsOfSpline(const FSplineId& Id) const
+	{
+		return (SplineEntries.IsValidIndex(Id.Index) && SplineEntries[Id.Index].Id == Id) ? TArrayView<const int32>(SplineEntries[Id.Index].Segments) : TArrayView<const int32>();
+	}
+
+	F_Box3 GetBounds() const;
+
+	// Nearest point within MaxDistance. If FilterId is valid, only the segments of that spline are considered.
+	bool FindNearest(FSegmentHit& OutHit, const TVectorX<Dim>& Position, double MaxDistance = TNumericLimits<double>::Max(), const FSplineId& FilterId = FSplineId()) const;
+
+	// Nearest point of every segment within Radius.
+	int32 QueryRadius(TArray<FSegmentHit>& OutHits, const TVectorX<Dim>& Position, double Radius) const;
+
+	// The first segment passing within Radius of the ray, by distance along the ray.
+	bool Raycast(FSegmentHit& OutHit, const TVectorX<Dim>& Origin, const TVectorX<Dim>& Direction, double Radius, double MaxDistance = TNumericLimits<double>::Max()) const;
+
+	// Segments whose boxes overlap the box. Safe to call from several threads, when the tree is not being updated.
+	int32 QueryBox(TArray<int32>& OutSegments, const F_Box3& Box) const;
+
+	// Segments whose boxes overlap the convex volume. Normals of the planes point outside, like FConvexVolume.
+	int32 QueryFrustum(TArray<int32>& OutSegments, TArrayView<const FPlane> Planes) const;
+
+	// Closest point of the curve to the line through Origin along the normalized Direction.
+	// A zero Direction gives the closest point to Origin.
+	static double FindClosestParam(const FCurveType& Curve, const TVectorX<Dim>& Origin, const TVectorX<Dim>& Direction, double& OutDistanceSquared);
+
+protected:
+	struct FNode
+	{
+		F_Box3 Box = F_Box3(EForceInit::ForceInit);
+		int32 Parent = INDEX_NONE;
+		int32 Left = INDEX_NONE;
+		int32 Right = INDEX_NONE;
+		// Range in LeafSegments, only for leaves.
+		int32 First = 0;
+		int32 Count = 0;
+
+		FORCEINLINE bool IsLeaf() const { return Left == INDEX_NONE; }
+	};
+
+	struct FSplineEntry
+	{
+		FSplineId Id;
+		const FSplineType* Spline = nullptr;
+		TArray<int32> Segments;
+		bool bDirty = false;
+	};
+
+	static constexpr int32 MaxLeafSize = 4;
+	static constexpr int32 MinPendingToRebuild = 32;
+
+	TArray<FSegment> Segments;
+	TArray<FNode> Nodes;
+	TArray<int32> LeafSegments;
+	TArray<int32> PendingSegments;
+	TArray<FSplineEntry> SplineEntries;
+	TArray<int32> DirtySplines;
+	TArray<int32> DirtyLeaves;
+	int32 LiveSegmentNum = 0;
+	int32 DeadSegmentNum = 0;
+	uint32 SyncedTopologyGeneration = 0;
+	bool bSynced = false;
+
+	void SyncSplines(const FGraphType& Graph);
+
+	void UpdateSpline(const FGraphType& Graph, int32 SplineIndex);
+
+	void RemoveSegmentsOfSpline(int32 SplineIndex);
+
+	int32 BuildNode(int32 Parent, int32 First, int32 Count);
+
+	void RefitLeaf(int32 Node);
+
+	void RebuildTree();
+
+	static bool IntersectRayBox(const F_Box3& Box, const TVectorX<Dim>& Origin, const TVectorX<Dim>& Direction, double MaxDistance, double& OutEntryDistance);
+
+	static bool IntersectPlanesBox(const F_Box3& Box, TArrayView<const FPlane> Planes);
+
+	template<typename FBoxPredicate, typename FSegmentVisitor>
+	void ForEachSegment(FBoxPredicate&& BoxPredicate, FSegmentVisitor&& SegmentVisitor) const;
+};
+
+#include "SplineGraphBVH.inl"
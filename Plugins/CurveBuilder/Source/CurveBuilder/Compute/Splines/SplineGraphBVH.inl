@@ -0,0 +1,564 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "Algo/Sort.h"
+
+template<int32 Dim>
+inline void TSplineGraphBVH<Dim>::Empty()
+{
+	Segments.Empty();
+	Nodes.Empty();
+	LeafSegments.Empty();
+	PendingSegments.Empty();
+	SplineEntries.Empty();
+	DirtySplines.Empty();
+	DirtyLeaves.Empty();
+	LiveSegmentNum = 0;
+	DeadSegmentNum = 0;
+	SyncedTopologyGeneration = 0;
+	bSynced = false;
+}
+
+template<int32 Dim>
+inline void TSplineGraphBVH<Dim>::MarkSplineDirty(const FSplineId& Id)
+{
+	if (!Id.IsValid()) {
+		return;
+	}
+	if (SplineEntries.Num() <= Id.Index) {
+		SplineEntries.SetNum(Id.Index + 1);
+	}
+	FSplineEntry& Entry = SplineEntries[Id.Index];
+	if (!Entry.bDirty) {
+		Entry.bDirty = true;
+		DirtySplines.Add(Id.Index);
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraphBVH<Dim>::MarkAllDirty()
+{
+	bSynced = false;
+	for (int32 i = 0; i < SplineEntries.Num(); ++i) {
+		if (!SplineEntries[i].bDirty) {
+			SplineEntries[i].bDirty = true;
+			DirtySplines.Add(i);
+		}
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraphBVH<Dim>::Update(const FGraphType& Graph)
+{
+	if (!bSynced || SyncedTopologyGeneration != Graph.GetTopologyGeneration()) {
+		SyncSplines(Graph);
+	}
+	for (int32 SplineIndex : DirtySplines) {
+		UpdateSpline(Graph, SplineIndex);
+	}
+	DirtySplines.Reset();
+
+	// Pending segments are tested linearly, and dead segments still occupy leaves, so rebuild if too many.
+	if (PendingSegments.Num() + DeadSegmentNum > FMath::Max(MinPendingToRebuild, LiveSegmentNum / 4)) {
+		RebuildTree();
+		return;
+	}
+
+	DirtyLeaves.Sort();
+	int32 LastLeaf = INDEX_NONE;
+	for (int32 Leaf : DirtyLeaves) {
+		if (Leaf != LastLeaf) {
+			RefitLeaf(Leaf);
+			LastLeaf = Leaf;
+		}
+	}
+	DirtyLeaves.Reset();
+}
+
+template<int32 Dim>
+inline void TSplineGraphBVH<Dim>::Rebuild(const FGraphType& Graph)
+{
+	Empty();
+	SyncSplines(Graph);
+	for (int32 SplineIndex : DirtySplines) {
+		UpdateSpline(Graph, SplineIndex);
+	}
+	DirtySplines.Reset();
+	RebuildTree();
+}
+
+template<int32 Dim>
+inline F_Box3 TSplineGraphBVH<Dim>::GetBounds() const
+{
+	F_Box3 Box = Nodes.Num() > 0 ? Nodes[0].Box : F_Box3(EForceInit::ForceInit);
+	for (int32 Segment : PendingSegments) {
+		if (Segments[Segment].IsAlive()) {
+			Box += Segments[Segment].Box;
+		}
+	}
+	return Box;
+}
+
+template<int32 Dim>
+inline bool TSplineGraphBVH<Dim>::FindNearest(FSegmentHit& OutHit, const TVectorX<Dim>& Position, double MaxDistance, const FSplineId& FilterId) const
+{
+	double BestDistSqr = FMath::Square(MaxDistance);
+	bool bFound = false;
+	auto TestSegment = [&](int32 Segment) {
+		const FSegment& Seg = Segments[Segment];
+		double DistSqr = 0.;
+		double T = FindClosestParam(Seg.Curve, Position, TVecLib<Dim>::Zero(), DistSqr);
+		if (DistSqr <= BestDistSqr) {
+			BestDistSqr = DistSqr;
+			bFound = true;
+			OutHit.Segment = Segment;
+			OutHit.SplineId = Seg.SplineId;
+			OutHit.SegmentParam = T;
+			OutHit.Param = Seg.GetSplineParam(T);
+			OutHit.Position = Seg.Curve.GetPosition(T);
+			OutHit.DistanceSquared = DistSqr;
+		}
+	};
+
+	if (FilterId.IsValid()) {
+		for (int32 Segment : GetSegmentsOfSpline(FilterId)) {
+			if (Segments[Segment].Box.ComputeSquaredDistanceToPoint(Position) <= BestDistSqr) {
+				TestSegment(Segment);
+			}
+		}
+		return bFound;
+	}
+
+	ForEachSegment([&](const F_Box3& Box, double& OutKey) {
+		OutKey = Box.ComputeSquaredDistanceToPoint(Position);
+		return OutKey <= BestDistSqr;
+	}, TestSegment);
+	return bFound;
+}
+
+template<int32 Dim>
+inline int32 TSplineGraphBVH<Dim>::QueryRadius(TArray<FSegmentHit>& OutHits, const TVectorX<Dim>& Position, double Radius) const
+{
+	OutHits.Reset();
+	const double RadiusSqr = FMath::Square(Radius);
+	ForEachSegment([&](const F_Box3& Box, double& OutKey) {
+		OutKey = Box.ComputeSquaredDistanceToPoint(Position);
+		return OutKey <= RadiusSqr;
+	}, [&](int32 Segment) {
+		const FSegment& Seg = Segments[Segment];
+		double DistSqr = 0.;
+		double T = FindClosestParam(Seg.Curve, Position, TVecLib<Dim>::Zero(), DistSqr);
+		if (DistSqr <= RadiusSqr) {
+			FSegmentHit& Hit = OutHits.AddDefaulted_GetRef();
+			Hit.Segment = Segment;
+			Hit.SplineId = Seg.SplineId;
+			Hit.SegmentParam = T;
+			Hit.Param = Seg.GetSplineParam(T);
+			Hit.Position = Seg.Curve.GetPosition(T);
+			Hit.DistanceSquared = DistSqr;
+		}
+	});
+	return OutHits.Num();
+}
+
+template<int32 Dim>
+inline bool TSplineGraphBVH<Dim>::Raycast(FSegmentHit& OutHit, const TVectorX<Dim>& Origin, const TVectorX<Dim>& Direction, double Radius, double MaxDistance) const
+{
+	const TVectorX<Dim> Dir = Direction.GetSafeNormal();
+	if (TVecLib<Dim>::IsNearlyZero(Dir)) {
+		return false;
+	}
+	const double RadiusSqr = FMath::Square(Radius);
+	double BestRayDistance = MaxDistance;
+	bool bFound = false;
+	ForEachSegment([&](const F_Box3& Box, double& OutKey) {
+		return IntersectRayBox(Box.ExpandBy(Radius), Origin, Dir, BestRayDistance, OutKey);
+	}, [&](int32 Segment) {
+		const FSegment& Seg = Segments[Segment];
+		double DistSqr = 0.;
+		double T = FindClosestParam(Seg.Curve, Origin, Dir, DistSqr);
+		if (DistSqr > RadiusSqr) {
+			return;
+		}
+		TVectorX<Dim> Position = Seg.Curve.GetPosition(T);
+		double RayDistance = TVecLib<Dim>::Dot(Position - Origin, Dir);
+		if (RayDistance >= 0. && RayDistance <= BestRayDistance) {
+			BestRayDistance = RayDistance;
+			bFound = true;
+			OutHit.Segment = Segment;
+			OutHit.SplineId = Seg.SplineId;
+			OutHit.SegmentParam = T;
+			OutHit.Param = Seg.GetSplineParam(T);
+			OutHit.Position = Position;
+			OutHit.DistanceSquared = DistSqr;
+			OutHit.RayDistance = RayDistance;
+		}
+	});
+	return bFound;
+}
+
+template<int32 Dim>
+inline int32 TSplineGraphBVH<Dim>::QueryBox(TArray<int32>& OutSegments, const F_Box3& Box) const
+{
+	OutSegments.Reset();
+	ForEachSegment([&](const F_Box3& NodeBox, double& OutKey) {
+		OutKey = 0.;
+		return NodeBox.Intersect(Box);
+	}, [&](int32 Segment) {
+		OutSegments.Add(Segment);
+	});
+	return OutSegments.Num();
+}
+
+template<int32 Dim>
+inline int32 TSplineGraphBVH<Dim>::QueryFrustum(TArray<int32>& OutSegments, TArrayView<const FPlane> Planes) const
+{
+	OutSegments.Reset();
+	ForEachSegment([&](const F_Box3& Box, double& OutKey) {
+		OutKey = 0.;
+		return IntersectPlanesBox(Box, Planes);
+	}, [&](int32 Segment) {
+		OutSegments.Add(Segment);
+	});
+	return OutSegments.Num();
+}
+
+template<int32 Dim>
+inline double TSplineGraphBVH<Dim>::FindClosestParam(const FCurveType& Curve, const TVectorX<Dim>& Origin, const TVectorX<Dim>& Direction, double& OutDistanceSquared)
+{
+	auto Perpendicular = [&Direction](const TVectorX<Dim>& V) -> TVectorX<Dim> {
+		return V - Direction * TVecLib<Dim>::Dot(V, Direction);
+	};
+
+	// Coarse samples, because a cubic may have more than one local minimum.
+	constexpr int32 SampleNum = 8;
+	double BestT = 0.;
+	double BestDistSqr = TNumericLimits<double>::Max();
+	for (int32 i = 0; i <= SampleNum; ++i) {
+		double T = static_cast<double>(i) / static_cast<double>(SampleNum);
+		double DistSqr = TVecLib<Dim>::SizeSquared(Perpendicular(Curve.GetPosition(T) - Origin));
+		if (DistSqr < BestDistSqr) {
+			BestDistSqr = DistSqr;
+			BestT = T;
+		}
+	}
+
+	// Gauss-Newton on (C(t) - O) . C'(t) = 0 in the plane perpendicular to the direction.
+	double T = BestT;
+	for (int32 i = 0; i < NumericalCalculationConst::NewtonIteration * 2; ++i) {
+		TVectorX<Dim> Diff = Perpendicular(Curve.GetPosition(T) - Origin);
+		TVectorX<Dim> Tangent = Perpendicular(Curve.GetTangent(T));
+		double Denominator = TVecLib<Dim>::SizeSquared(Tangent);
+		if (FMath::IsNearlyZero(Denominator)) {
+			break;
+		}
+		double NewT = FMath::Clamp(T - TVecLib<Dim>::Dot(Diff, Tangent) / Denominator, 0., 1.);
+		if (FMath::IsNearlyEqual(NewT, T, 1e-8)) {
+			T = NewT;
+			break;
+		}
+		T = NewT;
+	}
+
+	double DistSqr = TVecLib<Dim>::SizeSquared(Perpendicular(Curve.GetPosition(T) - Origin));
+	if (DistSqr > BestDistSqr) {
+		T = BestT;
+		DistSqr = BestDistSqr;
+	}
+	OutDistanceSquared = DistSqr;
+	return T;
+}
+
+template<int32 Dim>
+inline void TSplineGraphBVH<Dim>::SyncSplines(const FGraphType& Graph)
+{
+	const int32 Capacity = Graph.GetSplineIndexCapacity();
+	for (int32 i = Capacity; i < SplineEntries.Num(); ++i) {
+		RemoveSegmentsOfSpline(i);
+	}
+	SplineEntries.SetNum(Capacity);
+	DirtySplines.RemoveAll([Capacity](int32 SplineIndex) { return SplineIndex >= Capacity; });
+
+	for (int32 i = 0; i < Capacity; ++i) {
+		FSplineEntry& Entry = SplineEntries[i];
+		FSplineId Id = Graph.GetSplineIdByIndex(i);
+		const FSplineType* Spline = Graph.GetSplineById(Id).Get();
+		if (Entry.Id != Id || Entry.Spline != Spline) {
+			RemoveSegmentsOfSpline(i);
+			Entry.Id = Id;
+			Entry.Spline = Spline;
+			if (Id.IsValid() && !Entry.bDirty) {
+				Entry.bDirty = true;
+				DirtySplines.Add(i);
+			}
+		}
+	}
+	SyncedTopologyGeneration = Graph.GetTopologyGeneration();
+	bSynced = true;
+}
+
+template<int32 Dim>
+inline void TSplineGraphBVH<Dim>::UpdateSpline(const FGraphType& Graph, int32 SplineIndex)
+{
+	if (!SplineEntries.IsValidIndex(SplineIndex)) {
+		return;
+	}
+	FSplineEntry& Entry = SplineEntries[SplineIndex];
+	Entry.bDirty = false;
+
+	FSplineId Id = Graph.GetSplineIdByIndex(SplineIndex);
+	if (Entry.Id != Id) {
+		RemoveSegmentsOfSpline(SplineIndex);
+		Entry.Id = Id;
+	}
+	Entry.Spline = Graph.GetSplineById(Id).Get();
+
+	TArray<FCurveType> Beziers;
+	TArray<TTuple<double, double> > ParamRanges;
+	if (!Entry.Spline || !Entry.Spline->ToBezierCurves(Beziers, &ParamRanges)) {
+		RemoveSegmentsOfSpline(SplineIndex);
+		return;
+	}
+
+	// Same number of segments, refit in place.
+	if (Beziers.Num() == Entry.Segments.Num()) {
+		for (int32 i = 0; i < Beziers.Num(); ++i) {
+			FSegment& Seg = Segments[Entry.Segments[i]];
+			Seg.Curve = Beziers[i];
+			Seg.ParamRange = ParamRanges[i];
+			Seg.Box = Seg.Curve.GetBox();
+			if (Seg.LeafNode != INDEX_NONE) {
+				DirtyLeaves.Add(Seg.LeafNode);
+			}
+		}
+		return;
+	}
+
+	RemoveSegmentsOfSpline(SplineIndex);
+	Entry.Segments.Reserve(Beziers.Num());
+	for (int32 i = 0; i < Beziers.Num(); ++i) {
+		int32 Segment = Segments.AddDefaulted();
+		FSegment& Seg = Segments[Segment];
+		Seg.SplineId = Id;
+		Seg.SegmentIndex = i;
+		Seg.ParamRange = ParamRanges[i];
+		Seg.Curve = Beziers[i];
+		Seg.Box = Seg.Curve.GetBox();
+		Entry.Segments.Add(Segment);
+		PendingSegments.Add(Segment);
+		++LiveSegmentNum;
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraphBVH<Dim>::RemoveSegmentsOfSpline(int32 SplineIndex)
+{
+	if (!SplineEntries.IsValidIndex(SplineIndex)) {
+		return;
+	}
+	FSplineEntry& Entry = SplineEntries[SplineIndex];
+	// Dead segments are not reused until the tree is rebuilt, since leaves may still refer to them.
+	for (int32 Segment : Entry.Segments) {
+		FSegment& Seg = Segments[Segment];
+		Seg.SplineId = FSplineId();
+		if (Seg.LeafNode != INDEX_NONE) {
+			DirtyLeaves.Add(Seg.LeafNode);
+		}
+		else {
+			PendingSegments.RemoveSingleSwap(Segment, false);
+		}
+		++DeadSegmentNum;
+		--LiveSegmentNum;
+	}
+	Entry.Segments.Reset();
+}
+
+template<int32 Dim>
+inline int32 TSplineGraphBVH<Dim>::BuildNode(int32 Parent, int32 First, int32 Count)
+{
+	const int32 NodeIndex = Nodes.AddDefaulted();
+	Nodes[NodeIndex].Parent = Parent;
+
+	F_Box3 Box(EForceInit::ForceInit);
+	F_Box3 CenterBox(EForceInit::ForceInit);
+	for (int32 i = First; i < First + Count; ++i) {
+		const F_Box3& SegBox = Segments[LeafSegments[i]].Box;
+		Box += SegBox;
+		CenterBox += SegBox.GetCenter();
+	}
+	Nodes[NodeIndex].Box = Box;
+
+	if (Count <= MaxLeafSize) {
+		Nodes[NodeIndex].First = First;
+		Nodes[NodeIndex].Count = Count;
+		for (int32 i = First; i < First + Count; ++i) {
+			Segments[LeafSegments[i]].LeafNode = NodeIndex;
+		}
+		return NodeIndex;
+	}
+
+	// Median split on the longest axis of the centers.
+	F_Vec3 Extent = CenterBox.GetExtent();
+	int32 Axis = (Extent.X >= Extent.Y && Extent.X >= Extent.Z) ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+	Algo::Sort(MakeArrayView(LeafSegments.GetData() + First, Count), [this, Axis](int32 A, int32 B) {
+		return Segments[A].Box.GetCenter()[Axis] < Segments[B].Box.GetCenter()[Axis];
+	});
+
+	const int32 LeftCount = Count / 2;
+	const int32 Left = BuildNode(NodeIndex, First, LeftCount);
+	const int32 Right = BuildNode(NodeIndex, First + LeftCount, Count - LeftCount);
+	Nodes[NodeIndex].Left = Left;
+	Nodes[NodeIndex].Right = Right;
+	return NodeIndex;
+}
+
+template<int32 Dim>
+inline void TSplineGraphBVH<Dim>::RefitLeaf(int32 Node)
+{
+	FNode& Leaf = Nodes[Node];
+	Leaf.Box = F_Box3(EForceInit::ForceInit);
+	for (int32 i = Leaf.First; i < Leaf.First + Leaf.Count; ++i) {
+		const FSegment& Seg = Segments[LeafSegments[i]];
+		if (Seg.IsAlive()) {
+			Leaf.Box += Seg.Box;
+		}
+	}
+	for (int32 Parent = Leaf.Parent; Parent != INDEX_NONE; Parent = Nodes[Parent].Parent) {
+		FNode& ParentNode = Nodes[Parent];
+		ParentNode.Box = Nodes[ParentNode.Left].Box + Nodes[ParentNode.Right].Box;
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraphBVH<Dim>::RebuildTree()
+{
+	// Compact the live segments, so the slots of the entries are remapped.
+	TArray<FSegment> LiveSegments;
+	LiveSegments.Reserve(LiveSegmentNum);
+	for (FSplineEntry& Entry : SplineEntries) {
+		for (int32& Segment : Entry.Segments) {
+			int32 NewSegment = LiveSegments.Add(MoveTemp(Segments[Segment]));
+			LiveSegments[NewSegment].LeafNode = INDEX_NONE;
+			Segment = NewSegment;
+		}
+	}
+	Segments = MoveTemp(LiveSegments);
+	LiveSegmentNum = Segments.Num();
+	DeadSegmentNum = 0;
+	PendingSegments.Reset();
+	DirtyLeaves.Reset();
+
+	LeafSegments.SetNumUninitialized(Segments.Num());
+	for (int32 i = 0; i < Segments.Num(); ++i) {
+		LeafSegments[i] = i;
+	}
+	Nodes.Reset();
+	if (Segments.Num() > 0) {
+		Nodes.Reserve(2 * (Segments.Num() / MaxLeafSize + 1));
+		BuildNode(INDEX_NONE, 0, Segments.Num());
+	}
+}
+
+template<int32 Dim>
+inline bool TSplineGraphBVH<Dim>::IntersectRayBox(const F_Box3& Box, const TVectorX<Dim>& Origin, const TVectorX<Dim>& Direction, double MaxDistance, double& OutEntryDistance)
+{
+	if (!Box.IsValid) {
+		return false;
+	}
+	double Entry = 0.;
+	double Exit = MaxDistance;
+	for (int32 i = 0; i < 3; ++i) {
+		if (FMath::IsNearlyZero(Direction[i])) {
+			if (Origin[i] < Box.Min[i] || Origin[i] > Box.Max[i]) {
+				return false;
+			}
+			continue;
+		}
+		double InvDir = 1. / Direction[i];
+		double T0 = (Box.Min[i] - Origin[i]) * InvDir;
+		double T1 = (Box.Max[i] - Origin[i]) * InvDir;
+		if (T0 > T1) {
+			Swap(T0, T1);
+		}
+		Entry = FMath::Max(Entry, T0);
+		Exit = FMath::Min(Exit, T1);
+		if (Entry > Exit) {
+			return false;
+		}
+	}
+	OutEntryDistance = Entry;
+	return true;
+}
+
+template<int32 Dim>
+inline bool TSplineGraphBVH<Dim>::IntersectPlanesBox(const F_Box3& Box, TArrayView<const FPlane> Planes)
+{
+	if (!Box.IsValid) {
+		return false;
+	}
+	const F_Vec3 Center = Box.GetCenter();
+	const F_Vec3 Extent = Box.GetExtent();
+	for (const FPlane& Plane : Planes) {
+		double PushOut = FMath::Abs(Extent.X * Plane.X) + FMath::Abs(Extent.Y * Plane.Y) + FMath::Abs(Extent.Z * Plane.Z);
+		if (Plane.PlaneDot(Center) > PushOut) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template<int32 Dim>
+template<typename FBoxPredicate, typename FSegmentVisitor>
+inline void TSplineGraphBVH<Dim>::ForEachSegment(FBoxPredicate&& BoxPredicate, FSegmentVisitor&& SegmentVisitor) const
+{
+	double Key = 0.;
+	for (int32 Segment : PendingSegments) {
+		if (Segments[Segment].IsAlive() && BoxPredicate(Segments[Segment].Box, Key)) {
+			SegmentVisitor(Segment);
+		}
+	}
+	if (Nodes.Num() == 0 || !BoxPredicate(Nodes[0].Box, Key)) {
+		return;
+	}
+
+	// Depth first, the child with the smaller key is visited first.
+	// The predicate is tested again when popped, since the bound may be tightened by the visitor.
+	TArray<int32, TInlineAllocator<64> > Stack;
+	Stack.Add(0);
+	while (Stack.Num() > 0) {
+		const FNode& Node = Nodes[Stack.Pop(false)];
+		if (!BoxPredicate(Node.Box, Key)) {
+			continue;
+		}
+		if (Node.IsLeaf()) {
+			for (int32 i = Node.First; i < Node.First + Node.Count; ++i) {
+				const FSegment& Seg = Segments[LeafSegments[i]];
+				if (Seg.IsAlive() && BoxPredicate(Seg.Box, Key)) {
+					SegmentVisitor(LeafSegments[i]);
+				}
+			}
+			continue;
+		}
+		double LeftKey = 0., RightKey = 0.;
+		bool bLeft = BoxPredicate(Nodes[Node.Left].Box, LeftKey);
+		bool bRight = BoxPredicate(Nodes[Node.Right].Box, RightKey);
+		if (bLeft && bRight) {
+			if (LeftKey <= RightKey) {
+				Stack.Add(Node.Right);
+				Stack.Add(Node.Left);
+			}
+			else {
+				Stack.Add(Node.Left);
+				Stack.Add(Node.Right);
+			}
+		}
+		else if (bLeft) {
+			Stack.Add(Node.Left);
+		}
+		else if (bRight) {
+			Stack.Add(Node.Right);
+		}
+	}
+}
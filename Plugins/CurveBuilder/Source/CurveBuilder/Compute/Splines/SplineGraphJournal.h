@@ -0,0 +1,245 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SplineGraph.h"
+
+// Undo and redo of a spline graph by small deltas.
+// Each step is an edit between BeginEdit() and the outermost EndEdit(). The graph records the splines it is
+// going to modify, and the links and slots it changes. At the end of the edit, each touched spline is diffed
+// to a splice of its control points, so a point move is stored and applied in O(points changed).
+// A full checkpoint is taken every CheckpointInterval steps, for jumping between far steps by GoToStep().
+// Changes made outside an edit are not recorded, so call Empty() after them.
+template<int32 Dim>
+class TSplineGraphJournal
+{
+public:
+	using FGraphType = typename TSplineGraph<Dim, 3>;
+	using FSplineType = typename FGraphType::FSplineType;
+	using FSplineWrapper = typename FGraphType::FSplineWrapper;
+	using FSplineId = typename FGraphType::FSplineId;
+	using FBezierStringType = typename TSplineTraitByType<ESplineType::BezierString, Dim, 3>::FSplineType;
+	using FBSplineType = typename TSplineTraitByType<ESplineType::ClampedBSpline, Dim, 3>::FSplineType;
+
+	// Flat control point. Prev, Next, Param and Continuity are only for bezier strings.
+	struct FPointState
+	{
+		TVectorX<Dim+1> Pos;
+		TVectorX<Dim+1> Prev;
+		TVectorX<Dim+1> Next;
+		double Param = 0.;
+		EEndPointContinuity Continuity = EEndPointContinuity::G1;
+
+		bool operator==(const FPointState& Other) const
+		{
+			return Pos == Other.Pos && Prev == Other.Prev && Next == Other.Next && Param == Other.Param && Continuity == Other.Continuity;
+		}
+
+		bool operator!=(const FPointState& Other) const { return !(*this == Other); }
+	};
+
+	struct FSplineState
+	{
+		ESplineType Type = ESplineType::Unknown;
+		TArray<FPointState> Points;
+		TArray<double> KnotIntervals;
+	};
+
+	// Scoped edit.
+	struct FScopedEdit
+	{
+		FORCEINLINE FScopedEdit(TSplineGraphJournal& InJournal)
+			: Journal(InJournal)
+		{
+			Journal.BeginEdit();
+		}
+
+		FORCEINLINE ~FScopedEdit()
+		{
+			Journal.EndEdit();
+		}
+
+		TSplineGraphJournal& Journal;
+	};
+
+public:
+	TSplineGraphJournal(FGraphType& InGraph, int32 InCheckpointInterval = 64);
+
+	~TSplineGraphJournal();
+
+	// Drop the history, and take the graph as step 0.
+	void Empty();
+
+	FORCEINLINE bool IsAttached() const { return Graph != nullptr; }
+
+	// Edits can be nested. End the batch of the graph before the outermost EndEdit().
+	void BeginEdit();
+
+	// Return true if a step is recorded. The steps after the current one are dropped then.
+	bool EndEdit();
+
+	FORCEINLINE bool IsRecording() const { return Graph && EditDepth > 0; }
+
+	// Declare a spline to be modified by its own methods in the current edit, before modifying it.
+	void TouchSpline(const FSplineId& Id);
+
+	FORCEINLINE int32 GetCurrentStep() const { return CurrentStep; }
+
+	FORCEINLINE int32 GetStepNum() const { return Entries.Num(); }
+
+	FORCEINLINE bool CanUndo() const { return IsAttached() && EditDepth == 0 && CurrentStep > 0; }
+
+	FORCEINLINE bool CanRedo() const { return IsAttached() && EditDepth == 0 && CurrentStep < Entries.Num(); }
+
+	// The splines changed (excluding the removed ones) are output, for updating their views.
+	// Control point structs are kept if the number of points and the type are not changed.
+	bool Undo(TArray<FSplineId>* OutAffectedIds = nullptr);
+
+	bool Redo(TArray<FSplineId>* OutAffectedIds = nullptr);
+
+	// Step by step, or from the nearest checkpoint before the step if cheaper.
+	bool GoToStep(int32 Step, TArray<FSplineId>* OutAffectedIds = nullptr);
+
+	static void GetSplineState(FSplineState& OutState, const FSplineType& Spline);
+
+protected:
+	friend class TSplineGraph<Dim, 3>;
+
+	using FEndpointLink = typename FGraphType::FEndpointLink;
+	using FEndpointLinkArray = typename TArray<FEndpointLink, TInlineAllocator<4> >;
+
+	enum class ELinkOp : uint8
+	{
+		Insert,
+		Remove,
+		Replace,
+		Reverse,
+	};
+
+	// Insert and remove at Index of the links of FromEndpoint. Replace changes the endpoint of Link from OldEndpoint.
+	// Reverse is ReverseLinks() of the spline of FromEndpoint, with the generation of Link. The links of both ends
+	// of the spline are swapped, and the links to the spline in FlippedLinks (endpoint and index, after the swap) are flipped.
+	struct FLinkOp
+	{
+		ELinkOp Op = ELinkOp::Insert;
+		int32 FromEndpoint = INDEX_NONE;
+		int32 Index = INDEX_NONE;
+		FEndpointLink Link;
+		int32 OldEndpoint = INDEX_NONE;
+		TArray<TTuple<int32, int32> > FlippedLinks;
+	};
+
+	// Install or remove a spline at a slot. The wrapper is kept alive by the journal.
+	struct FSlotOp
+	{
+		bool bInstall = true;
+		int32 SplineIndex = INDEX_NONE;
+		uint32 Generation = 0;
+		TSharedPtr<FSplineWrapper> Wrapper;
+	};
+
+	// Points [Start, Start + OldPoints.Num()) are replaced by NewPoints.
+	struct FSplineDelta
+	{
+		int32 SplineIndex = INDEX_NONE;
+		TSharedPtr<FSplineWrapper> Wrapper;
+		ESplineType OldType = ESplineType::Unknown;
+		ESplineType NewType = ESplineType::Unknown;
+		int32 Start = 0;
+		TArray<FPointState> OldPoints;
+		TArray<FPointState> NewPoints;
+		bool bKnotsChanged = false;
+		TArray<double> OldKnotIntervals;
+		TArray<double> NewKnotIntervals;
+	};
+
+	struct FEntry
+	{
+		TArray<FSlotOp> SlotOps;
+		TArray<FSplineDelta> SplineDeltas;
+		TArray<FLinkOp> LinkOps;
+	};
+
+	struct FCheckpointSlot
+	{
+		TSharedPtr<FSplineWrapper> Wrapper;
+		uint32 Generation = 0;
+		FSplineState State;
+	};
+
+	struct FCheckpoint
+	{
+		int32 Step = 0;
+		int64 Cost = 0;
+		TArray<FCheckpointSlot> Slots;
+		TArray<int32> FreeSplineIndices;
+		TArray<FEndpointLinkArray> EndpointLinks;
+	};
+
+	struct FTouchedSpline
+	{
+		int32 SplineIndex = INDEX_NONE;
+		TSharedPtr<FSplineWrapper> Wrapper;
+		FSplineState Before;
+	};
+
+	FGraphType* Graph = nullptr;
+	int32 CheckpointInterval = 64;
+
+	TArray<FEntry> Entries;
+	// CostPrefix[i] is the total cost of Entries[0, i).
+	TArray<int64> CostPrefix;
+	// Sorted by step.
+	TArray<FCheckpoint> Checkpoints;
+	int32 CurrentStep = 0;
+
+	int32 EditDepth = 0;
+	FEntry PendingEntry;
+	TArray<FTouchedSpline> TouchedSplines;
+	// Index in TouchedSplines by spline index, or INDEX_NONE.
+	TArray<int32> TouchedIndices;
+
+	void OnDetached();
+
+	bool TouchSplineIndex(int32 SplineIndex);
+
+	void DiscardTouch(int32 SplineIndex);
+
+	void RecordSlot(bool bInstall, int32 SplineIndex);
+
+	void RecordLinkInsert(int32 FromEndpoint, int32 Index);
+
+	void RecordLinkRemove(int32 FromEndpoint, int32 Index);
+
+	void RecordLinkReplace(int32 FromEndpoint, int32 Index, int32 OldEndpoint);
+
+	void RecordReverseLinks(int32 SplineIndex, uint32 Generation, TArray<TTuple<int32, int32> >&& FlippedLinks);
+
+	static bool MakeSplineDelta(FSplineDelta& OutDelta, const FSplineState& Before, const FSplineState& After);
+
+	static int64 GetEntryCost(const FEntry& Entry);
+
+	void ApplyEntry(const FEntry& Entry, bool bForward, TSet<int32>& InOutAffectedIndices);
+
+	void ApplySlotOp(const FSlotOp& SlotOp, bool bInstall);
+
+	void ApplyLinkOp(const FLinkOp& LinkOp, bool bForward);
+
+	void ApplySplineDelta(const FSplineDelta& Delta, bool bForward);
+
+	// Overwrite the points from Start, keeping the control point structs.
+	static void SetPointsInPlace(FSplineType& Spline, int32 Start, const TArray<FPointState>& Points);
+
+	// Set the whole state, in place if the type and the number of points are not changed.
+	void SetSplineState(FSplineWrapper& Wrapper, const FSplineState& State);
+
+	void TakeCheckpoint();
+
+	void RestoreCheckpoint(const FCheckpoint& Checkpoint, TSet<int32>& InOutAffectedIndices);
+
+	void OutputAffectedIds(TArray<FSplineId>* OutAffectedIds, const TSet<int32>& AffectedIndices) const;
+};
+
+#include "SplineGraphJournal.inl"
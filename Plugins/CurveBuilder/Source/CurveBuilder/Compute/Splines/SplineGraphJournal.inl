@@ -0,0 +1,585 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+template<int32 Dim>
+inline TSplineGraphJournal<Dim>::TSplineGraphJournal(FGraphType& InGraph, int32 InCheckpointInterval)
+	: Graph(&InGraph)
+	, CheckpointInterval(FMath::Max(InCheckpointInterval, 1))
+{
+	Graph->SetJournal(this);
+	Empty();
+}
+
+template<int32 Dim>
+inline TSplineGraphJournal<Dim>::~TSplineGraphJournal()
+{
+	if (Graph && Graph->GetJournal() == this) {
+		Graph->SetJournal(nullptr);
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::Empty()
+{
+	Entries.Empty();
+	CostPrefix.Reset();
+	CostPrefix.Add(0);
+	Checkpoints.Empty();
+	CurrentStep = 0;
+	EditDepth = 0;
+	PendingEntry = FEntry();
+	TouchedSplines.Empty();
+	TouchedIndices.Empty();
+	if (Graph) {
+		TakeCheckpoint();
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::OnDetached()
+{
+	Graph = nullptr;
+	Empty();
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::BeginEdit()
+{
+	++EditDepth;
+}
+
+template<int32 Dim>
+inline bool TSplineGraphJournal<Dim>::EndEdit()
+{
+	if (EditDepth <= 0 || --EditDepth > 0) {
+		return false;
+	}
+
+	FEntry Entry = MoveTemp(PendingEntry);
+	PendingEntry = FEntry();
+	FSplineState After;
+	for (FTouchedSpline& Touched : TouchedSplines) {
+		TouchedIndices[Touched.SplineIndex] = INDEX_NONE;
+		if (!Touched.Wrapper.IsValid() || !Touched.Wrapper->Spline.IsValid()) {
+			continue;
+		}
+		GetSplineState(After, *Touched.Wrapper->Spline.Get());
+		FSplineDelta Delta;
+		if (MakeSplineDelta(Delta, Touched.Before, After)) {
+			Delta.SplineIndex = Touched.SplineIndex;
+			Delta.Wrapper = Touched.Wrapper;
+			Entry.SplineDeltas.Add(MoveTemp(Delta));
+		}
+	}
+	TouchedSplines.Reset();
+
+	if (!Graph || (Entry.SlotOps.Num() == 0 && Entry.SplineDeltas.Num() == 0 && Entry.LinkOps.Num() == 0)) {
+		return false;
+	}
+
+	// Drop the redo steps.
+	Entries.SetNum(CurrentStep);
+	CostPrefix.SetNum(CurrentStep + 1);
+	while (Checkpoints.Num() > 0 && Checkpoints.Last().Step > CurrentStep) {
+		Checkpoints.Pop(false);
+	}
+
+	CostPrefix.Add(CostPrefix.Last() + GetEntryCost(Entry));
+	Entries.Add(MoveTemp(Entry));
+	++CurrentStep;
+	if (CurrentStep % CheckpointInterval == 0) {
+		TakeCheckpoint();
+	}
+	return true;
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::TouchSpline(const FSplineId& Id)
+{
+	if (IsRecording() && Graph->IsValidId(Id)) {
+		TouchSplineIndex(Id.Index);
+	}
+}
+
+template<int32 Dim>
+inline bool TSplineGraphJournal<Dim>::TouchSplineIndex(int32 SplineIndex)
+{
+	if (!Graph->SplineSlots.IsValidIndex(SplineIndex)) {
+		return false;
+	}
+	const TSharedPtr<FSplineWrapper>& Wrapper = Graph->SplineSlots[SplineIndex].Wrapper;
+	if (!Wrapper.IsValid() || !Wrapper->Spline.IsValid()) {
+		return false;
+	}
+	if (TouchedIndices.Num() <= SplineIndex) {
+		const int32 OldNum = TouchedIndices.Num();
+		TouchedIndices.SetNumUninitialized(Graph->SplineSlots.Num());
+		for (int32 i = OldNum; i < TouchedIndices.Num(); ++i) {
+			TouchedIndices[i] = INDEX_NONE;
+		}
+	}
+	const int32 TouchedIndex = TouchedIndices[SplineIndex];
+	if (TouchedIndex != INDEX_NONE && TouchedSplines[TouchedIndex].Wrapper == Wrapper) {
+		return false;
+	}
+	TouchedIndices[SplineIndex] = TouchedSplines.Num();
+	FTouchedSpline& Touched = TouchedSplines.AddDefaulted_GetRef();
+	Touched.SplineIndex = SplineIndex;
+	Touched.Wrapper = Wrapper;
+	GetSplineState(Touched.Before, *Wrapper->Spline.Get());
+	return true;
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::DiscardTouch(int32 SplineIndex)
+{
+	if (TouchedIndices.IsValidIndex(SplineIndex) && TouchedIndices[SplineIndex] == TouchedSplines.Num() - 1) {
+		TouchedSplines.Pop(false);
+		TouchedIndices[SplineIndex] = INDEX_NONE;
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::RecordSlot(bool bInstall, int32 SplineIndex)
+{
+	const auto& Slot = Graph->SplineSlots[SplineIndex];
+	FSlotOp& SlotOp = PendingEntry.SlotOps.AddDefaulted_GetRef();
+	SlotOp.bInstall = bInstall;
+	SlotOp.SplineIndex = SplineIndex;
+	SlotOp.Generation = Slot.Generation;
+	SlotOp.Wrapper = Slot.Wrapper;
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::RecordLinkInsert(int32 FromEndpoint, int32 Index)
+{
+	PendingEntry.LinkOps.Add(FLinkOp{ ELinkOp::Insert, FromEndpoint, Index, Graph->EndpointLinks[FromEndpoint][Index], INDEX_NONE });
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::RecordLinkRemove(int32 FromEndpoint, int32 Index)
+{
+	PendingEntry.LinkOps.Add(FLinkOp{ ELinkOp::Remove, FromEndpoint, Index, Graph->EndpointLinks[FromEndpoint][Index], INDEX_NONE });
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::RecordLinkReplace(int32 FromEndpoint, int32 Index, int32 OldEndpoint)
+{
+	PendingEntry.LinkOps.Add(FLinkOp{ ELinkOp::Replace, FromEndpoint, Index, Graph->EndpointLinks[FromEndpoint][Index], OldEndpoint });
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::RecordReverseLinks(int32 SplineIndex, uint32 Generation, TArray<TTuple<int32, int32> >&& FlippedLinks)
+{
+	PendingEntry.LinkOps.Add(FLinkOp{ ELinkOp::Reverse, FGraphType::MakeEndpoint(SplineIndex, EContactType::Start), INDEX_NONE, FEndpointLink{ INDEX_NONE, Generation }, INDEX_NONE, MoveTemp(FlippedLinks) });
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::GetSplineState(FSplineState& OutState, const FSplineType& Spline)
+{
+	OutState.Type = Spline.GetType();
+	OutState.Points.Reset(Spline.GetCtrlPointNum());
+	OutState.KnotIntervals.Reset();
+	switch (OutState.Type) {
+	case ESplineType::BezierString:
+	{
+		const FBezierStringType& BezierString = static_cast<const FBezierStringType&>(Spline);
+		for (auto* Node = BezierString.FirstNode(); Node; Node = Node->GetNextNode()) {
+			const auto& Point = Node->GetValue().Get();
+			OutState.Points.Add(FPointState{ Point.Pos, Point.PrevCtrlPointPos, Point.NextCtrlPointPos, Point.Param, Point.Continuity });
+		}
+	}
+	break;
+	case ESplineType::ClampedBSpline:
+	{
+		const FBSplineType& BSpline = static_cast<const FBSplineType&>(Spline);
+		for (auto* Node = BSpline.FirstNode(); Node; Node = Node->GetNextNode()) {
+			OutState.Points.Add(FPointState{ Node->GetValue().Get().Pos, TVecLib<Dim+1>::Zero(), TVecLib<Dim+1>::Zero() });
+		}
+		BSpline.GetKnotIntervals(OutState.KnotIntervals);
+	}
+	break;
+	}
+}
+
+template<int32 Dim>
+inline bool TSplineGraphJournal<Dim>::MakeSplineDelta(FSplineDelta& OutDelta, const FSplineState& Before, const FSplineState& After)
+{
+	OutDelta.OldType = Before.Type;
+	OutDelta.NewType = After.Type;
+	OutDelta.bKnotsChanged = Before.KnotIntervals != After.KnotIntervals;
+	if (OutDelta.bKnotsChanged) {
+		OutDelta.OldKnotIntervals = Before.KnotIntervals;
+		OutDelta.NewKnotIntervals = After.KnotIntervals;
+	}
+
+	// Splice between the common prefix and the common suffix.
+	const int32 MinNum = FMath::Min(Before.Points.Num(), After.Points.Num());
+	int32 PrefixNum = 0;
+	while (PrefixNum < MinNum && Before.Points[PrefixNum] == After.Points[PrefixNum]) {
+		++PrefixNum;
+	}
+	int32 SuffixNum = 0;
+	while (SuffixNum < MinNum - PrefixNum
+		&& Before.Points[Before.Points.Num() - 1 - SuffixNum] == After.Points[After.Points.Num() - 1 - SuffixNum]) {
+		++SuffixNum;
+	}
+	OutDelta.Start = PrefixNum;
+	OutDelta.OldPoints.Reset();
+	OutDelta.OldPoints.Append(Before.Points.GetData() + PrefixNum, Before.Points.Num() - PrefixNum - SuffixNum);
+	OutDelta.NewPoints.Reset();
+	OutDelta.NewPoints.Append(After.Points.GetData() + PrefixNum, After.Points.Num() - PrefixNum - SuffixNum);
+
+	return OutDelta.OldType != OutDelta.NewType || OutDelta.bKnotsChanged || OutDelta.OldPoints.Num() > 0 || OutDelta.NewPoints.Num() > 0;
+}
+
+template<int32 Dim>
+inline int64 TSplineGraphJournal<Dim>::GetEntryCost(const FEntry& Entry)
+{
+	int64 Cost = Entry.SlotOps.Num() + Entry.LinkOps.Num();
+	for (const FSplineDelta& Delta : Entry.SplineDeltas) {
+		Cost += 1 + FMath::Max(Delta.OldPoints.Num(), Delta.NewPoints.Num());
+	}
+	for (const FLinkOp& LinkOp : Entry.LinkOps) {
+		Cost += LinkOp.FlippedLinks.Num();
+	}
+	return Cost;
+}
+
+template<int32 Dim>
+inline bool TSplineGraphJournal<Dim>::Undo(TArray<FSplineId>* OutAffectedIds)
+{
+	return CanUndo() && GoToStep(CurrentStep - 1, OutAffectedIds);
+}
+
+template<int32 Dim>
+inline bool TSplineGraphJournal<Dim>::Redo(TArray<FSplineId>* OutAffectedIds)
+{
+	return CanRedo() && GoToStep(CurrentStep + 1, OutAffectedIds);
+}
+
+template<int32 Dim>
+inline bool TSplineGraphJournal<Dim>::GoToStep(int32 Step, TArray<FSplineId>* OutAffectedIds)
+{
+	if (OutAffectedIds) {
+		OutAffectedIds->Reset();
+	}
+	if (!IsAttached() || EditDepth > 0 || Step < 0 || Step > Entries.Num()) {
+		return false;
+	}
+
+	TSet<int32> AffectedIndices;
+	if (Step != CurrentStep) {
+		// The last checkpoint not after the step.
+		const int32 CheckpointIndex = Algo::UpperBoundBy(Checkpoints, Step, [](const FCheckpoint& Checkpoint) { return Checkpoint.Step; }) - 1;
+		const int64 SteppingCost = FMath::Abs(CostPrefix[Step] - CostPrefix[CurrentStep]);
+		if (Checkpoints.IsValidIndex(CheckpointIndex)) {
+			const FCheckpoint& Checkpoint = Checkpoints[CheckpointIndex];
+			const int64 CheckpointCost = Checkpoint.Cost + CostPrefix[Step] - CostPrefix[Checkpoint.Step];
+			if (CheckpointCost < SteppingCost) {
+				RestoreCheckpoint(Checkpoint, AffectedIndices);
+				CurrentStep = Checkpoint.Step;
+			}
+		}
+		for (; CurrentStep > Step; --CurrentStep) {
+			ApplyEntry(Entries[CurrentStep - 1], false, AffectedIndices);
+		}
+		for (; CurrentStep < Step; ++CurrentStep) {
+			ApplyEntry(Entries[CurrentStep], true, AffectedIndices);
+		}
+	}
+	OutputAffectedIds(OutAffectedIds, AffectedIndices);
+	return true;
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::ApplyEntry(const FEntry& Entry, bool bForward, TSet<int32>& InOutAffectedIndices)
+{
+	// Slot ops only touch the slots and the links only touch the link arrays, so each kind is applied
+	// in its own order, and all of them are reversed for undo.
+	if (bForward) {
+		for (const FSlotOp& SlotOp : Entry.SlotOps) {
+			ApplySlotOp(SlotOp, SlotOp.bInstall);
+		}
+		for (const FSplineDelta& Delta : Entry.SplineDeltas) {
+			ApplySplineDelta(Delta, true);
+			InOutAffectedIndices.Add(Delta.SplineIndex);
+		}
+		for (const FLinkOp& LinkOp : Entry.LinkOps) {
+			ApplyLinkOp(LinkOp, true);
+		}
+	}
+	else {
+		for (int32 i = Entry.LinkOps.Num() - 1; i >= 0; --i) {
+			ApplyLinkOp(Entry.LinkOps[i], false);
+		}
+		for (int32 i = Entry.SplineDeltas.Num() - 1; i >= 0; --i) {
+			ApplySplineDelta(Entry.SplineDeltas[i], false);
+			InOutAffectedIndices.Add(Entry.SplineDeltas[i].SplineIndex);
+		}
+		for (int32 i = Entry.SlotOps.Num() - 1; i >= 0; --i) {
+			ApplySlotOp(Entry.SlotOps[i], !Entry.SlotOps[i].bInstall);
+		}
+	}
+	for (const FSlotOp& SlotOp : Entry.SlotOps) {
+		InOutAffectedIndices.Add(SlotOp.SplineIndex);
+	}
+	for (const FLinkOp& LinkOp : Entry.LinkOps) {
+		InOutAffectedIndices.Add(FGraphType::GetEndpointSplineIndex(LinkOp.FromEndpoint));
+	}
+	if (Entry.SlotOps.Num() > 0 || Entry.LinkOps.Num() > 0) {
+		Graph->MarkTopologyChanged();
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::ApplySlotOp(const FSlotOp& SlotOp, bool bInstall)
+{
+	auto& Slot = Graph->SplineSlots[SlotOp.SplineIndex];
+	if (bInstall) {
+		Slot.Wrapper = SlotOp.Wrapper;
+		Slot.Generation = SlotOp.Generation;
+		Graph->FreeSplineIndices.RemoveSingle(SlotOp.SplineIndex);
+		Graph->SplineToIndex.Add(SlotOp.Wrapper->Spline.Get(), SlotOp.SplineIndex);
+	}
+	else {
+		Graph->SplineToIndex.Remove(SlotOp.Wrapper->Spline.Get());
+		Slot.Wrapper.Reset();
+		Slot.Generation = SlotOp.Generation + 1;
+		Graph->FreeSplineIndices.Add(SlotOp.SplineIndex);
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::ApplyLinkOp(const FLinkOp& LinkOp, bool bForward)
+{
+	auto& Links = Graph->EndpointLinks[LinkOp.FromEndpoint];
+	switch (LinkOp.Op) {
+	case ELinkOp::Insert:
+	case ELinkOp::Remove:
+		if ((LinkOp.Op == ELinkOp::Insert) == bForward) {
+			Links.Insert(LinkOp.Link, LinkOp.Index);
+		}
+		else {
+			Links.RemoveAt(LinkOp.Index, 1, false);
+		}
+		break;
+	case ELinkOp::Replace:
+		Links[LinkOp.Index].Endpoint = bForward ? LinkOp.Link.Endpoint : LinkOp.OldEndpoint;
+		break;
+	case ELinkOp::Reverse:
+	{
+		// Swap, then flip the recorded links. Flip first for undo.
+		auto SwapEnds = [this, &LinkOp]() {
+			Swap(Graph->EndpointLinks[LinkOp.FromEndpoint], Graph->EndpointLinks[LinkOp.FromEndpoint ^ 1]);
+		};
+		if (bForward) {
+			SwapEnds();
+		}
+		for (const TTuple<int32, int32>& Flipped : LinkOp.FlippedLinks) {
+			Graph->EndpointLinks[Flipped.Get<0>()][Flipped.Get<1>()].Endpoint ^= 1;
+		}
+		if (!bForward) {
+			SwapEnds();
+		}
+	}
+	break;
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::ApplySplineDelta(const FSplineDelta& Delta, bool bForward)
+{
+	FSplineWrapper& Wrapper = *Delta.Wrapper.Get();
+	const ESplineType ToType = bForward ? Delta.NewType : Delta.OldType;
+	const TArray<FPointState>& FromPoints = bForward ? Delta.OldPoints : Delta.NewPoints;
+	const TArray<FPointState>& ToPoints = bForward ? Delta.NewPoints : Delta.OldPoints;
+
+	// In place, for moves.
+	if (ToType == Wrapper.Spline->GetType() && FromPoints.Num() == ToPoints.Num() && !Delta.bKnotsChanged) {
+		SetPointsInPlace(*Wrapper.Spline.Get(), Delta.Start, ToPoints);
+		return;
+	}
+
+	FSplineState State;
+	GetSplineState(State, *Wrapper.Spline.Get());
+	State.Type = ToType;
+	State.Points.RemoveAt(Delta.Start, FMath::Min(FromPoints.Num(), State.Points.Num() - Delta.Start), false);
+	State.Points.Insert(ToPoints, Delta.Start);
+	if (Delta.bKnotsChanged) {
+		State.KnotIntervals = bForward ? Delta.NewKnotIntervals : Delta.OldKnotIntervals;
+	}
+	SetSplineState(Wrapper, State);
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::SetPointsInPlace(FSplineType& Spline, int32 Start, const TArray<FPointState>& Points)
+{
+	switch (Spline.GetType()) {
+	case ESplineType::BezierString:
+	{
+		FBezierStringType& BezierString = static_cast<FBezierStringType&>(Spline);
+		for (int32 i = 0; i < Points.Num(); ++i) {
+			const FPointState& Point = Points[i];
+			BezierString.SetCtrlPointAt(Start + i, typename FBezierStringType::FControlPointType(Point.Pos, Point.Prev, Point.Next, Point.Param, Point.Continuity));
+		}
+	}
+	break;
+	case ESplineType::ClampedBSpline:
+	{
+		// No index of nodes in B-Splines, so walk to the start.
+		FBSplineType& BSpline = static_cast<FBSplineType&>(Spline);
+		auto* Node = BSpline.FirstNode();
+		for (int32 i = 0; i < Start && Node; ++i) {
+			Node = Node->GetNextNode();
+		}
+		for (int32 i = 0; i < Points.Num() && Node; ++i, Node = Node->GetNextNode()) {
+			Node->GetValue().Get().Pos = Points[i].Pos;
+		}
+	}
+	break;
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::SetSplineState(FSplineWrapper& Wrapper, const FSplineState& State)
+{
+	TSharedPtr<FSplineType> Spline = Wrapper.Spline;
+	if (!Spline.IsValid() || Spline->GetType() != State.Type) {
+		switch (State.Type) {
+		case ESplineType::BezierString:
+			Spline = MakeShareable(new FBezierStringType());
+			break;
+		case ESplineType::ClampedBSpline:
+			Spline = MakeShareable(new FBSplineType());
+			break;
+		default:
+			return;
+		}
+		// Keep the wrapper, so the graph nodes are still valid.
+		int32 IndexInGraph = INDEX_NONE;
+		if (Wrapper.Spline.IsValid() && Graph->SplineToIndex.RemoveAndCopyValue(Wrapper.Spline.Get(), IndexInGraph)) {
+			Graph->SplineToIndex.Add(Spline.Get(), IndexInGraph);
+		}
+		Wrapper.Spline = Spline;
+	}
+	else if (Spline->GetCtrlPointNum() == State.Points.Num()) {
+		FSplineState Current;
+		GetSplineState(Current, *Spline.Get());
+		if (Current.KnotIntervals == State.KnotIntervals) {
+			FSplineDelta Delta;
+			if (MakeSplineDelta(Delta, Current, State)) {
+				SetPointsInPlace(*Spline.Get(), Delta.Start, Delta.NewPoints);
+			}
+			return;
+		}
+	}
+
+	TArray<TVectorX<Dim+1> > Pos, Prev, Next;
+	Pos.Reserve(State.Points.Num());
+	for (const FPointState& Point : State.Points) {
+		Pos.Add(Point.Pos);
+	}
+	switch (State.Type) {
+	case ESplineType::BezierString:
+	{
+		TArray<double> Params;
+		TArray<EEndPointContinuity> Continuities;
+		Prev.Reserve(State.Points.Num());
+		Next.Reserve(State.Points.Num());
+		Params.Reserve(State.Points.Num());
+		Continuities.Reserve(State.Points.Num());
+		for (const FPointState& Point : State.Points) {
+			Prev.Add(Point.Prev);
+			Next.Add(Point.Next);
+			Params.Add(Point.Param);
+			Continuities.Add(Point.Continuity);
+		}
+		static_cast<FBezierStringType&>(*Spline.Get()).Reset(Pos, Prev, Next, Params, Continuities);
+	}
+	break;
+	case ESplineType::ClampedBSpline:
+		static_cast<FBSplineType&>(*Spline.Get()).Reset(Pos, State.KnotIntervals);
+		break;
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::TakeCheckpoint()
+{
+	FCheckpoint& Checkpoint = Checkpoints.AddDefaulted_GetRef();
+	Checkpoint.Step = CurrentStep;
+	Checkpoint.Slots.SetNum(Graph->SplineSlots.Num());
+	for (int32 i = 0; i < Graph->SplineSlots.Num(); ++i) {
+		const auto& Slot = Graph->SplineSlots[i];
+		FCheckpointSlot& CheckpointSlot = Checkpoint.Slots[i];
+		CheckpointSlot.Wrapper = Slot.Wrapper;
+		CheckpointSlot.Generation = Slot.Generation;
+		if (Slot.Wrapper.IsValid() && Slot.Wrapper->Spline.IsValid()) {
+			GetSplineState(CheckpointSlot.State, *Slot.Wrapper->Spline.Get());
+			Checkpoint.Cost += 1 + CheckpointSlot.State.Points.Num();
+		}
+	}
+	Checkpoint.FreeSplineIndices = Graph->FreeSplineIndices;
+	Checkpoint.EndpointLinks = Graph->EndpointLinks;
+	for (const FEndpointLinkArray& Links : Checkpoint.EndpointLinks) {
+		Checkpoint.Cost += Links.Num();
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::RestoreCheckpoint(const FCheckpoint& Checkpoint, TSet<int32>& InOutAffectedIndices)
+{
+	// Slots are never shrunk, so the slots after the checkpoint are emptied.
+	Graph->SplineToIndex.Reset();
+	Graph->FreeSplineIndices = Checkpoint.FreeSplineIndices;
+	for (int32 i = 0; i < Graph->SplineSlots.Num(); ++i) {
+		auto& Slot = Graph->SplineSlots[i];
+		if (Slot.Wrapper.IsValid()) {
+			InOutAffectedIndices.Add(i);
+		}
+		if (!Checkpoint.Slots.IsValidIndex(i)) {
+			if (Slot.Wrapper.IsValid()) {
+				Slot.Wrapper.Reset();
+				++Slot.Generation;
+			}
+			Graph->FreeSplineIndices.Add(i);
+			continue;
+		}
+		const FCheckpointSlot& CheckpointSlot = Checkpoint.Slots[i];
+		Slot.Wrapper = CheckpointSlot.Wrapper;
+		Slot.Generation = CheckpointSlot.Generation;
+		if (Slot.Wrapper.IsValid()) {
+			SetSplineState(*Slot.Wrapper.Get(), CheckpointSlot.State);
+			Graph->SplineToIndex.Add(Slot.Wrapper->Spline.Get(), i);
+			InOutAffectedIndices.Add(i);
+		}
+	}
+	for (int32 Endpoint = 0; Endpoint < Graph->EndpointLinks.Num(); ++Endpoint) {
+		if (Checkpoint.EndpointLinks.IsValidIndex(Endpoint)) {
+			Graph->EndpointLinks[Endpoint] = Checkpoint.EndpointLinks[Endpoint];
+		}
+		else {
+			Graph->EndpointLinks[Endpoint].Reset();
+		}
+	}
+	Graph->MarkTopologyChanged();
+}
+
+template<int32 Dim>
+inline void TSplineGraphJournal<Dim>::OutputAffectedIds(TArray<FSplineId>* OutAffectedIds, const TSet<int32>& AffectedIndices) const
+{
+	if (!OutAffectedIds) {
+		return;
+	}
+	// The indices are unique, so are the ids.
+	OutAffectedIds->Reserve(OutAffectedIds->Num() + AffectedIndices.Num());
+	for (int32 SplineIndex : AffectedIndices) {
+		FSplineId Id = Graph->GetSplineIdByIndex(SplineIndex);
+		if (Id.IsValid()) {
+			OutAffectedIds->Add(Id);
+		}
+	}
+}
@@ -0,0 +1,165 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SplineGraph.h"
+
+// Shortest path by arc length through the connections of a spline graph.
+// A node is an endpoint where a spline is left, and the edge from endpoint X to F^1 (F linked from X)
+// is weighted by the length of the spline of F, so turning back at a junction is not possible.
+// The lengths are cached per spline and updated by Update() after MarkSplineDirty().
+// Queries are const and may run in parallel after Update().
+template<int32 Dim>
+class TSplineGraphRouter
+{
+public:
+	using FGraphType = typename TSplineGraph<Dim, 3>;
+	using FSplineType = typename FGraphType::FSplineType;
+	using FSplineId = typename FGraphType::FSplineId;
+
+	struct FRouteSegment
+	{
+		FSplineId SplineId;
+		// EContactType::End means forward, EContactType::Start means backward.
+		EContactType Direction = EContactType::End;
+		// From the first parameter to the second one, in the travel order.
+		TTuple<double, double> ParamRange;
+	};
+
+	struct FRouteRequest
+	{
+		FSplineId SourceId;
+		double SourceParam = 0.;
+		FSplineId TargetId;
+		double TargetParam = 0.;
+	};
+
+	struct FRoute
+	{
+		TArray<FRouteSegment> Segments;
+		double Length = -1.;
+
+		FORCEINLINE bool IsValid() const { return Length >= 0.; }
+	};
+
+public:
+	void Empty();
+
+	void MarkSplineDirty(const FSplineId& Id);
+
+	void MarkAllDirty();
+
+	// Refresh the cached lengths of dirty splines, and the connections if the topology changed.
+	// The contraction hierarchy is discarded if anything changed.
+	void Update(const FGraphType& Graph);
+
+	// Preprocessing for large static networks. Queries use it until the next change.
+	void BuildContractionHierarchy();
+
+	FORCEINLINE bool HasContractionHierarchy() const { return bHasContractionHierarchy; }
+
+	double GetSplineLength(const FSplineId& Id) const;
+
+	// A* with the straight distance to the target, or the contraction hierarchy if built.
+	bool FindRoute(FRoute& OutRoute, const FRouteRequest& Request) const;
+
+	// Routes of many agents, in parallel.
+	void FindRoutes(TArray<FRoute>& OutRoutes, TArrayView<const FRouteRequest> Requests) const;
+
+protected:
+	struct FSplineEntry
+	{
+		FSplineId Id;
+		const FSplineType* Spline = nullptr;
+		TTuple<double, double> ParamRange;
+		double Length = 0.;
+		TVectorX<Dim> EndpointPositions[2];
+		bool bDirty = false;
+	};
+
+	struct FHierarchyEdge
+	{
+		int32 Node = INDEX_NONE;
+		double Weight = 0.;
+		// Contracted node of a shortcut, or INDEX_NONE for an original edge.
+		int32 Middle = INDEX_NONE;
+	};
+
+	// Per query scratch. Index 0 is forward, 1 is backward.
+	struct FSearchScratch
+	{
+		TArray<double> Distances[2];
+		TArray<int32> Parents[2];
+		TArray<int32> Touched[2];
+		// Entry of the target spline each node of the backward search is from.
+		TArray<int32> Seeds;
+		TArray<TTuple<double, int32> > Heap;
+
+		void Reset(int32 NodeNum);
+	};
+
+	static constexpr int32 WitnessSettleLimit = 64;
+
+	TArray<FSplineEntry> SplineEntries;
+	TArray<int32> DirtySplines;
+
+	// Snapshot of the live links of each endpoint, so queries do not touch the graph.
+	// The reversed links are the endpoints linking to each endpoint.
+	TArray<int32> LinkOffsets;
+	TArray<int32> LinkEndpoints;
+	TArray<int32> ReversedLinkOffsets;
+	TArray<int32> ReversedLinkEndpoints;
+	bool bLinksDirty = true;
+
+	uint32 SyncedTopologyGeneration = 0;
+	bool bSynced = false;
+
+	// Upward edges of the hierarchy. Backward edges are reversed, stored at the lower node.
+	TArray<TArray<FHierarchyEdge> > UpwardEdges[2];
+	bool bHasContractionHierarchy = false;
+
+	FORCEINLINE int32 GetNodeNum() const { return SplineEntries.Num() * 2; }
+
+	FORCEINLINE bool IsValidEntry(int32 SplineIndex) const
+	{
+		return SplineEntries.IsValidIndex(SplineIndex) && SplineEntries[SplineIndex].Spline != nullptr;
+	}
+
+	FORCEINLINE double GetEndpointParam(int32 Endpoint) const
+	{
+		const FSplineEntry& Entry = SplineEntries[FGraphType::GetEndpointSplineIndex(Endpoint)];
+		return (Endpoint & 1) ? Entry.ParamRange.Get<1>() : Entry.ParamRange.Get<0>();
+	}
+
+	FORCEINLINE TArrayView<const int32> GetLinkedEndpoints(int32 Endpoint) const
+	{
+		return TArrayView<const int32>(LinkEndpoints.GetData() + LinkOffsets[Endpoint], LinkOffsets[Endpoint + 1] - LinkOffsets[Endpoint]);
+	}
+
+	FORCEINLINE TArrayView<const int32> GetReversedLinkedEndpoints(int32 Endpoint) const
+	{
+		return TArrayView<const int32>(ReversedLinkEndpoints.GetData() + ReversedLinkOffsets[Endpoint], ReversedLinkOffsets[Endpoint + 1] - ReversedLinkOffsets[Endpoint]);
+	}
+
+	void UpdateSpline(const FGraphType& Graph, int32 SplineIndex);
+
+	void RebuildLinks(const FGraphType& Graph);
+
+	double GetLengthFromStart(int32 SplineIndex, double Param) const;
+
+	// The node path starts from an endpoint of the source spline, and ends at an endpoint of the target spline
+	// which is left if the target spline is passed through. SourceOffset and TargetOffset are lengths from the start.
+	bool FindNodePathAStar(TArray<int32>& OutNodes, double& OutLength, const FRouteRequest& Request, double SourceOffset, double TargetOffset, FSearchScratch& Scratch) const;
+
+	bool FindNodePathHierarchy(TArray<int32>& OutNodes, double& OutLength, const FRouteRequest& Request, double SourceOffset, double TargetOffset, FSearchScratch& Scratch) const;
+
+	bool FindRouteInternal(FRoute& OutRoute, const FRouteRequest& Request, FSearchScratch& Scratch) const;
+
+	const FHierarchyEdge* FindHierarchyEdge(int32 From, int32 To) const;
+
+	void UnpackHierarchyEdge(TArray<int32>& OutNodes, int32 From, int32 To) const;
+};
+
+#include "SplineGraphRouter.inl"
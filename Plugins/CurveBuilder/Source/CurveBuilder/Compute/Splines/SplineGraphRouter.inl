@@ -0,0 +1,643 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "Async/ParallelFor.h"
+#include "Algo/Reverse.h"
+
+namespace SplineGraphRouterUtils
+{
+	FORCEINLINE bool HeapPredicate(const TTuple<double, int32>& A, const TTuple<double, int32>& B)
+	{
+		return A.Get<0>() < B.Get<0>();
+	}
+};
+
+template<int32 Dim>
+inline void TSplineGraphRouter<Dim>::FSearchScratch::Reset(int32 NodeNum)
+{
+	for (int32 d = 0; d < 2; ++d) {
+		if (Distances[d].Num() != NodeNum) {
+			Distances[d].Init(TNumericLimits<double>::Max(), NodeNum);
+			Parents[d].Init(INDEX_NONE, NodeNum);
+		}
+		else {
+			for (int32 Node : Touched[d]) {
+				Distances[d][Node] = TNumericLimits<double>::Max();
+				Parents[d][Node] = INDEX_NONE;
+			}
+		}
+		Touched[d].Reset();
+	}
+	Seeds.SetNumUninitialized(NodeNum);
+	Heap.Reset();
+}
+
+template<int32 Dim>
+inline void TSplineGraphRouter<Dim>::Empty()
+{
+	SplineEntries.Empty();
+	DirtySplines.Empty();
+	LinkOffsets.Empty();
+	LinkEndpoints.Empty();
+	ReversedLinkOffsets.Empty();
+	ReversedLinkEndpoints.Empty();
+	bLinksDirty = true;
+	SyncedTopologyGeneration = 0;
+	bSynced = false;
+	UpwardEdges[0].Empty();
+	UpwardEdges[1].Empty();
+	bHasContractionHierarchy = false;
+}
+
+template<int32 Dim>
+inline void TSplineGraphRouter<Dim>::MarkSplineDirty(const FSplineId& Id)
+{
+	if (!Id.IsValid()) {
+		return;
+	}
+	// New splines are found by the next Update().
+	if (!SplineEntries.IsValidIndex(Id.Index)) {
+		bSynced = false;
+		return;
+	}
+	FSplineEntry& Entry = SplineEntries[Id.Index];
+	if (!Entry.bDirty) {
+		Entry.bDirty = true;
+		DirtySplines.Add(Id.Index);
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraphRouter<Dim>::MarkAllDirty()
+{
+	bSynced = false;
+	for (int32 i = 0; i < SplineEntries.Num(); ++i) {
+		MarkSplineDirty(FSplineId{ i, SplineEntries[i].Id.Generation });
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraphRouter<Dim>::Update(const FGraphType& Graph)
+{
+	if (!bSynced || SyncedTopologyGeneration != Graph.GetTopologyGeneration()) {
+		const int32 Capacity = Graph.GetSplineIndexCapacity();
+		SplineEntries.SetNum(Capacity);
+		DirtySplines.RemoveAll([Capacity](int32 SplineIndex) { return SplineIndex >= Capacity; });
+		for (int32 i = 0; i < Capacity; ++i) {
+			FSplineEntry& Entry = SplineEntries[i];
+			FSplineId Id = Graph.GetSplineIdByIndex(i);
+			if ((Entry.Id != Id || Entry.Spline != Graph.GetSplineById(Id).Get()) && !Entry.bDirty) {
+				Entry.bDirty = true;
+				DirtySplines.Add(i);
+			}
+		}
+		SyncedTopologyGeneration = Graph.GetTopologyGeneration();
+		bSynced = true;
+		bLinksDirty = true;
+	}
+
+	for (int32 SplineIndex : DirtySplines) {
+		UpdateSpline(Graph, SplineIndex);
+	}
+	const bool bChanged = bLinksDirty || DirtySplines.Num() > 0;
+	DirtySplines.Reset();
+
+	if (bLinksDirty) {
+		RebuildLinks(Graph);
+	}
+	if (bChanged) {
+		UpwardEdges[0].Empty();
+		UpwardEdges[1].Empty();
+		bHasContractionHierarchy = false;
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraphRouter<Dim>::BuildContractionHierarchy()
+{
+	using FShortcut = TTuple<int32, int32, double>;
+	const int32 NodeNum = GetNodeNum();
+
+	// Current graph with shortcuts. Edges are never removed, contracted nodes are skipped instead.
+	TArray<TArray<FHierarchyEdge> > OutEdges, InEdges;
+	OutEdges.SetNum(NodeNum);
+	InEdges.SetNum(NodeNum);
+	auto AddOrImproveEdge = [](TArray<FHierarchyEdge>& Edges, int32 Node, double Weight, int32 Middle) {
+		for (FHierarchyEdge& Edge : Edges) {
+			if (Edge.Node == Node) {
+				if (Weight < Edge.Weight) {
+					Edge.Weight = Weight;
+					Edge.Middle = Middle;
+				}
+				return;
+			}
+		}
+		Edges.Add(FHierarchyEdge{ Node, Weight, Middle });
+	};
+	for (int32 Node = 0; Node < NodeNum; ++Node) {
+		for (int32 Entry : GetLinkedEndpoints(Node)) {
+			int32 NextNode = Entry ^ 1;
+			if (NextNode == Node) {
+				continue;
+			}
+			double Weight = SplineEntries[FGraphType::GetEndpointSplineIndex(Entry)].Length;
+			AddOrImproveEdge(OutEdges[Node], NextNode, Weight, INDEX_NONE);
+			AddOrImproveEdge(InEdges[NextNode], Node, Weight, INDEX_NONE);
+		}
+	}
+
+	TArray<bool> Contracted;
+	TArray<int32> Ranks;
+	TArray<int32> ContractedNeighborNums;
+	Contracted.Init(false, NodeNum);
+	Ranks.Init(INDEX_NONE, NodeNum);
+	ContractedNeighborNums.Init(0, NodeNum);
+
+	// Witness search from each predecessor, bounded by the settled number.
+	FSearchScratch WitnessScratch;
+	TArray<FShortcut> Shortcuts;
+	auto FindShortcuts = [&](int32 Node, TArray<FShortcut>& OutShortcuts) {
+		OutShortcuts.Reset();
+		for (const FHierarchyEdge& InEdge : InEdges[Node]) {
+			const int32 From = InEdge.Node;
+			if (Contracted[From]) {
+				continue;
+			}
+			double MaxWeight = -1.;
+			for (const FHierarchyEdge& OutEdge : OutEdges[Node]) {
+				if (!Contracted[OutEdge.Node] && OutEdge.Node != From) {
+					MaxWeight = FMath::Max(MaxWeight, InEdge.Weight + OutEdge.Weight);
+				}
+			}
+			if (MaxWeight < 0.) {
+				continue;
+			}
+
+			WitnessScratch.Reset(NodeNum);
+			TArray<double>& Distances = WitnessScratch.Distances[0];
+			Distances[From] = 0.;
+			WitnessScratch.Touched[0].Add(From);
+			WitnessScratch.Heap.HeapPush(MakeTuple(0., From), SplineGraphRouterUtils::HeapPredicate);
+			int32 SettledNum = 0;
+			while (WitnessScratch.Heap.Num() > 0 && SettledNum < WitnessSettleLimit) {
+				TTuple<double, int32> Top;
+				WitnessScratch.Heap.HeapPop(Top, SplineGraphRouterUtils::HeapPredicate, false);
+				if (Top.Get<0>() > Distances[Top.Get<1>()]) {
+					continue;
+				}
+				if (Top.Get<0>() > MaxWeight) {
+					break;
+				}
+				++SettledNum;
+				for (const FHierarchyEdge& Edge : OutEdges[Top.Get<1>()]) {
+					if (Contracted[Edge.Node] || Edge.Node == Node) {
+						continue;
+					}
+					double NewDistance = Top.Get<0>() + Edge.Weight;
+					if (NewDistance < Distances[Edge.Node]) {
+						if (Distances[Edge.Node] == TNumericLimits<double>::Max()) {
+							WitnessScratch.Touched[0].Add(Edge.Node);
+						}
+						Distances[Edge.Node] = NewDistance;
+						WitnessScratch.Heap.HeapPush(MakeTuple(NewDistance, Edge.Node), SplineGraphRouterUtils::HeapPredicate);
+					}
+				}
+			}
+
+			for (const FHierarchyEdge& OutEdge : OutEdges[Node]) {
+				if (Contracted[OutEdge.Node] || OutEdge.Node == From) {
+					continue;
+				}
+				double Weight = InEdge.Weight + OutEdge.Weight;
+				if (Distances[OutEdge.Node] > Weight) {
+					OutShortcuts.Emplace(From, OutEdge.Node, Weight);
+				}
+			}
+		}
+		return OutShortcuts.Num();
+	};
+	auto GetPriority = [&](int32 Node) -> double {
+		int32 DegreeNum = 0;
+		for (const FHierarchyEdge& Edge : InEdges[Node]) {
+			DegreeNum += Contracted[Edge.Node] ? 0 : 1;
+		}
+		for (const FHierarchyEdge& Edge : OutEdges[Node]) {
+			DegreeNum += Contracted[Edge.Node] ? 0 : 1;
+		}
+		return static_cast<double>(FindShortcuts(Node, Shortcuts) - DegreeNum + ContractedNeighborNums[Node]);
+	};
+
+	// Lazy update: the priority is recomputed when popped, and pushed again if it is no longer the minimum.
+	TArray<TTuple<double, int32> > Queue;
+	Queue.Reserve(NodeNum);
+	for (int32 Node = 0; Node < NodeNum; ++Node) {
+		Queue.HeapPush(MakeTuple(GetPriority(Node), Node), SplineGraphRouterUtils::HeapPredicate);
+	}
+	int32 Order = 0;
+	while (Queue.Num() > 0) {
+		TTuple<double, int32> Top;
+		Queue.HeapPop(Top, SplineGraphRouterUtils::HeapPredicate, false);
+		const int32 Node = Top.Get<1>();
+		if (Contracted[Node]) {
+			continue;
+		}
+		double Priority = GetPriority(Node);
+		if (Queue.Num() > 0 && Priority > Queue.HeapTop().Get<0>()) {
+			Queue.HeapPush(MakeTuple(Priority, Node), SplineGraphRouterUtils::HeapPredicate);
+			continue;
+		}
+
+		FindShortcuts(Node, Shortcuts);
+		for (const FShortcut& Shortcut : Shortcuts) {
+			AddOrImproveEdge(OutEdges[Shortcut.Get<0>()], Shortcut.Get<1>(), Shortcut.Get<2>(), Node);
+			AddOrImproveEdge(InEdges[Shortcut.Get<1>()], Shortcut.Get<0>(), Shortcut.Get<2>(), Node);
+		}
+		Contracted[Node] = true;
+		Ranks[Node] = Order++;
+		for (const FHierarchyEdge& Edge : InEdges[Node]) {
+			++ContractedNeighborNums[Edge.Node];
+		}
+		for (const FHierarchyEdge& Edge : OutEdges[Node]) {
+			++ContractedNeighborNums[Edge.Node];
+		}
+	}
+
+	// An edge is stored at the lower node, as forward if it goes up, and as backward (reversed) if it comes down.
+	UpwardEdges[0].Empty(NodeNum);
+	UpwardEdges[1].Empty(NodeNum);
+	UpwardEdges[0].SetNum(NodeNum);
+	UpwardEdges[1].SetNum(NodeNum);
+	for (int32 Node = 0; Node < NodeNum; ++Node) {
+		for (const FHierarchyEdge& Edge : OutEdges[Node]) {
+			if (Ranks[Edge.Node] > Ranks[Node]) {
+				UpwardEdges[0][Node].Add(Edge);
+			}
+			else {
+				UpwardEdges[1][Edge.Node].Add(FHierarchyEdge{ Node, Edge.Weight, Edge.Middle });
+			}
+		}
+	}
+	bHasContractionHierarchy = true;
+}
+
+template<int32 Dim>
+inline double TSplineGraphRouter<Dim>::GetSplineLength(const FSplineId& Id) const
+{
+	return (IsValidEntry(Id.Index) && SplineEntries[Id.Index].Id == Id) ? SplineEntries[Id.Index].Length : 0.;
+}
+
+template<int32 Dim>
+inline bool TSplineGraphRouter<Dim>::FindRoute(FRoute& OutRoute, const FRouteRequest& Request) const
+{
+	FSearchScratch Scratch;
+	return FindRouteInternal(OutRoute, Request, Scratch);
+}
+
+template<int32 Dim>
+inline void TSplineGraphRouter<Dim>::FindRoutes(TArray<FRoute>& OutRoutes, TArrayView<const FRouteRequest> Requests) const
+{
+	// The scratch is shared by the requests of a chunk.
+	static constexpr int32 ChunkSize = 16;
+	OutRoutes.SetNum(Requests.Num());
+	const int32 ChunkNum = FMath::DivideAndRoundUp(Requests.Num(), ChunkSize);
+	ParallelFor(ChunkNum, [this, &OutRoutes, &Requests](int32 ChunkIndex) {
+		FSearchScratch Scratch;
+		const int32 End = FMath::Min((ChunkIndex + 1) * ChunkSize, Requests.Num());
+		for (int32 i = ChunkIndex * ChunkSize; i < End; ++i) {
+			FindRouteInternal(OutRoutes[i], Requests[i], Scratch);
+		}
+	});
+}
+
+template<int32 Dim>
+inline void TSplineGraphRouter<Dim>::UpdateSpline(const FGraphType& Graph, int32 SplineIndex)
+{
+	if (!SplineEntries.IsValidIndex(SplineIndex)) {
+		return;
+	}
+	FSplineEntry& Entry = SplineEntries[SplineIndex];
+	Entry.bDirty = false;
+
+	const bool bWasValid = Entry.Spline != nullptr;
+	Entry.Id = Graph.GetSplineIdByIndex(SplineIndex);
+	Entry.Spline = Graph.GetSplineById(Entry.Id).Get();
+	if (Entry.Spline && Entry.Spline->GetCtrlPointNum() > 0) {
+		Entry.ParamRange = Entry.Spline->GetParamRange();
+		Entry.Length = Entry.Spline->GetLength(Entry.ParamRange.Get<1>());
+		Entry.EndpointPositions[0] = Entry.Spline->GetPosition(Entry.ParamRange.Get<0>());
+		Entry.EndpointPositions[1] = Entry.Spline->GetPosition(Entry.ParamRange.Get<1>());
+	}
+	else {
+		Entry.Spline = nullptr;
+		Entry.Length = 0.;
+	}
+	if (bWasValid != (Entry.Spline != nullptr)) {
+		bLinksDirty = true;
+	}
+}
+
+template<int32 Dim>
+inline void TSplineGraphRouter<Dim>::RebuildLinks(const FGraphType& Graph)
+{
+	const int32 NodeNum = GetNodeNum();
+	LinkOffsets.Reset(NodeNum + 1);
+	LinkEndpoints.Reset();
+	TArray<int32> ReversedLinkNums;
+	ReversedLinkNums.Init(0, NodeNum);
+	for (int32 Endpoint = 0; Endpoint < NodeNum; ++Endpoint) {
+		LinkOffsets.Add(LinkEndpoints.Num());
+		if (!IsValidEntry(FGraphType::GetEndpointSplineIndex(Endpoint))) {
+			continue;
+		}
+		for (int32 Linked : Graph.GetAdjacentEndpoints(Endpoint)) {
+			if (Linked < NodeNum && IsValidEntry(FGraphType::GetEndpointSplineIndex(Linked))) {
+				LinkEndpoints.Add(Linked);
+				++ReversedLinkNums[Linked];
+			}
+		}
+	}
+	LinkOffsets.Add(LinkEndpoints.Num());
+
+	ReversedLinkOffsets.SetNumUninitialized(NodeNum + 1);
+	ReversedLinkOffsets[0] = 0;
+	for (int32 Endpoint = 0; Endpoint < NodeNum; ++Endpoint) {
+		ReversedLinkOffsets[Endpoint + 1] = ReversedLinkOffsets[Endpoint] + ReversedLinkNums[Endpoint];
+	}
+	ReversedLinkEndpoints.SetNumUninitialized(LinkEndpoints.Num());
+	for (int32 Endpoint = 0; Endpoint < NodeNum; ++Endpoint) {
+		ReversedLinkNums[Endpoint] = ReversedLinkOffsets[Endpoint];
+	}
+	for (int32 Endpoint = 0; Endpoint < NodeNum; ++Endpoint) {
+		for (int32 Linked : GetLinkedEndpoints(Endpoint)) {
+			ReversedLinkEndpoints[ReversedLinkNums[Linked]++] = Endpoint;
+		}
+	}
+	bLinksDirty = false;
+}
+
+template<int32 Dim>
+inline double TSplineGraphRouter<Dim>::GetLengthFromStart(int32 SplineIndex, double Param) const
+{
+	const FSplineEntry& Entry = SplineEntries[SplineIndex];
+	if (Param <= Entry.ParamRange.Get<0>()) {
+		return 0.;
+	}
+	if (Param >= Entry.ParamRange.Get<1>()) {
+		return Entry.Length;
+	}
+	return Entry.Spline->GetLength(Param);
+}
+
+template<int32 Dim>
+inline bool TSplineGraphRouter<Dim>::FindNodePathAStar(TArray<int32>& OutNodes, double& OutLength, const FRouteRequest& Request, double SourceOffset, double TargetOffset, FSearchScratch& Scratch) const
+{
+	const int32 SourceIndex = Request.SourceId.Index;
+	const int32 TargetIndex = Request.TargetId.Index;
+	const FSplineEntry& SourceEntry = SplineEntries[SourceIndex];
+	const FSplineEntry& TargetEntry = SplineEntries[TargetIndex];
+	const TVectorX<Dim> TargetPosition = TargetEntry.Spline->GetPosition(Request.TargetParam);
+
+	Scratch.Reset(GetNodeNum());
+	TArray<double>& Distances = Scratch.Distances[0];
+	TArray<int32>& Parents = Scratch.Parents[0];
+
+	// The straight distance is a lower bound if the connected endpoints are at the same position.
+	auto Heuristic = [&](int32 Node) -> double {
+		const FSplineEntry& Entry = SplineEntries[FGraphType::GetEndpointSplineIndex(Node)];
+		return TVecLib<Dim>::Size(Entry.EndpointPositions[Node & 1] - TargetPosition);
+	};
+	auto Relax = [&](int32 Node, double Distance, int32 Parent) {
+		if (Distance < Distances[Node]) {
+			if (Distances[Node] == TNumericLimits<double>::Max()) {
+				Scratch.Touched[0].Add(Node);
+			}
+			Distances[Node] = Distance;
+			Parents[Node] = Parent;
+			Scratch.Heap.HeapPush(MakeTuple(Distance + Heuristic(Node), Node), SplineGraphRouterUtils::HeapPredicate);
+		}
+	};
+
+	Relax(FGraphType::MakeEndpoint(SourceIndex, EContactType::Start), SourceOffset, INDEX_NONE);
+	Relax(FGraphType::MakeEndpoint(SourceIndex, EContactType::End), SourceEntry.Length - SourceOffset, INDEX_NONE);
+
+	double BestLength = TNumericLimits<double>::Max();
+	int32 BestNode = INDEX_NONE;
+	int32 BestEntry = INDEX_NONE;
+	while (Scratch.Heap.Num() > 0) {
+		TTuple<double, int32> Top;
+		Scratch.Heap.HeapPop(Top, SplineGraphRouterUtils::HeapPredicate, false);
+		if (Top.Get<0>() >= BestLength) {
+			break;
+		}
+		const int32 Node = Top.Get<1>();
+		if (Top.Get<0>() > Distances[Node] + Heuristic(Node)) {
+			continue;
+		}
+		for (int32 Entry : GetLinkedEndpoints(Node)) {
+			const int32 SplineIndex = FGraphType::GetEndpointSplineIndex(Entry);
+			const double SplineLength = SplineEntries[SplineIndex].Length;
+			if (SplineIndex == TargetIndex) {
+				double Length = Distances[Node] + ((Entry & 1) ? SplineLength - TargetOffset : TargetOffset);
+				if (Length < BestLength) {
+					BestLength = Length;
+					BestNode = Node;
+					BestEntry = Entry;
+				}
+			}
+			Relax(Entry ^ 1, Distances[Node] + SplineLength, Node);
+		}
+	}
+
+	if (BestNode == INDEX_NONE) {
+		return false;
+	}
+	OutNodes.Reset();
+	for (int32 Node = BestNode; Node != INDEX_NONE; Node = Parents[Node]) {
+		OutNodes.Add(Node);
+	}
+	Algo::Reverse(OutNodes);
+	OutNodes.Add(BestEntry ^ 1);
+	OutLength = BestLength;
+	return true;
+}
+
+template<int32 Dim>
+inline bool TSplineGraphRouter<Dim>::FindNodePathHierarchy(TArray<int32>& OutNodes, double& OutLength, const FRouteRequest& Request, double SourceOffset, double TargetOffset, FSearchScratch& Scratch) const
+{
+	const int32 SourceIndex = Request.SourceId.Index;
+	const int32 TargetIndex = Request.TargetId.Index;
+	const double TargetLength = SplineEntries[TargetIndex].Length;
+
+	Scratch.Reset(GetNodeNum());
+	auto Relax = [&Scratch](int32 Direction, int32 Node, double Distance, int32 Parent, int32 Seed) {
+		if (Distance < Scratch.Distances[Direction][Node]) {
+			if (Scratch.Distances[Direction][Node] == TNumericLimits<double>::Max()) {
+				Scratch.Touched[Direction].Add(Node);
+			}
+			Scratch.Distances[Direction][Node] = Distance;
+			Scratch.Parents[Direction][Node] = Parent;
+			if (Direction == 1) {
+				Scratch.Seeds[Node] = Seed;
+			}
+			Scratch.Heap.HeapPush(MakeTuple(Distance, Node), SplineGraphRouterUtils::HeapPredicate);
+		}
+	};
+
+	// Forward from the endpoints of the source spline, through the whole upward space.
+	Relax(0, FGraphType::MakeEndpoint(SourceIndex, EContactType::Start), SourceOffset, INDEX_NONE, INDEX_NONE);
+	Relax(0, FGraphType::MakeEndpoint(SourceIndex, EContactType::End), SplineEntries[SourceIndex].Length - SourceOffset, INDEX_NONE, INDEX_NONE);
+	while (Scratch.Heap.Num() > 0) {
+		TTuple<double, int32> Top;
+		Scratch.Heap.HeapPop(Top, SplineGraphRouterUtils::HeapPredicate, false);
+		const int32 Node = Top.Get<1>();
+		if (Top.Get<0>() > Scratch.Distances[0][Node]) {
+			continue;
+		}
+		for (const FHierarchyEdge& Edge : UpwardEdges[0][Node]) {
+			Relax(0, Edge.Node, Top.Get<0>() + Edge.Weight, Node, INDEX_NONE);
+		}
+	}
+
+	// Backward from the endpoints linking to the target spline, so the last entry is implicit.
+	// The entry is kept as the seed, which is passed along the search, so the path ends on the same side.
+	for (int32 c = 0; c < 2; ++c) {
+		const int32 Entry = FGraphType::MakeEndpoint(TargetIndex, c == 0 ? EContactType::Start : EContactType::End);
+		const double EntryToTarget = c == 0 ? TargetOffset : TargetLength - TargetOffset;
+		for (int32 Node : GetReversedLinkedEndpoints(Entry)) {
+			Relax(1, Node, EntryToTarget, INDEX_NONE, Entry);
+		}
+	}
+	double BestLength = TNumericLimits<double>::Max();
+	int32 MeetingNode = INDEX_NONE;
+	while (Scratch.Heap.Num() > 0) {
+		TTuple<double, int32> Top;
+		Scratch.Heap.HeapPop(Top, SplineGraphRouterUtils::HeapPredicate, false);
+		if (Top.Get<0>() >= BestLength) {
+			break;
+		}
+		const int32 Node = Top.Get<1>();
+		if (Top.Get<0>() > Scratch.Distances[1][Node]) {
+			continue;
+		}
+		if (Scratch.Distances[0][Node] != TNumericLimits<double>::Max()) {
+			double Length = Scratch.Distances[0][Node] + Top.Get<0>();
+			if (Length < BestLength) {
+				BestLength = Length;
+				MeetingNode = Node;
+			}
+		}
+		for (const FHierarchyEdge& Edge : UpwardEdges[1][Node]) {
+			Relax(1, Edge.Node, Top.Get<0>() + Edge.Weight, Node, Scratch.Seeds[Node]);
+		}
+	}
+
+	if (MeetingNode == INDEX_NONE) {
+		return false;
+	}
+
+	TArray<int32, TInlineAllocator<16> > UpNodes;
+	for (int32 Node = MeetingNode; Node != INDEX_NONE; Node = Scratch.Parents[0][Node]) {
+		UpNodes.Add(Node);
+	}
+	OutNodes.Reset();
+	OutNodes.Add(UpNodes.Last());
+	for (int32 i = UpNodes.Num() - 1; i > 0; --i) {
+		UnpackHierarchyEdge(OutNodes, UpNodes[i], UpNodes[i - 1]);
+	}
+	int32 LastNode = MeetingNode;
+	for (int32 Node = Scratch.Parents[1][MeetingNode]; Node != INDEX_NONE; Node = Scratch.Parents[1][Node]) {
+		UnpackHierarchyEdge(OutNodes, LastNode, Node);
+		LastNode = Node;
+	}
+	OutNodes.Add(Scratch.Seeds[MeetingNode] ^ 1);
+	OutLength = BestLength;
+	return true;
+}
+
+template<int32 Dim>
+inline bool TSplineGraphRouter<Dim>::FindRouteInternal(FRoute& OutRoute, const FRouteRequest& Request, FSearchScratch& Scratch) const
+{
+	OutRoute.Segments.Reset();
+	OutRoute.Length = -1.;
+
+	const int32 SourceIndex = Request.SourceId.Index;
+	const int32 TargetIndex = Request.TargetId.Index;
+	if (!IsValidEntry(SourceIndex) || SplineEntries[SourceIndex].Id != Request.SourceId ||
+		!IsValidEntry(TargetIndex) || SplineEntries[TargetIndex].Id != Request.TargetId) {
+		return false;
+	}
+	const FSplineEntry& SourceEntry = SplineEntries[SourceIndex];
+	const FSplineEntry& TargetEntry = SplineEntries[TargetIndex];
+	const double SourceParam = FMath::Clamp(Request.SourceParam, SourceEntry.ParamRange.Get<0>(), SourceEntry.ParamRange.Get<1>());
+	const double TargetParam = FMath::Clamp(Request.TargetParam, TargetEntry.ParamRange.Get<0>(), TargetEntry.ParamRange.Get<1>());
+	const double SourceOffset = GetLengthFromStart(SourceIndex, SourceParam);
+	const double TargetOffset = GetLengthFromStart(TargetIndex, TargetParam);
+
+	TArray<int32> NodePath;
+	double PathLength = TNumericLimits<double>::Max();
+	FRouteRequest ClampedRequest{ Request.SourceId, SourceParam, Request.TargetId, TargetParam };
+	bool bFound = bHasContractionHierarchy ?
+		FindNodePathHierarchy(NodePath, PathLength, ClampedRequest, SourceOffset, TargetOffset, Scratch) :
+		FindNodePathAStar(NodePath, PathLength, ClampedRequest, SourceOffset, TargetOffset, Scratch);
+
+	// Along the spline itself.
+	if (SourceIndex == TargetIndex) {
+		double DirectLength = FMath::Abs(TargetOffset - SourceOffset);
+		if (!bFound || DirectLength <= PathLength) {
+			OutRoute.Segments.Add(FRouteSegment{ Request.SourceId, TargetParam >= SourceParam ? EContactType::End : EContactType::Start, MakeTuple(SourceParam, TargetParam) });
+			OutRoute.Length = DirectLength;
+			return true;
+		}
+	}
+	if (!bFound || NodePath.Num() < 2) {
+		return false;
+	}
+
+	auto AddSegment = [this, &OutRoute](int32 SplineIndex, EContactType Direction, double ParamFrom, double ParamTo, bool bSkipIfEmpty) {
+		if (bSkipIfEmpty && FMath::IsNearlyEqual(ParamFrom, ParamTo)) {
+			return;
+		}
+		OutRoute.Segments.Add(FRouteSegment{ SplineEntries[SplineIndex].Id, Direction, MakeTuple(ParamFrom, ParamTo) });
+	};
+	const int32 FirstNode = NodePath[0];
+	AddSegment(SourceIndex, FGraphType::GetEndpointContactType(FirstNode), SourceParam, GetEndpointParam(FirstNode), true);
+	for (int32 i = 1; i < NodePath.Num() - 1; ++i) {
+		const int32 Node = NodePath[i];
+		AddSegment(FGraphType::GetEndpointSplineIndex(Node), FGraphType::GetEndpointContactType(Node), GetEndpointParam(Node ^ 1), GetEndpointParam(Node), false);
+	}
+	const int32 LastNode = NodePath.Last();
+	AddSegment(TargetIndex, FGraphType::GetEndpointContactType(LastNode), GetEndpointParam(LastNode ^ 1), TargetParam, true);
+	OutRoute.Length = PathLength;
+	return true;
+}
+
+template<int32 Dim>
+inline const typename TSplineGraphRouter<Dim>::FHierarchyEdge* TSplineGraphRouter<Dim>::FindHierarchyEdge(int32 From, int32 To) const
+{
+	for (const FHierarchyEdge& Edge : UpwardEdges[0][From]) {
+		if (Edge.Node == To) {
+			return &Edge;
+		}
+	}
+	for (const FHierarchyEdge& Edge : UpwardEdges[1][To]) {
+		if (Edge.Node == From) {
+			return &Edge;
+		}
+	}
+	return nullptr;
+}
+
+template<int32 Dim>
+inline void TSplineGraphRouter<Dim>::UnpackHierarchyEdge(TArray<int32>& OutNodes, int32 From, int32 To) const
+{
+	const FHierarchyEdge* Edge = FindHierarchyEdge(From, To);
+	if (!Edge || Edge->Middle == INDEX_NONE) {
+		OutNodes.Add(To);
+		return;
+	}
+	const int32 Middle = Edge->Middle;
+	UnpackHierarchyEdge(OutNodes, From, Middle);
+	UnpackHierarchyEdge(OutNodes, Middle, To);
+}
@@ -0,0 +1,89 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BezierString.h"
+#include "BSpline.h"
+
+// Immutable version of a spline in bezier form, for readers on other threads (e.g. the render thread).
+// A new version is created on the game thread after each edit, sharing the unchanged chunks of segments
+// and the control polygon with the previous version. Readers only hold a reference, without copy or lock.
+template<int32 Dim>
+class TSplineSnapshot
+{
+public:
+	using FSplineType = typename TSplineBase<Dim, 3>;
+	using FCurveType = typename TBezierCurve<Dim, 3>;
+	using FSnapshotRef = typename TSharedRef<const TSplineSnapshot<Dim>, ESPMode::ThreadSafe>;
+	using FSnapshotPtr = typename TSharedPtr<const TSplineSnapshot<Dim>, ESPMode::ThreadSafe>;
+
+	static constexpr int32 ChunkSize = 16;
+
+	struct FChunk
+	{
+		TArray<FCurveType> Curves;
+		TArray<TTuple<double, double> > ParamRanges;
+	};
+
+	// Control points for drawing. The previous and next points are only for bezier strings.
+	struct FControlPolygon
+	{
+		TArray<TVectorX<Dim> > Points;
+		TArray<TVectorX<Dim> > PrevPoints;
+		TArray<TVectorX<Dim> > NextPoints;
+	};
+
+	using FChunkRef = typename TSharedRef<const FChunk, ESPMode::ThreadSafe>;
+	using FControlPolygonRef = typename TSharedRef<const FControlPolygon, ESPMode::ThreadSafe>;
+
+public:
+	// Only on the thread editing the spline.
+	static FSnapshotRef Create(const FSplineType& Spline, const FSnapshotPtr& Previous = nullptr);
+
+	FORCEINLINE ESplineType GetType() const { return Type; }
+
+	FORCEINLINE uint32 GetVersion() const { return Version; }
+
+	FORCEINLINE const TTuple<double, double>& GetParamRange() const { return ParamRange; }
+
+	FORCEINLINE int32 GetSegmentNum() const { return SegmentNum; }
+
+	FORCEINLINE const FCurveType& GetCurve(int32 Segment) const { return Chunks[Segment / ChunkSize]->Curves[Segment % ChunkSize]; }
+
+	FORCEINLINE const TTuple<double, double>& GetSegmentParamRange(int32 Segment) const { return Chunks[Segment / ChunkSize]->ParamRanges[Segment % ChunkSize]; }
+
+	FORCEINLINE const FControlPolygon& GetControlPolygon() const { return ControlPolygon.Get(); }
+
+	// Segment containing the parameter, by binary search.
+	int32 FindSegment(double T) const;
+
+	TVectorX<Dim> GetPosition(double T) const;
+
+	TVectorX<Dim> GetTangent(double T) const;
+
+	// Same as TSplineBase::GetSegParams.
+	void GetSegParams(TArray<double>& OutParameters) const;
+
+	// Evenly sample each segment with ceil(1 / SegParamLength) steps, like URuntimeCustomSplineBaseComponent::SampleParameters.
+	void SamplePositionsBySegment(TArray<TVectorX<Dim> >& OutPositions, double SegParamLength) const;
+
+protected:
+	TSplineSnapshot(const FControlPolygonRef& InControlPolygon)
+		: ControlPolygon(InControlPolygon)
+	{}
+
+	static bool IsSameChunk(const FChunk& Chunk, const TArray<FCurveType>& Curves, const TArray<TTuple<double, double> >& ParamRanges, int32 First);
+
+	static bool IsSameControlPolygon(const FControlPolygon& A, const FControlPolygon& B);
+
+	ESplineType Type = ESplineType::Unknown;
+	uint32 Version = 0;
+	TTuple<double, double> ParamRange = MakeTuple(0., 0.);
+	int32 SegmentNum = 0;
+	TArray<FChunkRef> Chunks;
+	FControlPolygonRef ControlPolygon;
+};
+
+#include "SplineSnapshot.inl"
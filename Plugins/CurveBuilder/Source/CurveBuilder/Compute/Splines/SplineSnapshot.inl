@@ -0,0 +1,181 @@
+// Copyright 2020 PacosLelouch, Inc. All Rights Reserved.
+// https://github.com/PacosLelouch/
+
+#pragma once
+
+template<int32 Dim>
+inline typename TSplineSnapshot<Dim>::FSnapshotRef TSplineSnapshot<Dim>::Create(const FSplineType& Spline, const FSnapshotPtr& Previous)
+{
+	// Control polygon.
+	TSharedRef<FControlPolygon, ESPMode::ThreadSafe> NewControlPolygon = MakeShared<FControlPolygon, ESPMode::ThreadSafe>();
+	{
+		TArray<TVectorX<Dim+1> > HomogeneousPoints;
+		auto ProjectPoints = [&HomogeneousPoints](TArray<TVectorX<Dim> >& OutPoints) {
+			OutPoints.Reset(HomogeneousPoints.Num());
+			for (const TVectorX<Dim+1>& P : HomogeneousPoints) {
+				OutPoints.Add(TVecLib<Dim+1>::Projection(P));
+			}
+		};
+		switch (Spline.GetType()) {
+		case ESplineType::ClampedBSpline:
+		{
+			const auto& BSpline = static_cast<const typename TSplineTraitByType<ESplineType::ClampedBSpline, Dim, 3>::FSplineType&>(Spline);
+			BSpline.GetCtrlPoints(HomogeneousPoints);
+			ProjectPoints(NewControlPolygon->Points);
+		}
+		break;
+		case ESplineType::BezierString:
+		{
+			const auto& BezierString = static_cast<const typename TSplineTraitByType<ESplineType::BezierString, Dim, 3>::FSplineType&>(Spline);
+			BezierString.GetCtrlPoints(HomogeneousPoints);
+			ProjectPoints(NewControlPolygon->Points);
+			BezierString.GetCtrlPointsPrev(HomogeneousPoints);
+			ProjectPoints(NewControlPolygon->PrevPoints);
+			BezierString.GetCtrlPointsNext(HomogeneousPoints);
+			ProjectPoints(NewControlPolygon->NextPoints);
+		}
+		break;
+		}
+	}
+
+	const bool bSameControlPolygon = Previous.IsValid() && IsSameControlPolygon(Previous->ControlPolygon.Get(), NewControlPolygon.Get());
+	FControlPolygonRef ControlPolygonToUse = bSameControlPolygon ? Previous->ControlPolygon : FControlPolygonRef(NewControlPolygon);
+	TSharedRef<TSplineSnapshot<Dim>, ESPMode::ThreadSafe> Snapshot = MakeShareable(new TSplineSnapshot<Dim>(ControlPolygonToUse));
+	Snapshot->Type = Spline.GetType();
+	Snapshot->Version = Previous.IsValid() ? Previous->Version + 1 : 1;
+	Snapshot->ParamRange = Spline.GetParamRange();
+
+	// Segments, sharing the chunks which are not changed.
+	TArray<FCurveType> Curves;
+	TArray<TTuple<double, double> > ParamRanges;
+	if (!Spline.ToBezierCurves(Curves, &ParamRanges) || Curves.Num() != ParamRanges.Num()) {
+		Curves.Reset();
+		ParamRanges.Reset();
+	}
+	Snapshot->SegmentNum = Curves.Num();
+	const int32 ChunkNum = FMath::DivideAndRoundUp(Curves.Num(), ChunkSize);
+	Snapshot->Chunks.Reserve(ChunkNum);
+	bool bChanged = !bSameControlPolygon || Previous->Type != Snapshot->Type || Previous->ParamRange != Snapshot->ParamRange || Previous->Chunks.Num() != ChunkNum;
+	for (int32 c = 0; c < ChunkNum; ++c) {
+		const int32 First = c * ChunkSize;
+		if (Previous.IsValid() && Previous->Chunks.IsValidIndex(c) && IsSameChunk(Previous->Chunks[c].Get(), Curves, ParamRanges, First)) {
+			Snapshot->Chunks.Add(Previous->Chunks[c]);
+			continue;
+		}
+		bChanged = true;
+		const int32 Count = FMath::Min(ChunkSize, Curves.Num() - First);
+		TSharedRef<FChunk, ESPMode::ThreadSafe> NewChunk = MakeShared<FChunk, ESPMode::ThreadSafe>();
+		NewChunk->Curves.Append(Curves.GetData() + First, Count);
+		NewChunk->ParamRanges.Append(ParamRanges.GetData() + First, Count);
+		Snapshot->Chunks.Add(NewChunk);
+	}
+	// Keep the previous version if nothing is changed.
+	return bChanged ? FSnapshotRef(Snapshot) : Previous.ToSharedRef();
+}
+
+template<int32 Dim>
+inline int32 TSplineSnapshot<Dim>::FindSegment(double T) const
+{
+	if (SegmentNum == 0) {
+		return INDEX_NONE;
+	}
+	int32 Low = 0, High = SegmentNum - 1;
+	while (Low < High) {
+		int32 Mid = (Low + High + 1) >> 1;
+		if (GetSegmentParamRange(Mid).Get<0>() <= T) {
+			Low = Mid;
+		}
+		else {
+			High = Mid - 1;
+		}
+	}
+	return Low;
+}
+
+template<int32 Dim>
+inline TVectorX<Dim> TSplineSnapshot<Dim>::GetPosition(double T) const
+{
+	int32 Segment = FindSegment(T);
+	if (Segment == INDEX_NONE) {
+		const FControlPolygon& Polygon = ControlPolygon.Get();
+		return Polygon.Points.Num() > 0 ? Polygon.Points[0] : TVecLib<Dim>::Zero();
+	}
+	const TTuple<double, double>& Range = GetSegmentParamRange(Segment);
+	double Diff = Range.Get<1>() - Range.Get<0>();
+	double U = FMath::IsNearlyZero(Diff) ? 0. : FMath::Clamp((T - Range.Get<0>()) / Diff, 0., 1.);
+	return GetCurve(Segment).GetPosition(U);
+}
+
+template<int32 Dim>
+inline TVectorX<Dim> TSplineSnapshot<Dim>::GetTangent(double T) const
+{
+	int32 Segment = FindSegment(T);
+	if (Segment == INDEX_NONE) {
+		return TVecLib<Dim>::Zero();
+	}
+	const TTuple<double, double>& Range = GetSegmentParamRange(Segment);
+	double Diff = Range.Get<1>() - Range.Get<0>();
+	if (FMath::IsNearlyZero(Diff)) {
+		return GetCurve(Segment).GetTangent(0.);
+	}
+	double U = FMath::Clamp((T - Range.Get<0>()) / Diff, 0., 1.);
+	return GetCurve(Segment).GetTangent(U) / Diff;
+}
+
+template<int32 Dim>
+inline void TSplineSnapshot<Dim>::GetSegParams(TArray<double>& OutParameters) const
+{
+	OutParameters.Reset(SegmentNum + 1);
+	for (int32 i = 0; i < SegmentNum; ++i) {
+		OutParameters.Add(GetSegmentParamRange(i).Get<0>());
+	}
+	if (SegmentNum > 0) {
+		OutParameters.Add(GetSegmentParamRange(SegmentNum - 1).Get<1>());
+	}
+}
+
+template<int32 Dim>
+inline void TSplineSnapshot<Dim>::SamplePositionsBySegment(TArray<TVectorX<Dim> >& OutPositions, double SegParamLength) const
+{
+	OutPositions.Reset();
+	if (SegmentNum == 0) {
+		OutPositions.Add(GetPosition(ParamRange.Get<0>()));
+		return;
+	}
+	const int32 StepNum = FMath::Max(FMath::CeilToInt(1. / FMath::Max(SegParamLength, KINDA_SMALL_NUMBER)), 1);
+	const double InvStepNum = 1. / static_cast<double>(StepNum);
+	OutPositions.Reserve(SegmentNum * StepNum + 1);
+	OutPositions.Add(GetCurve(0).GetPosition(0.));
+	for (int32 i = 0; i < SegmentNum; ++i) {
+		const FCurveType& Curve = GetCurve(i);
+		for (int32 Step = 1; Step <= StepNum; ++Step) {
+			OutPositions.Add(Curve.GetPosition(Step * InvStepNum));
+		}
+	}
+}
+
+template<int32 Dim>
+inline bool TSplineSnapshot<Dim>::IsSameChunk(const FChunk& Chunk, const TArray<FCurveType>& Curves, const TArray<TTuple<double, double> >& ParamRanges, int32 First)
+{
+	const int32 Count = FMath::Min(ChunkSize, Curves.Num() - First);
+	if (Chunk.Curves.Num() != Count) {
+		return false;
+	}
+	for (int32 i = 0; i < Count; ++i) {
+		if (Chunk.ParamRanges[i] != ParamRanges[First + i]) {
+			return false;
+		}
+		for (int32 j = 0; j <= 3; ++j) {
+			if (Chunk.Curves[i].GetPointHomogeneous(j) != Curves[First + i].GetPointHomogeneous(j)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+template<int32 Dim>
+inline bool TSplineSnapshot<Dim>::IsSameControlPolygon(const FControlPolygon& A, const FControlPolygon& B)
+{
+	return A.Points == B.Points && A.PrevPoints == B.PrevPoints && A.NextPoints == B.NextPoints;
+}
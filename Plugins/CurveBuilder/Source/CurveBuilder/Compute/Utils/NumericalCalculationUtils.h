@@ -51,6 +51,248 @@ protected:
 	TFunction<TVectorX<Dim>(double)> GetValue, GetDerivative;
 };
 
+// Thomas algorithm for tridiagonal linear equations. O(n) instead of dense LU.
+// Lower[0] and Upper[Num - 1] are ignored. InOutValues is the right side, and receives the solution.
+// TValue can be a scalar or a vector, so that all components are solved in one sweep.
+namespace TridiagonalEquationSolver
+{
+	template<typename TValue>
+	inline void Solve(TArray<TValue>& InOutValues, const TArray<double>& Lower, const TArray<double>& Diag, const TArray<double>& Upper)
+	{
+		const int32 Num = InOutValues.Num();
+		if (Num == 0) {
+			return;
+		}
+		TArray<double> ModifiedUpper;
+		ModifiedUpper.SetNumUninitialized(Num);
+
+		double InvDenominator = 1. / Diag[0];
+		ModifiedUpper[0] = Upper[0] * InvDenominator;
+		InOutValues[0] = InOutValues[0] * InvDenominator;
+		for (int32 i = 1; i < Num; ++i) {
+			InvDenominator = 1. / (Diag[i] - Lower[i] * ModifiedUpper[i - 1]);
+			ModifiedUpper[i] = Upper[i] * InvDenominator;
+			InOutValues[i] = (InOutValues[i] - InOutValues[i - 1] * Lower[i]) * InvDenominator;
+		}
+		for (int32 i = Num - 2; i >= 0; --i) {
+			InOutValues[i] = InOutValues[i] - InOutValues[i + 1] * ModifiedUpper[i];
+		}
+	}
+
+	// Cyclic version by Sherman-Morrison formula, for closed curves.
+	// Lower[0] is the top-right corner, and Upper[Num - 1] is the bottom-left corner.
+	// Reference: Numerical Recipes, 2.7 Sparse Linear Systems, Cyclic Tridiagonal Systems.
+	template<typename TValue>
+	inline void SolveCyclic(TArray<TValue>& InOutValues, const TArray<double>& Lower, const TArray<double>& Diag, const TArray<double>& Upper)
+	{
+		const int32 Num = InOutValues.Num();
+		if (Num < 3) {
+			// The corners are merged into the ordinary off-diagonal terms.
+			TArray<double> MergedLower(Lower), MergedUpper(Upper);
+			if (Num == 2) {
+				MergedUpper[0] += Lower[0];
+				MergedLower[1] += Upper[1];
+			}
+			Solve(InOutValues, MergedLower, Diag, MergedUpper);
+			return;
+		}
+
+		const double Gamma = -Diag[0];
+		const double CornerRatio = Lower[0] / Gamma;
+		TArray<double> ModifiedDiag(Diag);
+		ModifiedDiag[0] -= Gamma;
+		ModifiedDiag[Num - 1] -= Upper[Num - 1] * CornerRatio;
+
+		TArray<double> Correction;
+		Correction.Init(0., Num);
+		Correction[0] = Gamma;
+		Correction[Num - 1] = Upper[Num - 1];
+
+		Solve(InOutValues, Lower, ModifiedDiag, Upper);
+		Solve(Correction, Lower, ModifiedDiag, Upper);
+
+		const double InvDenominator = 1. / (1. + Correction[0] + Correction[Num - 1] * CornerRatio);
+		const TValue Factor = (InOutValues[0] + InOutValues[Num - 1] * CornerRatio) * InvDenominator;
+		for (int32 i = 0; i < Num; ++i) {
+			InOutValues[i] = InOutValues[i] - Factor * Correction[i];
+		}
+	}
+};
+
+// Polynomials in power basis, with the coefficients from the constant term.
+// Real roots inside a range are isolated by Sturm sequences and refined by bisection, for low degrees (e.g. of the derivatives of bezier curves).
+// The roots at the ends of the range may be missed, so check the ends separately.
+namespace PolynomialSolver
+{
+	inline double Evaluate(const TArray<double>& Coefficients, double X)
+	{
+		double Value = 0.;
+		for (int32 i = Coefficients.Num() - 1; i >= 0; --i) {
+			Value = Value * X + Coefficients[i];
+		}
+		return Value;
+	}
+
+	inline void Add(TArray<double>& Out, const TArray<double>& A, const TArray<double>& B, double ScaleB = 1.)
+	{
+		Out.Init(0., FMath::Max(A.Num(), B.Num()));
+		for (int32 i = 0; i < A.Num(); ++i) {
+			Out[i] += A[i];
+		}
+		for (int32 i = 0; i < B.Num(); ++i) {
+			Out[i] += B[i] * ScaleB;
+		}
+	}
+
+	inline void Multiply(TArray<double>& Out, const TArray<double>& A, const TArray<double>& B)
+	{
+		Out.Reset();
+		if (A.Num() == 0 || B.Num() == 0) {
+			return;
+		}
+		Out.Init(0., A.Num() + B.Num() - 1);
+		for (int32 i = 0; i < A.Num(); ++i) {
+			for (int32 j = 0; j < B.Num(); ++j) {
+				Out[i + j] += A[i] * B[j];
+			}
+		}
+	}
+
+	inline void Derivative(TArray<double>& Out, const TArray<double>& A)
+	{
+		Out.Reset(FMath::Max(A.Num() - 1, 0));
+		for (int32 i = 1; i < A.Num(); ++i) {
+			Out.Add(A[i] * i);
+		}
+	}
+
+	// Drop the leading coefficients which are nearly zero relative to the largest one.
+	inline void Trim(TArray<double>& InOutCoefficients, double RelativeTolerance = 1e-12)
+	{
+		double MaxAbs = 0.;
+		for (double Coefficient : InOutCoefficients) {
+			MaxAbs = FMath::Max(MaxAbs, FMath::Abs(Coefficient));
+		}
+		const double Threshold = MaxAbs * RelativeTolerance;
+		int32 Num = InOutCoefficients.Num();
+		while (Num > 0 && FMath::Abs(InOutCoefficients[Num - 1]) <= Threshold) {
+			--Num;
+		}
+		InOutCoefficients.SetNum(Num, false);
+	}
+
+	inline void FindRoots(TArray<double>& OutRoots, const TArray<double>& Coefficients, double Low, double High, double Tolerance = 1e-10)
+	{
+		OutRoots.Reset();
+		TArray<TArray<double>, TInlineAllocator<16> > Sequence;
+		Sequence.Add(Coefficients);
+		Trim(Sequence[0]);
+		if (Sequence[0].Num() < 2 || High <= Low) {
+			return;
+		}
+
+		// Sturm sequence. P(i+1) = -rem(P(i-1), P(i)). Each one is scaled to keep the magnitude.
+		auto Normalize = [](TArray<double>& P) {
+			double MaxAbs = 0.;
+			for (double C : P) {
+				MaxAbs = FMath::Max(MaxAbs, FMath::Abs(C));
+			}
+			if (MaxAbs > 0.) {
+				for (double& C : P) {
+					C /= MaxAbs;
+				}
+			}
+		};
+		Normalize(Sequence[0]);
+		Sequence.AddDefaulted();
+		Derivative(Sequence[1], Sequence[0]);
+		Normalize(Sequence[1]);
+		while (Sequence.Last().Num() > 1) {
+			TArray<double> Remainder = Sequence[Sequence.Num() - 2];
+			const TArray<double>& Divisor = Sequence.Last();
+			const int32 DivisorDegree = Divisor.Num() - 1;
+			for (int32 i = Remainder.Num() - 1; i >= DivisorDegree; --i) {
+				const double Factor = Remainder[i] / Divisor[DivisorDegree];
+				for (int32 j = 0; j <= DivisorDegree; ++j) {
+					Remainder[i - DivisorDegree + j] -= Factor * Divisor[j];
+				}
+			}
+			Remainder.SetNum(DivisorDegree, false);
+			Trim(Remainder, 1e-10);
+			if (Remainder.Num() == 0) {
+				break;
+			}
+			for (double& C : Remainder) {
+				C = -C;
+			}
+			Normalize(Remainder);
+			Sequence.Add(MoveTemp(Remainder));
+		}
+
+		auto CountSignChanges = [&Sequence](double X) -> int32 {
+			int32 Changes = 0;
+			double LastSign = 0.;
+			for (const TArray<double>& P : Sequence) {
+				const double Value = Evaluate(P, X);
+				if (Value != 0.) {
+					const double Sign = FMath::Sign(Value);
+					Changes += LastSign * Sign < 0. ? 1 : 0;
+					LastSign = Sign;
+				}
+			}
+			return Changes;
+		};
+
+		// Isolate the roots in (Low, High], then bisect each one.
+		struct FInterval
+		{
+			double A, B;
+			int32 ChangesA, ChangesB;
+		};
+		TArray<FInterval, TInlineAllocator<16> > Stack;
+		Stack.Add(FInterval{ Low, High, CountSignChanges(Low), CountSignChanges(High) });
+		const TArray<double>& P = Sequence[0];
+		while (Stack.Num() > 0) {
+			const FInterval Interval = Stack.Pop(false);
+			const int32 RootNum = Interval.ChangesA - Interval.ChangesB;
+			if (RootNum <= 0) {
+				continue;
+			}
+			double A = Interval.A, B = Interval.B;
+			double ValueA = Evaluate(P, A), ValueB = Evaluate(P, B);
+			if (B - A <= Tolerance) {
+				OutRoots.Add((A + B) * 0.5);
+				continue;
+			}
+			if (RootNum == 1 && ValueA * ValueB < 0.) {
+				while (B - A > Tolerance) {
+					const double Mid = (A + B) * 0.5;
+					const double ValueMid = Evaluate(P, Mid);
+					if (ValueMid == 0.) {
+						A = B = Mid;
+						break;
+					}
+					if (ValueA * ValueMid < 0.) {
+						B = Mid;
+						ValueB = ValueMid;
+					}
+					else {
+						A = Mid;
+						ValueA = ValueMid;
+					}
+				}
+				OutRoots.Add((A + B) * 0.5);
+				continue;
+			}
+			const double Mid = (A + B) * 0.5;
+			const int32 ChangesMid = CountSignChanges(Mid);
+			Stack.Add(FInterval{ Mid, B, ChangesMid, Interval.ChangesB });
+			Stack.Add(FInterval{ A, Mid, Interval.ChangesA, ChangesMid });
+		}
+		OutRoots.Sort();
+	}
+};
+
 // Gauss-Legendre integrator. Currently only for n = 5.
 template<int32 N = NumericalCalculationConst::GaussLegendreN>
 class TGaussLegendre;
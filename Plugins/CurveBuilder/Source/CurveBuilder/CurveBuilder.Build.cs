@@ -57,6 +57,7 @@ public class CurveBuilder : ModuleRules
 				"SlateCore",
 				"InputCore",
 				"RHI",
+				"ProceduralMeshComponent",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -5,6 +5,9 @@
 #include "RuntimeCustomSplineBaseComponent.h"
 #include "RuntimeSplinePointBaseComponent.h"
 #include "SceneProxies/RuntimeCustomSplineSceneProxy.h"
+#include "../Compute/Splines/SplineFrameTable.h"
+#include "../Compute/CurveOperations/SplineSweep.h"
+#include "ProceduralMeshComponent.h"
 #include "PhysicsEngine/BodySetup.h"
 #include "Engine/StaticMesh.h"
 #include "Components/SplineMeshComponent.h"
@@ -14,6 +17,10 @@ UIndividualCustomSplineBaseComponent::UIndividualCustomSplineBaseComponent(const
 	: Super(ObjectInitializer), OriginalMethod(CreationMethod)
 {
 	
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	bTickInEditor = true;
+
 	ConstructorHelpers::FObjectFinder<UStaticMesh> StaticMeshFinder(TEXT("StaticMesh'/Engine/EditorLandscapeResources/SplineEditorMesh.SplineEditorMesh'"));
 	if (StaticMeshFinder.Succeeded())
 	{
@@ -272,45 +279,235 @@ void UIndividualCustomSplineBaseComponent::InitIndividualSpline()
 
 void UIndividualCustomSplineBaseComponent::GenerateSplineMeshes()
 {
+	bSplineMeshesDirty = false;
+	if (bGenerateSweptMesh)
+	{
+		GenerateSweptMesh();
+		return;
+	}
 	AActor* Owner = GetOwner();
 	UWorld* World = GetWorld();
 	if (IsValid(StaticMeshForSpline) && IsValid(SplineComponent) && !SplineComponent->IsBeingDestroyed()
 		&& IsValid(Owner) && !Owner->IsActorBeingDestroyed() && IsValid(World))
 	{
-		for (auto It = SplineMeshes.CreateIterator(); It; ++It)
+		DestroySweptMesh();
+		TArray<FVector> Positions, ArriveTangents, LeaveTangents;
+		SplineComponent->GetHermiteForms(Positions, ArriveTangents, LeaveTangents, ECustomSplineCoordinateType::World);
+
+		TSplineFrameTable<3> Frames;
+		if (bRotationMinimizingRoll && SplineComponent->GetSplineProxy())
+		{
+			Frames.Build(*SplineComponent->GetSplineProxy());
+		}
+		const bool bUseFrames = Frames.GetArcLengthTable().GetSegmentNum() == Positions.Num() - 1;
+		const FTransform SplineLocalToWorld = SplineComponent->GetSplineLocalToWorldTransform();
+		auto GetRoll = [&Frames, &SplineLocalToWorld](USplineMeshComponent* SplineMesh, double Param) -> float
+		{
+			const TSplineFrameTable<3>::FFrame Frame = Frames.GetFrame(Param);
+			return static_cast<float>(TSplineFrameTable<3>::GetRollAroundTangent(
+				SplineLocalToWorld.TransformVector(Frame.Tangent),
+				SplineLocalToWorld.TransformVectorNoScale(Frame.Normal),
+				SplineMesh->GetSplineUpDir()));
+		};
+
+		// Keep the components of the previous update, and only update the segments which are changed.
+		const int32 SegmentNum = FMath::Max(0, Positions.Num() - 1);
+		const ECollisionEnabled::Type DefaultCollision = GetDefault<USplineMeshComponent>()->GetCollisionEnabled();
+		if (SplineMeshPool.Num() != SplineMeshes.Num())
+		{
+			// E.g. the meshes are loaded without the pool.
+			SplineMeshPool.RemoveAll([this](USplineMeshComponent* SplineMesh) { return !SplineMeshes.Contains(SplineMesh); });
+			for (USplineMeshComponent* SplineMesh : SplineMeshes)
+			{
+				SplineMeshPool.AddUnique(SplineMesh);
+			}
+		}
+		SplineMeshPool.SetNum(FMath::Max(SplineMeshPool.Num(), SegmentNum));
+		// Unwrapped along the spline, so the joints share the rolls and no segment twists by a full turn.
+		float PrevRoll = 0.f;
+		for (int32 i = 0; i < SegmentNum; ++i)
+		{
+			USplineMeshComponent*& SplineMesh = SplineMeshPool[i];
+			bool bNewMesh = false;
+			if (!IsValid(SplineMesh))
+			{
+				SplineMeshes.Remove(SplineMesh);
+				SplineMesh = NewObject<USplineMeshComponent>(this);
+				SplineMesh->Mobility = Mobility;
+				SplineMesh->AttachToComponent(this, FAttachmentTransformRules::KeepRelativeTransform);
+				SplineMesh->SetStaticMesh(StaticMeshForSpline);
+				SplineMesh->SetWorldLocation(Positions[i]);
+				Owner->AddInstanceComponent(SplineMesh);
+				SplineMesh->RegisterComponent();
+				SplineMeshes.Add(SplineMesh);
+				bNewMesh = true;
+			}
+			else if (!SplineMesh->IsVisible())
+			{
+				SplineMesh->SetVisibility(true);
+				SplineMesh->SetCollisionEnabled(DefaultCollision);
+			}
+			if (SplineMesh->GetStaticMesh() != StaticMeshForSpline)
+			{
+				SplineMesh->SetStaticMesh(StaticMeshForSpline);
+			}
+			if (!SplineMesh->GetComponentLocation().Equals(Positions[i]))
+			{
+				SplineMesh->SetWorldLocation(Positions[i]);
+			}
+
+			const FVector EndPosition = Positions[i + 1] - Positions[i];
+			float StartRoll = 0.f, EndRoll = 0.f;
+			if (bUseFrames)
+			{
+				const TTuple<double, double>& ParamRange = Frames.GetArcLengthTable().GetSegmentParamRange(i);
+				StartRoll = GetRoll(SplineMesh, ParamRange.Get<0>());
+				if (i > 0)
+				{
+					StartRoll = static_cast<float>(TSplineFrameTable<3>::UnwrapRoll(StartRoll, PrevRoll));
+				}
+				EndRoll = static_cast<float>(TSplineFrameTable<3>::UnwrapRoll(GetRoll(SplineMesh, ParamRange.Get<1>()), StartRoll));
+				PrevRoll = EndRoll;
+			}
+			// The rolls are set before the first UpdateMesh() of a new mesh.
+			if (bNewMesh
+				|| !SplineMesh->GetStartPosition().Equals(FVector::ZeroVector)
+				|| !SplineMesh->GetStartTangent().Equals(LeaveTangents[i])
+				|| !SplineMesh->GetEndPosition().Equals(EndPosition)
+				|| !SplineMesh->GetEndTangent().Equals(ArriveTangents[i + 1])
+				|| !FMath::IsNearlyEqual(SplineMesh->GetStartRoll(), StartRoll)
+				|| !FMath::IsNearlyEqual(SplineMesh->GetEndRoll(), EndRoll))
+			{
+				SplineMesh->SetStartAndEnd(FVector::ZeroVector, LeaveTangents[i], EndPosition, ArriveTangents[i + 1], false);
+				SplineMesh->SetStartRoll(StartRoll, false);
+				SplineMesh->SetEndRoll(EndRoll, false);
+				SplineMesh->UpdateMesh();
+			}
+		}
+
+		// Hide the rest for later updates.
+		for (int32 i = SegmentNum; i < SplineMeshPool.Num(); ++i)
+		{
+			USplineMeshComponent* SplineMesh = SplineMeshPool[i];
+			if (IsValid(SplineMesh) && SplineMesh->IsVisible())
+			{
+				SplineMesh->SetVisibility(false);
+				SplineMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+			}
+		}
+	}
+}
+
+void UIndividualCustomSplineBaseComponent::GenerateSweptMesh()
+{
+	AActor* Owner = GetOwner();
+	UWorld* World = GetWorld();
+	if (!IsValid(SplineComponent) || SplineComponent->IsBeingDestroyed() || !SplineComponent->GetSplineProxy()
+		|| !IsValid(Owner) || Owner->IsActorBeingDestroyed() || !IsValid(World))
+	{
+		return;
+	}
+	DestroySplineMeshes();
+
+	FSweepCrossSection Section;
+	Section.Points = SweepCrossSection;
+	Section.bClosed = bSweepCrossSectionClosed;
+	FSweepSettings Settings;
+	Settings.LODChordErrors = { FMath::Max(SweepChordError, KINDA_SMALL_NUMBER) };
+	Settings.VLength = SweepVLength;
+	TSplineFrameTable<3> Frames(*SplineComponent->GetSplineProxy());
+	TArray<FSweepMeshBuffers> LODs;
+	if (!TSplineSweep<3>::Build(LODs, Frames, Section, Settings))
+	{
+		DestroySweptMesh();
+		return;
+	}
+
+	// From the spline graph to this component.
+	FSweepMeshBuffers& Buffers = LODs[0];
+	const FTransform SplineLocalToComponent = SplineComponent->GetSplineLocalToWorldTransform() * GetComponentTransform().Inverse();
+	TArray<FProcMeshTangent> Tangents;
+	Tangents.Reserve(Buffers.Tangents.Num());
+	for (int32 i = 0; i < Buffers.Positions.Num(); ++i)
+	{
+		Buffers.Positions[i] = SplineLocalToComponent.TransformPosition(Buffers.Positions[i]);
+		Buffers.Normals[i] = SplineLocalToComponent.TransformVectorNoScale(Buffers.Normals[i]);
+		Tangents.Add(FProcMeshTangent(SplineLocalToComponent.TransformVectorNoScale(Buffers.Tangents[i]), false));
+	}
+
+	if (!IsValid(SweptMesh))
+	{
+		SweptMesh = NewObject<UProceduralMeshComponent>(this);
+		SweptMesh->Mobility = Mobility;
+		SweptMesh->AttachToComponent(this, FAttachmentTransformRules::KeepRelativeTransform);
+		Owner->AddInstanceComponent(SweptMesh);
+		SweptMesh->RegisterComponent();
+	}
+	SweptMesh->CreateMeshSection(0, Buffers.Positions, Buffers.Indices, Buffers.Normals, Buffers.UVs, TArray<FColor>(), Tangents, false);
+	SweptMesh->SetMaterial(0, SweepMaterial);
+}
+
+void UIndividualCustomSplineBaseComponent::DestroySplineMeshes()
+{
+	AActor* Owner = GetOwner();
+	for (USplineMeshComponent* SplineMesh : SplineMeshPool)
+	{
+		SplineMeshes.Add(SplineMesh);
+	}
+	for (auto It = SplineMeshes.CreateIterator(); It; ++It)
+	{
+		if (IsValid(*It) && (*It)->IsA<USplineMeshComponent>())
 		{
-			if ((*It)->IsA<USplineMeshComponent>())
+			if (IsValid(Owner))
 			{
 				Owner->RemoveInstanceComponent(*It);
-				(*It)->DestroyComponent();
 			}
+			(*It)->DestroyComponent();
 		}
-		TArray<FVector> Positions, ArriveTangents, LeaveTangents;
-		SplineComponent->GetHermiteForms(Positions, ArriveTangents, LeaveTangents, ECustomSplineCoordinateType::World);
+	}
+	SplineMeshes.Empty();
+	SplineMeshPool.Empty();
+}
 
-		SplineMeshes.Empty(FMath::Max(0, Positions.Num() - 1));
-		for (int32 i = 0; i + 1 < Positions.Num(); ++i)
+void UIndividualCustomSplineBaseComponent::DestroySweptMesh()
+{
+	if (IsValid(SweptMesh))
+	{
+		AActor* Owner = GetOwner();
+		if (IsValid(Owner))
 		{
-			USplineMeshComponent* SplineMesh = NewObject<USplineMeshComponent>(this);
-			SplineMesh->Mobility = Mobility;
-			SplineMesh->AttachToComponent(this, FAttachmentTransformRules::KeepRelativeTransform);
-			SplineMesh->SetStaticMesh(StaticMeshForSpline);
-			SplineMesh->SetWorldLocation(Positions[i]);
-			Owner->AddInstanceComponent(SplineMesh);
-			SplineMesh->RegisterComponent(); 
-			SplineMesh->SetStartAndEnd(FVector::ZeroVector, LeaveTangents[i], Positions[i + 1] - Positions[i], ArriveTangents[i + 1], true);
-
-			SplineMeshes.Add(SplineMesh);
+			Owner->RemoveInstanceComponent(SweptMesh);
 		}
+		SweptMesh->DestroyComponent();
 	}
+	SweptMesh = nullptr;
 }
 
 void UIndividualCustomSplineBaseComponent::GenerateSplineMeshesEvent(URuntimeCustomSplineBaseComponent* InSpline)
 {
 	if (InSpline == SplineComponent)
+	{
+		// Coalesce the updates of a frame (e.g. when dragging points) into one at the next tick.
+		if (IsRegistered() && PrimaryComponentTick.IsTickFunctionRegistered())
+		{
+			bSplineMeshesDirty = true;
+			SetComponentTickEnabled(true);
+		}
+		else
+		{
+			GenerateSplineMeshes();
+		}
+	}
+}
+
+void UIndividualCustomSplineBaseComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	if (bSplineMeshesDirty)
 	{
 		GenerateSplineMeshes();
 	}
+	SetComponentTickEnabled(false);
 }
 
 void UIndividualCustomSplineBaseComponent::ConstructIndividualSpline(
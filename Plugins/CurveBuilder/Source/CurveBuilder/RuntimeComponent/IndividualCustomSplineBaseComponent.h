@@ -12,6 +12,8 @@
 
 class UStaticMesh;
 class USplineMeshComponent;
+class UProceduralMeshComponent;
+class UMaterialInterface;
 
 UCLASS(BlueprintType, ClassGroup = CustomSpline, ShowCategories = (Mobility), HideCategories = (Physics, Lighting, Mobile), meta = (BlueprintSpawnableComponent))
 class CURVEBUILDER_API UIndividualCustomSplineBaseComponent : public USceneComponent//, public IInterface_CollisionDataProvider
@@ -30,6 +32,8 @@ public:
 	virtual void OnRegister() override;
 	virtual void OnUnregister() override;
 
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
 #if WITH_EDITOR
 	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 #endif
@@ -40,6 +44,10 @@ public:
 	UFUNCTION(BlueprintCallable, CallInEditor, Category = "RuntimeCustomSpline|Individual")
 	void GenerateSplineMeshes();
 
+	// One mesh section swept along the spline, instead of a spline mesh for each segment.
+	UFUNCTION(BlueprintCallable, CallInEditor, Category = "RuntimeCustomSpline|Individual")
+	void GenerateSweptMesh();
+
 	UFUNCTION(BlueprintCallable, Category = "RuntimeCustomSpline|Individual")
 	void GenerateSplineMeshesEvent(URuntimeCustomSplineBaseComponent* InSpline);
 
@@ -77,6 +85,31 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RuntimeCustomSpline|Individual")
 	bool bAutoGenerateMesh = true;
 
+	// Roll the spline meshes by the rotation minimizing frames, so they do not twist or flip on steep segments.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RuntimeCustomSpline|Individual")
+	bool bRotationMinimizingRoll = false;
+
+	// Generate the swept mesh instead of the spline meshes.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RuntimeCustomSpline|Individual")
+	bool bGenerateSweptMesh = false;
+
+	// X is to the right and Y is up. The faces of a counter-clockwise section are outwards.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RuntimeCustomSpline|Individual")
+	TArray<FVector2D> SweepCrossSection { FVector2D(200.f, 0.f), FVector2D(-200.f, 0.f) };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RuntimeCustomSpline|Individual")
+	bool bSweepCrossSectionClosed = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RuntimeCustomSpline|Individual", meta = (ClampMin = "0.01"))
+	float SweepChordError = 1.f;
+
+	// Length along the spline of one repeat of V.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RuntimeCustomSpline|Individual")
+	float SweepVLength = 400.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RuntimeCustomSpline|Individual")
+	UMaterialInterface* SweepMaterial = nullptr;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RuntimeCustomSpline|Individual")
 	bool bDrawSplineInGame = false;
 
@@ -90,7 +123,21 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "RuntimeCustomSpline")
 	TSet<USplineMeshComponent*> SplineMeshes;
 
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "RuntimeCustomSpline")
+	UProceduralMeshComponent* SweptMesh = nullptr;
+
 private:
+	// Same components as SplineMeshes, by segment. The ones after the last segment are hidden and kept for later updates.
+	UPROPERTY()
+	TArray<USplineMeshComponent*> SplineMeshPool;
+
+	// Set by GenerateSplineMeshesEvent(), and the meshes are generated at the next tick.
+	bool bSplineMeshesDirty = false;
+
+	void DestroySplineMeshes();
+
+	void DestroySweptMesh();
+
 	EComponentCreationMethod OriginalMethod;
 	TMap<URuntimeSplinePointBaseComponent*, FVector> ConstructSplinePoints;
 };
\ No newline at end of file
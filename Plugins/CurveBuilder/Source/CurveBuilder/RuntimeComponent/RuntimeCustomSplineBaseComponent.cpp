@@ -67,6 +67,7 @@ bool URuntimeCustomSplineBaseComponent::MoveComponentImpl(const FVector& Delta,
 
 FPrimitiveSceneProxy* URuntimeCustomSplineBaseComponent::CreateSceneProxy()
 {
+	PublishRenderSnapshot();
 	return new FRuntimeCustomSplineSceneProxy(this);
 }
 
@@ -213,6 +214,15 @@ void URuntimeCustomSplineBaseComponent::UpdateCollision()
 {
 	QUICK_SCOPE_CYCLE_COUNTER(STAT_RuntimeCustomSplineBaseComponent_UpdateCollision);
 
+	if (IsValid(ParentGraph))
+	{
+		if (ParentGraph->DeferSplineComponentUpdate(this))
+		{
+			return;
+		}
+		ParentGraph->MarkSplineBVHDirty(this);
+	}
+
 	if (bCreateCollisionForSelection)
 	{
 		DestroyPhysicsState();
@@ -234,20 +244,25 @@ void URuntimeCustomSplineBaseComponent::UpdateCollision()
 
 	CreateBodySetup();
 
-	TArray<double> Parameters;
-	int32 SegNum = SampleParameters(Parameters, *Spline, CollisionSegLength, bCreateCollisionByCurveLength);
+	if (!IsCollisionSampleValid())
+	{
+		SampleCollisionPositions(CollisionSamplePositions, *Spline, CollisionSegLength, bCreateCollisionByCurveLength);
+		CollisionSampleVersion = SplineVersion;
+		CollisionSampleSegLength = CollisionSegLength;
+		bCollisionSampleByCurveLength = bCreateCollisionByCurveLength;
+		bCollisionSamplesValid = true;
+	}
+	int32 SegNum = CollisionSamplePositions.Num() - 1;
 
 	//FMatrix LocalToWorld = GetSplineLocalToWorldMatrix();
 	FMatrix SplineLocalToComponentLocal = GetSplineLocalToComponentLocalTransform().ToMatrixWithScale();
-	double T = Parameters[0];
-	FVector Start = SplineLocalToComponentLocal.TransformPosition(Spline->GetPosition(T));
+	FVector Start = SplineLocalToComponentLocal.TransformPosition(CollisionSamplePositions[0]);
 
 	// Fill in simple collision sphyl elements
-	BodySetup->AggGeom.SphylElems.Empty(Parameters.Num() - 1);
+	BodySetup->AggGeom.SphylElems.Empty(SegNum);
 	for (int32 i = 0; i < SegNum; ++i)
 	{
-		T = Parameters[i + 1];
-		FVector End = SplineLocalToComponentLocal.TransformPosition(Spline->GetPosition(T));
+		FVector End = SplineLocalToComponentLocal.TransformPosition(CollisionSamplePositions[i + 1]);
 		FVector SphylUpTangent = End - Start;
 		FVector SphylUpDirection = SphylUpTangent.GetSafeNormal();
 		//FVector SphylDirection = (FVector::UpVector ^ SphylUpDirection).GetSafeNormal();
@@ -736,6 +751,7 @@ void URuntimeCustomSplineBaseComponent::ClearSpline()
 	{
 		SplineBaseWrapperProxy.Get()->Spline.Reset();
 	}
+	MarkSplineChanged();
 }
 
 URuntimeSplinePointBaseComponent* URuntimeCustomSplineBaseComponent::AddEndPoint(
@@ -796,39 +812,51 @@ URuntimeSplinePointBaseComponent* URuntimeCustomSplineBaseComponent::InsertPoint
 		
 		if (Spline->FindParamByPosition(Param, SplineLocalPosition, FMath::Square(CollisionSegWidth)))
 		{
-			URuntimeSplinePointBaseComponent* NewPointComponent = nullptr;
-			switch (Spline->GetType()) {
-			case ESplineType::BezierString:
-			{
-				SCOPE_MUTEX_LOCK(RenderMuteX);
-				auto* NewNode = static_cast<TSplineTraitByType<ESplineType::BezierString, 3, 3>::FSplineType*>(Spline)->AddPointWithParamWithoutChangingShape(Param);
-				if (NewNode) {
-					NewNode->GetValue().Get().Continuity = EEndPointContinuity::G1;
-					NewPointComponent = AddPointInternal(NewNode->GetValue(), 0);
-					AddPointInternal(NewNode->GetValue(), -1);
-					AddPointInternal(NewNode->GetValue(), 1);
-				}
-			}
-				break;
-			case ESplineType::ClampedBSpline:
-			{
-				SCOPE_MUTEX_LOCK(RenderMuteX);
-				auto* NewNode = static_cast<TSplineTraitByType<ESplineType::ClampedBSpline, 3, 3>::FSplineType*>(Spline)->AddPointWithParamWithoutChangingShape(Param);
-				if (NewNode) {
-					NewPointComponent = AddPointInternal(NewNode->GetValue(), 0);
-				}
+			return InsertPointWithParam(Param, bSucceedReturn);
+		}
+	}
+
+	bSucceedReturn = false;
+	return nullptr;
+}
+
+URuntimeSplinePointBaseComponent* URuntimeCustomSplineBaseComponent::InsertPointWithParam(double Param, bool& bSucceedReturn)
+{
+	auto* Spline = GetSplineProxy();
+	if (Spline)
+	{
+		URuntimeSplinePointBaseComponent* NewPointComponent = nullptr;
+		switch (Spline->GetType()) {
+		case ESplineType::BezierString:
+		{
+			SCOPE_MUTEX_LOCK(RenderMuteX);
+			auto* NewNode = static_cast<TSplineTraitByType<ESplineType::BezierString, 3, 3>::FSplineType*>(Spline)->AddPointWithParamWithoutChangingShape(Param);
+			if (NewNode) {
+				NewNode->GetValue().Get().Continuity = EEndPointContinuity::G1;
+				NewPointComponent = AddPointInternal(NewNode->GetValue(), 0);
+				AddPointInternal(NewNode->GetValue(), -1);
+				AddPointInternal(NewNode->GetValue(), 1);
 			}
-				break;
+		}
+			break;
+		case ESplineType::ClampedBSpline:
+		{
+			SCOPE_MUTEX_LOCK(RenderMuteX);
+			auto* NewNode = static_cast<TSplineTraitByType<ESplineType::ClampedBSpline, 3, 3>::FSplineType*>(Spline)->AddPointWithParamWithoutChangingShape(Param);
+			if (NewNode) {
+				NewPointComponent = AddPointInternal(NewNode->GetValue(), 0);
 			}
-			if (Spline->GetType() != ESplineType::Unknown)
+		}
+			break;
+		}
+		if (Spline->GetType() != ESplineType::Unknown)
+		{
+			bSucceedReturn = (NewPointComponent != nullptr);
+			if (bSucceedReturn)
 			{
-				bSucceedReturn = (NewPointComponent != nullptr);
-				if (bSucceedReturn)
-				{
-					UpdateControlPointsLocation();
-				}
-				return NewPointComponent;
+				UpdateControlPointsLocation();
 			}
+			return NewPointComponent;
 		}
 	}
 
@@ -893,6 +921,7 @@ void URuntimeCustomSplineBaseComponent::ReverseImpl()
 		CPComp->MarkRenderStateDirty();
 	}
 
+	MarkSplineChanged();
 	UpdateBounds();
 	UpdateCollision();
 	MarkRenderStateDirty();
@@ -972,20 +1001,21 @@ URuntimeSplinePointBaseComponent* URuntimeCustomSplineBaseComponent::AddPointInt
 
 void URuntimeCustomSplineBaseComponent::UpdateTransformByCtrlPoint()
 {
+	MarkSplineChanged();
+	if (IsValid(ParentGraph))
+	{
+		if (ParentGraph->DeferSplineComponentUpdate(this))
+		{
+			return;
+		}
+		ParentGraph->MarkSplineBVHDirty(this);
+	}
+
 	auto* Spline = GetSplineProxy();
 	if (IsValid(this) && !this->IsBeingDestroyed() && Spline && Spline->GetCtrlPointNum() > 0)
 	{
 		TTuple<double, double> ParamRange = Spline->GetParamRange();
-		FVector SplineLocalPosition = Spline->GetPosition(ParamRange.Get<0>());
-		FVector ComponentLocalPosition = GetSplineLocalToParentComponentTransform().TransformPosition(SplineLocalPosition);
-		if ((ComponentLocalPosition - GetRelativeLocation()).IsNearlyZero())
-		{
-			OnUpdateTransform(EUpdateTransformFlags::None, ETeleportType::None);
-		}
-		else
-		{
-			SetRelativeTransform(FTransform(FRotator::ZeroRotator, ComponentLocalPosition));
-		}
+		UpdateTransformBySplineStart(Spline->GetPosition(ParamRange.Get<0>()));
 
 		//if (Spline->GetType() == ESplineType::BezierString)
 		//{
@@ -997,6 +1027,31 @@ void URuntimeCustomSplineBaseComponent::UpdateTransformByCtrlPoint()
 	//MarkRenderTransformDirty();
 }
 
+void URuntimeCustomSplineBaseComponent::UpdateTransformBySplineStart(const FVector& SplineLocalStart)
+{
+	FVector ComponentLocalPosition = GetSplineLocalToParentComponentTransform().TransformPosition(SplineLocalStart);
+	if ((ComponentLocalPosition - GetRelativeLocation()).IsNearlyZero())
+	{
+		OnUpdateTransform(EUpdateTransformFlags::None, ETeleportType::None);
+	}
+	else
+	{
+		SetRelativeTransform(FTransform(FRotator::ZeroRotator, ComponentLocalPosition));
+	}
+}
+
+void URuntimeCustomSplineBaseComponent::PublishRenderSnapshot()
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_RuntimeCustomSplineBaseComponent_PublishRenderSnapshot);
+	auto* Spline = GetSplineProxy();
+	if (!Spline)
+	{
+		RenderSnapshot.Reset();
+		return;
+	}
+	RenderSnapshot = FSpatialSplineSnapshot3::Create(*Spline, RenderSnapshot);
+}
+
 int32 URuntimeCustomSplineBaseComponent::SampleParameters(TArray<double>& OutParameters, const FSpatialSplineBase3& SplineInternal, double SegLength, bool bByCurveLength, bool bAdjustKeyLength)
 {
 	TTuple<double, double> ParamRange = SplineInternal.GetParamRange();
@@ -1069,6 +1124,29 @@ int32 URuntimeCustomSplineBaseComponent::SampleParameters(TArray<double>& OutPar
 	return OutParameters.Num() - 1;
 }
 
+void URuntimeCustomSplineBaseComponent::SampleCollisionPositions(TArray<FVector>& OutPositions, const FSpatialSplineBase3& SplineInternal, double SegLength, bool bByCurveLength)
+{
+	TArray<double> Parameters;
+	SampleParameters(Parameters, SplineInternal, SegLength, bByCurveLength);
+	OutPositions.SetNumUninitialized(Parameters.Num());
+	for (int32 i = 0; i < Parameters.Num(); ++i)
+	{
+		OutPositions[i] = SplineInternal.GetPosition(Parameters[i]);
+	}
+}
+
+void URuntimeCustomSplineBaseComponent::SetCollisionSamples(TArray<FVector>&& Positions, uint32 Version)
+{
+	if (Positions.Num() > 0)
+	{
+		CollisionSamplePositions = MoveTemp(Positions);
+		CollisionSampleVersion = Version;
+		CollisionSampleSegLength = CollisionSegLength;
+		bCollisionSampleByCurveLength = bCreateCollisionByCurveLength;
+		bCollisionSamplesValid = true;
+	}
+}
+
 void FRuntimeSplineCommandHelper::CapturedMouseMove(FViewport* InViewport, int32 InMouseX, int32 InMouseY)
 {
 	FRuntimeSplineCommandHelperBase::CapturedMouseMove(InViewport, InMouseX, InMouseY);
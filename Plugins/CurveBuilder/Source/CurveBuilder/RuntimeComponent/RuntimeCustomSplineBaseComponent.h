@@ -230,10 +230,39 @@ public:
 
 	URuntimeSplinePointBaseComponent* AddPointInternal(const TSharedRef<FSpatialControlPoint3>& PointRef, int32 TangentFlag = 0);
 
+	// Insert a point at the parameter of the spline without changing the shape.
+	URuntimeSplinePointBaseComponent* InsertPointWithParam(double Param, bool& bSucceedReturn);
+
 	void UpdateTransformByCtrlPoint();
 
+	// Same as UpdateTransformByCtrlPoint() without deferring, with the start of the spline computed elsewhere (e.g. in parallel).
+	void UpdateTransformBySplineStart(const FVector& SplineLocalStart);
+
+	// Increased whenever the spline is changed, so caches of its shape do not need to read the spline to be validated.
+	FORCEINLINE void MarkSplineChanged() { ++SplineVersion; }
+
+	FORCEINLINE uint32 GetSplineVersion() const { return SplineVersion; }
+
+	// Publish a new immutable version of the spline for the render thread, if the spline is changed since the last one.
+	void PublishRenderSnapshot();
+
+	FORCEINLINE const FSpatialSplineSnapshot3::FSnapshotPtr& GetRenderSnapshot() const { return RenderSnapshot; }
+
 	static int32 SampleParameters(TArray<double>& OutParameters, const FSpatialSplineBase3& SplineInternal, double SegLength, bool bByCurveLength = false, bool bAdjustKeyLength = true);
 
+	// Positions of the collision segments in spline local space. Only reads the spline, so it may run off the game thread.
+	static void SampleCollisionPositions(TArray<FVector>& OutPositions, const FSpatialSplineBase3& SplineInternal, double SegLength, bool bByCurveLength);
+
+	// The collision samples are out of date if the spline version or the collision settings are changed.
+	FORCEINLINE bool IsCollisionSampleValid() const
+	{
+		return bCollisionSamplesValid && CollisionSampleVersion == SplineVersion
+			&& CollisionSampleSegLength == CollisionSegLength && bCollisionSampleByCurveLength == bCreateCollisionByCurveLength;
+	}
+
+	// Samples computed elsewhere (e.g. in parallel) with the current settings, used by the next UpdateCollision if the spline version still matches.
+	void SetCollisionSamples(TArray<FVector>&& Positions, uint32 Version);
+
 public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RuntimeCustomSpline|Settings")
@@ -285,6 +314,17 @@ public:
 private:
 	bool bLastCreateCollisionByCurveLength = false;
 
+	uint32 SplineVersion = 0;
+
+	// Collision samples in spline local space, reused while the spline version and the settings are unchanged.
+	TArray<FVector> CollisionSamplePositions;
+	uint32 CollisionSampleVersion = 0;
+	float CollisionSampleSegLength = 0.f;
+	bool bCollisionSampleByCurveLength = false;
+	bool bCollisionSamplesValid = false;
+
+	FSpatialSplineSnapshot3::FSnapshotPtr RenderSnapshot;
+
 	AActor* PreviousAttachedActor = nullptr;
 
 };
@@ -5,6 +5,7 @@
 #include "RuntimeCustomSplineBaseComponent.h"
 #include "RuntimeSplinePointBaseComponent.h"
 #include "GameFramework/PlayerController.h"
+#include "Async/ParallelFor.h"
 
 void USplineGraphRootComponent::OnUpdateTransform(EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
 {
@@ -94,18 +95,18 @@ void ARuntimeSplineGraph::GetAdjacentSplines(TMap<URuntimeCustomSplineBaseCompon
 	}
 }
 
-void ARuntimeSplineGraph::GetClusterSplinesWithoutSource(TMap<URuntimeCustomSplineBaseComponent*, int32>& OutClusterSplinesWithDistance, URuntimeCustomSplineBaseComponent* SourceSpline, bool bForward)
+void ARuntimeSplineGraph::GetClusterSplinesWithoutSource(TMap<URuntimeCustomSplineBaseComponent*, int32>& OutClusterSplinesWithDistance, URuntimeCustomSplineBaseComponent* SourceSpline, bool bForward, int32 MaxDistance)
 {
+	OutClusterSplinesWithDistance.Reset();
 	if (IsValid(SourceSpline) && !SourceSpline->IsBeingDestroyed())
 	{
-		TSharedPtr<FSpatialSplineBase3> SplineSharedPtr = SourceSpline->GetSplineProxyWeakPtr().Pin();
-		TSet<TTuple<FSpatialSplineGraph3::FGraphNode, int> > ConnectedSplineWrappers;
-		SplineGraphProxy.GetClusterWithoutSelf(ConnectedSplineWrappers, SplineSharedPtr, bForward ? EContactType::End : EContactType::Start);
-		OutClusterSplinesWithDistance.Empty(ConnectedSplineWrappers.Num());
-		for (const auto& Tuple : ConnectedSplineWrappers)
+		FSpatialSplineGraph3::FSplineId SourceId = SplineGraphProxy.GetSplineId(SourceSpline->GetSplineProxyWeakPtr());
+		SplineGraphProxy.GetClusterWithoutSelf(ClusterEndpointsScratch, SourceId, bForward ? EContactType::End : EContactType::Start, MaxDistance);
+		for (const TTuple<int32, int32>& Tuple : ClusterEndpointsScratch)
 		{
-			URuntimeCustomSplineBaseComponent** CompPtr = SplineComponentMap.Find(Tuple.Get<0>().SplineWrapper.Pin());
-			if (CompPtr)
+			FSpatialSplineGraph3::FSplineId Id = SplineGraphProxy.GetSplineIdByIndex(FSpatialSplineGraph3::GetEndpointSplineIndex(Tuple.Get<0>()));
+			URuntimeCustomSplineBaseComponent** CompPtr = SplineComponentMap.Find(SplineGraphProxy.GetSplineWrapperById(Id));
+			if (CompPtr && !OutClusterSplinesWithDistance.Contains(*CompPtr))
 			{
 				OutClusterSplinesWithDistance.Add(*CompPtr, Tuple.Get<1>());
 			}
@@ -224,126 +225,82 @@ bool ARuntimeSplineGraph::TraceSpline(URuntimeCustomSplineBaseComponent*& OutTra
 	{
 		return false;
 	}
-	TMap<URuntimeCustomSplineBaseComponent*, TSharedPtr<FSpatialSplineBase3> > ScreenSpaceSplineMap;
-	TMap<URuntimeCustomSplineBaseComponent*, TSharedPtr<FSpatialSplineBase3> > ScreenSpaceSplinePlanarMap;
-	TMap<URuntimeCustomSplineBaseComponent*, FBox> ScreenSpaceBoxMap;
-	ScreenSpaceSplineMap.Reserve(SplineComponentMap.Num());
-	ScreenSpaceSplinePlanarMap.Reserve(SplineComponentMap.Num());
-	ScreenSpaceBoxMap.Reserve(SplineComponentMap.Num());
+	UpdateSplineBVH();
+
+	// Only the segments whose boxes overlap the pick frustum are projected to the screen.
+	float MaxCollisionSegWidth = 0.f;
 	for (auto& SplinePair : SplineComponentMap)
 	{
 		auto* SplineComp = SplinePair.Get<1>();
-		//URoadEditorSplineComponent* SplineComp = Cast<URoadEditorSplineComponent>(SplinePair.Get<1>());
-		if (!IsValid(SplineComp) || SplineComp->IsBeingDestroyed() || !SplineComp->IsVisible())// || SplineComp->bIsOffset)
+		if (IsValid(SplineComp))
 		{
-			continue;
+			MaxCollisionSegWidth = FMath::Max(MaxCollisionSegWidth, SplineComp->CollisionSegWidth);
 		}
+	}
 
-		FBox& NewBox = ScreenSpaceBoxMap.Add(SplineComp, FBox(EForceInit::ForceInit));
-
-		auto* SplineProxy = SplineComp->GetSplineProxy();
-		TArray<TWeakPtr<FSpatialControlPoint3> > CPStructs;
-		SplineProxy->GetCtrlPointStructs(CPStructs);
-
-		FTransform SplineLocalToWorld = SplineComp->GetSplineLocalToWorldTransform();
-
-		switch (SplineProxy->GetType())
-		{
-		case ESplineType::ClampedBSpline:
+	static constexpr float PickDistance = 1e6f;
+	const FTransform WorldToSplineGraphLocal = GetActorTransform().Inverse();
+	const FVector2D CornerOffsets[4] = { FVector2D(-1.f, -1.f), FVector2D(1.f, -1.f), FVector2D(1.f, 1.f), FVector2D(-1.f, 1.f) };
+	FVector NearCorners[4], FarCorners[4];
+	for (int32 i = 0; i < 4; ++i)
+	{
+		FVector2D Corner = MousePosition + CornerOffsets[i] * MaxCollisionSegWidth;
+		FVector WorldLocation = FVector::ZeroVector, WorldDirection = FVector::ZeroVector;
+		if (!PlayerController->DeprojectScreenPositionToWorld(Corner.X, Corner.Y, WorldLocation, WorldDirection))
 		{
-			TArray<FVector4> CPs;
-			TArray<FVector4> CPsPlanar;
-			TArray<double> Intervals;
-			CPs.Reserve(CPStructs.Num());
-			CPsPlanar.Reserve(CPStructs.Num());
-			static_cast<TSplineTraitByType<ESplineType::ClampedBSpline, 3, 3>::FSplineType*>(SplineProxy)->GetKnotIntervals(Intervals);
-			for (auto& CPStructWeakPtr : CPStructs)
-			{
-				FVector ScreenLocation = FVector::ZeroVector;
-				auto* CPStruct = static_cast<TSplineTraitByType<ESplineType::ClampedBSpline, 3, 3>::FControlPointType*>(CPStructWeakPtr.Pin().Get());
-				PlayerController->ProjectWorldLocationToScreenWithDistance(SplineLocalToWorld.TransformPosition(TVecLib<4>::Projection(CPStruct->Pos)), ScreenLocation, true);
-				CPs.Add(FVector4(ScreenLocation, 1.f));
-				CPsPlanar.Add(FVector4(ScreenLocation.X, ScreenLocation.Y, 0.f, 1.f));
-				NewBox += ScreenLocation;
-			}
-			auto* NewSplinePtr = new TSplineTraitByType<ESplineType::ClampedBSpline, 3, 3>::FSplineType();
-			NewSplinePtr->Reset(CPs, Intervals);
-			ScreenSpaceSplineMap.Add(SplineComp, MakeShareable(NewSplinePtr));
-
-			auto* NewSplinePlanarPtr = new TSplineTraitByType<ESplineType::ClampedBSpline, 3, 3>::FSplineType();
-			NewSplinePlanarPtr->Reset(CPsPlanar, Intervals);
-			ScreenSpaceSplinePlanarMap.Add(SplineComp, MakeShareable(NewSplinePlanarPtr));
+			return false;
 		}
-		break;
-		case ESplineType::BezierString:
+		NearCorners[i] = WorldToSplineGraphLocal.TransformPosition(WorldLocation);
+		FarCorners[i] = WorldToSplineGraphLocal.TransformPosition(WorldLocation + WorldDirection * PickDistance);
+	}
+	FVector InsideLocation = FVector::ZeroVector;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		InsideLocation += (NearCorners[i] + FarCorners[i]) * 0.125f;
+	}
+	FPlane PickPlanes[4];
+	for (int32 i = 0; i < 4; ++i)
+	{
+		PickPlanes[i] = FPlane(NearCorners[i], FarCorners[i], FarCorners[(i + 1) % 4]);
+		if (PickPlanes[i].PlaneDot(InsideLocation) > 0.f)
 		{
-			TArray<FVector4> CPs;
-			TArray<FVector4> CPsPlanar;
-			TArray<FVector4> PCPs;
-			TArray<FVector4> PCPsPlanar;
-			TArray<FVector4> NCPs;
-			TArray<FVector4> NCPsPlanar;
-			TArray<double> Params;
-			TArray<EEndPointContinuity> Continuities;
-			CPs.Reserve(CPStructs.Num());
-			CPsPlanar.Reserve(CPStructs.Num());
-			PCPs.Reserve(CPStructs.Num());
-			PCPsPlanar.Reserve(CPStructs.Num());
-			NCPs.Reserve(CPStructs.Num());
-			NCPsPlanar.Reserve(CPStructs.Num());
-			Params.Reserve(CPStructs.Num());
-			Continuities.Reserve(CPStructs.Num());
-			for (auto& CPStructWeakPtr : CPStructs)
-			{
-				FVector ScreenLocation = FVector::ZeroVector;
-				auto* CPStruct = static_cast<TSplineTraitByType<ESplineType::BezierString, 3, 3>::FControlPointType*>(CPStructWeakPtr.Pin().Get());
-				PlayerController->ProjectWorldLocationToScreenWithDistance(SplineLocalToWorld.TransformPosition(TVecLib<4>::Projection(CPStruct->Pos)), ScreenLocation, true);
-				CPs.Add(FVector4(ScreenLocation, 1.f));
-				CPsPlanar.Add(FVector4(ScreenLocation.X, ScreenLocation.Y, 0.f, 1.f));
-				NewBox += ScreenLocation;
-
-				PlayerController->ProjectWorldLocationToScreenWithDistance(SplineLocalToWorld.TransformPosition(TVecLib<4>::Projection(CPStruct->PrevCtrlPointPos)), ScreenLocation, true);
-				PCPs.Add(FVector4(ScreenLocation, 1.f));
-				PCPsPlanar.Add(FVector4(ScreenLocation.X, ScreenLocation.Y, 0.f, 1.f));
-				NewBox += ScreenLocation;
-
-				PlayerController->ProjectWorldLocationToScreenWithDistance(SplineLocalToWorld.TransformPosition(TVecLib<4>::Projection(CPStruct->NextCtrlPointPos)), ScreenLocation, true);
-				NCPs.Add(FVector4(ScreenLocation, 1.f));
-				NCPsPlanar.Add(FVector4(ScreenLocation.X, ScreenLocation.Y, 0.f, 1.f));
-				NewBox += ScreenLocation;
-
-				Params.Add(CPStruct->Param);
-				Continuities.Add(CPStruct->Continuity);
-			}
-			auto* NewSplinePtr = new TSplineTraitByType<ESplineType::BezierString, 3, 3>::FSplineType();
-			NewSplinePtr->Reset(CPs, PCPs, NCPs, Params, Continuities);
-			ScreenSpaceSplineMap.Add(SplineComp, MakeShareable(NewSplinePtr));
-
-			auto* NewSplinePlanarPtr = new TSplineTraitByType<ESplineType::BezierString, 3, 3>::FSplineType();
-			NewSplinePlanarPtr->Reset(CPsPlanar, PCPsPlanar, NCPsPlanar, Params, Continuities);
-			ScreenSpaceSplinePlanarMap.Add(SplineComp, MakeShareable(NewSplinePlanarPtr));
-		}
-		break;
+			PickPlanes[i] = PickPlanes[i].Flip();
 		}
 	}
+	SplineBVH.QueryFrustum(TracedSegmentsScratch, MakeArrayView(PickPlanes, 4));
 
 	float NearestZ = TNumericLimits<float>::Max();
-	for (auto& ScreenSpaceSplinePair : ScreenSpaceSplineMap)
+	for (int32 Segment : TracedSegmentsScratch)
 	{
-		auto* SplineComp = ScreenSpaceSplinePair.Get<0>();
-		const FBox& ScreenSpaceBox = ScreenSpaceBoxMap[SplineComp];
-		if (ScreenSpaceBox.Max.Z >= 0.f && ScreenSpaceBox.IsInsideXY(FVector(MousePosition, 0.f)))
+		const FSpatialSplineGraphBVH3::FSegment& Seg = SplineBVH.GetSegment(Segment);
+		auto* SplineComp = GetSplineComponentBySplineId(Seg.SplineId);
+		if (!IsValid(SplineComp) || SplineComp->IsBeingDestroyed() || !SplineComp->IsVisible())
+		{
+			continue;
+		}
+
+		FTransform SplineLocalToWorld = SplineComp->GetSplineLocalToWorldTransform();
+		FVector ScreenPoints[4];
+		FVector ScreenPlanarPoints[4];
+		FBox ScreenSpaceBox(EForceInit::ForceInit);
+		for (int32 i = 0; i < 4; ++i)
+		{
+			PlayerController->ProjectWorldLocationToScreenWithDistance(SplineLocalToWorld.TransformPosition(Seg.Curve.GetPoint(i)), ScreenPoints[i], true);
+			ScreenPlanarPoints[i] = FVector(ScreenPoints[i].X, ScreenPoints[i].Y, 0.f);
+			ScreenSpaceBox += ScreenPoints[i];
+		}
+		if (ScreenSpaceBox.Max.Z >= 0.f && ScreenSpaceBox.ExpandBy(SplineComp->CollisionSegWidth).IsInsideXY(FVector(MousePosition, 0.f)))
 		{
 			double Param = -1.;
-			auto* SplinePlanarProxy = ScreenSpaceSplinePlanarMap[SplineComp].Get();
-			if (SplinePlanarProxy->FindParamByPosition(Param, FVector(MousePosition, 0.f), FMath::Square(SplineComp->CollisionSegWidth)))
+			TBezierCurve<3, 3> ScreenSpacePlanarCurve(ScreenPlanarPoints);
+			if (ScreenSpacePlanarCurve.FindParamByPosition(Param, FVector(MousePosition, 0.f), FMath::Square(SplineComp->CollisionSegWidth)))
 			{
-				auto* SplineProxy = ScreenSpaceSplinePair.Get<1>().Get();
-				FVector ScreenSpaceWithDist = SplineProxy->GetPosition(Param);
+				TBezierCurve<3, 3> ScreenSpaceCurve(ScreenPoints);
+				FVector ScreenSpaceWithDist = ScreenSpaceCurve.GetPosition(Param);
 				if (ScreenSpaceWithDist.Z < NearestZ)
 				{
 					NearestZ = ScreenSpaceWithDist.Z;
-					OutTracedParam = Param;
+					OutTracedParam = Seg.GetSplineParam(Param);
 					OutTracedComponent = SplineComp;
 				}
 			}
@@ -408,6 +365,7 @@ void ARuntimeSplineGraph::ClearAllSplines()
 	}
 	SplineGraphProxy.Empty();
 	SplineComponentMap.Empty();
+	SplineBVH.Empty();
 }
 
 void ARuntimeSplineGraph::SplitConnection(URuntimeCustomSplineBaseComponent* Source, URuntimeCustomSplineBaseComponent* Target, bool bForward)
@@ -578,20 +536,48 @@ URuntimeSplinePointBaseComponent* ARuntimeSplineGraph::InsertPoint(
 	URuntimeCustomSplineBaseComponent* ToSpline, 
 	ECustomSplineCoordinateType CoordinateType)
 {
-	if (IsValid(ToSpline) && !ToSpline->IsBeingDestroyed())
+	bSucceedReturn = false;
+	const bool bToSplineValid = IsValid(ToSpline) && !ToSpline->IsBeingDestroyed();
+	FSpatialSplineGraph3::FSplineId FilterId;
+	FVector SplineGraphLocalPosition = Position;
+	if (bToSplineValid)
 	{
-		URuntimeSplinePointBaseComponent* ReturnComponent = ToSpline->InsertPoint(Position, bSucceedReturn, CoordinateType);
-		if (!ReturnComponent)
+		FilterId = SplineGraphProxy.GetSplineId(ToSpline->GetSplineProxy());
+		SplineGraphLocalPosition = ToSpline->ConvertPosition(Position, CoordinateType, ECustomSplineCoordinateType::SplineGraphLocal);
+	}
+	else if (CoordinateType == ECustomSplineCoordinateType::World)
+	{
+		SplineGraphLocalPosition = GetActorTransform().InverseTransformPosition(Position);
+	}
+
+	URuntimeSplinePointBaseComponent* ReturnComponent = nullptr;
+	if (bToSplineValid && !FilterId.IsValid())
+	{
+		// Not in the graph, so not in the BVH.
+		ReturnComponent = ToSpline->InsertPoint(Position, bSucceedReturn, CoordinateType);
+	}
+	else
+	{
+		// Find the parameter by the BVH. Without a target spline, the nearest spline in the graph is used.
+		UpdateSplineBVH();
+		FSpatialSplineGraphBVH3::FSegmentHit Hit;
+		if (SplineBVH.FindNearest(Hit, SplineGraphLocalPosition, TNumericLimits<double>::Max(), FilterId))
 		{
-			ReturnComponent = AddEndPoint(Position, ToSpline, true, CoordinateType, ToSpline->GetSplineType());
+			URuntimeCustomSplineBaseComponent* HitSpline = GetSplineComponentBySplineId(Hit.SplineId);
+			if (IsValid(HitSpline) && !HitSpline->IsBeingDestroyed() && Hit.DistanceSquared <= FMath::Square(HitSpline->CollisionSegWidth))
+			{
+				ReturnComponent = HitSpline->InsertPointWithParam(Hit.Param, bSucceedReturn);
+			}
 		}
+	}
 
-		bSucceedReturn = (ReturnComponent != nullptr);
-		return ReturnComponent;
+	if (!ReturnComponent && bToSplineValid)
+	{
+		ReturnComponent = AddEndPoint(Position, ToSpline, true, CoordinateType, ToSpline->GetSplineType());
 	}
 
-	bSucceedReturn = false;
-	return nullptr;
+	bSucceedReturn = (ReturnComponent != nullptr);
+	return ReturnComponent;
 }
 
 URuntimeCustomSplineBaseComponent* ARuntimeSplineGraph::ExtendNewSplineWithContinuity(bool& bSucceedReturn, URuntimeCustomSplineBaseComponent* SourceSpline, bool bAtLast, ECustomSplineCoordinateType CoordinateType)
@@ -690,25 +676,355 @@ FVector ARuntimeSplineGraph::MovePointInternal(
 		SplineGraphProxy.AdjustCtrlPointPos(
 			CPRef, TargetSplineLocalPosition, SourceSpline->GetSplineProxyWeakPtr(),
 			1, SourcePoint->TangentFlag, 0);
-		TMap<URuntimeCustomSplineBaseComponent*, int32> ClusterSplines;
-		GetClusterSplinesWithoutSource(ClusterSplines, SourceSpline, true);
-		for (TPair<URuntimeCustomSplineBaseComponent*, int32>& TargetSplinePair : ClusterSplines)
+		if (IsMovingPoints())
 		{
-			TargetSplinePair.Get<0>()->UpdateControlPointsLocation();
-			TargetSplinePair.Get<0>()->UpdateTransformByCtrlPoint();
+			// The connected splines are updated in EndMovePoints().
+			return TargetSplineLocalPosition;
 		}
-		GetClusterSplinesWithoutSource(ClusterSplines, SourceSpline, false);
-		for (TPair<URuntimeCustomSplineBaseComponent*, int32>& TargetSplinePair : ClusterSplines)
+		// Not a member scratch, since updating the components may move points recursively.
+		TArray<URuntimeCustomSplineBaseComponent*, TInlineAllocator<8> > SplinesToUpdate;
+		TMap<URuntimeCustomSplineBaseComponent*, int32> ClusterSplines;
+		for (bool bForward : { true, false })
 		{
-			TargetSplinePair.Get<0>()->UpdateControlPointsLocation();
-			TargetSplinePair.Get<0>()->UpdateTransformByCtrlPoint();
+			GetClusterSplinesWithoutSource(ClusterSplines, SourceSpline, bForward);
+			for (TPair<URuntimeCustomSplineBaseComponent*, int32>& TargetSplinePair : ClusterSplines)
+			{
+				SplinesToUpdate.AddUnique(TargetSplinePair.Get<0>());
+			}
 		}
+		UpdateSplineComponentsInternal(SplinesToUpdate);
 		//SourcePoint->UpdateComponentLocationBySpline(); // Stack Overflow
 	}
 
 	return TargetSplineLocalPosition;
 }
 
+void ARuntimeSplineGraph::BeginMovePoints()
+{
+	SplineGraphProxy.BeginBatch();
+}
+
+void ARuntimeSplineGraph::EndMovePoints()
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_RuntimeSplineGraph_EndMovePoints);
+	SplineGraphProxy.EndBatch(&MovedSplineIdsScratch);
+	TArray<URuntimeCustomSplineBaseComponent*> SplinesToUpdate;
+	SplinesToUpdate.Reserve(MovedSplineIdsScratch.Num());
+	for (const FSpatialSplineGraph3::FSplineId& SplineId : MovedSplineIdsScratch)
+	{
+		URuntimeCustomSplineBaseComponent* SplineComponent = GetSplineComponentBySplineId(SplineId);
+		if (SplineComponent)
+		{
+			SplinesToUpdate.Add(SplineComponent);
+		}
+	}
+	MovedSplineIdsScratch.Reset();
+	UpdateSplineComponentsInternal(SplinesToUpdate);
+}
+
+bool ARuntimeSplineGraph::BuildFromArrays(
+	TArray<URuntimeCustomSplineBaseComponent*>& OutSplines,
+	const TArray<FVector>& Points,
+	const TArray<int32>& PointOffsets,
+	const TArray<ERuntimeSplineType>& SplineTypes,
+	const TArray<FRuntimeSplineConnection>& Connections,
+	ECustomSplineCoordinateType CoordinateType)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_RuntimeSplineGraph_BuildFromArrays);
+	OutSplines.Reset();
+
+	TArray<FVector> LocalPoints;
+	if (CoordinateType == ECustomSplineCoordinateType::World)
+	{
+		const FTransform& GraphTransform = GetActorTransform();
+		LocalPoints.Reserve(Points.Num());
+		for (const FVector& Point : Points)
+		{
+			LocalPoints.Add(GraphTransform.InverseTransformPosition(Point));
+		}
+	}
+
+	TArray<ESplineType> InternalTypes;
+	InternalTypes.Reserve(SplineTypes.Num());
+	for (ERuntimeSplineType SplineType : SplineTypes)
+	{
+		InternalTypes.Add(GetInternalSplineType(SplineType));
+	}
+
+	TArray<TTuple<int32, int32> > InternalConnections;
+	InternalConnections.Reserve(Connections.Num());
+	for (const FRuntimeSplineConnection& Connection : Connections)
+	{
+		if (!SplineTypes.IsValidIndex(Connection.SourceSpline) || !SplineTypes.IsValidIndex(Connection.TargetSpline))
+		{
+			return false;
+		}
+		InternalConnections.Add(MakeTuple(
+			FSpatialSplineGraph3::MakeEndpoint(Connection.SourceSpline, Connection.bSourceAtLast ? EContactType::End : EContactType::Start),
+			FSpatialSplineGraph3::MakeEndpoint(Connection.TargetSpline, Connection.bTargetAtLast ? EContactType::End : EContactType::Start)));
+	}
+
+	FSpatialSplineGraph3::FBuildArrays Arrays;
+	Arrays.Points = CoordinateType == ECustomSplineCoordinateType::World ? LocalPoints : Points;
+	Arrays.PointOffsets = PointOffsets;
+	Arrays.Types = InternalTypes;
+	Arrays.Connections = InternalConnections;
+
+	TArray<FSpatialSplineGraph3::FSplineId> SplineIds;
+	if (!SplineGraphProxy.BuildFromArrays(SplineIds, Arrays))
+	{
+		return false;
+	}
+
+	OutSplines.Reserve(SplineIds.Num());
+	BeginDeferComponentUpdates();
+	for (const FSpatialSplineGraph3::FSplineId& SplineId : SplineIds)
+	{
+		OutSplines.Add(CreateSplineActorInternal(SplineGraphProxy.GetSplineById(SplineId)));
+	}
+	EndDeferComponentUpdates();
+	return true;
+}
+
+int32 ARuntimeSplineGraph::ChangeSplineTypes(const TArray<URuntimeCustomSplineBaseComponent*>& SplinesToChange, ERuntimeSplineType NewType)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_RuntimeSplineGraph_ChangeSplineTypes);
+	TArray<FSpatialSplineGraph3::FSplineId> SplineIds;
+	SplineIds.Reserve(SplinesToChange.Num());
+	for (URuntimeCustomSplineBaseComponent* SplineComponent : SplinesToChange)
+	{
+		if (IsValid(SplineComponent) && !SplineComponent->IsBeingDestroyed())
+		{
+			FSpatialSplineGraph3::FSplineId SplineId = SplineGraphProxy.GetSplineId(SplineComponent->GetSplineProxy());
+			if (SplineGraphProxy.IsValidId(SplineId))
+			{
+				SplineIds.Add(SplineId);
+			}
+		}
+	}
+
+	TArray<FSpatialSplineGraph3::FSplineTypeRemap> Remaps;
+	SplineGraphProxy.ChangeSplineTypes(Remaps, SplineIds, GetInternalSplineType(NewType));
+
+	BeginDeferComponentUpdates();
+	for (const FSpatialSplineGraph3::FSplineTypeRemap& Remap : Remaps)
+	{
+		URuntimeCustomSplineBaseComponent* SplineComponent = GetSplineComponentBySplineId(Remap.Id);
+		if (SplineComponent)
+		{
+			RebindPointComponentsInternal(SplineComponent, Remap);
+			SplineComponent->UpdateTransformByCtrlPoint();
+		}
+	}
+	EndDeferComponentUpdates();
+	return Remaps.Num();
+}
+
+void ARuntimeSplineGraph::BeginDeferComponentUpdates()
+{
+	++DeferComponentUpdatesDepth;
+}
+
+void ARuntimeSplineGraph::EndDeferComponentUpdates()
+{
+	if (DeferComponentUpdatesDepth == 0 || --DeferComponentUpdatesDepth > 0)
+	{
+		return;
+	}
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_RuntimeSplineGraph_EndDeferComponentUpdates);
+	TArray<URuntimeCustomSplineBaseComponent*> SplinesToUpdate = DeferredSplineComponents.Array();
+	DeferredSplineComponents.Empty();
+	UpdateSplineComponentsInternal(SplinesToUpdate);
+}
+
+void ARuntimeSplineGraph::RebindPointComponentsInternal(URuntimeCustomSplineBaseComponent* SplineComponent, const FSpatialSplineGraph3::FSplineTypeRemap& Remap)
+{
+	TArray<TWeakPtr<FSpatialControlPoint3> > OldPointStructs, NewPointStructs;
+	Remap.OldSpline->GetCtrlPointStructs(OldPointStructs);
+	Remap.NewSpline->GetCtrlPointStructs(NewPointStructs);
+
+	TMap<const FSpatialControlPoint3*, int32> OldPointIndices;
+	OldPointIndices.Reserve(OldPointStructs.Num());
+	for (int32 i = 0; i < OldPointStructs.Num(); ++i)
+	{
+		OldPointIndices.Add(OldPointStructs[i].Pin().Get(), i);
+	}
+	TArray<URuntimeSplinePointBaseComponent*> OldPointComponents;
+	OldPointComponents.Init(nullptr, OldPointStructs.Num());
+	for (URuntimeSplinePointBaseComponent* PointComponent : SplineComponent->PointComponents)
+	{
+		if (IsValid(PointComponent) && PointComponent->TangentFlag == 0 && PointComponent->SplinePointProxy.IsValid())
+		{
+			const int32* OldIndexPtr = OldPointIndices.Find(PointComponent->SplinePointProxy.Pin().Get());
+			if (OldIndexPtr)
+			{
+				OldPointComponents[*OldIndexPtr] = PointComponent;
+			}
+		}
+	}
+
+	// Keep the point components of the matched points.
+	TArray<URuntimeSplinePointBaseComponent*> KeptPointComponents;
+	TSet<URuntimeSplinePointBaseComponent*> KeptPointComponentSet;
+	KeptPointComponents.Init(nullptr, NewPointStructs.Num());
+	for (int32 i = 0; i < NewPointStructs.Num(); ++i)
+	{
+		const int32 OldIndex = Remap.NewToOldPoints.IsValidIndex(i) ? Remap.NewToOldPoints[i] : INDEX_NONE;
+		if (OldPointComponents.IsValidIndex(OldIndex) && OldPointComponents[OldIndex])
+		{
+			KeptPointComponents[i] = OldPointComponents[OldIndex];
+			KeptPointComponentSet.Add(OldPointComponents[OldIndex]);
+		}
+	}
+
+	// Detached before destroyed, so that the new spline is not modified by them.
+	TArray<URuntimeSplinePointBaseComponent*> PointComponentsToDestroy;
+	for (URuntimeSplinePointBaseComponent* PointComponent : SplineComponent->PointComponents)
+	{
+		if (!KeptPointComponentSet.Contains(PointComponent))
+		{
+			PointComponentsToDestroy.Add(PointComponent);
+		}
+	}
+	for (URuntimeSplinePointBaseComponent* PointComponent : PointComponentsToDestroy)
+	{
+		SplineComponent->PointComponents.Remove(PointComponent);
+		if (IsValid(PointComponent))
+		{
+			PointComponent->ParentSpline = nullptr;
+			PointComponent->SplinePointProxy.Reset();
+			PointComponent->DestroyComponent();
+		}
+	}
+
+	const bool bBezierString = Remap.NewSpline->GetType() == ESplineType::BezierString;
+	for (int32 i = 0; i < NewPointStructs.Num(); ++i)
+	{
+		TSharedRef<FSpatialControlPoint3> CPRef = NewPointStructs[i].Pin().ToSharedRef();
+		if (KeptPointComponents[i])
+		{
+			KeptPointComponents[i]->SplinePointProxy = CPRef;
+		}
+		else
+		{
+			SplineComponent->AddPointInternal(CPRef, 0);
+		}
+		if (bBezierString)
+		{
+			SplineComponent->AddPointInternal(CPRef, -1);
+			SplineComponent->AddPointInternal(CPRef, 1);
+		}
+	}
+}
+
+bool ARuntimeSplineGraph::DeferSplineComponentUpdate(URuntimeCustomSplineBaseComponent* SplineComponent)
+{
+	if (!IsDeferringComponentUpdates())
+	{
+		return false;
+	}
+	DeferredSplineComponents.Add(SplineComponent);
+	return true;
+}
+
+void ARuntimeSplineGraph::UpdateSplineComponentsInternal(TArrayView<URuntimeCustomSplineBaseComponent* const> SplineComponents)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_RuntimeSplineGraph_UpdateSplineComponents);
+
+	struct FSplineComponentJob
+	{
+		const FSpatialSplineBase3* Spline = nullptr;
+		uint32 Version = 0;
+		double SegLength = 0.;
+		bool bByCurveLength = false;
+		bool bSample = false;
+		TArray<FVector> Positions;
+		bool bHasStart = false;
+		FVector StartPosition = FVector::ZeroVector;
+		TArray<URuntimeSplinePointBaseComponent*> PointComponents;
+		TArray<const FSpatialControlPoint3*> PointStructs;
+		TArray<int32> TangentFlags;
+		TArray<FVector> PointPositions;
+	};
+
+	// Gather the inputs on the game thread. The splines in the list are changed, so the versions are increased.
+	TArray<FSplineComponentJob> Jobs;
+	Jobs.SetNum(SplineComponents.Num());
+	for (int32 i = 0; i < SplineComponents.Num(); ++i)
+	{
+		URuntimeCustomSplineBaseComponent* SplineComponent = SplineComponents[i];
+		if (!IsValid(SplineComponent) || SplineComponent->IsBeingDestroyed())
+		{
+			continue;
+		}
+		SplineComponent->MarkSplineChanged();
+		FSplineComponentJob& Job = Jobs[i];
+		Job.Spline = SplineComponent->GetSplineProxy();
+		Job.Version = SplineComponent->GetSplineVersion();
+		Job.SegLength = SplineComponent->CollisionSegLength;
+		Job.bByCurveLength = SplineComponent->bCreateCollisionByCurveLength;
+		Job.bSample = !SplineComponent->bCreateCollisionForSelection && !SplineComponent->IsCollisionSampleValid();
+		Job.PointComponents.Reserve(SplineComponent->PointComponents.Num());
+		for (URuntimeSplinePointBaseComponent* PointComponent : SplineComponent->PointComponents)
+		{
+			if (IsValid(PointComponent) && !PointComponent->IsBeingDestroyed() && PointComponent->SplinePointProxy.IsValid())
+			{
+				Job.PointComponents.Add(PointComponent);
+				Job.PointStructs.Add(PointComponent->SplinePointProxy.Pin().Get());
+				Job.TangentFlags.Add(PointComponent->TangentFlag);
+			}
+		}
+	}
+
+	// The splines and the points are only read here.
+	ParallelFor(Jobs.Num(), [&Jobs](int32 i) {
+		FSplineComponentJob& Job = Jobs[i];
+		if (!Job.Spline || Job.Spline->GetCtrlPointNum() <= 0)
+		{
+			return;
+		}
+		const ESplineType SplineType = Job.Spline->GetType();
+		Job.PointPositions.SetNumUninitialized(Job.PointStructs.Num());
+		for (int32 p = 0; p < Job.PointStructs.Num(); ++p)
+		{
+			Job.PointPositions[p] = URuntimeSplinePointBaseComponent::GetSplineLocalPosition(*Job.PointStructs[p], SplineType, Job.TangentFlags[p]);
+		}
+		Job.StartPosition = Job.Spline->GetPosition(Job.Spline->GetParamRange().Get<0>());
+		Job.bHasStart = true;
+		if (Job.bSample)
+		{
+			URuntimeCustomSplineBaseComponent::SampleCollisionPositions(Job.Positions, *Job.Spline, Job.SegLength, Job.bByCurveLength);
+		}
+	}, Jobs.Num() < 2);
+
+	// Only the transforms are updated on the game thread.
+	for (int32 i = 0; i < SplineComponents.Num(); ++i)
+	{
+		URuntimeCustomSplineBaseComponent* SplineComponent = SplineComponents[i];
+		if (!IsValid(SplineComponent) || SplineComponent->IsBeingDestroyed())
+		{
+			continue;
+		}
+		FSplineComponentJob& Job = Jobs[i];
+		if (Job.bSample)
+		{
+			SplineComponent->SetCollisionSamples(MoveTemp(Job.Positions), Job.Version);
+		}
+		for (int32 p = 0; p < Job.PointPositions.Num(); ++p)
+		{
+			if (IsValid(Job.PointComponents[p]) && !Job.PointComponents[p]->IsBeingDestroyed())
+			{
+				Job.PointComponents[p]->SetLocationBySplineLocalPosition(Job.PointPositions[p]);
+			}
+		}
+		MarkSplineBVHDirty(SplineComponent);
+		if (Job.bHasStart)
+		{
+			SplineComponent->UpdateTransformBySplineStart(Job.StartPosition);
+		}
+	}
+}
+
 URuntimeCustomSplineBaseComponent* ARuntimeSplineGraph::GetSplineComponentBySplineWeakPtr(TWeakPtr<FSpatialSplineGraph3::FSplineType> SplineWeakPtr)
 {
 	TWeakPtr<FSpatialSplineGraph3::FSplineWrapper> WrapperWeakPtr = SplineGraphProxy.GetSplineWrapper(SplineWeakPtr);
@@ -724,6 +1040,31 @@ URuntimeCustomSplineBaseComponent* ARuntimeSplineGraph::GetSplineComponentBySpli
 	return *SpCompPtr;
 }
 
+URuntimeCustomSplineBaseComponent* ARuntimeSplineGraph::GetSplineComponentBySplineId(const FSpatialSplineGraph3::FSplineId& SplineId)
+{
+	TSharedPtr<FSpatialSplineGraph3::FSplineWrapper> Wrapper = SplineGraphProxy.GetSplineWrapperById(SplineId);
+	if (!Wrapper.IsValid())
+	{
+		return nullptr;
+	}
+	URuntimeCustomSplineBaseComponent** SpCompPtr = SplineComponentMap.Find(Wrapper);
+	return SpCompPtr ? *SpCompPtr : nullptr;
+}
+
+void ARuntimeSplineGraph::MarkSplineBVHDirty(URuntimeCustomSplineBaseComponent* SplineComponent)
+{
+	if (IsValid(SplineComponent))
+	{
+		SplineBVH.MarkSplineDirty(SplineGraphProxy.GetSplineId(SplineComponent->GetSplineProxy()));
+	}
+}
+
+void ARuntimeSplineGraph::UpdateSplineBVH()
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_RuntimeSplineGraph_UpdateSplineBVH);
+	SplineBVH.Update(SplineGraphProxy);
+}
+
 URuntimeCustomSplineBaseComponent* ARuntimeSplineGraph::CreateSplineActorInternal(TWeakPtr<FSpatialSplineBase3> SplineWeakPtr, URuntimeSplinePointBaseComponent** LatestNewPointPtr)
 {
 	UWorld* World = GetWorld();
@@ -7,11 +7,15 @@
 #include "GameFramework/Actor.h"
 #include "Components/SceneComponent.h"
 #include "../Compute/Splines/SplineGraph.h"
+#include "../Compute/Splines/SplineGraphBVH.h"
+#include "../Compute/Splines/SplineSnapshot.h"
 #include "RuntimeSplineGraph.generated.h"
 
 using FSpatialSplineGraph3 = typename TSplineGraph<3, 3>;
 using FSpatialSplineBase3 = typename TSplineBase<3, 3>;
 using FSpatialControlPoint3 = typename TSplineBaseControlPoint<3, 3>;
+using FSpatialSplineGraphBVH3 = typename TSplineGraphBVH<3>;
+using FSpatialSplineSnapshot3 = typename TSplineSnapshot<3>;
 
 class URuntimeCustomSplineBaseComponent;
 class APlayerController;
@@ -32,6 +36,25 @@ enum class ERuntimeSplineType : uint8
 	BezierString,
 };
 
+// Connection of two splines by their indices in ARuntimeSplineGraph::BuildFromArrays.
+USTRUCT(BlueprintType)
+struct CURVEBUILDER_API FRuntimeSplineConnection
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RuntimeCustomSpline")
+	int32 SourceSpline = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RuntimeCustomSpline")
+	bool bSourceAtLast = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RuntimeCustomSpline")
+	int32 TargetSpline = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RuntimeCustomSpline")
+	bool bTargetAtLast = false;
+};
+
 UCLASS()
 class CURVEBUILDER_API USplineGraphRootComponent : public USceneComponent
 {
@@ -74,7 +97,7 @@ public:
 	void GetAdjacentSplines(TMap<URuntimeCustomSplineBaseComponent*, bool>& OutAdjacentSplinesAndForward, URuntimeCustomSplineBaseComponent* SourceSpline, bool bForward = true);
 
 	UFUNCTION(BlueprintPure, Category = "RuntimeCustomSpline|Query")
-	void GetClusterSplinesWithoutSource(TMap<URuntimeCustomSplineBaseComponent*, int32>& OutClusterSplinesWithDistance, URuntimeCustomSplineBaseComponent* SourceSpline, bool bForward = true);
+	void GetClusterSplinesWithoutSource(TMap<URuntimeCustomSplineBaseComponent*, int32>& OutClusterSplinesWithDistance, URuntimeCustomSplineBaseComponent* SourceSpline, bool bForward = true, int32 MaxDistance = -1);
 
 	UFUNCTION(BlueprintCallable, Category = "RuntimeCustomSpline|Query")
 	bool TraceSplinePoint(URuntimeSplinePointBaseComponent*& OutTracedComponent, APlayerController* PlayerController, const FVector2D& MousePosition);
@@ -141,14 +164,66 @@ public:
 		const FVector& TargetPosition,
 		ECustomSplineCoordinateType CoordinateType = ECustomSplineCoordinateType::SplineGraphLocal);
 
+	// Points moved between BeginMovePoints() and EndMovePoints(), such as a multi-selection drag,
+	// adjust the connected splines and update the affected components only once at the end.
+	UFUNCTION(BlueprintCallable, Category = "RuntimeCustomSpline|Update")
+	void BeginMovePoints();
+
+	UFUNCTION(BlueprintCallable, Category = "RuntimeCustomSpline|Update")
+	void EndMovePoints();
+
+	FORCEINLINE bool IsMovingPoints() const { return SplineGraphProxy.IsInBatch(); }
+
+	// Import a network of splines. Spline s has the points [PointOffsets[s], PointOffsets[s + 1]),
+	// so PointOffsets has one more element than SplineTypes. The splines are built in parallel,
+	// and the spline components are updated once at the end.
+	UFUNCTION(BlueprintCallable, Category = "RuntimeCustomSpline|Update")
+	bool BuildFromArrays(
+		TArray<URuntimeCustomSplineBaseComponent*>& OutSplines,
+		const TArray<FVector>& Points,
+		const TArray<int32>& PointOffsets,
+		const TArray<ERuntimeSplineType>& SplineTypes,
+		const TArray<FRuntimeSplineConnection>& Connections,
+		ECustomSplineCoordinateType CoordinateType = ECustomSplineCoordinateType::SplineGraphLocal);
+
+	// Convert the splines in parallel, keeping the connections. The point components at the same positions are rebound
+	// to the new control points, and the others are recreated. Return the number of splines converted.
+	UFUNCTION(BlueprintCallable, Category = "RuntimeCustomSpline|Update")
+	int32 ChangeSplineTypes(const TArray<URuntimeCustomSplineBaseComponent*>& SplinesToChange, ERuntimeSplineType NewType);
+
+	// Between BeginDeferComponentUpdates() and EndDeferComponentUpdates(), the transform and collision updates
+	// of the spline components are gathered, and done once for each spline at the end.
+	UFUNCTION(BlueprintCallable, Category = "RuntimeCustomSpline|Update")
+	void BeginDeferComponentUpdates();
+
+	UFUNCTION(BlueprintCallable, Category = "RuntimeCustomSpline|Update")
+	void EndDeferComponentUpdates();
+
+	FORCEINLINE bool IsDeferringComponentUpdates() const { return DeferComponentUpdatesDepth > 0; }
+
 public:
 
 	URuntimeCustomSplineBaseComponent* GetSplineComponentBySplineWeakPtr(TWeakPtr<FSpatialSplineBase3> SplineWeakPtr);
 
+	URuntimeCustomSplineBaseComponent* GetSplineComponentBySplineId(const FSpatialSplineGraph3::FSplineId& SplineId);
+
+	// The segment BVH is refitted lazily before queries.
+	void MarkSplineBVHDirty(URuntimeCustomSplineBaseComponent* SplineComponent);
+
+	void UpdateSplineBVH();
+
+	// The spline math of the components is computed in parallel, then the components are updated on the game thread.
+	void UpdateSplineComponentsInternal(TArrayView<URuntimeCustomSplineBaseComponent* const> SplineComponents);
+
 	URuntimeCustomSplineBaseComponent* CreateSplineActorInternal(TWeakPtr<FSpatialSplineBase3> SplineWeakPtr, URuntimeSplinePointBaseComponent** LatestNewPointPtr = nullptr);
 
 	void AddUnbindingPointsInternal(const TArray<TWeakPtr<FSpatialControlPoint3> >& CtrlPointStructsWP, URuntimeCustomSplineBaseComponent* NewSpline, URuntimeSplinePointBaseComponent** LatestNewPointPtr = nullptr);
 
+	void RebindPointComponentsInternal(URuntimeCustomSplineBaseComponent* SplineComponent, const FSpatialSplineGraph3::FSplineTypeRemap& Remap);
+
+	// Return true if the update of the spline component is deferred.
+	bool DeferSplineComponentUpdate(URuntimeCustomSplineBaseComponent* SplineComponent);
+
 	static ESplineType GetInternalSplineType(ERuntimeSplineType SplineType)
 	{
 		return static_cast<ESplineType>(SplineType);
@@ -184,4 +259,12 @@ public:
 public:
 	FSpatialSplineGraph3 SplineGraphProxy;
 	TMap<TSharedPtr<FSpatialSplineGraph3::FSplineWrapper>, URuntimeCustomSplineBaseComponent*> SplineComponentMap;
+	FSpatialSplineGraphBVH3 SplineBVH;
+
+protected:
+	TArray<TTuple<int32, int32> > ClusterEndpointsScratch;
+	TArray<int32> TracedSegmentsScratch;
+	TArray<FSpatialSplineGraph3::FSplineId> MovedSplineIdsScratch;
+	int32 DeferComponentUpdatesDepth = 0;
+	TSet<URuntimeCustomSplineBaseComponent*> DeferredSplineComponents;
 };
\ No newline at end of file
@@ -390,24 +390,33 @@ void URuntimeSplinePointBaseComponent::UpdateComponentLocationBySpline()
 	if (SplinePointProxy.IsValid())
 	{
 		const FSpatialControlPoint3& PointStruct = *SplinePointProxy.Pin().Get();
+		ESplineType SplineType = ESplineType::Unknown;
 		if (IsValid(ParentSpline) && !ParentSpline->IsBeingDestroyed())
 		{
 			auto* Spline = ParentSpline->GetSplineProxy();
 			if (Spline)
 			{
-				if (Spline->GetType() == ESplineType::BezierString)
-				{
-					const auto& BezierPointStruct = static_cast<const TSplineTraitByType<ESplineType::BezierString, 3, 3>::FControlPointType&>(PointStruct);
-					FVector4 SplineLocalPosition4 = (TangentFlag == 0 ? BezierPointStruct.Pos :
-						(TangentFlag > 0 ? BezierPointStruct.NextCtrlPointPos : BezierPointStruct.PrevCtrlPointPos));
-					SetRelativeLocation(GetSplineLocalToParentComponentTransform().TransformPosition(SplineLocalPosition4));
-					return;
-				}
+				SplineType = Spline->GetType();
 			}
 		}
+		SetLocationBySplineLocalPosition(GetSplineLocalPosition(PointStruct, SplineType, TangentFlag));
+	}
+}
 
-		SetRelativeLocation(GetSplineLocalToParentComponentTransform().TransformPosition(PointStruct.Pos));
+FVector URuntimeSplinePointBaseComponent::GetSplineLocalPosition(const FSpatialControlPoint3& PointStruct, ESplineType SplineType, int32 InTangentFlag)
+{
+	if (SplineType == ESplineType::BezierString)
+	{
+		const auto& BezierPointStruct = static_cast<const TSplineTraitByType<ESplineType::BezierString, 3, 3>::FControlPointType&>(PointStruct);
+		return FVector(InTangentFlag == 0 ? BezierPointStruct.Pos :
+			(InTangentFlag > 0 ? BezierPointStruct.NextCtrlPointPos : BezierPointStruct.PrevCtrlPointPos));
 	}
+	return FVector(PointStruct.Pos);
+}
+
+void URuntimeSplinePointBaseComponent::SetLocationBySplineLocalPosition(const FVector& InSplineLocalPosition)
+{
+	SetRelativeLocation(GetSplineLocalToParentComponentTransform().TransformPosition(InSplineLocalPosition));
 }
 
 bool URuntimeSplinePointBaseComponent::IsEndPoint(bool& bIsForwardEnd) const
@@ -437,6 +446,11 @@ void URuntimeSplinePointBaseComponent::MoveSplinePointInternal()
 		if (IsValid(ParentGraph))
 		{
 			SplineLocalPosition = ParentGraph->MovePointInternal(ParentSpline, this, GetRelativeLocation(), ECustomSplineCoordinateType::ComponentLocal);
+			if (ParentGraph->IsMovingPoints())
+			{
+				// The parent spline is updated once in EndMovePoints().
+				return;
+			}
 		}
 		else
 		{
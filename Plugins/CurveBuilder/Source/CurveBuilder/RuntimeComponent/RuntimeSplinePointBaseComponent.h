@@ -126,6 +126,12 @@ public:
 
 	bool IsEndPointOrNot(EContactType& OutContactType) const;
 
+	// Position of the point, or of its tangent handle in bezier strings, in spline local space. Only reads the point struct.
+	static FVector GetSplineLocalPosition(const FSpatialControlPoint3& PointStruct, ESplineType SplineType, int32 InTangentFlag);
+
+	// Same as UpdateComponentLocationBySpline(), with the position computed elsewhere (e.g. in parallel).
+	void SetLocationBySplineLocalPosition(const FVector& InSplineLocalPosition);
+
 public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "RuntimeCustomSpline|Component")
 	FVector SplineLocalPosition = FVector::ZeroVector;
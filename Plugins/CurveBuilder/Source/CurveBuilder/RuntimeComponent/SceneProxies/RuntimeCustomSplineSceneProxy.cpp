@@ -65,32 +65,26 @@ void FRuntimeCustomSplineSceneProxy::DrawRuntimeSpline(FPrimitiveDrawInterface*
 		return;
 	}
 
-	SCOPE_MUTEX_LOCK(ComponentWeakPtr->RenderMuteX);
-#if DISABLE_COPY_IN_SPLINE_SCENE_PROXY
-	if (!DrawInfo.SplineInternalWeakPtr.IsValid())
+	if (!DrawInfo.SplineSnapshot.IsValid())
 	{
 		return;
 	}
-	const FSpatialSplineBase3& SplineInternal = *DrawInfo.SplineInternalWeakPtr.Pin().Get();
-#else
-	const FSpatialSplineBase3& SplineInternal = *DrawInfo.SplineInternalRef.Get();
-#endif
+	const FSpatialSplineSnapshot3& SplineSnapshot = *DrawInfo.SplineSnapshot.Get();
 
-	//TTuple<double, double> ParamRange = SplineInternal.GetParamRange();
+	//TTuple<double, double> ParamRange = SplineSnapshot.GetParamRange();
 	
 #if ENABLE_CUSTOM_SPLINE_HIT_PROXY_RUNTIME
 	//PDI->SetHitProxy(new HRuntimeSplineHitProxy(ComponentWeakPtr.Get()));
 #endif
 	
 	{
-		TArray<double> Parameters;
-		int32 SegNum = URuntimeCustomSplineBaseComponent::SampleParameters(Parameters, SplineInternal, DrawInfo.SegLength, bDrawLineByCurveLength);
-		double T = Parameters[0];
-		FVector Start = InLocalToWorld.TransformPosition(SplineInternal.GetPosition(T));
-		for (int32 i = 0; i < SegNum; ++i)
+		// The snapshot is sampled by parameter length in each segment. bDrawLineByCurveLength is not supported.
+		TArray<FVector> Positions;
+		SplineSnapshot.SamplePositionsBySegment(Positions, DrawInfo.SegLength);
+		FVector Start = InLocalToWorld.TransformPosition(Positions[0]);
+		for (int32 i = 1; i < Positions.Num(); ++i)
 		{
-			T = Parameters[i + 1];
-			FVector End = InLocalToWorld.TransformPosition(SplineInternal.GetPosition(T));
+			FVector End = InLocalToWorld.TransformPosition(Positions[i]);
 			PDI->DrawLine(Start, End, DrawInfo.CurveColor, DepthPriorityGroup, DrawInfo.Thickness, DrawInfo.DepthBias, false);
 			Start = End;
 		}
@@ -142,13 +136,12 @@ void FRuntimeCustomSplineSceneProxy::DrawRuntimeSpline(FPrimitiveDrawInterface*
 
 	if (DrawInfo.bSelected)
 	{
-		switch (SplineInternal.GetType())
+		const FSpatialSplineSnapshot3::FControlPolygon& ControlPolygon = SplineSnapshot.GetControlPolygon();
+		switch (SplineSnapshot.GetType())
 		{
 		case ESplineType::ClampedBSpline:
 		{
-			const auto& BSpline = static_cast<const TSplineTraitByType<ESplineType::ClampedBSpline, 3, 3>::FSplineType&>(SplineInternal);
-			TArray<FVector4> CtrlPoints;
-			BSpline.GetCtrlPoints(CtrlPoints);
+			const TArray<FVector>& CtrlPoints = ControlPolygon.Points;
 
 			if (CtrlPoints.Num() > 1)
 			{
@@ -166,13 +159,9 @@ void FRuntimeCustomSplineSceneProxy::DrawRuntimeSpline(FPrimitiveDrawInterface*
 		break;
 		case ESplineType::BezierString:
 		{
-			const auto& BezierString = static_cast<const TSplineTraitByType<ESplineType::BezierString, 3, 3>::FSplineType&>(SplineInternal);
-			TArray<FVector4> CtrlPoints;
-			TArray<FVector4> CtrlPointsPrev;
-			TArray<FVector4> CtrlPointsNext;
-			BezierString.GetCtrlPoints(CtrlPoints);
-			BezierString.GetCtrlPointsPrev(CtrlPointsPrev);
-			BezierString.GetCtrlPointsNext(CtrlPointsNext);
+			const TArray<FVector>& CtrlPoints = ControlPolygon.Points;
+			const TArray<FVector>& CtrlPointsPrev = ControlPolygon.PrevPoints;
+			const TArray<FVector>& CtrlPointsNext = ControlPolygon.NextPoints;
 
 			if (CtrlPoints.Num() > 1)
 			{
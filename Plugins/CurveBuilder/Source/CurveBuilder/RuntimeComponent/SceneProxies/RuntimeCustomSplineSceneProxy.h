@@ -38,11 +38,7 @@ protected:
 			, Thickness(InComponent->DrawThickness)
 			, DepthBias(InComponent->DepthBias)
 			, bSelected(InComponent->bCustomSelected)
-#if !DISABLE_COPY_IN_SPLINE_SCENE_PROXY
-			, SplineInternalRef(InComponent->GetSplineProxy() ? InComponent->GetSplineProxy()->Copy() : TSharedPtr<FSpatialSplineBase3>())
-#else
-			, SplineInternalWeakPtr(InComponent->GetSplineProxyWeakPtr())
-#endif
+			, SplineSnapshot(InComponent->GetRenderSnapshot())
 
 			//: SplineComponent(InComponent)
 		{}
@@ -55,11 +51,8 @@ protected:
 		float Thickness = 0.f;
 		float DepthBias = 0.f;
 		bool bSelected = false;
-#if !DISABLE_COPY_IN_SPLINE_SCENE_PROXY
-		TSharedPtr<FSpatialSplineBase3> SplineInternalRef;
-#else
-		TWeakPtr<FSpatialSplineBase3> SplineInternalWeakPtr;
-#endif
+		// Immutable, so it is neither copied nor locked.
+		FSpatialSplineSnapshot3::FSnapshotPtr SplineSnapshot;
 		//const URuntimeCustomSplineBaseComponent* SplineComponent;
 	};
 